@@ -242,6 +242,37 @@ class ParseOptions(object):
             raise TypeError("max_parse_time must be set to an integer")
         clg.parse_options_set_max_parse_time(self._obj, value)
 
+    @property
+    def max_wall_time_ms(self):
+        """
+        The maximum wall-clock time (in milliseconds) that parsing is
+        allowed to take (-1: no limit). Unlike max_parse_time, which
+        limits the CPU time, it also counts the time the parsing thread
+        doesn't run.
+        """
+        return clg.parse_options_get_max_wall_time_ms(self._obj)
+
+    @max_wall_time_ms.setter
+    def max_wall_time_ms(self, value):
+        if not isinstance(value, int):
+            raise TypeError("max_wall_time_ms must be set to an integer")
+        clg.parse_options_set_max_wall_time_ms(self._obj, value)
+
+    @property
+    def anytime(self):
+        """
+        If a full parse cannot be done within max_parse_time, return the
+        linkages of a faster degraded parse (all links short, null words
+        allowed) instead of none. Such a sentence is marked as partial.
+        """
+        return clg.parse_options_get_anytime(self._obj)
+
+    @anytime.setter
+    def anytime(self, value):
+        if not isinstance(value, bool):
+            raise TypeError("anytime must be set to a bool")
+        clg.parse_options_set_anytime(self._obj, value)
+
     @property
     def display_morphology(self):
         """
@@ -554,6 +585,14 @@ class Sentence(object):
         """Number of null links in the linkages of this sentence."""
         return clg.sentence_null_count(self._obj)
 
+    def is_partial(self):
+        """True if the linkages are from an anytime-mode degraded parse."""
+        return clg.sentence_is_partial(self._obj)
+
+    def cancel(self):
+        """Abort the parsing of this sentence (from another thread)."""
+        clg.sentence_cancel(self._obj)
+
     class sentence_parse(object):
         def __init__(self, sent, parse_options):
             self.sent = sent
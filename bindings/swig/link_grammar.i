@@ -29,6 +29,8 @@
 // End of ignored API calls.
 
 %ignore lg_library_failure_hook;     /* Not supported. */
+%ignore sentence_batch_parse;        /* Needs a C callback. */
+%ignore sentence_batch_callback;
 
 %nodefaultdtor lg_errinfo;
 
@@ -76,9 +76,14 @@ struct Cost_Model_s
 
 struct Resources_s
 {
-	int    max_parse_time;  /* in seconds */
+	double max_parse_time;  /* CPU time, in seconds */
+	double max_wall_time;   /* Wall-clock time, in seconds */
+	double time_share;      /* Share of the above for the current stage */
 	size_t max_memory;      /* in bytes */
+	const cancel_flag *cancel; /* Of the sentence that is being parsed */
 	double time_when_parse_started;
+	double wall_time_when_parse_started;
+	double next_usage_check; /* Wall-clock time to check the CPU time */
 	size_t space_when_parse_started;
 	double when_created;
 	double when_last_called;
@@ -115,6 +120,8 @@ struct Parse_Options_s
 	                          no longer than this.  Default = 16 */
 	bool all_short;        /* If true, no connectors that are exempt. */
 	bool repeatable_rand;  /* Reset rand number gen after every parse. */
+	unsigned int count_threads; /* Counting/post-processing threads 1 */
+	bool anytime;          /* On timeout, return degraded linkages FALSE */
 
 	/* Options governing post-processing */
 	bool perform_pp_prune; /* Perform post-processing-based pruning TRUE */
@@ -143,7 +150,6 @@ struct Sentence_s
 	size_t length;              /* Number of words */
 	Word  *word;                /* Array of words after tokenization */
 	String_set *   string_set;  /* Used for assorted strings */
-	Pool_desc * Match_node_pool;
 	Pool_desc * Table_tracon_pool; /* Count memoizing memory pool */
 	Pool_desc * wordvec_pool;   /* For tracon-word zero-count memoizing */
 	Pool_desc * Exp_pool;
@@ -165,6 +171,12 @@ struct Sentence_s
 	word_queue_t *word_queue_last;
 	size_t gword_node_num;       /* Debug - for differentiating between
 	                                wordgraph nodes with identical subwords. */
+	Pool_desc * Gword_pool;      /* The wordgraph words */
+	Pool_desc * gword_set_pool;  /* Added gword_set elements */
+	Pool_desc * Gword_list_pool; /* The next/prev word lists */
+	uint64_t *alt_bitmap;        /* Gword alternatives bitmaps */
+	size_t alt_bitmap_len;       /* Length of each bitmap, in uint64_t */
+	struct Token_recording_s *token_recording; /* See token-cache.c */
 
 	size_t min_len_multi_pruning; /* Do it from this sentence length. */
 
@@ -182,7 +194,11 @@ struct Sentence_s
 	                               because some may be non-canonical. */
 	size_t num_valid_linkages;  /* Number with no pp violations */
 	unsigned int null_count;    /* Number of null links in linkages */
+	bool   partial;             /* Linkages of an incomplete (anytime) parse */
+	cancel_flag cancel;         /* Set by sentence_cancel() */
 	Linkage        lnkages;     /* Sorted array of valid & invalid linkages */
+	bool   defer_linkages;      /* Set only by linkage_iter_create() */
+	struct extractor_s *extractor; /* Parse-set of deferred linkages */
 	Postprocessor * postprocessor;
 	Postprocessor * constituent_pp;
 
@@ -39,6 +39,14 @@ typedef struct Dialect_s Dialect;
 typedef struct Word_file_struct Word_file;
 typedef struct Wordgraph_pathpos_s Wordgraph_pathpos;
 
+/* Set from another thread to abort the parsing (see sentence_cancel()) */
+#if HAVE_STDATOMIC_H
+#include <stdatomic.h>
+typedef atomic_bool cancel_flag;
+#else
+typedef volatile _Bool cancel_flag;
+#endif /* HAVE_STDATOMIC_H */
+
 /* Post-processing structures */
 typedef struct pp_knowledge_s pp_knowledge;
 typedef struct pp_linkset_s pp_linkset;
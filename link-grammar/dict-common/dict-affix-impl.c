@@ -16,6 +16,7 @@
 #include "dict-affix-impl.h"
 #include "dict-api.h"
 #include "dict-common.h"
+#include "dict-file/dict-binary.h"      // dict_binary_shared_word
 #include "print/print-util.h"           // patch_subscript_mark
 #include "regex-morph.h"
 #include "string-set.h"
@@ -83,24 +84,16 @@ static int revcmplen(const void *a, const void *b)
 #endif /* AFDICT_ORDER_NOT_PRESERVED */
 
 /**
- * Traverse the main dict in dictionary order, and extract all the suffixes
- * and prefixes - every time we see a new suffix/prefix (the previous one is
- * remembered by w_last), we save it in the corresponding affix-class list.
+ * Save the suffix or prefix of the dict word \p w, if it is a new one
+ * (the previous one is remembered by \p plast).
  * The saved affixes don't include the infix mark.
  */
-static void get_dict_affixes(Dictionary dict, Dict_node * dn,
-                             char infix_mark,
-                             const char** plast, size_t *lastlen)
+static void add_dict_affix(Dictionary afdict, const char *w, char infix_mark,
+                           const char** plast, size_t *lastlen)
 {
-	const char *w;         /* current dict word */
 	const char *w_sm;      /* SUBSCRIPT_MARK position in the dict word */
 	size_t w_len;          /* length of the dict word */
-	Dictionary afdict = dict->affix_table;
 
-	if (dn == NULL) return;
-	get_dict_affixes(dict, dn->right, infix_mark, plast, lastlen);
-
-	w = dn->string;
 	w_sm = get_word_subscript(w);
 	w_len = (NULL == w_sm) ? strlen(w) : (size_t)(w_sm - w);
 
@@ -122,7 +115,20 @@ static void get_dict_affixes(Dictionary dict, Dict_node * dn,
 		*plast = w;
 		*lastlen = w_len;
 	}
+}
 
+/**
+ * Traverse the main dict in dictionary order, and extract all the suffixes
+ * and prefixes - every time we see a new suffix/prefix (the previous one is
+ * remembered by w_last), we save it in the corresponding affix-class list.
+ */
+static void get_dict_affixes(Dictionary dict, Dict_node * dn,
+                             char infix_mark,
+                             const char** plast, size_t *lastlen)
+{
+	if (dn == NULL) return;
+	get_dict_affixes(dict, dn->right, infix_mark, plast, lastlen);
+	add_dict_affix(dict->affix_table, dn->string, infix_mark, plast, lastlen);
 	get_dict_affixes(dict, dn->left, infix_mark, plast, lastlen);
 }
 
@@ -240,7 +246,20 @@ bool afdict_init(Dictionary dict)
 		{
 			const char *last = 0x0;
 			size_t len = 0;
-			get_dict_affixes(dict, dict->root, ac->string[0][0], &last, &len);
+			if (NULL != dict->shared_image)
+			{
+				/* A shared dictionary has no word tree. */
+				const Dict_binary *db = dict->shared_image;
+				for (size_t i = dict_binary_shared_num_words(db); i-- > 0; )
+				{
+					add_dict_affix(afdict, dict_binary_shared_word(db, i),
+					               ac->string[0][0], &last, &len);
+				}
+			}
+			else
+			{
+				get_dict_affixes(dict, dict->root, ac->string[0][0], &last, &len);
+			}
 		}
 		else
 		{
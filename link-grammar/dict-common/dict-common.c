@@ -17,13 +17,17 @@
 #include "dict-api.h"
 #include "dict-common.h"
 #include "dict-defines.h"
+#include "dict-internals.h"                // dict_node_copy_list
 #include "disjunct-utils.h"
 #include "file-utils.h"                // free_categories_from_disjunct_array
 #include "post-process/pp_knowledge.h" // Needed only for pp_close !!??
+#include "prepare/disjunct-cache.h"
 #include "regex-morph.h"
 #include "string-set.h"
 #include "tokenize/anysplit.h"
+#include "tokenize/spell-guess.h"
 #include "tokenize/spellcheck.h"
+#include "tokenize/token-cache.h"
 
 #include "dict-sql/read-sql.h"
 #include "dict-file/read-dict.h"
@@ -146,6 +150,140 @@ const char * dictionary_get_lang(Dictionary dict)
 /* ======================================================================== */
 /* Dictionary lookup stuff */
 
+/*
+ * Per-sentence lookup memo, for dictionaries with dynamic lookup (SQL,
+ * Atomese), for which each lookup may be a round-trip to a server.
+ *
+ * The tokenizer looks up the same strings many times, for the different
+ * split alternatives of the sentence words. Between dict_memo_start()
+ * and dict_memo_end(), each distinct string is looked up only once, and
+ * a whole set of strings can be prefetched by dict_memo_prefetch() in
+ * one call to the dictionary lookup_bulk() method.
+ *
+ * The memo is per thread, because the lookup functions don't get the
+ * sentence as an argument.
+ */
+typedef struct
+{
+	Dict_node *dn;          /* Result of lookup_list() */
+	bool dn_valid;          /* dn has been looked up */
+	int8_t exists;          /* 0: unknown; 1: in the dict; -1: not */
+} Memo_entry;
+
+typedef struct
+{
+	Dictionary dict;
+	String_id *sid;         /* Memoized string -> entry index */
+	Memo_entry *entry;
+	size_t entries_alloced;
+} Lookup_memo;
+
+static TLS Lookup_memo *lookup_memo;
+
+/** Return the index of the memo entry of \p s. */
+static unsigned int memo_id(Lookup_memo *memo, const char *s)
+{
+	unsigned int id = string_id_add(s, memo->sid);
+	if (id >= memo->entries_alloced)
+	{
+		size_t old_alloced = memo->entries_alloced;
+		memo->entries_alloced = 2 * id + 64;
+		memo->entry = realloc(memo->entry,
+		                      memo->entries_alloced * sizeof(*memo->entry));
+		memset(&memo->entry[old_alloced], 0,
+		       (memo->entries_alloced - old_alloced) * sizeof(*memo->entry));
+	}
+
+	return id;
+}
+
+/**
+ * Return the memo entry of \p s, or NULL if there is no memo for
+ * \p dict in this thread.
+ */
+static Memo_entry *memo_entry(const Dictionary dict, const char *s)
+{
+	Lookup_memo *memo = lookup_memo;
+	if ((NULL == memo) || (memo->dict != dict)) return NULL;
+
+	return &memo->entry[memo_id(memo, s)];
+}
+
+void dict_memo_start(const Dictionary dict)
+{
+	if (!IS_DYNAMIC_DICT(dict)) return;
+
+	/* The memo keeps the lookup_list() results for copying them. */
+	if (dict->free_lookup != dict_node_free_lookup) return;
+
+	Lookup_memo *memo = malloc(sizeof(Lookup_memo));
+	memset(memo, 0, sizeof(Lookup_memo));
+	memo->dict = dict;
+	memo->sid = string_id_create();
+	lookup_memo = memo;
+}
+
+void dict_memo_end(const Dictionary dict)
+{
+	Lookup_memo *memo = lookup_memo;
+	if ((NULL == memo) || (memo->dict != dict)) return;
+
+	for (size_t i = 0; i < memo->entries_alloced; i++)
+		dict_node_free_list(memo->entry[i].dn);
+	free(memo->entry);
+	string_id_delete(memo->sid);
+	free(memo);
+	lookup_memo = NULL;
+}
+
+/**
+ * Look up in bulk those of the \p num strings \p s that have not been
+ * looked up yet. This is a no-op if there is no memo, or the dictionary
+ * has no bulk lookup.
+ */
+void dict_memo_prefetch(const Dictionary dict, const char **s, size_t num)
+{
+	Lookup_memo *memo = lookup_memo;
+	if ((NULL == memo) || (memo->dict != dict)) return;
+	if (NULL == dict->lookup_bulk) return;
+
+	const char **word = malloc(num * sizeof(*word));
+	unsigned int *id = malloc(num * sizeof(*id));
+	size_t nwords = 0;
+
+	for (size_t i = 0; i < num; i++)
+	{
+		unsigned int sid = memo_id(memo, s[i]);
+		Memo_entry *me = &memo->entry[sid];
+		if (me->dn_valid) continue;
+
+		/* Mark it, so duplicates are not looked up twice. */
+		me->dn_valid = true;
+		if (-1 == me->exists) continue;
+		id[nwords] = sid;
+		word[nwords++] = s[i];
+	}
+
+	if (0 < nwords)
+	{
+		Dict_node **dn = malloc(nwords * sizeof(*dn));
+		bool ok = dict->lookup_bulk(dict, word, nwords, dn);
+
+		for (size_t i = 0; i < nwords; i++)
+		{
+			Memo_entry *me = &memo->entry[id[i]];
+			me->dn_valid = ok;
+			if (!ok) continue;
+			me->dn = dn[i];
+			me->exists = (NULL != dn[i]) ? 1 : -1;
+		}
+		free(dn);
+	}
+
+	free(word);
+	free(id);
+}
+
 /**
  * dictionary_lookup_list() - get list of matching words in the dictionary.
  *
@@ -159,7 +297,16 @@ const char * dictionary_get_lang(Dictionary dict)
  */
 Dict_node * dictionary_lookup_list(const Dictionary dict, const char *s)
 {
-	return dict->lookup_list(dict, s);
+	Memo_entry *me = memo_entry(dict, s);
+	if (NULL == me) return dict->lookup_list(dict, s);
+
+	if (!me->dn_valid && (-1 != me->exists))
+	{
+		me->dn = dict->lookup_list(dict, s);
+		me->dn_valid = true;
+		me->exists = (NULL != me->dn) ? 1 : -1;
+	}
+	return dict_node_copy_list(me->dn);
 }
 
 Dict_node * dictionary_lookup_wild(const Dictionary dict, const char *s)
@@ -174,7 +321,12 @@ void free_lookup_list(const Dictionary dict, Dict_node *llist)
 
 bool dict_has_word(const Dictionary dict, const char *s)
 {
-	return dict->exists_lookup(dict, s);
+	Memo_entry *me = memo_entry(dict, s);
+	if (NULL == me) return dict->exists_lookup(dict, s);
+
+	if (0 == me->exists)
+		me->exists = dict->exists_lookup(dict, s) ? 1 : -1;
+	return (1 == me->exists);
 }
 
 /**
@@ -340,6 +492,16 @@ void dictionary_delete(Dictionary dict)
 
 	condesc_delete(dict);
 
+	if (verbosity >= D_USER_INFO)
+	{
+		disjunct_cache_print_stats(dict->disjunct_cache);
+		token_cache_print_stats(dict->token_cache);
+		spell_guess_print_stats(dict->spell_guess);
+	}
+	disjunct_cache_delete(dict->disjunct_cache);
+	token_cache_delete(dict->token_cache);
+	spell_guess_delete(dict->spell_guess);
+
 	if (dict->close) dict->close(dict);
 
 	pp_knowledge_close(dict->base_knowledge);
@@ -357,6 +519,7 @@ void dictionary_delete(Dictionary dict)
 	free_regexs(dict->regex_root);
 	free_anysplit(dict);
 	free_Word_file(dict->word_file_header);
+	free_Word_file(dict->include_file_header);
 	free_dictionary_root(dict);
 
 	/* Free sentence generation stuff. */
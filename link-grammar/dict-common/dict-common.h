@@ -47,6 +47,8 @@ static const int UNINITIALIZED_MAX_DISJUNCTS = INT_MAX;
 
 /* Forward decls */
 typedef struct Afdict_class_struct Afdict_class;
+typedef struct Dict_binary_s Dict_binary;
+typedef struct Word_index_s Word_index;
 typedef struct Regex_node_s Regex_node;
 
 /* The regexes are stored as a linked list of the following nodes. */
@@ -60,6 +62,8 @@ struct Regex_node_s
 	                    takes care of all matching.
 	                  */
 	Regex_node *next;
+	Regex_node *screen; /* Combined regex of a block of nodes starting
+	                       at this one, or NULL (see regex-morph.c) */
 	bool neg;        /* Negate the match */
 	int capture_group;  /* Capture group number (-1 if none) for ovector */
 };
@@ -74,6 +78,7 @@ static inline Regex_node *regex_new(const char *name, const char *pattern)
 	rn->neg = false;
 	rn->capture_group = -1;
 	rn->next = NULL;
+	rn->screen = NULL;
 
 	return rn;
 }
@@ -188,15 +193,28 @@ struct Dictionary_s
 	Dict_node* (*lookup_wild)(Dictionary, const char*);
 	void (*free_lookup)(Dictionary, Dict_node*);
 	bool (*exists_lookup)(Dictionary, const char*);
+	bool (*lookup_bulk)(Dictionary, const char**, size_t, Dict_node**);
 
 	void (*clear_cache)(Dictionary);
 	void (*close)(Dictionary);
 
 	String_set *    string_set;        /* Set of link names in the dictionary */
 	Word_file *     word_file_header;
+	Word_file *     include_file_header; /* #include'd dictionary files */
+	Word_index *    word_index;        /* Hash index of the words */
+	Dict_binary *   shared_image;      /* Shared dictionary (if used) */
 	ConTable        contable;
 	Pool_desc *     Exp_pool;
 
+	/* Disjuncts of frequently used expressions (NULL if disabled). */
+	struct Disjunct_cache_s * disjunct_cache;
+
+	/* Tokenization of frequently used words (NULL if disabled). */
+	struct Token_cache_s * token_cache;
+
+	/* Cached spell-guess suggestions (NULL if spell guessing is disabled). */
+	struct Spell_guess_s * spell_guess;
+
 	/* Post-processing */
 	pp_knowledge  * base_knowledge;    /* Core post-processing rules */
 	pp_knowledge  * hpsg_knowledge;    /* Head-Phrase Structure rules */
@@ -222,6 +240,9 @@ bool dictionary_generation_request(const Dictionary);
  * and pretty much no one else. If you are not the tokenizer, you
  * probably don't need these. */
 bool dict_has_word(const Dictionary dict, const char *);
+void dict_memo_start(const Dictionary);
+void dict_memo_end(const Dictionary);
+void dict_memo_prefetch(const Dictionary, const char **, size_t);
 
 static inline const char *subscript_mark_str(void)
 {
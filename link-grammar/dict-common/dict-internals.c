@@ -43,3 +43,20 @@ void dict_node_free_lookup(Dictionary dict, Dict_node* llist)
 {
 	dict_node_free_list(llist);
 }
+
+/* Copy a list of Dict_nodes. The strings and expressions are shared. */
+Dict_node * dict_node_copy_list(const Dict_node *llist)
+{
+	Dict_node *head = NULL;
+	Dict_node **tail = &head;
+
+	for (; NULL != llist; llist = llist->right)
+	{
+		*tail = dict_node_new();
+		(*tail)->string = llist->string;
+		(*tail)->exp = llist->exp;
+		tail = &(*tail)->right;
+	}
+
+	return head;
+}
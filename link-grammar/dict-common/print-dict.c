@@ -822,7 +822,7 @@ static char *display_disjuncts(Dictionary dict, const Dict_node *dn,
 		                                      max_cost, NULL);
 
 		unsigned int dnum0 = count_disjuncts(d);
-		unsigned int dnum1 = dnum0 - eliminate_duplicate_disjuncts(d, false);
+		unsigned int dnum1 = dnum0 - eliminate_duplicate_disjuncts(dummy_sent, d, false);
 
 		if ((flags != NULL) && (strchr(flags, 'm') != NULL))
 		{
@@ -88,6 +88,9 @@ typedef struct {
 #define ALLOCTE_MATCH_DATA(var) \
 	regmatch_t mem_##var[MAX_CAPTURE_GROUPS]; regmatch_t *var = mem_##var
 
+/* POSIX regex has no non-capturing groups. */
+#define SCREEN_GROUP_START "("
+
 /**
  * Compile the given regex..
  * Return \c true on success, \c false otherwise.
@@ -110,10 +113,13 @@ static bool reg_comp(Regex_node *rn)
 
 	if (rc != 0)
 	{
-		char errbuf[ERRBUFFLEN];
-		regerror(rc, &re->re_code, errbuf, ERRBUFFLEN);
-		prt_error("Error: Failed to compile regex: \"%s\" (pattern \"%s\"): %s "
-		          "(code %d)\n", rn->name, rn->pattern, errbuf, rc);
+		if (rn->name != NULL) /* Block screens are silently discarded. */
+		{
+			char errbuf[ERRBUFFLEN];
+			regerror(rc, &re->re_code, errbuf, ERRBUFFLEN);
+			prt_error("Error: Failed to compile regex: \"%s\" (pattern \"%s\"): "
+			          "%s (code %d)\n", rn->name, rn->pattern, errbuf, rc);
+		}
 		free(re);
 		return false;
 	}
@@ -204,6 +210,8 @@ static pcre2_match_data* alloc_match_data(void)
 
 #define ALLOCTE_MATCH_DATA(var) pcre2_match_data *var = alloc_match_data();
 
+#define SCREEN_GROUP_START "(?:"
+
 static bool reg_comp(Regex_node *rn)
 {
 	reg_info *re = rn->re = malloc(sizeof(reg_info));
@@ -223,11 +231,14 @@ static bool reg_comp(Regex_node *rn)
 	}
 
 	/* We have an error. */
-	PCRE2_UCHAR errbuf[ERRBUFFLEN];
-	pcre2_get_error_message(rc, errbuf, ERRBUFFLEN);
-	prt_error("Error: Failed to compile regex: \"%s\" (pattern \"%s\": %s "
-	          "(code %d) at %d\n",
-	          rn->name, rn->pattern, errbuf, rc, (int)erroffset);
+	if (rn->name != NULL) /* Block screens are silently discarded. */
+	{
+		PCRE2_UCHAR errbuf[ERRBUFFLEN];
+		pcre2_get_error_message(rc, errbuf, ERRBUFFLEN);
+		prt_error("Error: Failed to compile regex: \"%s\" (pattern \"%s\": %s "
+		          "(code %d) at %d\n",
+		          rn->name, rn->pattern, errbuf, rc, (int)erroffset);
+	}
 	free(re);
 	return false;
 }
@@ -281,6 +292,8 @@ static void reg_free(Regex_node *rn)
 #define ALLOCTE_MATCH_DATA(var) \
 	std::cmatch mem_##var; std::cmatch *var = &mem_##var
 
+#define SCREEN_GROUP_START "(?:"
+
 static bool reg_comp(Regex_node *rn)
 {
 	rn->re = new reg_info;
@@ -291,8 +304,11 @@ static bool reg_comp(Regex_node *rn)
 	}
 	catch (const std::regex_error& e)
 	{
-		prt_error("Error: Failed to compile regex \"%s\" (pattern \"%s\"): %s "
-		          "(code %d)\n", rn->pattern, rn->name, e.what(), e.code());
+		if (rn->name != NULL) /* Block screens are silently discarded. */
+		{
+			prt_error("Error: Failed to compile regex \"%s\" (pattern \"%s\"): "
+			          "%s (code %d)\n", rn->pattern, rn->name, e.what(), e.code());
+		}
 		delete (reg_info *)rn->re;
 		return false;
 	}
@@ -376,16 +392,131 @@ static bool check_capture_group(const Regex_node *rn)
 	return rc;
 }
 
+/* ============================== Block screens ============================ */
+
+/*
+ * Most of the words that get to the regex list don't match any of its
+ * patterns, and matching them one by one costs a regex scan per pattern.
+ * So blocks of consecutive patterns are also combined into "screens",
+ * each one an alternation of the patterns of its block. If the screen
+ * doesn't match the word, no pattern in its block does, and the whole
+ * block is skipped in one scan. Else the patterns of the block are
+ * matched one by one as before, so the first-match order and the negated
+ * patterns keep their meaning.
+ *
+ * The screen of a block is kept at its first node, as an unlinked
+ * Regex_node with a NULL name whose "next" is the node after the block.
+ */
+#define SCREEN_BLOCK_SIZE 8
+
+/**
+ * Return \c true if the pattern means the same inside an alternation.
+ * Back-references and named groups would change their meaning (or
+ * clash) when the groups of the other patterns are added, and a few
+ * PCRE2 constructs are only valid at the start of a pattern. Rejecting
+ * more than needed just leaves the pattern out of the screens.
+ */
+static bool is_screenable(const char *pattern)
+{
+	for (const char *p = pattern; *p != '\0'; p++)
+	{
+		if (p[0] == '\\')
+		{
+			if ((p[1] >= '0' && p[1] <= '9') || (p[1] == 'g') ||
+			    (p[1] == 'k') || (p[1] == 'Q'))
+				return false;
+			if (p[1] != '\0') p++;
+			continue;
+		}
+		if ((p[0] == '(') && ((p[1] == '*') || (p[1] == '?' &&
+		    ((p[2] == '<') || (p[2] == 'P') || (p[2] == '\'')))))
+			return false;
+	}
+
+	return true;
+}
+
+static void free_screen(Regex_node *rn)
+{
+	Regex_node *screen = rn->screen;
+
+	reg_free(screen);
+	free(screen->pattern);
+	free(screen);
+	rn->screen = NULL;
+}
+
+/**
+ * Combine blocks of up to SCREEN_BLOCK_SIZE consecutive patterns of the
+ * given regex list into screens. A block ends early at a pattern that
+ * cannot be combined. Blocks of a single pattern don't get a screen,
+ * and neither do blocks whose combined pattern fails to compile (they
+ * are then just matched one pattern at a time).
+ */
+static void compile_screens(Regex_node *rn)
+{
+	while (rn != NULL)
+	{
+		if (rn->screen != NULL)
+		{
+			rn = rn->screen->next; /* Already done. */
+			continue;
+		}
+
+		Regex_node *end = rn;
+		int n = 0;
+		for (; (end != NULL) && (n < SCREEN_BLOCK_SIZE); end = end->next, n++)
+		{
+			if ((end->screen != NULL) || !is_screenable(end->pattern)) break;
+		}
+
+		if (n < 2)
+		{
+			rn = (n == 0) ? rn->next : end;
+			continue;
+		}
+
+		dyn_str *pattern = dyn_str_new();
+		for (Regex_node *b = rn; b != end; b = b->next)
+		{
+			if (b != rn) dyn_strcat(pattern, "|");
+			dyn_strcat(pattern, SCREEN_GROUP_START);
+			dyn_strcat(pattern, b->pattern);
+			dyn_strcat(pattern, ")");
+		}
+
+		Regex_node *screen = regex_new(NULL, dyn_str_value(pattern));
+		dyn_str_delete(pattern);
+
+		if (reg_comp(screen))
+		{
+			screen->next = end;
+			rn->screen = screen;
+		}
+		else
+		{
+			lgdebug(+D_USER_FILES, "Regex \"%s\": Cannot combine a block of %d "
+			        "patterns\n", rn->name, n);
+			free(screen->pattern);
+			free(screen);
+		}
+
+		rn = end;
+	}
+}
+
 /* ============================== Internal API ============================= */
 
 /**
- * Compile all the given regexs.
+ * Compile all the given regexs, and their block screens.
  * @param rn Regex list
  * @param dict Validate that the pattern is in the given dict.
  * @retrun \c true on success, else \c false.
  */
 bool compile_regexs(Regex_node *rn, Dictionary dict)
 {
+	Regex_node *rn_list = rn;
+
 	while (rn != NULL)
 	{
 		/* If rn->re non-null, assume compiled already. */
@@ -408,6 +539,8 @@ bool compile_regexs(Regex_node *rn, Dictionary dict)
 		}
 		rn = rn->next;
 	}
+
+	compile_screens(rn_list);
 	return true;
 }
 
@@ -425,6 +558,12 @@ const char *match_regex(const Regex_node *rn, const char *s)
 	{
 		if (rn->re == NULL) continue; // Make sure the regex has been compiled.
 
+		if ((rn->screen != NULL) && !reg_match(s, rn->screen, re_md))
+		{
+			rn = rn->screen->next; /* No match in this block. */
+			continue;
+		}
+
 		if (reg_match(s, rn, re_md))
 		{
 			lgdebug(+D_MRE, "%s%s %s\n", &"!"[!rn->neg], rn->name, s);
@@ -458,6 +597,12 @@ const char *matchspan_regex(Regex_node *rn, const char *s,
 	{
 		if (rn->re == NULL) continue; // Make sure the regex has been compiled.
 
+		if ((rn->screen != NULL) && !reg_match(s, rn->screen, re_md))
+		{
+			rn = rn->screen->next; /* No match in this block. */
+			continue;
+		}
+
 		if (reg_match(s, rn, re_md))
 		{
 			lgdebug(+D_MRE, "%s%s %s\n", &"!"[!rn->neg], rn->name, s);
@@ -504,6 +649,7 @@ void free_regexs(Regex_node *rn)
 			reg_free(rn);
 			rn->re = NULL;
 		}
+		if (rn->screen != NULL) free_screen(rn);
 		free(rn->pattern);
 		free(rn);
 
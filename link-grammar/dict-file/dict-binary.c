@@ -0,0 +1,1629 @@
+/*************************************************************************/
+/* Copyright (c) 2026 The Link Grammar project                           */
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+/*
+ * Precompiled dictionary.
+ *
+ * Reading the text dictionary (4.0.dict and its word files) takes most
+ * of the dictionary creation time. The precompiled dictionary is a
+ * binary image of the result of read_dictionary(): the string table, the
+ * expressions, the word tree, and the other things that are collected
+ * while reading the text dictionary. It contains indices instead of
+ * pointers, so it can be mapped into memory as is and then converted
+ * to the usual dictionary structures (which are then used exactly as if
+ * the text dictionary had been read).
+ *
+ * The rest of the dictionary files (affix, regex, post-processing and
+ * dialect) are small and are still read as text.
+ *
+ * The precompiled dictionary records the sizes and modification times
+ * of the text dictionary files it has been compiled from. If any of
+ * them has been changed, it is ignored and the text dictionary is read.
+ * It is also ignored if it has been written by another library version.
+ *
+ * The same image can also be shared by processes, see "Shared
+ * dictionary" below.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#if defined HAVE_MMAP || defined HAVE_SHM_OPEN
+#include <sys/mman.h>
+#endif /* HAVE_MMAP || HAVE_SHM_OPEN */
+#ifdef HAVE_SHM_OPEN
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#if HAVE_STDATOMIC_H
+#include <stdatomic.h>
+#endif /* HAVE_STDATOMIC_H */
+#endif /* HAVE_SHM_OPEN */
+
+#include "connectors.h"
+#include "dict-common/dialect.h"        // exptag_dialect_add
+#include "dict-common/dict-common.h"
+#include "dict-common/dict-internals.h" // dict_node_new
+#include "dict-common/file-utils.h"
+#include "dict-ram/dict-ram.h"          // add_define
+#include "dict-binary.h"
+#include "error.h"
+#include "string-set.h"
+#include "utilities.h"
+#include "word-file.h"
+
+#define DICT_BINARY_MAGIC "LGDICTB"
+#define DICT_BINARY_FORMAT 2
+#define DICT_BINARY_BYTE_ORDER 0x01020304
+#define NULL_INDEX UINT32_MAX
+
+typedef enum
+{
+	SEC_STRING_OFFSET,     /* Offset of each string in SEC_STRING_DATA */
+	SEC_STRING_DATA,       /* NUL-terminated strings */
+	SEC_EXP,               /* In Exp_pool order */
+	SEC_NODE,              /* In pre-order (the root first) */
+	SEC_DEFINE,            /* Name and value string index pairs */
+	SEC_DIALECT_TAG,       /* Name string index, in tag id order */
+	SEC_MACRO_TAG,         /* Name string index, in tag id order */
+	SEC_LENGTH_LIMIT,      /* In definition order */
+	SEC_SOURCE,            /* The text dictionary files */
+	SEC_WORD,              /* Node indices, in tree (alphabetical) order */
+	SEC_WORD_BASE,         /* Base words of SEC_WORD */
+	SEC_WORD_TABLE,        /* Hash table of SEC_WORD_BASE */
+	NUM_SECTIONS
+} section_id;
+
+typedef struct
+{
+	uint32_t offset;       /* From the start of the file */
+	uint32_t count;        /* Number of elements */
+} bin_section;
+
+typedef struct
+{
+	char magic[8];
+	uint32_t byte_order;
+	uint32_t format;
+	char version[16];      /* LINK_VERSION_STRING of the writer */
+	uint32_t file_size;
+	int32_t num_entries;
+	int8_t allow_duplicate_words;
+	int8_t allow_duplicate_idioms;
+	char current_idiom[IDIOM_LINK_SZ];
+	char unused[2];
+	bin_section section[NUM_SECTIONS];
+} bin_header;
+
+typedef struct
+{
+	uint8_t type;
+	uint8_t tag_type;      /* The multi flag, for connectors */
+	uint8_t dir;           /* Connectors only */
+	uint8_t farthest_word; /* Connectors only */
+	uint32_t tag_id;
+	uint32_t pos;
+	float cost;
+	uint32_t operand_first; /* Exp index, or the connector string index */
+	uint32_t operand_next;  /* Exp index */
+} bin_exp;
+
+typedef struct
+{
+	uint32_t string;
+	uint32_t exp;
+	uint32_t left;
+	uint32_t right;
+	uint32_t file;         /* NULL_INDEX if the word is from the dict file */
+} bin_node;
+
+typedef struct
+{
+	int32_t length_limit;
+	uint32_t exp;
+	uint32_t word;
+} bin_length_limit;
+
+/* The words of a given base word (the word without its subscript) are
+ * adjacent in the tree order, so they are a range of SEC_WORD. Used for
+ * lookups in a shared dictionary, which doesn't have a word tree. */
+typedef struct
+{
+	uint32_t hash;         /* dict_base_word_hash() */
+	uint32_t base_len;
+	uint32_t first;        /* Index in SEC_WORD */
+	uint32_t count;
+} bin_base_word;
+
+typedef enum { SRC_DICT, SRC_INCLUDE, SRC_WORD_FILE } source_kind;
+
+typedef struct
+{
+	uint32_t name;
+	uint32_t kind;
+	int64_t size;
+	int64_t mtime;
+} bin_source;
+
+static const size_t element_size[NUM_SECTIONS] =
+{
+	[SEC_STRING_OFFSET] = sizeof(uint32_t),
+	[SEC_STRING_DATA] = 1,
+	[SEC_EXP] = sizeof(bin_exp),
+	[SEC_NODE] = sizeof(bin_node),
+	[SEC_DEFINE] = 2 * sizeof(uint32_t),
+	[SEC_DIALECT_TAG] = sizeof(uint32_t),
+	[SEC_MACRO_TAG] = sizeof(uint32_t),
+	[SEC_LENGTH_LIMIT] = sizeof(bin_length_limit),
+	[SEC_SOURCE] = sizeof(bin_source),
+	[SEC_WORD] = sizeof(uint32_t),
+	[SEC_WORD_BASE] = sizeof(bin_base_word),
+	[SEC_WORD_TABLE] = sizeof(uint32_t), /* Index in SEC_WORD_BASE plus 1 */
+};
+
+#define SECTION_ALIGNMENT 8
+
+struct Dict_binary_s
+{
+	const char *data;
+	size_t size;
+	bool mapped;
+	Exp **exp;             /* Shared dictionary: Its expressions */
+};
+
+static void set_version(char *version, size_t size)
+{
+	memset(version, 0, size);
+	strncpy(version, LINK_VERSION_STRING, size - 1);
+}
+
+/**
+ * Get the size and the modification time of the dictionary file \p name.
+ * @return \c false if it cannot be opened.
+ */
+static bool source_stat(const char *name, int64_t *size, int64_t *mtime)
+{
+	/* 'b' - see get_file_contents(). */
+	FILE *fp = dictopen(name, "rb");
+	if (NULL == fp) return false;
+
+	struct stat buf;
+	bool rc = (0 == fstat(fileno(fp), &buf));
+	fclose(fp);
+	if (!rc) return false;
+
+	*size = (int64_t)buf.st_size;
+	*mtime = (int64_t)buf.st_mtime;
+	return true;
+}
+
+/* ======================================================================= */
+/* Writing. */
+
+typedef struct
+{
+	const void *ptr;
+	uint32_t index;
+} ptr_index;
+
+static int ptr_index_cmp(const void *a, const void *b)
+{
+	uintptr_t pa = (uintptr_t)((const ptr_index *)a)->ptr;
+	uintptr_t pb = (uintptr_t)((const ptr_index *)b)->ptr;
+
+	return (pa > pb) - (pa < pb);
+}
+
+typedef struct
+{
+	ptr_index *pi;
+	size_t num;
+	size_t size;
+} ptr_map;
+
+static void ptr_map_add(ptr_map *pm, const void *ptr)
+{
+	if (NULL == ptr) return;
+
+	if (pm->num == pm->size)
+	{
+		pm->size = (0 == pm->size) ? 1024 : pm->size * 2;
+		pm->pi = realloc(pm->pi, pm->size * sizeof(*pm->pi));
+	}
+	pm->pi[pm->num].ptr = ptr;
+	pm->pi[pm->num].index = (uint32_t)pm->num;
+	pm->num++;
+}
+
+/**
+ * Sort the map for ptr_map_find(). If \p dedup, remove duplicate
+ * pointers and index the remaining ones by their sorted order.
+ */
+static void ptr_map_sort(ptr_map *pm, bool dedup)
+{
+	qsort(pm->pi, pm->num, sizeof(*pm->pi), ptr_index_cmp);
+	if (!dedup) return;
+
+	size_t n = 0;
+	for (size_t i = 0; i < pm->num; i++)
+	{
+		if ((0 < n) && (pm->pi[n-1].ptr == pm->pi[i].ptr)) continue;
+		pm->pi[n].ptr = pm->pi[i].ptr;
+		pm->pi[n].index = (uint32_t)n;
+		n++;
+	}
+	pm->num = n;
+}
+
+static uint32_t ptr_map_find(const ptr_map *pm, const void *ptr)
+{
+	if (NULL == ptr) return NULL_INDEX;
+
+	ptr_index key = { .ptr = ptr };
+	const ptr_index *pi =
+		bsearch(&key, pm->pi, pm->num, sizeof(*pm->pi), ptr_index_cmp);
+	assert(NULL != pi, "Precompiled dictionary: Unknown pointer");
+
+	return pi->index;
+}
+
+typedef struct
+{
+	char *buf;
+	size_t size;
+	size_t alloced;
+	section_id current;
+} out_buf;
+
+static void *out_append(out_buf *ob, const void *data, size_t size)
+{
+	if (ob->size + size > ob->alloced)
+	{
+		while (ob->size + size > ob->alloced)
+			ob->alloced = (0 == ob->alloced) ? 64 * 1024 : ob->alloced * 2;
+		ob->buf = realloc(ob->buf, ob->alloced);
+	}
+
+	void *p = ob->buf + ob->size;
+	if (NULL == data)
+		memset(p, 0, size);
+	else
+		memcpy(p, data, size);
+	ob->size += size;
+
+	return p;
+}
+
+static void section_begin(out_buf *ob, section_id sec)
+{
+	size_t pad = (SECTION_ALIGNMENT - ob->size % SECTION_ALIGNMENT) %
+	             SECTION_ALIGNMENT;
+	out_append(ob, NULL, pad);
+
+	ob->current = sec;
+	((bin_header *)ob->buf)->section[sec].offset = (uint32_t)ob->size;
+}
+
+static void section_add(out_buf *ob, const void *element)
+{
+	out_append(ob, element, element_size[ob->current]);
+	((bin_header *)ob->buf)->section[ob->current].count++;
+}
+
+static void section_add_index(out_buf *ob, uint32_t index)
+{
+	section_add(ob, &index);
+}
+
+static size_t count_nodes(const Dict_node *dn)
+{
+	if (NULL == dn) return 0;
+	return 1 + count_nodes(dn->left) + count_nodes(dn->right);
+}
+
+static void collect_node_strings(ptr_map *strings, const Dict_node *dn)
+{
+	if (NULL == dn) return;
+
+	ptr_map_add(strings, dn->string);
+	ptr_map_add(strings, dn->file);
+	collect_node_strings(strings, dn->left);
+	collect_node_strings(strings, dn->right);
+}
+
+/**
+ * Convert the word tree to an array in pre-order. Also list the node
+ * indices in the tree order in \p word.
+ * @return The index of \p dn in \p node.
+ */
+static uint32_t write_nodes(bin_node *node, size_t *num,
+                            uint32_t *word, size_t *num_words,
+                            const Dict_node *dn,
+                            const ptr_map *strings, const ptr_map *exps)
+{
+	if (NULL == dn) return NULL_INDEX;
+
+	uint32_t i = (uint32_t)(*num)++;
+	node[i].string = ptr_map_find(strings, dn->string);
+	node[i].exp = ptr_map_find(exps, dn->exp);
+	node[i].file = ptr_map_find(strings, dn->file);
+	node[i].left =
+		write_nodes(node, num, word, num_words, dn->left, strings, exps);
+	word[(*num_words)++] = i;
+	node[i].right =
+		write_nodes(node, num, word, num_words, dn->right, strings, exps);
+
+	return i;
+}
+
+static const bin_base_word *
+base_word_find(const bin_base_word *base, const uint32_t *table,
+               size_t table_size, const char *(*first_word)(const void *, uint32_t),
+               const void *arg, const char *s)
+{
+	if (0 == table_size) return NULL;
+
+	size_t len;
+	uint32_t h = dict_base_word_hash(s, &len);
+	size_t mask = table_size - 1;
+
+	for (size_t i = h & mask; ; i = (i + 1) & mask)
+	{
+		if (0 == table[i]) return NULL;
+
+		const bin_base_word *bw = &base[table[i] - 1];
+		if ((bw->hash == h) && (bw->base_len == len) &&
+		    (0 == memcmp(first_word(arg, bw->first), s, len)))
+			return bw;
+	}
+}
+
+typedef struct
+{
+	const Dict_node **node;    /* In tree order */
+} tree_words;
+
+static const char *tree_word(const void *arg, uint32_t i)
+{
+	return ((const tree_words *)arg)->node[i]->string;
+}
+
+static void collect_tree_order(const Dict_node **node, size_t *n,
+                               const Dict_node *dn)
+{
+	for (; NULL != dn; dn = dn->right)
+	{
+		collect_tree_order(node, n, dn->left);
+		node[(*n)++] = dn;
+	}
+}
+
+/**
+ * Write the word index sections (SEC_WORD_BASE and SEC_WORD_TABLE).
+ * They are left empty if the words of some base word are not adjacent
+ * in the tree order (then the dictionary cannot be shared).
+ */
+static void write_word_index(out_buf *ob, const Dict_node *root,
+                             size_t num_nodes)
+{
+	tree_words tw = { .node = malloc(num_nodes * sizeof(*tw.node) + 1) };
+	size_t n = 0;
+	collect_tree_order(tw.node, &n, root);
+
+	bin_base_word *base = malloc(num_nodes * sizeof(*base) + 1);
+	size_t num_base = 0;
+	for (size_t i = 0; i < num_nodes; i++)
+	{
+		size_t len;
+		uint32_t h = dict_base_word_hash(tw.node[i]->string, &len);
+
+		if (0 < num_base)
+		{
+			bin_base_word *prev = &base[num_base - 1];
+			if ((prev->hash == h) && (prev->base_len == len) &&
+			    (0 == memcmp(tw.node[prev->first]->string,
+			                 tw.node[i]->string, len)))
+			{
+				prev->count++;
+				continue;
+			}
+		}
+
+		base[num_base++] =
+			(bin_base_word){ .hash = h, .base_len = (uint32_t)len,
+			                 .first = (uint32_t)i, .count = 1 };
+	}
+
+	size_t table_size = 1;
+	while (table_size < 2 * num_base) table_size *= 2;
+	uint32_t *table = calloc(table_size, sizeof(*table));
+
+	for (size_t b = 0; b < num_base; b++)
+	{
+		const bin_base_word *bw = &base[b];
+
+		if (NULL != base_word_find(base, table, table_size, tree_word, &tw,
+		                           tw.node[bw->first]->string))
+		{
+			lgdebug(D_USER_FILES, "Debug: Precompiled dictionary: "
+			        "No word index (\"%s\")\n", tw.node[bw->first]->string);
+			num_base = 0;
+			table_size = 0;
+			break;
+		}
+
+		size_t i = bw->hash & (table_size - 1);
+		while (0 != table[i]) i = (i + 1) & (table_size - 1);
+		table[i] = (uint32_t)(b + 1);
+	}
+
+	section_begin(ob, SEC_WORD_BASE);
+	for (size_t b = 0; b < num_base; b++)
+		section_add(ob, &base[b]);
+
+	section_begin(ob, SEC_WORD_TABLE);
+	for (size_t i = 0; i < table_size; i++)
+		section_add_index(ob, table[i]);
+
+	free(table);
+	free(base);
+	free(tw.node);
+}
+
+static bool add_source(out_buf *ob, const ptr_map *strings, const char *name,
+                       source_kind kind)
+{
+	bin_source src = { .kind = kind };
+
+	if (!source_stat(name, &src.size, &src.mtime))
+	{
+		prt_error("Error: Cannot open dictionary file \"%s\".\n", name);
+		return false;
+	}
+	src.name = ptr_map_find(strings, name);
+	section_add(ob, &src);
+
+	return true;
+}
+
+/**
+ * Build the precompiled form of the dictionary \p dict in \p image.
+ * It must be called just after read_dictionary(), because some of the
+ * things that are collected during reading are released later.
+ * @return \c true on success, \c false on error.
+ */
+static bool dict_binary_image(Dictionary dict, out_buf *image)
+{
+	if (IS_GENERATION(dict))
+	{
+		prt_error("Error: Cannot precompile a dictionary in generation mode.\n");
+		return false;
+	}
+
+	ptr_map exps = { 0 };
+	ptr_map strings = { 0 };
+	out_buf ob = { 0 };
+	bin_node *node = NULL;
+	uint32_t *word = NULL;
+	bool rc = false;
+
+	/* Index the expressions by their pool order, so they can be recreated
+	 * in the same order (which also keeps the order of the connector
+	 * descriptors). */
+	Pool_location loc = { 0 };
+	const Exp *e;
+	while (NULL != (e = pool_next(dict->Exp_pool, &loc)))
+	{
+		ptr_map_add(&exps, e);
+		if (CONNECTOR_type == e->type)
+			ptr_map_add(&strings, e->condesc->more->string);
+	}
+	ptr_map_sort(&exps, false);
+
+	collect_node_strings(&strings, dict->root);
+	for (unsigned int i = 0; i < dict->dfine.size; i++)
+	{
+		ptr_map_add(&strings, dict->dfine.name[i]);
+		ptr_map_add(&strings, dict->dfine.value[i]);
+	}
+	for (unsigned int i = 1; i <= dict->dialect_tag.num; i++)
+		ptr_map_add(&strings, dict->dialect_tag.name[i]);
+	if (NULL != dict->macro_tag)
+	{
+		for (unsigned int i = 0; i < dict->macro_tag->num; i++)
+			ptr_map_add(&strings, dict->macro_tag->name[i]);
+	}
+	const length_limit_def_t *lld;
+	for (lld = dict->contable.length_limit_def; NULL != lld; lld = lld->next)
+		ptr_map_add(&strings, lld->defword);
+	ptr_map_add(&strings, dict->name);
+	for (const Word_file *wf = dict->include_file_header; NULL != wf; wf = wf->next)
+		ptr_map_add(&strings, wf->file);
+	for (const Word_file *wf = dict->word_file_header; NULL != wf; wf = wf->next)
+		ptr_map_add(&strings, wf->file);
+	ptr_map_sort(&strings, true);
+
+	/* Header - filled in below. */
+	out_append(&ob, NULL, sizeof(bin_header));
+
+	section_begin(&ob, SEC_STRING_OFFSET);
+	uint32_t str_offset = 0;
+	for (size_t i = 0; i < strings.num; i++)
+	{
+		section_add_index(&ob, str_offset);
+		str_offset += (uint32_t)strlen(strings.pi[i].ptr) + 1;
+	}
+
+	section_begin(&ob, SEC_STRING_DATA);
+	for (size_t i = 0; i < strings.num; i++)
+	{
+		const char *s = strings.pi[i].ptr;
+		size_t len = strlen(s) + 1;
+		out_append(&ob, s, len);
+		((bin_header *)ob.buf)->section[SEC_STRING_DATA].count += (uint32_t)len;
+	}
+
+	section_begin(&ob, SEC_EXP);
+	loc = (Pool_location){ 0 };
+	while (NULL != (e = pool_next(dict->Exp_pool, &loc)))
+	{
+		bin_exp be = { .type = (uint8_t)e->type, .pos = e->pos };
+
+		be.cost = e->cost;
+		be.operand_next = ptr_map_find(&exps, e->operand_next);
+		if (CONNECTOR_type == e->type)
+		{
+			be.tag_type = (uint8_t)e->multi;
+			be.dir = (uint8_t)e->dir;
+			be.farthest_word = e->farthest_word;
+			be.operand_first =
+				ptr_map_find(&strings, e->condesc->more->string);
+		}
+		else
+		{
+			be.tag_type = (uint8_t)e->tag_type;
+			be.tag_id = e->tag_id;
+			be.operand_first = ptr_map_find(&exps, e->operand_first);
+		}
+		section_add(&ob, &be);
+	}
+
+	section_begin(&ob, SEC_NODE);
+	size_t num_nodes = count_nodes(dict->root);
+	node = malloc(num_nodes * sizeof(*node) + 1);
+	word = malloc(num_nodes * sizeof(*word) + 1);
+	size_t n = 0, num_words = 0;
+	write_nodes(node, &n, word, &num_words, dict->root, &strings, &exps);
+	for (size_t i = 0; i < num_nodes; i++)
+		section_add(&ob, &node[i]);
+
+	section_begin(&ob, SEC_WORD);
+	for (size_t i = 0; i < num_words; i++)
+		section_add_index(&ob, word[i]);
+	write_word_index(&ob, dict->root, num_nodes);
+
+	section_begin(&ob, SEC_DEFINE);
+	for (unsigned int i = 0; i < dict->dfine.size; i++)
+	{
+		uint32_t nv[2] =
+		{
+			ptr_map_find(&strings, dict->dfine.name[i]),
+			ptr_map_find(&strings, dict->dfine.value[i]),
+		};
+		section_add(&ob, nv);
+	}
+
+	section_begin(&ob, SEC_DIALECT_TAG);
+	for (unsigned int i = 1; i <= dict->dialect_tag.num; i++)
+		section_add_index(&ob, ptr_map_find(&strings, dict->dialect_tag.name[i]));
+
+	section_begin(&ob, SEC_MACRO_TAG);
+	if (NULL != dict->macro_tag)
+	{
+		for (unsigned int i = 0; i < dict->macro_tag->num; i++)
+			section_add_index(&ob, ptr_map_find(&strings, dict->macro_tag->name[i]));
+	}
+
+	section_begin(&ob, SEC_LENGTH_LIMIT);
+	for (lld = dict->contable.length_limit_def; NULL != lld; lld = lld->next)
+	{
+		bin_length_limit bll =
+		{
+			.length_limit = lld->length_limit,
+			.exp = ptr_map_find(&exps, lld->defexp),
+			.word = ptr_map_find(&strings, lld->defword),
+		};
+		section_add(&ob, &bll);
+	}
+
+	section_begin(&ob, SEC_SOURCE);
+	if (!add_source(&ob, &strings, dict->name, SRC_DICT)) goto cleanup;
+	for (const Word_file *wf = dict->include_file_header; NULL != wf; wf = wf->next)
+	{
+		if (!add_source(&ob, &strings, wf->file, SRC_INCLUDE)) goto cleanup;
+	}
+	for (const Word_file *wf = dict->word_file_header; NULL != wf; wf = wf->next)
+	{
+		if (!add_source(&ob, &strings, wf->file, SRC_WORD_FILE)) goto cleanup;
+	}
+
+	bin_header *hdr = (bin_header *)ob.buf;
+	memcpy(hdr->magic, DICT_BINARY_MAGIC, sizeof(DICT_BINARY_MAGIC));
+	hdr->byte_order = DICT_BINARY_BYTE_ORDER;
+	hdr->format = DICT_BINARY_FORMAT;
+	set_version(hdr->version, sizeof(hdr->version));
+	hdr->file_size = (uint32_t)ob.size;
+	hdr->num_entries = dict->num_entries;
+	hdr->allow_duplicate_words = dict->allow_duplicate_words;
+	hdr->allow_duplicate_idioms = dict->allow_duplicate_idioms;
+	memcpy(hdr->current_idiom, dict->current_idiom, IDIOM_LINK_SZ);
+
+	lgdebug(D_USER_FILES, "Debug: Precompiled dictionary: %zu bytes, "
+	        "%zu strings, %zu expressions, %zu words\n",
+	        ob.size, strings.num, exps.num, num_nodes);
+	*image = ob;
+	ob.buf = NULL;
+	rc = true;
+
+cleanup:
+	free(word);
+	free(node);
+	free(ob.buf);
+	free(strings.pi);
+	free(exps.pi);
+	return rc;
+}
+
+/**
+ * Write the precompiled form of the dictionary \p dict to \p fp.
+ * See dict_binary_image() for when it can be called.
+ * @return \c true on success, \c false on error.
+ */
+bool dict_binary_write(Dictionary dict, FILE *fp)
+{
+	out_buf ob;
+	if (!dict_binary_image(dict, &ob)) return false;
+
+	bool rc = (ob.size == fwrite(ob.buf, 1, ob.size, fp));
+	if (!rc)
+	{
+		prt_error("Error: Cannot write the precompiled dictionary (%s).\n",
+		          syserror_msg(errno));
+	}
+
+	free(ob.buf);
+	return rc;
+}
+
+/* ======================================================================= */
+/* Reading. */
+
+static const void *section_data(const Dict_binary *db, section_id sec)
+{
+	const bin_header *hdr = (const bin_header *)db->data;
+	return db->data + hdr->section[sec].offset;
+}
+
+static uint32_t section_count(const Dict_binary *db, section_id sec)
+{
+	const bin_header *hdr = (const bin_header *)db->data;
+	return hdr->section[sec].count;
+}
+
+static bool index_ok(uint32_t index, uint32_t num, bool allow_none)
+{
+	return (index < num) || (allow_none && (NULL_INDEX == index));
+}
+
+/**
+ * Check that the expressions (whose indices have already been checked)
+ * don't refer to themselves through operand_first/operand_next chains.
+ * They are in the pool order, in which an operand may come before or
+ * after its expression, and macro expressions have many references,
+ * so this is done by removing unreferenced expressions until none is
+ * left (a cycle is never removed).
+ */
+static bool exps_acyclic(const bin_exp *be, uint32_t num_exps)
+{
+	uint32_t *refs = calloc(num_exps + 1, sizeof(*refs));
+	uint32_t *unref = malloc((num_exps + 1) * sizeof(*unref));
+	uint32_t num_unref = 0;
+	uint32_t num_removed = 0;
+
+	for (uint32_t i = 0; i < num_exps; i++)
+	{
+		if ((CONNECTOR_type != be[i].type) && (NULL_INDEX != be[i].operand_first))
+			refs[be[i].operand_first]++;
+		if (NULL_INDEX != be[i].operand_next)
+			refs[be[i].operand_next]++;
+	}
+	for (uint32_t i = 0; i < num_exps; i++)
+	{
+		if (0 == refs[i]) unref[num_unref++] = i;
+	}
+
+	while (0 < num_unref)
+	{
+		uint32_t i = unref[--num_unref];
+		num_removed++;
+
+		if ((CONNECTOR_type != be[i].type) && (NULL_INDEX != be[i].operand_first))
+		{
+			if (0 == --refs[be[i].operand_first])
+				unref[num_unref++] = be[i].operand_first;
+		}
+		if (NULL_INDEX != be[i].operand_next)
+		{
+			if (0 == --refs[be[i].operand_next])
+				unref[num_unref++] = be[i].operand_next;
+		}
+	}
+
+	free(unref);
+	free(refs);
+	return num_removed == num_exps;
+}
+
+/**
+ * Check that the nodes (whose indices have already been checked) are
+ * a word tree in pre-order, as written by write_nodes(): The children
+ * of a node come after it, and each node but the root is the child of
+ * exactly one node. So there are no cycles and each node is reached
+ * once.
+ */
+static bool word_tree_ok(const bin_node *bn, uint32_t num_nodes)
+{
+	bool *has_parent = calloc(num_nodes + 1, sizeof(*has_parent));
+	bool ok = true;
+
+	for (uint32_t i = 0; ok && (i < num_nodes); i++)
+	{
+		const uint32_t child[] = { bn[i].left, bn[i].right };
+		for (size_t c = 0; c < ARRAY_SIZE(child); c++)
+		{
+			if (NULL_INDEX == child[c]) continue;
+			if ((child[c] <= i) || has_parent[child[c]])
+			{
+				ok = false;
+				break;
+			}
+			has_parent[child[c]] = true;
+		}
+	}
+	for (uint32_t i = 1; ok && (i < num_nodes); i++)
+	{
+		if (!has_parent[i]) ok = false;
+	}
+
+	free(has_parent);
+	return ok;
+}
+
+/**
+ * Check the structure of the precompiled dictionary, so that loading it
+ * cannot fail.
+ * @return NULL if it is valid, else the reason it is not.
+ */
+static const char *dict_binary_invalid(const Dict_binary *db)
+{
+	const bin_header *hdr = (const bin_header *)db->data;
+
+	if (0 != memcmp(hdr->magic, DICT_BINARY_MAGIC, sizeof(DICT_BINARY_MAGIC)))
+		return "Not a precompiled dictionary";
+	if (DICT_BINARY_BYTE_ORDER != hdr->byte_order)
+		return "Different byte order";
+	if (hdr->file_size != db->size)
+		return "Truncated file";
+
+	for (int sec = 0; sec < NUM_SECTIONS; sec++)
+	{
+		const bin_section *s = &hdr->section[sec];
+		if ((0 != s->offset % SECTION_ALIGNMENT) ||
+		    ((uint64_t)s->offset + (uint64_t)s->count * element_size[sec] >
+		     db->size))
+			return "Bad section";
+	}
+
+	const uint32_t num_strings = section_count(db, SEC_STRING_OFFSET);
+	const uint32_t data_size = section_count(db, SEC_STRING_DATA);
+	const char *data = section_data(db, SEC_STRING_DATA);
+	const uint32_t *str_offset = section_data(db, SEC_STRING_OFFSET);
+	if ((0 < data_size) && ('\0' != data[data_size - 1]))
+		return "Bad string table";
+	for (uint32_t i = 0; i < num_strings; i++)
+	{
+		if (str_offset[i] >= data_size) return "Bad string table";
+	}
+
+	const uint32_t num_exps = section_count(db, SEC_EXP);
+	const uint32_t num_dialect_tags = section_count(db, SEC_DIALECT_TAG);
+	const uint32_t num_macro_tags = section_count(db, SEC_MACRO_TAG);
+	const bin_exp *be = section_data(db, SEC_EXP);
+	for (uint32_t i = 0; i < num_exps; i++)
+	{
+		if (!index_ok(be[i].operand_next, num_exps, true))
+			return "Bad expression";
+
+		switch (be[i].type)
+		{
+			case CONNECTOR_type:
+				if (!index_ok(be[i].operand_first, num_strings, false))
+					return "Bad expression";
+				break;
+			case AND_type:
+			case OR_type:
+				if (!index_ok(be[i].operand_first, num_exps, true))
+					return "Bad expression";
+				if ((Exptag_dialect == be[i].tag_type) &&
+				    !index_ok(be[i].tag_id - 1, num_dialect_tags, false))
+					return "Bad expression";
+				if ((Exptag_macro == be[i].tag_type) &&
+				    !index_ok(be[i].tag_id, num_macro_tags, false))
+					return "Bad expression";
+				if (be[i].tag_type > Exptag_macro)
+					return "Bad expression";
+				break;
+			default:
+				return "Bad expression";
+		}
+	}
+	if (!exps_acyclic(be, num_exps)) return "Bad expression";
+
+	const uint32_t num_nodes = section_count(db, SEC_NODE);
+	const bin_node *bn = section_data(db, SEC_NODE);
+	for (uint32_t i = 0; i < num_nodes; i++)
+	{
+		if (!index_ok(bn[i].string, num_strings, false) ||
+		    !index_ok(bn[i].exp, num_exps, false) ||
+		    !index_ok(bn[i].file, num_strings, true) ||
+		    !index_ok(bn[i].left, num_nodes, true) ||
+		    !index_ok(bn[i].right, num_nodes, true))
+			return "Bad word tree";
+	}
+	if (!word_tree_ok(bn, num_nodes)) return "Bad word tree";
+
+	const uint32_t *dfine = section_data(db, SEC_DEFINE);
+	for (uint32_t i = 0; i < 2 * section_count(db, SEC_DEFINE); i++)
+	{
+		if (!index_ok(dfine[i], num_strings, false)) return "Bad #define";
+	}
+
+	const uint32_t *tag = section_data(db, SEC_DIALECT_TAG);
+	for (uint32_t i = 0; i < num_dialect_tags; i++)
+	{
+		if (!index_ok(tag[i], num_strings, false)) return "Bad dialect tag";
+	}
+
+	tag = section_data(db, SEC_MACRO_TAG);
+	for (uint32_t i = 0; i < num_macro_tags; i++)
+	{
+		if (!index_ok(tag[i], num_strings, false)) return "Bad macro tag";
+	}
+
+	const bin_length_limit *bll = section_data(db, SEC_LENGTH_LIMIT);
+	for (uint32_t i = 0; i < section_count(db, SEC_LENGTH_LIMIT); i++)
+	{
+		if (!index_ok(bll[i].exp, num_exps, false) ||
+		    !index_ok(bll[i].word, num_strings, false))
+			return "Bad length limit";
+	}
+
+	const bin_source *src = section_data(db, SEC_SOURCE);
+	for (uint32_t i = 0; i < section_count(db, SEC_SOURCE); i++)
+	{
+		if (!index_ok(src[i].name, num_strings, false) ||
+		    (src[i].kind > SRC_WORD_FILE))
+			return "Bad source file list";
+	}
+
+	const uint32_t num_words = section_count(db, SEC_WORD);
+	const uint32_t *word = section_data(db, SEC_WORD);
+	if (num_words != num_nodes) return "Bad word list";
+	for (uint32_t i = 0; i < num_words; i++)
+	{
+		if (!index_ok(word[i], num_nodes, false)) return "Bad word list";
+	}
+
+	const uint32_t num_base = section_count(db, SEC_WORD_BASE);
+	const bin_base_word *base = section_data(db, SEC_WORD_BASE);
+	for (uint32_t i = 0; i < num_base; i++)
+	{
+		if ((0 == base[i].count) || (base[i].first >= num_words) ||
+		    (base[i].count > num_words - base[i].first))
+			return "Bad word index";
+	}
+
+	const uint32_t table_size = section_count(db, SEC_WORD_TABLE);
+	const uint32_t *table = section_data(db, SEC_WORD_TABLE);
+	if ((0 != (table_size & (table_size - 1))) ||
+	    ((0 == table_size) && (0 != num_base)))
+		return "Bad word index";
+	uint32_t num_empty = 0;
+	for (uint32_t i = 0; i < table_size; i++)
+	{
+		if (table[i] > num_base) return "Bad word index";
+		if (0 == table[i]) num_empty++;
+	}
+	/* Lookups stop at an empty slot. */
+	if ((0 != table_size) && (0 == num_empty)) return "Bad word index";
+
+	return NULL;
+}
+
+static const char *bin_string(const Dict_binary *db, uint32_t index)
+{
+	const uint32_t *str_offset = section_data(db, SEC_STRING_OFFSET);
+	const char *data = section_data(db, SEC_STRING_DATA);
+
+	return data + str_offset[index];
+}
+
+/**
+ * Check whether the text dictionary files have been changed since the
+ * precompiled dictionary has been written.
+ */
+static bool dict_binary_stale(const Dict_binary *db, const char *dict_name)
+{
+	const bin_source *src = section_data(db, SEC_SOURCE);
+
+	for (uint32_t i = 0; i < section_count(db, SEC_SOURCE); i++)
+	{
+		/* The dict file may have been referred to by another path. */
+		const char *name = (SRC_DICT == src[i].kind) ?
+			dict_name : bin_string(db, src[i].name);
+		int64_t size, mtime;
+
+		if (!source_stat(name, &size, &mtime) ||
+		    (size != src[i].size) || (mtime != src[i].mtime))
+		{
+			if (verbosity_level(D_USER_BASIC))
+				prt_error("Info: Precompiled dictionary is out of date "
+				          "(\"%s\" has been changed); not used.\n", name);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool dict_binary_map(Dict_binary *db, FILE *fp, const char *bin_name)
+{
+	struct stat buf;
+	if (0 != fstat(fileno(fp), &buf)) return false;
+	db->size = (size_t)buf.st_size;
+	if (db->size < sizeof(bin_header)) return false;
+
+#ifdef HAVE_MMAP
+	void *data =
+		mmap(NULL, db->size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+	if (MAP_FAILED != data)
+	{
+		db->data = data;
+		db->mapped = true;
+		return true;
+	}
+	lgdebug(D_USER_FILES, "Debug: %s: mmap() failed (%s)\n",
+	        bin_name, syserror_msg(errno));
+#endif /* HAVE_MMAP */
+
+	char *data_copy = malloc(db->size);
+	if (db->size != fread(data_copy, 1, db->size, fp))
+	{
+		free(data_copy);
+		return false;
+	}
+	db->data = data_copy;
+	db->mapped = false;
+
+	return true;
+}
+
+/**
+ * Check that the precompiled dictionary \p db (named \p bin_name) can
+ * be used for the dictionary file \p dict_name.
+ * @param outdated Set to \c true if it cannot be used because it has
+ * been written by another library version or the dictionary has been
+ * changed since then.
+ */
+static bool dict_binary_usable(const Dict_binary *db, const char *bin_name,
+                               const char *dict_name, bool *outdated)
+{
+	*outdated = false;
+
+	const char *invalid = dict_binary_invalid(db);
+	if (NULL != invalid)
+	{
+		prt_error("Warning: %s: %s; the text dictionary is used.\n",
+		          bin_name, invalid);
+		return false;
+	}
+
+	*outdated = true;
+
+	const bin_header *hdr = (const bin_header *)db->data;
+	char version[sizeof(hdr->version)];
+	set_version(version, sizeof(version));
+	if ((DICT_BINARY_FORMAT != hdr->format) ||
+	    (0 != memcmp(version, hdr->version, sizeof(version))))
+	{
+		if (verbosity_level(D_USER_BASIC))
+			prt_error("Info: %s: Written by another library version; "
+			          "not used.\n", bin_name);
+		return false;
+	}
+
+	if (dict_binary_stale(db, dict_name)) return false;
+
+	*outdated = false;
+	return true;
+}
+
+/**
+ * Open the precompiled form of the dictionary file \p dict_name.
+ * It should be called after the text dictionary has been located (so
+ * the precompiled dictionary is looked up in its directory).
+ * @return The precompiled dictionary, or NULL if there is no usable one.
+ */
+Dict_binary *dict_binary_open(const char *dict_name)
+{
+	if (test_enabled("text-dict")) return NULL;
+
+	char *bin_name = malloc(strlen(dict_name) + sizeof(DICT_BINARY_SUFFIX));
+	strcpy(bin_name, dict_name);
+	strcat(bin_name, DICT_BINARY_SUFFIX);
+
+	Dict_binary *db = NULL;
+	FILE *fp = dictopen(bin_name, "rb");
+	if (NULL == fp) goto done;
+
+	db = malloc(sizeof(*db));
+	db->data = NULL;
+	db->exp = NULL;
+	bool mapped = dict_binary_map(db, fp, bin_name);
+	fclose(fp);
+
+	bool outdated;
+	if (!mapped)
+	{
+		prt_error("Warning: %s: Cannot be read; the text dictionary is used.\n",
+		          bin_name);
+		goto fail;
+	}
+	if (!dict_binary_usable(db, bin_name, dict_name, &outdated)) goto fail;
+
+	lgdebug(D_USER_FILES, "Debug: Using precompiled dictionary %s\n", bin_name);
+	goto done;
+
+fail:
+	dict_binary_close(db);
+	db = NULL;
+done:
+	free(bin_name);
+	return db;
+}
+
+void dict_binary_close(Dict_binary *db)
+{
+	if (NULL == db) return;
+	if (NULL != db->data)
+	{
+#ifdef HAVE_MMAP
+		if (db->mapped)
+			munmap((void *)db->data, db->size);
+		else
+#endif /* HAVE_MMAP */
+			free((void *)db->data);
+	}
+	free(db->exp);
+	free(db);
+}
+
+static void word_file_append(Word_file ***tail, const char *file)
+{
+	Word_file *wf = malloc(sizeof(*wf));
+	wf->file = file;
+	wf->next = NULL;
+	**tail = wf;
+	*tail = &wf->next;
+}
+
+/**
+ * Get string \p index of \p db, in the string set of \p dict.
+ * @param str The strings of \p db, if they have all been added to the
+ * string set already.
+ */
+static const char *load_string(Dictionary dict, const Dict_binary *db,
+                               const char **str, uint32_t index)
+{
+	if (NULL != str) return str[index];
+	return string_set_add(bin_string(db, index), dict->string_set);
+}
+
+/**
+ * Build the dictionary structures that read_dictionary() would build,
+ * except for the word tree, from the precompiled dictionary \p db.
+ * @return The expressions, by their index in \p db.
+ */
+static Exp **load_definitions(Dictionary dict, const Dict_binary *db,
+                              const char **str)
+{
+	const bin_header *hdr = (const bin_header *)db->data;
+
+	/* Allocate all the expressions first, since they refer to each other. */
+	const uint32_t num_exps = section_count(db, SEC_EXP);
+	const bin_exp *be = section_data(db, SEC_EXP);
+	Exp **exp = malloc(num_exps * sizeof(*exp) + 1);
+	for (uint32_t i = 0; i < num_exps; i++)
+		exp[i] = pool_alloc(dict->Exp_pool);
+
+	for (uint32_t i = 0; i < num_exps; i++)
+	{
+		Exp *e = exp[i];
+
+		memset(e, 0, sizeof(*e));
+		e->type = be[i].type;
+		e->pos = be[i].pos;
+		e->cost = be[i].cost;
+		e->operand_next =
+			(NULL_INDEX == be[i].operand_next) ? NULL : exp[be[i].operand_next];
+		if (CONNECTOR_type == e->type)
+		{
+			e->multi = be[i].tag_type;
+			e->dir = (char)be[i].dir;
+			e->farthest_word = be[i].farthest_word;
+			e->condesc = condesc_add(&dict->contable,
+			             load_string(dict, db, str, be[i].operand_first));
+		}
+		else
+		{
+			if ((NULL != dict->macro_tag) || (Exptag_macro != be[i].tag_type))
+			{
+				e->tag_type = be[i].tag_type;
+				e->tag_id = be[i].tag_id;
+			}
+			e->operand_first = (NULL_INDEX == be[i].operand_first) ?
+				NULL : exp[be[i].operand_first];
+		}
+	}
+
+	const uint32_t *dfine = section_data(db, SEC_DEFINE);
+	for (uint32_t i = 0; i < section_count(db, SEC_DEFINE); i++)
+	{
+		add_define(dict, load_string(dict, db, str, dfine[2*i]),
+		           load_string(dict, db, str, dfine[2*i + 1]));
+	}
+
+	const uint32_t *tag = section_data(db, SEC_DIALECT_TAG);
+	for (uint32_t i = 0; i < section_count(db, SEC_DIALECT_TAG); i++)
+		exptag_dialect_add(dict, load_string(dict, db, str, tag[i]));
+
+	if (NULL != dict->macro_tag)
+	{
+		expression_tag *mt = dict->macro_tag;
+
+		tag = section_data(db, SEC_MACRO_TAG);
+		mt->num = section_count(db, SEC_MACRO_TAG);
+		mt->size = mt->num;
+		mt->name = malloc(mt->num * sizeof(*mt->name) + 1);
+		for (uint32_t i = 0; i < mt->num; i++)
+			mt->name[i] = load_string(dict, db, str, tag[i]);
+	}
+
+	const bin_length_limit *bll = section_data(db, SEC_LENGTH_LIMIT);
+	for (uint32_t i = 0; i < section_count(db, SEC_LENGTH_LIMIT); i++)
+	{
+		length_limit_def_t *lld = malloc(sizeof(*lld));
+		lld->next = NULL;
+		lld->length_limit = bll[i].length_limit;
+		lld->defexp = exp[bll[i].exp];
+		lld->defword = load_string(dict, db, str, bll[i].word);
+		*dict->contable.length_limit_def_next = lld;
+		dict->contable.length_limit_def_next = &lld->next;
+	}
+
+	const bin_source *src = section_data(db, SEC_SOURCE);
+	Word_file **include_tail = &dict->include_file_header;
+	Word_file **word_file_tail = &dict->word_file_header;
+	for (uint32_t i = 0; i < section_count(db, SEC_SOURCE); i++)
+	{
+		if (SRC_INCLUDE == src[i].kind)
+		{
+			word_file_append(&include_tail,
+			                 load_string(dict, db, str, src[i].name));
+		}
+		else if (SRC_WORD_FILE == src[i].kind)
+		{
+			word_file_append(&word_file_tail,
+			                 load_string(dict, db, str, src[i].name));
+		}
+	}
+
+	dict->num_entries = hdr->num_entries;
+	dict->allow_duplicate_words = hdr->allow_duplicate_words;
+	dict->allow_duplicate_idioms = hdr->allow_duplicate_idioms;
+	memcpy(dict->current_idiom, hdr->current_idiom, IDIOM_LINK_SZ);
+
+	return exp;
+}
+
+/**
+ * Build the dictionary structures that read_dictionary() would build,
+ * from the precompiled dictionary \p db.
+ */
+void dict_binary_load(Dictionary dict, const Dict_binary *db)
+{
+	const uint32_t num_strings = section_count(db, SEC_STRING_OFFSET);
+	const char **str = malloc(num_strings * sizeof(*str) + 1);
+	for (uint32_t i = 0; i < num_strings; i++)
+		str[i] = string_set_add(bin_string(db, i), dict->string_set);
+
+	Exp **exp = load_definitions(dict, db, str);
+
+	const uint32_t num_nodes = section_count(db, SEC_NODE);
+	const bin_node *bn = section_data(db, SEC_NODE);
+	Dict_node **node = malloc(num_nodes * sizeof(*node) + 1);
+	for (uint32_t i = 0; i < num_nodes; i++)
+		node[i] = dict_node_new();
+	for (uint32_t i = 0; i < num_nodes; i++)
+	{
+		node[i]->string = str[bn[i].string];
+		node[i]->exp = exp[bn[i].exp];
+		node[i]->file = (NULL_INDEX == bn[i].file) ? NULL : str[bn[i].file];
+		node[i]->left = (NULL_INDEX == bn[i].left) ? NULL : node[bn[i].left];
+		node[i]->right = (NULL_INDEX == bn[i].right) ? NULL : node[bn[i].right];
+	}
+	dict->root = (0 == num_nodes) ? NULL : node[0];
+
+	free(node);
+	free(exp);
+	free(str);
+}
+
+/* ======================================================================= */
+/*
+ * Shared dictionary.
+ *
+ * A dictionary that is used by many processes can be published in a
+ * POSIX shared memory object, in its precompiled form. Processes that
+ * create the dictionary with dictionary_create_lang_shared() map it
+ * read-only and look up the words directly in it (using its word index
+ * instead of the word tree). So the word strings, the word records and
+ * the word index (most of the dictionary memory) are shared. The
+ * expressions, the connector descriptors and the rest of the dictionary
+ * files are still built in the memory of each process, as they are
+ * pointer based (and small).
+ *
+ * The first process that doesn't find a usable shared dictionary
+ * creates the dictionary as usual and then publishes it (it can also
+ * be published in advance with "link-dict-compile -s"). The header magic
+ * is written last, so a partially written shared dictionary is never
+ * used. A shared dictionary that is out of date is removed (and then
+ * published again by the process that removed it). So is one that is
+ * still not complete long after it has been created, as its publishing
+ * process has presumably died.
+ */
+
+static const char *image_word(const void *arg, uint32_t i)
+{
+	const Dict_binary *db = arg;
+	const uint32_t *word = section_data(db, SEC_WORD);
+	const bin_node *bn = section_data(db, SEC_NODE);
+
+	return bin_string(db, bn[word[i]].string);
+}
+
+static const bin_base_word *shared_base_word(const Dict_binary *db,
+                                             const char *s)
+{
+	return base_word_find(section_data(db, SEC_WORD_BASE),
+	                      section_data(db, SEC_WORD_TABLE),
+	                      section_count(db, SEC_WORD_TABLE),
+	                      image_word, db, s);
+}
+
+static Dict_node *shared_dict_node(const Dict_binary *db, uint32_t i,
+                                   Dict_node *next)
+{
+	const uint32_t *word = section_data(db, SEC_WORD);
+	const bin_node *bn = &((const bin_node *)section_data(db, SEC_NODE))[word[i]];
+	Dict_node *dn = dict_node_new();
+
+	dn->string = bin_string(db, bn->string);
+	dn->exp = db->exp[bn->exp];
+	dn->file = (NULL_INDEX == bn->file) ? NULL : bin_string(db, bn->file);
+	dn->right = next;
+
+	return dn;
+}
+
+/**
+ * Lookup \p s in the shared dictionary, with the semantics of
+ * dict_node_lookup().
+ * @return The matching words, or NULL if there are none. If
+ * \p boolean_lookup, a non-NULL dummy value is returned instead.
+ */
+static Dict_node *shared_lookup(const Dict_binary *db, const char *s,
+                                bool boolean_lookup)
+{
+	const bin_base_word *bw = shared_base_word(db, s);
+	if (NULL == bw) return NULL;
+
+	/* A subscripted search string matches only its own subscript. */
+	bool match_all = ('\0' == s[bw->base_len]);
+	size_t slen = match_all ? 0 : strlen(s);
+	Dict_node *llist = NULL;
+
+	/* Prepend the matches in reverse, to get them in the tree order. */
+	for (uint32_t i = bw->first + bw->count; i-- > bw->first; )
+	{
+		if (!match_all)
+		{
+			const char *t = image_word(db, i);
+			if (0 != strncmp(s, t, slen)) continue;
+			if ((t[slen] != '\0') && (t[slen] != SUBSCRIPT_MARK)) continue;
+		}
+
+		if (boolean_lookup) return (Dict_node *)db;
+		llist = shared_dict_node(db, i, llist);
+	}
+
+	return llist;
+}
+
+static Dict_node *shared_lookup_list(Dictionary dict, const char *s)
+{
+	return shared_lookup(dict->shared_image, s, false);
+}
+
+static bool shared_exists_lookup(Dictionary dict, const char *s)
+{
+	return NULL != shared_lookup(dict->shared_image, s, true);
+}
+
+static Dict_node *shared_lookup_wild(Dictionary dict, const char *s)
+{
+	const Dict_binary *db = dict->shared_image;
+	char *pattern = strdupa(s);
+	Dict_node *llist = NULL;
+
+	dict_wild_pattern(pattern);
+	for (uint32_t i = section_count(db, SEC_WORD); i-- > 0; )
+	{
+		if (dict_wild_match(pattern, image_word(db, i)))
+			llist = shared_dict_node(db, i, llist);
+	}
+
+	return llist;
+}
+
+static void shared_close(Dictionary dict)
+{
+	dict_binary_close(dict->shared_image);
+	dict->shared_image = NULL;
+}
+
+size_t dict_binary_shared_num_words(const Dict_binary *db)
+{
+	return section_count(db, SEC_WORD);
+}
+
+/**
+ * Get word \p i (in the dictionary order) of the shared dictionary \p db.
+ */
+const char *dict_binary_shared_word(const Dict_binary *db, size_t i)
+{
+	return image_word(db, (uint32_t)i);
+}
+
+/**
+ * Set up \p dict to use the shared dictionary \p db, which is then
+ * owned by it. Only the definitions (see load_definitions()) are built;
+ * the words are looked up in \p db.
+ */
+void dict_binary_load_shared(Dictionary dict, Dict_binary *db)
+{
+	db->exp = load_definitions(dict, db, NULL);
+
+	dict->shared_image = db;
+	dict->lookup_list = shared_lookup_list;
+	dict->lookup_wild = shared_lookup_wild;
+	dict->exists_lookup = shared_exists_lookup;
+	dict->close = shared_close;
+}
+
+#ifdef HAVE_SHM_OPEN
+/* Publishing takes much less than that (seconds). */
+#define SHM_PUBLISH_TIMEOUT 60
+
+/**
+ * The shared dictionary \p shm_name, whose status is \p buf, is not
+ * complete. If it has not been changed for SHM_PUBLISH_TIMEOUT seconds
+ * (can be changed by the "shm-publish-timeout:SECONDS" test option),
+ * remove it, so it can be published again.
+ */
+static void shm_remove_unfinished(const char *shm_name, const struct stat *buf)
+{
+	time_t timeout = SHM_PUBLISH_TIMEOUT;
+	const char *timeout_option = test_enabled("shm-publish-timeout");
+	if ((NULL != timeout_option) && (':' == timeout_option[0]))
+		timeout = (time_t)atoi(timeout_option+1);
+
+	time_t changed = MAX(buf->st_mtime, buf->st_ctime);
+	if (time(NULL) - changed < timeout) return;
+
+	if ((0 == shm_unlink(shm_name)) && verbosity_level(D_USER_BASIC))
+	{
+		prt_error("Info: Shared dictionary %s: Removed an unfinished one.\n",
+		          shm_name);
+	}
+}
+
+/**
+ * Attach to the shared dictionary \p shm_name of the dictionary file
+ * \p dict_name. If it is out of date, or its publishing has not been
+ * finished in time, it is removed, so it can be published again.
+ * @return The shared dictionary, or NULL if there is no usable one.
+ */
+Dict_binary *dict_binary_shm_open(const char *shm_name, const char *dict_name)
+{
+	int fd = shm_open(shm_name, O_RDONLY, 0);
+	if (-1 == fd)
+	{
+		if (ENOENT != errno)
+		{
+			prt_error("Warning: Shared dictionary %s: Cannot be opened (%s).\n",
+			          shm_name, syserror_msg(errno));
+		}
+		return NULL;
+	}
+
+	struct stat buf;
+	if (0 != fstat(fd, &buf))
+	{
+		prt_error("Warning: Shared dictionary %s: Cannot be opened (%s).\n",
+		          shm_name, syserror_msg(errno));
+		close(fd);
+		return NULL;
+	}
+
+	if ((size_t)buf.st_size < sizeof(bin_header))
+	{
+		/* Probably just created by another process. */
+		lgdebug(D_USER_FILES, "Debug: Shared dictionary %s: Not ready\n",
+		        shm_name);
+		close(fd);
+		shm_remove_unfinished(shm_name, &buf);
+		return NULL;
+	}
+
+	void *data = mmap(NULL, (size_t)buf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (MAP_FAILED == data)
+	{
+		prt_error("Warning: Shared dictionary %s: Cannot be mapped (%s).\n",
+		          shm_name, syserror_msg(errno));
+		return NULL;
+	}
+
+	Dict_binary *db = malloc(sizeof(*db));
+	db->data = data;
+	db->size = (size_t)buf.st_size;
+	db->mapped = true;
+	db->exp = NULL;
+
+	const bin_header *hdr = (const bin_header *)db->data;
+	if (0 != memcmp(hdr->magic, DICT_BINARY_MAGIC, sizeof(DICT_BINARY_MAGIC)))
+	{
+		lgdebug(D_USER_FILES, "Debug: Shared dictionary %s: Not ready\n",
+		        shm_name);
+		dict_binary_close(db);
+		shm_remove_unfinished(shm_name, &buf);
+		return NULL;
+	}
+#if HAVE_STDATOMIC_H
+	atomic_thread_fence(memory_order_acquire); /* The magic is written last */
+#endif
+
+	bool outdated;
+	if (!dict_binary_usable(db, shm_name, dict_name, &outdated))
+	{
+		if (outdated && (0 == shm_unlink(shm_name)) &&
+		    verbosity_level(D_USER_BASIC))
+		{
+			prt_error("Info: Shared dictionary %s removed.\n", shm_name);
+		}
+		dict_binary_close(db);
+		return NULL;
+	}
+
+	if ((0 == section_count(db, SEC_WORD_TABLE)) &&
+	    (0 != section_count(db, SEC_WORD)))
+	{
+		if (verbosity_level(D_USER_BASIC))
+			prt_error("Info: Shared dictionary %s: No word index; "
+			          "not used.\n", shm_name);
+		dict_binary_close(db);
+		return NULL;
+	}
+
+	lgdebug(D_USER_FILES, "Debug: Using shared dictionary %s\n", shm_name);
+	return db;
+}
+
+/**
+ * Publish the dictionary \p dict as the shared dictionary \p shm_name.
+ * See dict_binary_image() for when it can be called. Nothing is done if
+ * it already exists (e.g. it is being published by another process).
+ * @return \c true if it has been published, \c false otherwise.
+ */
+bool dict_binary_shm_create(Dictionary dict, const char *shm_name)
+{
+	out_buf ob;
+	if (!dict_binary_image(dict, &ob)) return false;
+
+	const bin_header *hdr = (const bin_header *)ob.buf;
+	bool rc = false;
+
+	if ((0 == hdr->section[SEC_WORD_TABLE].count) &&
+	    (0 != hdr->section[SEC_WORD].count))
+	{
+		prt_error("Warning: Shared dictionary %s: No word index; "
+		          "not published.\n", shm_name);
+		free(ob.buf);
+		return false;
+	}
+
+	int fd = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (-1 == fd)
+	{
+		if (EEXIST != errno)
+		{
+			prt_error("Warning: Shared dictionary %s: Cannot be created (%s).\n",
+			          shm_name, syserror_msg(errno));
+		}
+		free(ob.buf);
+		return false;
+	}
+
+	char *data = MAP_FAILED;
+	if (0 == ftruncate(fd, (off_t)ob.size))
+	{
+		data = mmap(NULL, ob.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	if (MAP_FAILED == data)
+	{
+		prt_error("Warning: Shared dictionary %s: Cannot be created (%s).\n",
+		          shm_name, syserror_msg(errno));
+		shm_unlink(shm_name);
+	}
+	else
+	{
+		/* Write the magic last, so the dictionary is not used before it
+		 * is complete. */
+		const size_t magic_size = sizeof(hdr->magic);
+		memcpy(data + magic_size, ob.buf + magic_size, ob.size - magic_size);
+#if HAVE_STDATOMIC_H
+		atomic_thread_fence(memory_order_release);
+#endif
+		memcpy(data, ob.buf, magic_size);
+		munmap(data, ob.size);
+
+		if (verbosity_level(D_USER_BASIC))
+			prt_error("Info: Shared dictionary %s published (%zu bytes).\n",
+			          shm_name, ob.size);
+		rc = true;
+	}
+
+	close(fd);
+	free(ob.buf);
+	return rc;
+}
+#endif /* HAVE_SHM_OPEN */
@@ -0,0 +1,38 @@
+/*************************************************************************/
+/* Copyright (c) 2026 The Link Grammar project                           */
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+#ifndef _LG_DICT_BINARY_H_
+#define _LG_DICT_BINARY_H_
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "dict-common/dict-common.h"    // Dict_binary
+
+/* The precompiled dictionary is looked up as the dictionary file name
+ * with this suffix appended (e.g. "en/4.0.dict.bin"). */
+#define DICT_BINARY_SUFFIX ".bin"
+
+Dict_binary *dict_binary_open(const char *dict_name);
+void dict_binary_load(Dictionary, const Dict_binary *);
+void dict_binary_close(Dict_binary *);
+
+bool dict_binary_write(Dictionary, FILE *);
+
+void dict_binary_load_shared(Dictionary, Dict_binary *);
+size_t dict_binary_shared_num_words(const Dict_binary *);
+const char *dict_binary_shared_word(const Dict_binary *, size_t);
+#ifdef HAVE_SHM_OPEN
+Dict_binary *dict_binary_shm_open(const char *shm_name, const char *dict_name);
+bool dict_binary_shm_create(Dictionary, const char *shm_name);
+#endif /* HAVE_SHM_OPEN */
+
+#endif /* _LG_DICT_BINARY_H_ */
@@ -11,6 +11,8 @@
 /*                                                                       */
 /*************************************************************************/
 
+#include <errno.h>
+
 #include "api-structures.h"
 #include "dict-common/dialect.h"      // dialect_alloc
 #include "dict-common/dict-affix.h"
@@ -26,12 +28,16 @@
 #include "dict-common/regex-morph.h"
 #include "dict-ram/dict-ram.h"
 #include "post-process/pp_knowledge.h"
+#include "prepare/disjunct-cache.h"
+#include "dict-binary.h"
 #include "read-dialect.h"
 #include "read-dict.h"
 #include "read-regex.h"
 #include "string-set.h"
 #include "tokenize/anysplit.h"        // Initialize anysplit here ...
+#include "tokenize/spell-guess.h"
 #include "tokenize/spellcheck.h"      // Initialize spellcheck here ...
+#include "tokenize/token-cache.h"
 
 /***************************************************************
 *
@@ -134,6 +140,12 @@ static bool load_regexes(Dictionary dict, const char *regex_name)
 /**
  * Read dictionary entries from a utf-8 string "input".
  * All other parts are read from files.
+ * If \p use_binary is set, the dictionary entries are read from the
+ * precompiled dictionary instead, if there is a usable one.
+ * If \p compile_to is not NULL, the precompiled dictionary is written
+ * to it.
+ * If \p shm_name is not NULL, the dictionary entries are used from the
+ * shared dictionary of that name, which is published first if needed.
  */
 #define D_DICT 10
 static Dictionary
@@ -141,7 +153,8 @@ dictionary_six_str(const char * lang,
                    const char * input,
                    const char * dict_name,
                    const char * pp_name, const char * cons_name,
-                   const char * affix_name, const char * regex_name)
+                   const char * affix_name, const char * regex_name,
+                   bool use_binary, FILE *compile_to, const char *shm_name)
 {
 	const char * t;
 	Dictionary dict;
@@ -227,9 +240,42 @@ dictionary_six_str(const char * lang,
 	                          sizeof(Exp), /*zero_out*/false,
 	                          /*align*/false, /*exact*/false);
 
-	/* Read dictionary from the input string. */
-	if (!read_dictionary(dict, input))
-		goto failure;
+	Dict_binary *db = NULL;
+#ifdef HAVE_SHM_OPEN
+	if ((NULL != shm_name) && !IS_GENERATION(dict))
+		db = dict_binary_shm_open(shm_name, dict_name);
+#endif /* HAVE_SHM_OPEN */
+
+	if (NULL != db)
+	{
+		dict_binary_load_shared(dict, db);
+	}
+	else
+	{
+		if (use_binary && !IS_GENERATION(dict))
+			db = dict_binary_open(dict_name);
+
+		if (NULL != db)
+		{
+			dict_binary_load(dict, db);
+			dict_binary_close(db);
+		}
+		else
+		{
+			/* Read dictionary from the input string. */
+			if (!read_dictionary(dict, input))
+				goto failure;
+
+			if ((NULL != compile_to) && !dict_binary_write(dict, compile_to))
+				goto failure;
+		}
+
+#ifdef HAVE_SHM_OPEN
+		/* This process keeps its own copy; the next ones use the shared one. */
+		if ((NULL != shm_name) && !IS_GENERATION(dict))
+			dict_binary_shm_create(dict, shm_name);
+#endif /* HAVE_SHM_OPEN */
+	}
 
 	if (NULL == affix_name)
 	{
@@ -241,6 +287,8 @@ dictionary_six_str(const char * lang,
 		return dict;
 	}
 
+	dict_node_index_build(dict);
+
 	if (dict->dialect_tag.num == 0)
 	{
 		string_id_delete(dict->dialect_tag.set);
@@ -268,6 +316,9 @@ dictionary_six_str(const char * lang,
 	dict->hpsg_knowledge  = pp_knowledge_open(cons_name);
 
 	condesc_setup(dict);
+	dict->disjunct_cache = disjunct_cache_create(dict);
+	dict->token_cache = token_cache_create(dict);
+	dict->spell_guess = spell_guess_create(dict);
 
 	// Special-case hack.
 	if ((0 == strncmp(dict->lang, "any", 3)) ||
@@ -285,10 +336,11 @@ failure:
  * Use filenames of six different files to put together the dictionary.
  */
 NO_SAN_DICT
-Dictionary
-dictionary_six(const char * lang, const char * dict_name,
-               const char * pp_name, const char * cons_name,
-               const char * affix_name, const char * regex_name)
+static Dictionary
+dictionary_six_bin(const char * lang, const char * dict_name,
+                   const char * pp_name, const char * cons_name,
+                   const char * affix_name, const char * regex_name,
+                   bool use_binary, FILE *compile_to, const char *shm_name)
 {
 	Dictionary dict;
 
@@ -300,13 +352,33 @@ dictionary_six(const char * lang, const char * dict_name,
 	}
 
 	dict = dictionary_six_str(lang, input, dict_name, pp_name,
-	                          cons_name, affix_name, regex_name);
+	                          cons_name, affix_name, regex_name,
+	                          use_binary, compile_to, shm_name);
 
 	free_file_contents(input);
 	return dict;
 }
 
-Dictionary dictionary_create_from_file(const char * lang)
+Dictionary
+dictionary_six(const char * lang, const char * dict_name,
+               const char * pp_name, const char * cons_name,
+               const char * affix_name, const char * regex_name)
+{
+	return dictionary_six_bin(lang, dict_name, pp_name, cons_name,
+	                          affix_name, regex_name, false, NULL, NULL);
+}
+
+/**
+ * Create the dictionary of \p lang from its files. Its main file is
+ * read from its precompiled form, if there is a usable one, unless
+ * \p compile_to is not NULL. In that case it is read as text and
+ * then the precompiled dictionary is written to \p compile_to.
+ * If \p shm_name is not NULL, the shared dictionary of that name is
+ * used instead if possible (see dict-binary.c).
+ */
+static Dictionary dictionary_create_from_files(const char * lang,
+                                               FILE *compile_to,
+                                               const char *shm_name)
 {
 	Dictionary dictionary;
 
@@ -325,8 +397,10 @@ Dictionary dictionary_create_from_file(const char * lang)
 		affix_name = join_path(lang, "4.0.affix");
 		regex_name = join_path(lang, "4.0.regex");
 
-		dictionary = dictionary_six(lang, dict_name, pp_name, cons_name,
-		                            affix_name, regex_name);
+		dictionary = dictionary_six_bin(lang, dict_name, pp_name, cons_name,
+		                                affix_name, regex_name,
+		                                NULL == compile_to, compile_to,
+		                                shm_name);
 
 		free(regex_name);
 		free(affix_name);
@@ -361,6 +435,90 @@ Dictionary dictionary_create_from_file(const char * lang)
 	return dictionary;
 }
 
+Dictionary dictionary_create_from_file(const char * lang)
+{
+	return dictionary_create_from_files(lang, NULL, NULL);
+}
+
+/**
+ * Create the dictionary of \p lang, using the shared dictionary
+ * \p shm_name (a POSIX shared memory object name, e.g. "/lg-en") for
+ * its words. If it doesn't exist yet (or is out of date), the dictionary
+ * is created as usual and then published under this name for the next
+ * processes.
+ */
+Dictionary dictionary_create_lang_shared(const char * lang,
+                                         const char * shm_name)
+{
+	object_open(NULL, NULL, NULL); /* Invalidate the directory path cache */
+
+#ifndef HAVE_SHM_OPEN
+	prt_error("Warning: Shared dictionaries are not supported "
+	          "on this system.\n");
+	shm_name = NULL;
+#endif /* HAVE_SHM_OPEN */
+
+	return dictionary_create_from_files(lang, NULL, shm_name);
+}
+
+/**
+ * Precompile the dictionary file of \p lang (see dict-binary.c).
+ * @param filename The precompiled dictionary file to write. If NULL,
+ * write it next to the dictionary file, where it is looked up when
+ * the dictionary is created.
+ * @return \c true on success, \c false on error.
+ */
+bool dictionary_compile_lang(const char * lang, const char * filename)
+{
+	if ((NULL == lang) || ('\0' == *lang))
+	{
+		prt_error("Error: No language specified!\n");
+		return false;
+	}
+
+	char *dict_name = join_path(lang, "4.0.dict");
+	char *bin_name = NULL;
+	FILE *fp;
+
+	object_open(NULL, NULL, NULL); /* Invalidate the directory path cache */
+	if (NULL != filename)
+	{
+		fp = fopen(filename, "wb");
+	}
+	else
+	{
+		bin_name = malloc(strlen(dict_name) + sizeof(DICT_BINARY_SUFFIX));
+		strcpy(bin_name, dict_name);
+		strcat(bin_name, DICT_BINARY_SUFFIX);
+		filename = bin_name;
+
+		/* Create it in the directory in which the dictionary is found. */
+		fp = file_exists(dict_name) ? dictopen(bin_name, "wb") : NULL;
+	}
+	free(dict_name);
+
+	if (NULL == fp)
+	{
+		prt_error("Error: Cannot create the precompiled dictionary \"%s\".\n",
+		          filename);
+		free(bin_name);
+		return false;
+	}
+
+	Dictionary dict = dictionary_create_from_files(lang, fp, NULL);
+	bool rc = (NULL != dict);
+	dictionary_delete(dict);
+
+	if (0 != fclose(fp))
+	{
+		prt_error("Error: %s: Write error (%s).\n", filename, syserror_msg(errno));
+		rc = false;
+	}
+	free(bin_name);
+
+	return rc;
+}
+
 
 #ifdef NOTDEF
 /**
@@ -382,12 +540,12 @@ Dictionary dictionary_create_from_utf8(const char * input)
 	lang = get_default_locale();
 	if (lang && *lang) {
 		dictionary = dictionary_six_str(lang, input, "string",
-		                                NULL, NULL, NULL, NULL);
+		                                NULL, NULL, NULL, NULL, false, NULL, NULL);
 		free(lang);
 	} else {
 		/* Default to en when locales are broken (e.g. WIN32) */
 		dictionary = dictionary_six_str("en", input, "string",
-		                                NULL, NULL, NULL, NULL);
+		                                NULL, NULL, NULL, NULL, false, NULL, NULL);
 	}
 
 	return dictionary;
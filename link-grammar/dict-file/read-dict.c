@@ -982,6 +982,13 @@ static bool read_entry(FileCursor fcurs)
 
 			/* The dict name and line-number are used for error reporting */
 			Dictionary dict = fcurs->dict;
+
+			/* Remember it for the precompiled dictionary. */
+			Word_file *wf = malloc(sizeof(Word_file));
+			wf->file = string_set_add(dict_name + skip_slash, dict->string_set);
+			wf->next = dict->include_file_header;
+			dict->include_file_header = wf;
+
 			const char * save_name = dict->name;
 			int save_line_number = dict->line_number;
 			dict->name = dict_name;
@@ -11,6 +11,7 @@
 /*                                                                       */
 /*************************************************************************/
 
+#include <stdint.h>
 #include <string.h>
 
 #include "dict-common/dict-common.h"
@@ -38,6 +39,7 @@ void free_dict_node_recursive(Dict_node * dn)
 
 void free_dictionary_root(Dictionary dict)
 {
+	dict_node_index_delete(dict);
 	free_dict_node_recursive(dict->root);
 	pool_delete(dict->Exp_pool);
 	dict->root = NULL;
@@ -240,6 +242,209 @@ rdictionary_lookup(Dict_node * restrict llist,
 	return llist;
 }
 
+/* ======================================================================== */
+/**
+ * Word index.
+ *
+ * Walking the binary tree costs a string comparison (and typically a
+ * cache miss) per tree level. So after the dictionary has been read,
+ * its words are also indexed by a hash table on their base word (the
+ * word without its subscript). The entries of a given base word are
+ * adjacent in the tree order ("make" < "make.n" < "make.v" < "make-up"),
+ * so each base word refers to a range of an array of the tree nodes in
+ * the tree order. This way the lookup results are exactly those of the
+ * tree walk, in the same order.
+ *
+ * The index is not used for wildcard lookups (which are only used for
+ * dictionary debugging).
+ */
+typedef struct
+{
+	uint32_t hash;
+	uint32_t base_len;
+	uint32_t first;            /* Index of its first node in node[] */
+	uint32_t count;            /* Number of its nodes */
+} base_word;
+
+struct Word_index_s
+{
+	Dict_node **node;          /* The dictionary nodes, in tree order */
+	base_word *base;
+	uint32_t *table;           /* Index in base[] plus 1 (0: empty) */
+	size_t table_mask;
+};
+
+/**
+ * Hash the base word of \p s (its part before the subscript), and set
+ * \p len to its length.
+ */
+uint32_t dict_base_word_hash(const char *s, size_t *len)
+{
+	uint32_t h = 2166136261u;
+	const char *p;
+
+	for (p = s; (*p != '\0') && (*p != SUBSCRIPT_MARK); p++)
+		h = (h ^ (unsigned char)*p) * 16777619u;
+
+	*len = (size_t)(p - s);
+	return h;
+}
+
+static size_t count_nodes(const Dict_node *dn)
+{
+	size_t n = 0;
+
+	for (; dn != NULL; dn = dn->right)
+		n += 1 + count_nodes(dn->left);
+
+	return n;
+}
+
+static size_t collect_nodes(Dict_node **node, size_t n, Dict_node *dn)
+{
+	while (dn != NULL)
+	{
+		n = collect_nodes(node, n, dn->left);
+		node[n++] = dn;
+		dn = dn->right;
+	}
+
+	return n;
+}
+
+static const base_word *word_index_find(const Word_index *wi, const char *s)
+{
+	size_t len;
+	uint32_t h = dict_base_word_hash(s, &len);
+
+	for (size_t i = h & wi->table_mask; ; i = (i + 1) & wi->table_mask)
+	{
+		if (0 == wi->table[i]) return NULL;
+
+		const base_word *bw = &wi->base[wi->table[i] - 1];
+		if ((bw->hash == h) && (bw->base_len == len) &&
+		    (0 == memcmp(wi->node[bw->first]->string, s, len)))
+			return bw;
+	}
+}
+
+void dict_node_index_delete(Dictionary dict)
+{
+	Word_index *wi = dict->word_index;
+	if (NULL == wi) return;
+
+	free(wi->node);
+	free(wi->base);
+	free(wi->table);
+	free(wi);
+	dict->word_index = NULL;
+}
+
+/**
+ * Build the word index of \p dict. It must be called after the
+ * dictionary has been read, as it doesn't track later insertions.
+ */
+void dict_node_index_build(Dictionary dict)
+{
+	size_t num_nodes = count_nodes(dict->root);
+	if ((0 == num_nodes) || (num_nodes >= UINT32_MAX)) return;
+
+	Word_index *wi = malloc(sizeof(*wi));
+	wi->node = malloc(num_nodes * sizeof(*wi->node));
+	collect_nodes(wi->node, 0, dict->root);
+
+	/* Group the nodes by their base word. */
+	wi->base = malloc(num_nodes * sizeof(*wi->base));
+	size_t num_base = 0;
+	for (size_t i = 0; i < num_nodes; i++)
+	{
+		size_t len;
+		uint32_t h = dict_base_word_hash(wi->node[i]->string, &len);
+
+		if (0 < num_base)
+		{
+			base_word *prev = &wi->base[num_base - 1];
+			if ((prev->hash == h) && (prev->base_len == len) &&
+			    (0 == memcmp(wi->node[prev->first]->string,
+			                 wi->node[i]->string, len)))
+			{
+				prev->count++;
+				continue;
+			}
+		}
+
+		wi->base[num_base++] =
+			(base_word){ .hash = h, .base_len = (uint32_t)len,
+			             .first = (uint32_t)i, .count = 1 };
+	}
+
+	size_t table_size = 1;
+	while (table_size < 2 * num_base) table_size *= 2;
+	wi->table = calloc(table_size, sizeof(*wi->table));
+	wi->table_mask = table_size - 1;
+
+	dict->word_index = wi;
+	for (size_t b = 0; b < num_base; b++)
+	{
+		const base_word *bw = &wi->base[b];
+
+		if (NULL != word_index_find(wi, wi->node[bw->first]->string))
+		{
+			/* Not adjacent in the tree order - cannot happen unless the
+			 * dictionary ordering is changed. Use the tree walk. */
+			lgdebug(+D_DICT, "Word index disabled (\"%s\")\n",
+			        wi->node[bw->first]->string);
+			dict_node_index_delete(dict);
+			return;
+		}
+
+		size_t i = bw->hash & wi->table_mask;
+		while (0 != wi->table[i]) i = (i + 1) & wi->table_mask;
+		wi->table[i] = (uint32_t)(b + 1);
+	}
+}
+
+/**
+ * Lookup \p s in the word index, with the semantics of
+ * rdictionary_lookup() with dict_order_bare() (or dict_order_strict()
+ * if \p strict).
+ */
+static Dict_node *index_lookup(const Word_index *wi, const char *s,
+                               bool boolean_lookup, bool strict)
+{
+	const base_word *bw = word_index_find(wi, s);
+	if (NULL == bw) return NULL;
+
+	/* A subscripted search string matches only its own subscript. */
+	bool match_all = !strict && ('\0' == s[bw->base_len]);
+	size_t slen = match_all ? 0 : strlen(s);
+	Dict_node *llist = NULL;
+
+	/* Prepend the matches in reverse, to get them in the tree order. */
+	for (uint32_t i = bw->first + bw->count; i-- > bw->first; )
+	{
+		Dict_node *dn = wi->node[i];
+
+		if (!match_all)
+		{
+			const char *t = dn->string;
+			if (0 != strncmp(s, t, slen)) continue;
+			if ((t[slen] != '\0') &&
+			    (strict || (t[slen] != SUBSCRIPT_MARK))) continue;
+		}
+
+		dn->use_count++;
+		if (boolean_lookup) return dn;
+		Dict_node * dn_new = dict_node_new();
+		*dn_new = *dn;
+		dn_new->right = llist;
+		dn_new->left = dn; /* Currently only used for inserting idioms */
+		llist = dn_new;
+	}
+
+	return llist;
+}
+
 /**
  * dict_node_lookup() - return list of words in the RAM-cached dictionary.
  *
@@ -252,11 +457,15 @@ rdictionary_lookup(Dict_node * restrict llist,
  */
 Dict_node * dict_node_lookup(const Dictionary dict, const char *s)
 {
+	if (NULL != dict->word_index)
+		return index_lookup(dict->word_index, s, false, false);
 	return rdictionary_lookup(NULL, dict->root, s, false, dict_order_bare);
 }
 
 bool dict_node_exists_lookup(Dictionary dict, const char *s)
 {
+	if (NULL != dict->word_index)
+		return !!index_lookup(dict->word_index, s, true, false);
 	return !!rdictionary_lookup(NULL, dict->root, s, true, dict_order_bare);
 }
 
@@ -275,6 +484,8 @@ bool dict_node_exists_lookup(Dictionary dict, const char *s)
  */
 Dict_node * strict_lookup_list(const Dictionary dict, const char *s)
 {
+	if (NULL != dict->word_index)
+		return index_lookup(dict->word_index, s, false, true);
 	return rdictionary_lookup(NULL, dict->root, s, false, dict_order_strict);
 }
 
@@ -283,21 +494,42 @@ Dict_node * strict_lookup_list(const Dictionary dict, const char *s)
  * Used to support the !! command in the parser command-line tool.
  */
 Dict_node * dict_node_wild_lookup(Dictionary dict, const char *s)
+{
+	Dict_node * result;
+	char * stmp = strdupa(s);
+
+	dict_wild_pattern(stmp);
+	result = rdictionary_lookup(NULL, dict->root, stmp, false, dict_order_wild);
+	return result;
+}
+
+/**
+ * Convert the wildcard search string \p s (in place) to the form that
+ * is used for matching.
+ */
+void dict_wild_pattern(char *s)
 {
 	char * ds = strrchr(s, SUBSCRIPT_DOT); /* Only the rightmost dot is a
 	                                          candidate for SUBSCRIPT_DOT */
 	char * ws = strrchr(s, WILD_TYPE);     /* A SUBSCRIPT_DOT can only appear
                                              after a wild-card */
-	Dict_node * result;
-	char * stmp = strdupa(s);
 
 	/* It is not a SUBSCRIPT_DOT if it is at the end or before the wild-card.
 	 * E.g: "Dr.", "i.*", "." */
 	if ((NULL != ds) && ('\0' != ds[1]) && ((NULL == ws) || (ds > ws)))
-		stmp[ds-s] = SUBSCRIPT_MARK;
+		*ds = SUBSCRIPT_MARK;
+}
 
-	result = rdictionary_lookup(NULL, dict->root, stmp, false, dict_order_wild);
-	return result;
+/**
+ * Check whether the dictionary word \p word matches the wildcard search
+ * string \p pattern (after dict_wild_pattern()), the way
+ * dict_node_wild_lookup() matches it.
+ */
+bool dict_wild_match(const char *pattern, const char *word)
+{
+	const Dict_node dn = { .string = word };
+
+	return (0 == dict_order_wild(pattern, &dn)) && subscr_match(pattern, &dn);
 }
 
 /* ======================================================================== */
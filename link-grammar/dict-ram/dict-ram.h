@@ -18,6 +18,12 @@ Dict_node * dict_node_insert(Dictionary dict, Dict_node *n, Dict_node *newnode);
 Dict_node * dict_node_lookup(const Dictionary dict, const char *s);
 Dict_node * dict_node_wild_lookup(Dictionary dict, const char *s);
 bool dict_node_exists_lookup(Dictionary dict, const char *s);
+void dict_wild_pattern(char *s);
+bool dict_wild_match(const char *pattern, const char *word);
+uint32_t dict_base_word_hash(const char *s, size_t *len);
+
+void dict_node_index_build(Dictionary dict);
+void dict_node_index_delete(Dictionary dict);
 
 void free_dictionary_root(Dictionary dict);
 void free_dict_node_recursive(Dict_node*);
@@ -133,228 +133,368 @@ static const char * make_expression(Dictionary dict,
 
 
 /* ========================================================= */
-/* Dictionary word lookup procedures. */
+/* Database connections. */
+
+/*
+ * Each thread that performs lookups uses a read-only connection of its
+ * own, holding its own cache of prepared statements, so that lookups
+ * from different threads run concurrently in SQLite. The connections
+ * are kept in a pool in the handle, and are reused by later lookups.
+ *
+ * The dictionary structures that are built from the query results
+ * (expressions, connector descriptors, the string set) are not
+ * thread-safe; the handle mutex is held only while updating them.
+ */
+
+/* Number of parameters of the batched `IN (...)` statements. Unused
+ * parameters are bound to NULL, which never matches anything. */
+#define DB_BATCH_SIZE 32
+
+/* Milliseconds to wait for a lock held by a process updating the DB. */
+#define DB_BUSY_TIMEOUT 5000
 
+typedef enum
+{
+	STMT_MORPHEME,          /* Entries of a word */
+	STMT_GLOB,              /* Entries of the words matching a pattern */
+	STMT_DISJUNCT,          /* Disjuncts of a class */
+	STMT_NUM_CLASSES,       /* Number of classes */
+	STMT_CLASSES,           /* The class names */
+	STMT_NUM_CLASS_WORDS,   /* Number of words in a class */
+	STMT_CLASS_WORDS,       /* The words in a class */
+	STMT_MORPHEME_BATCH,    /* Entries of DB_BATCH_SIZE words */
+	STMT_DISJUNCT_BATCH,    /* Disjuncts of DB_BATCH_SIZE classes */
+	STMT_NUM
+} Stmt_id;
+
+static const char *stmt_sql[STMT_NUM] =
+{
+	[STMT_MORPHEME] =
+		"SELECT subscript, classname FROM Morphemes WHERE morpheme = ?;",
+	[STMT_GLOB] =
+		"SELECT subscript, classname FROM Morphemes WHERE morpheme GLOB ?;",
+	[STMT_DISJUNCT] =
+		"SELECT disjunct, cost FROM Disjuncts WHERE classname = ?;",
+	[STMT_NUM_CLASSES] =
+		"SELECT count(DISTINCT classname) FROM Disjuncts;",
+	[STMT_CLASSES] =
+		"SELECT DISTINCT classname FROM Disjuncts;",
+	[STMT_NUM_CLASS_WORDS] =
+		"SELECT count(*) FROM Morphemes WHERE classname = ?;",
+	[STMT_CLASS_WORDS] =
+		"SELECT subscript FROM Morphemes WHERE classname = ?;",
+	[STMT_MORPHEME_BATCH] =
+		"SELECT morpheme, subscript, classname FROM Morphemes "
+		"WHERE morpheme IN (%s);",
+	[STMT_DISJUNCT_BATCH] =
+		"SELECT classname, disjunct, cost FROM Disjuncts "
+		"WHERE classname IN (%s);",
+};
+
+typedef struct Db_conn_s Db_conn;
+
+typedef struct
+{
+	char *name;              /* Database file name */
+	Db_conn *idle;           /* Connections not in use by any thread */
 #if HAVE_THREADS_H
-static mtx_t global_mutex;
+	mtx_t mutex;
 #endif
+} Db_handle;
 
+/* A class of the words of a bulk lookup, and its expression. */
 typedef struct
 {
-	Dictionary dict;
-	Dict_node* dn;
-	bool found;
-	int count;
-	Exp* exp;
-	char* classname;
-} cbdata;
+	char *name;
+	Exp *exp;
+} Batch_class;
 
-/* callback -- set bs->exp to the expressions for a class in the dict */
-static int exp_cb(void *user_data, int argc, char **argv, char **colName)
+/* A dictionary entry whose expression is not known yet. */
+typedef struct
 {
-	cbdata* bs = user_data;
-	Dictionary dict = bs->dict;
+	Dict_node *dn;
+	size_t cls;
+} Batch_entry;
 
-	assert(2 == argc, "Bad column count");
-	assert(argv[0], "NULL column value");
-
-	Exp* exp = NULL;
-	make_expression(dict, argv[0], &exp);
-	assert(NULL != exp, "Failed expression %s", argv[0]);
+struct Db_conn_s
+{
+	Db_handle *handle;
+	sqlite3 *db;
+	sqlite3_stmt *stmt[STMT_NUM];
+	Db_conn *next;
+
+	/* Scratch space for db_lookup_bulk(). */
+	Batch_class *cls;
+	size_t num_classes;
+	size_t classes_alloced;
+	Batch_entry *entry;
+	size_t num_entries;
+	size_t entries_alloced;
+};
+
+static void db_lock(Db_handle *h)
+{
+#if HAVE_THREADS_H
+	mtx_lock(&h->mutex);
+#endif
+}
 
-	if (!strtofC(argv[1], &exp->cost))
-	{
-		prt_error("Warning: Invalid cost \"%s\" in expression \"%s\" "
-		          "(using 1.0)\n", argv[1], argv[0]);
-		exp->cost = 1.0;
-	}
+static void db_unlock(Db_handle *h)
+{
+#if HAVE_THREADS_H
+	mtx_unlock(&h->mutex);
+#endif
+}
 
-	/* If the very first expression, just put it in place */
-	if (NULL == bs->exp)
-	{
-		bs->exp = exp;
-		return 0;
-	}
+static sqlite3 *db_connect(const char *name)
+{
+	sqlite3 *db;
 
-	/* If the second expression, OR-it with the existing expression. */
-	if (OR_type != bs->exp->type)
+	if (SQLITE_OK != sqlite3_open_v2(name, &db,
+	                   SQLITE_OPEN_READONLY|SQLITE_OPEN_NOMUTEX, NULL))
 	{
-		bs->exp = make_or_node(dict->Exp_pool, exp, bs->exp);
-		return 0;
+		prt_error("Error: Can't open database %s: %s\n",
+			name, sqlite3_errmsg(db));
+		sqlite3_close(db);
+		return NULL;
 	}
+	sqlite3_busy_timeout(db, DB_BUSY_TIMEOUT);
 
-	/* Extend the OR-chain for the third and later expressions. */
-	exp->operand_next = bs->exp->operand_first;
-	bs->exp->operand_first = exp;
+	return db;
+}
 
-	return 0;
+static void conn_delete(Db_conn *conn)
+{
+	for (size_t i = 0; i < STMT_NUM; i++)
+		sqlite3_finalize(conn->stmt[i]);
+	sqlite3_close(conn->db);
+	free(conn->cls);
+	free(conn->entry);
+	free(conn);
 }
 
-/* Escape single-quotes.  That is, replace single-quotes by
- * two single-quotes. e.g. don't --> don''t */
-static char * escape_quotes(const char * s)
+/**
+ * Get an idle connection from the pool, or open a new one.
+ * Return NULL if the database cannot be opened.
+ */
+static Db_conn *conn_acquire(Db_handle *h)
 {
-	char * q = strchr(s, '\'');
-	if (NULL == q) return (char *) s;
+	db_lock(h);
+	Db_conn *conn = h->idle;
+	if (NULL != conn) h->idle = conn->next;
+	db_unlock(h);
+	if (NULL != conn) return conn;
 
-	/* If there are two in a row, already, assume that they are
-	 * already escaped. This is pathological, and a sign that
-	 * something somewhere else has already gone wrong. But I'm
-	 * exhausted debugging right now and will punt on this.
-	 */
-	if ('\'' == *(q+1)) return (char *) s;
+	sqlite3 *db = db_connect(h->name);
+	if (NULL == db) return NULL;
 
-	char * es = malloc(2 * strlen(s) + 1);
-	char * p = es;
-	while (q)
-	{
-		strncpy(p, s, q-s+1);
-		p += q-s+1;
-		*p = '\'';
-		p++;
-		s = q+1;
-		q = strchr(s, '\'');
-	}
-	strcpy(p, s);
-	return es;
+	conn = malloc(sizeof(Db_conn));
+	memset(conn, 0, sizeof(Db_conn));
+	conn->handle = h;
+	conn->db = db;
+
+	return conn;
 }
 
-static void
-db_lookup_exp(Dictionary dict, const char *s, cbdata* bs)
+static void conn_release(Db_conn *conn)
 {
-#if HAVE_THREADS_H
-	mtx_lock(&global_mutex);
-#endif
-	sqlite3 *db = dict->db_handle;
-	dyn_str *qry;
+	Db_handle *h = conn->handle;
 
-	/* Escape single-quotes.  That is, replace single-quotes by
-	 * two single-quotes. e.g. don't --> don''t */
-	char * es = escape_quotes(s);
+	db_lock(h);
+	conn->next = h->idle;
+	h->idle = conn;
+	db_unlock(h);
+}
 
-	/* The token to look up is called the 'morpheme'. */
-	qry = dyn_str_new();
-	dyn_strcat(qry, "SELECT disjunct, cost FROM Disjuncts WHERE classname = \'");
-	dyn_strcat(qry, es);
-	dyn_strcat(qry, "\';");
+/**
+ * Return the prepared statement \p id of this connection. It is
+ * prepared on first use, and then reused by resetting it.
+ */
+static sqlite3_stmt *get_stmt(Db_conn *conn, Stmt_id id)
+{
+	if (NULL != conn->stmt[id]) return conn->stmt[id];
 
-	sqlite3_exec(db, qry->str, exp_cb, bs, NULL);
-	dyn_str_delete(qry);
+	const char *sql = stmt_sql[id];
+	char batch_sql[256];
+	if ((STMT_MORPHEME_BATCH == id) || (STMT_DISJUNCT_BATCH == id))
+	{
+		char params[2 * DB_BATCH_SIZE];
+		for (size_t i = 0; i < DB_BATCH_SIZE; i++)
+		{
+			params[2*i] = '?';
+			params[2*i+1] = ',';
+		}
+		params[2 * DB_BATCH_SIZE - 1] = '\0';
 
-	if (es != s) free(es);
+		snprintf(batch_sql, sizeof(batch_sql), sql, params);
+		sql = batch_sql;
+	}
 
-	lgdebug(D_SQL+1, "Found expression for class %s: %s\n",
-	        s, exp_stringify(bs->exp));
+	if (SQLITE_OK != sqlite3_prepare_v2(conn->db, sql, -1, &conn->stmt[id], NULL))
+	{
+		prt_error("Error: Can't prepare \"%s\": %s\n",
+		          sql, sqlite3_errmsg(conn->db));
+		conn->stmt[id] = NULL;
+	}
 
-#if HAVE_THREADS_H
-	mtx_unlock(&global_mutex);
-#endif
+	return conn->stmt[id];
 }
 
+/* ========================================================= */
+/* Dictionary word lookup procedures. */
 
-/* callback -- set bs->found to true if the word is in the dict */
-static int exists_cb(void *user_data, int argc, char **argv, char **colName)
+/**
+ * Add the expression of one row of the Disjuncts table to \p *pexp.
+ * The handle mutex must be held.
+ */
+static void add_disjunct(Dictionary dict, Exp **pexp,
+                         const char *disjunct, const char *cost)
 {
-	cbdata* bs = user_data;
+	assert(NULL != disjunct, "NULL column value");
 
-	assert(2 == argc, "Bad column count");
-	assert(argv[0], "NULL column value");
+	Exp* exp = NULL;
+	make_expression(dict, disjunct, &exp);
+	assert(NULL != exp, "Failed expression %s", disjunct);
 
-	bs->found = true;
-	return 0;
+	if ((NULL == cost) || !strtofC(cost, &exp->cost))
+	{
+		prt_error("Warning: Invalid cost \"%s\" in expression \"%s\" "
+		          "(using 1.0)\n", cost ? cost : "(null)", disjunct);
+		exp->cost = 1.0;
+	}
+
+	/* If the very first expression, just put it in place */
+	if (NULL == *pexp)
+	{
+		*pexp = exp;
+		return;
+	}
+
+	/* If the second expression, OR-it with the existing expression. */
+	if (OR_type != (*pexp)->type)
+	{
+		*pexp = make_or_node(dict->Exp_pool, exp, *pexp);
+		return;
+	}
+
+	/* Extend the OR-chain for the third and later expressions. */
+	exp->operand_next = (*pexp)->operand_first;
+	(*pexp)->operand_first = exp;
 }
 
-/* callback -- set bs->dn to the dict nodes for a word in the dict */
-static int morph_cb(void *user_data, int argc, char **argv, char **colName)
+/** Return the expression for the class \p s, or NULL if it has none. */
+static Exp *db_lookup_exp(Db_conn *conn, Dictionary dict, const char *s)
 {
-	assert(2 == argc, "Bad column count");
-	assert(argv[0], "NULL column value");
-	char * scriword = argv[0];
-	char * wclass = argv[1];
+	sqlite3_stmt *stmt = get_stmt(conn, STMT_DISJUNCT);
+	if (NULL == stmt) return NULL;
 
-	/* Now look up the expressions for each word */
-	cbdata* bs = user_data;
-	bs->exp = NULL;
-	db_lookup_exp(bs->dict, wclass, bs);
-
-	/* Well, if we found a classname for a word, then there really,
-	 * really should be able to find one or more corresponding disjuncts.
-	 * However, it is possible to have corrupted databases which do not
-	 * have any disjuncts for a word class.  We complain about those.
-	 */
-	assert(NULL != bs->exp, "Missing disjuncts for word %s %s",
-		scriword, wclass);
+	Exp *exp = NULL;
+	sqlite3_bind_text(stmt, 1, s, -1, SQLITE_STATIC);
+	while (SQLITE_ROW == sqlite3_step(stmt))
+	{
+		db_lock(conn->handle);
+		add_disjunct(dict, &exp,
+		             (const char *)sqlite3_column_text(stmt, 0),
+		             (const char *)sqlite3_column_text(stmt, 1));
+		db_unlock(conn->handle);
+	}
+	sqlite3_reset(stmt);
 
-#if HAVE_THREADS_H
-	mtx_lock(&global_mutex);
-#endif
-	/* Put each word into a Dict_node. */
-	Dict_node *dn = dict_node_new();
-	dn->string = string_set_add(scriword, bs->dict->string_set);
-	dn->right = bs->dn;
-	dn->exp = bs->exp;
-	bs->dn = dn;
-#if HAVE_THREADS_H
-	mtx_unlock(&global_mutex);
-#endif
+	lgdebug(D_SQL+1, "Found expression for class %s: %s\n",
+	        s, exp_stringify(exp));
 
-	return 0;
+	return exp;
 }
 
-static void
-db_lookup_common(Dictionary dict, const char *s, const char *equals,
-                 int (*cb)(void *, int, char **, char **),
-                 cbdata* bs)
+/** Put a dictionary entry for \p subscript in front of \p dn. */
+static Dict_node *db_add_dict_node(Db_conn *conn, Dictionary dict,
+                                   Dict_node *dn, const char *subscript)
 {
-	sqlite3 *db = dict->db_handle;
-	dyn_str *qry;
+	Dict_node *new_dn = dict_node_new();
 
-	/* Escape single-quotes.  That is, replace single-quotes by
-	 * two single-quotes. e.g. don't --> don''t */
-	char * es = escape_quotes(s);
+	db_lock(conn->handle);
+	new_dn->string = string_set_add(subscript, dict->string_set);
+	db_unlock(conn->handle);
+	new_dn->right = dn;
 
-	/* The token to look up is called the 'morpheme'. */
-	qry = dyn_str_new();
-	dyn_strcat(qry, "SELECT subscript, classname FROM Morphemes WHERE morpheme ");
-	dyn_strcat(qry, equals);
-	dyn_strcat(qry, " \'");
-	dyn_strcat(qry, es);
-	dyn_strcat(qry, "\';");
+	return new_dn;
+}
 
-	if (es != s) free(es);
+/**
+ * Return the dictionary entries of the morphemes that are equal to
+ * (STMT_MORPHEME) or match (STMT_GLOB) the string \p s.
+ */
+static Dict_node *db_lookup_common(Db_conn *conn, Dictionary dict,
+                                   Stmt_id id, const char *s)
+{
+	sqlite3_stmt *stmt = get_stmt(conn, id);
+	if (NULL == stmt) return NULL;
+
+	Dict_node *dn = NULL;
+	sqlite3_bind_text(stmt, 1, s, -1, SQLITE_STATIC);
+	while (SQLITE_ROW == sqlite3_step(stmt))
+	{
+		const char *subscript = (const char *)sqlite3_column_text(stmt, 0);
+		const char *classname = (const char *)sqlite3_column_text(stmt, 1);
+		assert(NULL != subscript, "NULL column value");
+
+		/* Well, if we found a classname for a word, then there really,
+		 * really should be able to find one or more corresponding
+		 * disjuncts. However, it is possible to have corrupted databases
+		 * which do not have any disjuncts for a word class.  We complain
+		 * about those.
+		 */
+		Exp *exp = db_lookup_exp(conn, dict, classname);
+		assert(NULL != exp, "Missing disjuncts for word %s %s",
+		       subscript, classname);
+
+		dn = db_add_dict_node(conn, dict, dn, subscript);
+		dn->exp = exp;
+	}
+	sqlite3_reset(stmt);
 
-	sqlite3_exec(db, qry->str, cb, bs, NULL);
-	dyn_str_delete(qry);
+	return dn;
 }
 
 static bool db_lookup(Dictionary dict, const char *s)
 {
-	cbdata bs;
-	bs.dict = dict;
-	bs.found = false;
-	db_lookup_common(dict, s, "=", exists_cb, &bs);
-	return bs.found;
+	Db_conn *conn = conn_acquire(dict->db_handle);
+	if (NULL == conn) return false;
+
+	bool found = false;
+	sqlite3_stmt *stmt = get_stmt(conn, STMT_MORPHEME);
+	if (NULL != stmt)
+	{
+		sqlite3_bind_text(stmt, 1, s, -1, SQLITE_STATIC);
+		found = (SQLITE_ROW == sqlite3_step(stmt));
+		sqlite3_reset(stmt);
+	}
+
+	conn_release(conn);
+	return found;
 }
 
 static Dict_node * db_lookup_list(Dictionary dict, const char *s)
 {
-	cbdata bs;
-	bs.dict = dict;
-	bs.dn = NULL;
-	db_lookup_common(dict, s, "=", morph_cb, &bs);
+	Db_conn *conn = conn_acquire(dict->db_handle);
+	if (NULL == conn) return NULL;
+
+	Dict_node *dn = db_lookup_common(conn, dict, STMT_MORPHEME, s);
+	conn_release(conn);
+
 	if (verbosity_level(D_SQL))
 	{
-		if (bs.dn)
+		if (dn)
 		{
 			printf("Found expression for word %s: %s\n",
-	        s, exp_stringify(bs.dn->exp));
+	        s, exp_stringify(dn->exp));
 		}
 		else
 		{
 			printf("No expression for word %s\n", s);
 		}
 	}
-	return bs.dn;
+	return dn;
 }
 
 /**
@@ -365,83 +505,216 @@ static Dict_node * db_lookup_list(Dictionary dict, const char *s)
  */
 static Dict_node * db_lookup_wild(Dictionary dict, const char *s)
 {
-	cbdata bs;
-	bs.dict = dict;
-	bs.dn = NULL;
-	db_lookup_common(dict, s, "GLOB", morph_cb, &bs);
+	Db_conn *conn = conn_acquire(dict->db_handle);
+	if (NULL == conn) return NULL;
+
+	Dict_node *dn = db_lookup_common(conn, dict, STMT_GLOB, s);
+	conn_release(conn);
+
 	if (verbosity_level(D_SQL))
 	{
-		if (bs.dn)
+		if (dn)
 		{
 			printf("Found expression for glob %s: %s\n",
-			       s, exp_stringify(bs.dn->exp));
+			       s, exp_stringify(dn->exp));
 		}
 		else
 		{
 			printf("No expression for glob %s\n", s);
 		}
 	}
-	return bs.dn;
+	return dn;
+}
+
+/* ========================================================= */
+/* Bulk lookup. */
+
+static size_t batch_add_class(Db_conn *conn, const char *name)
+{
+	for (size_t i = 0; i < conn->num_classes; i++)
+	{
+		if (0 == strcmp(conn->cls[i].name, name)) return i;
+	}
+
+	if (conn->num_classes == conn->classes_alloced)
+	{
+		conn->classes_alloced = 2 * conn->classes_alloced + 16;
+		conn->cls = realloc(conn->cls,
+		                    conn->classes_alloced * sizeof(*conn->cls));
+	}
+	conn->cls[conn->num_classes] = (Batch_class){ .name = strdup(name) };
+
+	return conn->num_classes++;
+}
+
+static void batch_add_entry(Db_conn *conn, Dict_node *dn, size_t cls)
+{
+	if (conn->num_entries == conn->entries_alloced)
+	{
+		conn->entries_alloced = 2 * conn->entries_alloced + 16;
+		conn->entry = realloc(conn->entry,
+		                      conn->entries_alloced * sizeof(*conn->entry));
+	}
+	conn->entry[conn->num_entries++] = (Batch_entry){ .dn = dn, .cls = cls };
+}
+
+static void batch_clear(Db_conn *conn)
+{
+	for (size_t i = 0; i < conn->num_classes; i++)
+		free(conn->cls[i].name);
+
+	conn->num_classes = 0;
+	conn->num_entries = 0;
+}
+
+/**
+ * Bind the parameters of a batched statement to the \p num first
+ * strings of \p s. Return the number of bound strings, which is at
+ * most DB_BATCH_SIZE.
+ */
+static size_t batch_bind(sqlite3_stmt *stmt, const char **s, size_t num)
+{
+	size_t n = MIN(num, DB_BATCH_SIZE);
+
+	for (size_t i = 0; i < DB_BATCH_SIZE; i++)
+	{
+		if (i < n)
+			sqlite3_bind_text(stmt, i+1, s[i], -1, SQLITE_STATIC);
+		else
+			sqlite3_bind_null(stmt, i+1);
+	}
+
+	return n;
+}
+
+/**
+ * Look up the dictionary entries of \p num words with a few `IN (...)`
+ * queries, instead of a query per word and a query per word class.
+ * On success, put the entries of words[i] in dn[i] and return true.
+ */
+static bool db_lookup_bulk(Dictionary dict, const char **words, size_t num,
+                           Dict_node **dn)
+{
+	Db_conn *conn = conn_acquire(dict->db_handle);
+	if (NULL == conn) return false;
+
+	memset(dn, 0, num * sizeof(*dn));
+
+	sqlite3_stmt *stmt = get_stmt(conn, STMT_MORPHEME_BATCH);
+	if (NULL == stmt) goto failure;
+
+	for (size_t first = 0; first < num; first += DB_BATCH_SIZE)
+	{
+		size_t n = batch_bind(stmt, &words[first], num - first);
+		while (SQLITE_ROW == sqlite3_step(stmt))
+		{
+			const char *morpheme = (const char *)sqlite3_column_text(stmt, 0);
+			const char *subscript = (const char *)sqlite3_column_text(stmt, 1);
+			const char *classname = (const char *)sqlite3_column_text(stmt, 2);
+			assert((NULL != subscript) && (NULL != classname),
+			       "NULL column value");
+
+			size_t i;
+			for (i = first; i < first + n; i++)
+				if (0 == strcmp(words[i], morpheme)) break;
+			if (first + n == i) continue;
+
+			dn[i] = db_add_dict_node(conn, dict, dn[i], subscript);
+			batch_add_entry(conn, dn[i], batch_add_class(conn, classname));
+		}
+		sqlite3_reset(stmt);
+	}
+
+	stmt = get_stmt(conn, STMT_DISJUNCT_BATCH);
+	if (NULL == stmt) goto failure;
+
+	for (size_t first = 0; first < conn->num_classes; first += DB_BATCH_SIZE)
+	{
+		const char *names[DB_BATCH_SIZE];
+		size_t n = MIN(conn->num_classes - first, DB_BATCH_SIZE);
+		for (size_t i = 0; i < n; i++)
+			names[i] = conn->cls[first + i].name;
+
+		batch_bind(stmt, names, n);
+		while (SQLITE_ROW == sqlite3_step(stmt))
+		{
+			const char *classname = (const char *)sqlite3_column_text(stmt, 0);
+			Batch_class *bc = &conn->cls[batch_add_class(conn, classname)];
+
+			db_lock(conn->handle);
+			add_disjunct(dict, &bc->exp,
+			             (const char *)sqlite3_column_text(stmt, 1),
+			             (const char *)sqlite3_column_text(stmt, 2));
+			db_unlock(conn->handle);
+		}
+		sqlite3_reset(stmt);
+	}
+
+	/* Well, if we found a classname for a word, then there really,
+	 * really should be able to find one or more corresponding disjuncts.
+	 */
+	for (size_t i = 0; i < conn->num_entries; i++)
+	{
+		Batch_entry *be = &conn->entry[i];
+		be->dn->exp = conn->cls[be->cls].exp;
+		assert(NULL != be->dn->exp, "Missing disjuncts for word %s %s",
+		       be->dn->string, conn->cls[be->cls].name);
+	}
+
+	lgdebug(D_SQL+1, "Looked up %zu words, %zu classes\n",
+	        num, conn->num_classes);
+
+	batch_clear(conn);
+	conn_release(conn);
+	return true;
+
+failure:
+	for (size_t i = 0; i < num; i++)
+		dict_node_free_list(dn[i]);
+	batch_clear(conn);
+	conn_release(conn);
+	return false;
 }
 
 /* ========================================================= */
 /* Callbacks and functions to support lexical category loading. */
 
 /* Used for `SELECT count(*) FROM foo` type of queries */
-static int count_cb(void *user_data, int argc, char **argv, char **colName)
+static int db_count(Db_conn *conn, Stmt_id id, const char *classname)
 {
-	cbdata* bs = user_data;
+	sqlite3_stmt *stmt = get_stmt(conn, id);
+	if (NULL == stmt) return 0;
 
-	assert(1 == argc, "Bad column count");
-	bs->count = atol(argv[0]);
+	int count = 0;
+	if (NULL != classname)
+		sqlite3_bind_text(stmt, 1, classname, -1, SQLITE_STATIC);
+	if (SQLITE_ROW == sqlite3_step(stmt))
+		count = sqlite3_column_int(stmt, 0);
+	sqlite3_reset(stmt);
 
-	return 0;
+	return count;
 }
 
 /* Record the name of each lexical class */
-static int classname_cb(void *user_data, int argc, char **argv, char **colName)
+static void db_add_classname(Dictionary dict, const char *classname)
 {
-	cbdata* bs = user_data;
-	Dictionary dict = bs->dict;
-
 	/* Assuming here that a class name of a wall is the same as the wall
 	 * name, and a class name of a macro is in macro format. */
-	if (!dict->generate_walls && is_wall(argv[0])) return 0;
-	if (is_macro(argv[0])) return 0;
+	if (!dict->generate_walls && is_wall(classname)) return;
+	if (is_macro(classname)) return;
 
 	/* Add a category. */
 	/* This is intentionally off-by-one, per design. */
 	dict->num_categories++;
 	dict->category[dict->num_categories].num_words = 0;
 	dict->category[dict->num_categories].word = NULL;
-	char* esc = escape_quotes(argv[0]);
 	dict->category[dict->num_categories].name =
-		string_set_add(esc, dict->string_set);
-	if (esc != argv[0]) free(esc);
+		string_set_add(classname, dict->string_set);
 
 	char category_string[16];     /* For the tokenizer - not used here */
 	snprintf(category_string, sizeof(category_string), " %x",
 	         dict->num_categories); /* ' ': See comment in build_disjuncts() */
 	string_set_add(category_string, dict->string_set);
-
-	return 0;
-}
-
-/* Record the words in each lexical class */
-static int classword_cb(void *user_data, int argc, char **argv, char **colName)
-{
-	cbdata* bs = user_data;
-	Dictionary dict = bs->dict;
-
-	char *word = strdupa(argv[0]);
-	patch_subscript(word);
-
-	/* Add the word. */
-	dict->category[dict->num_categories].word[bs->count] =
-		string_set_add(word, dict->string_set);
-	bs->count++;
-
-	return 0;
 }
 
 /* The current design for generation requires that all word categories
@@ -451,76 +724,65 @@ static int classword_cb(void *user_data, int argc, char **argv, char **colName)
  */
 static void db_add_categories(Dictionary dict)
 {
-	sqlite3 *db = dict->db_handle;
-	cbdata bs;
-	bs.dict = dict;
-#if HAVE_THREADS_H
-	mtx_lock(&global_mutex);
-#endif
+	Db_conn *conn = conn_acquire(dict->db_handle);
+	if (NULL == conn) return;
 
 	/* How many lexical categories are there? Find out. */
-	sqlite3_exec(db, "SELECT count(DISTINCT classname) FROM Disjuncts;",
-		count_cb, &bs, NULL);
+	int num_classes = db_count(conn, STMT_NUM_CLASSES, NULL);
 
 	dict->num_categories = 0;
-	dict->num_categories_alloced = 1 + bs.count + 1; // skip slot 0 + terminator
+	dict->num_categories_alloced = 1 + num_classes + 1; // skip slot 0 + terminator
 	dict->category = malloc(dict->num_categories_alloced *
 	                        sizeof(*dict->category));
 
-	sqlite3_exec(db, "SELECT DISTINCT classname FROM Disjuncts;",
-		classname_cb, &bs, NULL);
+	sqlite3_stmt *stmt = get_stmt(conn, STMT_CLASSES);
+	if (NULL != stmt)
+	{
+		while (SQLITE_ROW == sqlite3_step(stmt))
+			db_add_classname(dict, (const char *)sqlite3_column_text(stmt, 0));
+		sqlite3_reset(stmt);
+	}
 
 	/* Category 0 is unused, intentionally. Not sure why. */
 	unsigned int ncat = dict->num_categories;
 	for (unsigned int i=1; i<=ncat; i++)
 	{
-		/* For each category, get the expression. */
-		dyn_str *qry = dyn_str_new();
-		dyn_strcat(qry,
-			"SELECT disjunct, cost FROM Disjuncts WHERE classname = \'");
-		dyn_strcat(qry, dict->category[i].name);
-		dyn_strcat(qry, "\';");
+		const char *classname = dict->category[i].name;
 
-		bs.exp = NULL;
-		sqlite3_exec(db, qry->str, exp_cb, &bs, NULL);
-		dyn_str_delete(qry);
-
-		dict->category[i].exp = bs.exp;
+		/* For each category, get the expression. */
+		dict->category[i].exp = db_lookup_exp(conn, dict, classname);
 
 		/* ------------------ */
 		/* For each category, get the number of words in the category */
-		qry = dyn_str_new();
-		dyn_strcat(qry,
-			"SELECT count(*) FROM Morphemes WHERE classname = \'");
-		dyn_strcat(qry, dict->category[i].name);
-		dyn_strcat(qry, "\';");
+		int num_words = db_count(conn, STMT_NUM_CLASS_WORDS, classname);
 
-		sqlite3_exec(db, qry->str, count_cb, &bs, NULL);
-		dyn_str_delete(qry);
-
-		dict->category[i].num_words = bs.count;
+		dict->category[i].num_words = num_words;
 		dict->category[i].word =
-			malloc(bs.count * sizeof(*dict->category[0].word));
+			malloc(num_words * sizeof(*dict->category[0].word));
 
 		/* ------------------ */
 		/* For each category, get the (subscripted) words in the category */
-		qry = dyn_str_new();
-		dyn_strcat(qry,
-			"SELECT subscript FROM Morphemes WHERE classname = \'");
-		dyn_strcat(qry, dict->category[i].name);
-		dyn_strcat(qry, "\';");
-
-		dict->num_categories = i;
-		bs.count = 0;
-		sqlite3_exec(db, qry->str, classword_cb, &bs, NULL);
-		dyn_str_delete(qry);
+		stmt = get_stmt(conn, STMT_CLASS_WORDS);
+		if (NULL == stmt) continue;
+
+		int count = 0;
+		sqlite3_bind_text(stmt, 1, classname, -1, SQLITE_STATIC);
+		while ((SQLITE_ROW == sqlite3_step(stmt)) && (count < num_words))
+		{
+			char *word = strdupa((const char *)sqlite3_column_text(stmt, 0));
+			patch_subscript(word);
+
+			/* Add the word. */
+			dict->category[i].word[count++] =
+				string_set_add(word, dict->string_set);
+		}
+		sqlite3_reset(stmt);
 	}
 
 	/* Set the termination entry. */
 	dict->category[dict->num_categories + 1].num_words = 0;
-#if HAVE_THREADS_H
-	mtx_unlock(&global_mutex);
-#endif
+
+	conn_release(conn);
 }
 
 /* ========================================================= */
@@ -528,10 +790,6 @@ static void db_add_categories(Dictionary dict)
 
 static void* db_open(const char * fullname, const void * user_data)
 {
-#if HAVE_THREADS_H
-	mtx_init(&global_mutex, mtx_plain);
-#endif
-
 	/* Is there a file here that can be read? */
 	FILE * fh =  fopen(fullname, "r");
 	if (NULL == fh)
@@ -547,39 +805,52 @@ static void* db_open(const char * fullname, const void * user_data)
 		return NULL;
 
 	/* Found a file, of non-zero length. See if that works. */
-	sqlite3 *db;
-	if (sqlite3_open(fullname, &db))
-	{
-		prt_error("Error: Can't open database %s: %s\n",
-			fullname, sqlite3_errmsg(db));
-		sqlite3_close(db);
+	sqlite3 *db = db_connect(fullname);
+	if (NULL == db)
 		return NULL;
-	}
-	return (void *) db;
+
+	Db_handle *h = malloc(sizeof(Db_handle));
+	memset(h, 0, sizeof(Db_handle));
+	h->name = strdup(fullname);
+#if HAVE_THREADS_H
+	mtx_init(&h->mutex, mtx_plain);
+#endif
+
+	/* Keep the first connection for the first lookups. */
+	Db_conn *conn = malloc(sizeof(Db_conn));
+	memset(conn, 0, sizeof(Db_conn));
+	conn->handle = h;
+	conn->db = db;
+	h->idle = conn;
+
+	return (void *) h;
 }
 
 static void db_close(Dictionary dict)
 {
-	sqlite3 *db = dict->db_handle;
-	if (db)
-		sqlite3_close(db);
+	Db_handle *h = dict->db_handle;
+	if (NULL == h) return;
 
-	dict->db_handle = NULL;
-}
+	while (NULL != h->idle)
+	{
+		Db_conn *conn = h->idle;
+		h->idle = conn->next;
+		conn_delete(conn);
+	}
+#if HAVE_THREADS_H
+	mtx_destroy(&h->mutex);
+#endif
+	free(h->name);
+	free(h);
 
-static void db_start_lookup(Dictionary dict, Sentence sent)
-{
+	dict->db_handle = NULL;
 }
 
 static void db_end_lookup(Dictionary dict, Sentence sent)
 {
-#if HAVE_THREADS_H
-	mtx_lock(&global_mutex);
-#endif
+	db_lock(dict->db_handle);
 	condesc_setup(dict);
-#if HAVE_THREADS_H
-	mtx_unlock(&global_mutex);
-#endif
+	db_unlock(dict->db_handle);
 }
 
 Dictionary dictionary_create_from_db(const char *lang)
@@ -621,11 +892,15 @@ Dictionary dictionary_create_from_db(const char *lang)
 	dict->lookup_wild = db_lookup_wild;
 	dict->free_lookup = dict_node_free_lookup;
 	dict->exists_lookup = db_lookup;
-	dict->start_lookup = db_start_lookup;
+	dict->lookup_bulk = db_lookup_bulk;
+	dict->start_lookup = dict_lookup_noop;
 	dict->end_lookup = db_end_lookup;
 	dict->clear_cache = dict_node_noop;
 	dict->close = db_close;
 
+	if (NULL == dict->db_handle)
+		goto failure;
+
 	dict->dynamic_lookup = true;
 	condesc_init(dict, 1<<8);
 
@@ -170,8 +170,8 @@ void free_sentence_disjuncts(Sentence sent, bool category_too)
 	}
 	else if (NULL != sent->Disjunct_pool)
 	{
-		pool_delete(sent->Disjunct_pool);
-		pool_delete(sent->Connector_pool);
+		pool_recycle(sent->Disjunct_pool);
+		pool_recycle(sent->Connector_pool);
 		sent->Disjunct_pool = NULL;
 		sent->Connector_pool = NULL;
 	}
@@ -344,10 +344,12 @@ static void disjunct_dup_table_delete(disjunct_dup_table *dt)
  * disjunct can never be eliminated (it cannot be a duplicate of
  * anything before it), the argument disjunct list always points to the
  * new list.
+ * Added gword_set elements are allocated in the pool of \p sent.
  *
  * @return The number of eliminated disjuncts.
  */
-unsigned int eliminate_duplicate_disjuncts(Disjunct *dw, bool multi_string)
+unsigned int eliminate_duplicate_disjuncts(Sentence sent, Disjunct *dw,
+                                           bool multi_string)
 {
 	unsigned int count = 0;
 	disjunct_dup_table *dt;
@@ -397,7 +399,8 @@ unsigned int eliminate_duplicate_disjuncts(Disjunct *dw, bool multi_string)
 			{
 				if (d->cost < dx->cost) dx->cost = d->cost;
 				dx->originating_gword =
-					gword_set_union(dx->originating_gword, d->originating_gword);
+					gword_set_union(sent, dx->originating_gword,
+					                d->originating_gword);
 			}
 
 			count++;
@@ -1050,6 +1053,11 @@ Tracon_sharing *pack_sentence_for_parsing(Sentence sent)
 
 	Tracon_sharing *ts = pack_sentence(sent, false);
 
+	/* Remember the packed disjuncts, for reuse_parsing_disjuncts(). */
+	ts->d = malloc(sent->length * sizeof(Disjunct *));
+	for (WordIdx w = 0; w < sent->length; w++)
+		ts->d[w] = sent->word[w].d;
+
 	if (verbosity_level(D_SPEC+2))
 	{
 		printf("pack_sentence_for_parsing (null_count %u):\n", sent->null_count);
@@ -1102,3 +1110,54 @@ void free_saved_memblock(void * blk)
 {
 	free(blk);
 }
+
+static bool connectors_equal_parse(const Connector *c1, const Connector *c2)
+{
+	for (; (NULL != c1) && (NULL != c2); c1 = c1->next, c2 = c2->next)
+	{
+		if ((c1->desc != c2->desc) || (c1->multi != c2->multi) ||
+		    (c1->nearest_word != c2->nearest_word) ||
+		    (c1->farthest_word != c2->farthest_word))
+			return false;
+	}
+
+	return (c1 == c2); /* Both NULL */
+}
+
+/**
+ * Check whether pruning has left the sentence with the same disjuncts
+ * as those that have been packed into \p ts_parsing (in the same order
+ * and with the same connector nearest/farthest words). This happens when
+ * pruning for a greater null count doesn't leave additional disjuncts.
+ * In that case, set the sentence disjuncts back to the packed ones, so
+ * the tracon IDs, the fast matcher and the count tables which have
+ * been generated for them can be reused.
+ *
+ * @return TRUE iff the packed disjuncts are the same (and are now used).
+ */
+bool reuse_parsing_disjuncts(Sentence sent, Tracon_sharing *ts_parsing)
+{
+	if ((NULL == ts_parsing) || (NULL == ts_parsing->d)) return false;
+
+	for (WordIdx w = 0; w < sent->length; w++)
+	{
+		Disjunct *d1 = sent->word[w].d;
+		Disjunct *d2 = ts_parsing->d[w];
+
+		for (; (NULL != d1) && (NULL != d2); d1 = d1->next, d2 = d2->next)
+		{
+			if ((d1->cost != d2->cost) ||
+			    (d1->word_string != d2->word_string) ||
+			    (d1->originating_gword != d2->originating_gword) ||
+			    !connectors_equal_parse(d1->left, d2->left) ||
+			    !connectors_equal_parse(d1->right, d2->right))
+				return false;
+		}
+		if (d1 != d2) return false; /* Different number of disjuncts */
+	}
+
+	for (WordIdx w = 0; w < sent->length; w++)
+		sent->word[w].d = ts_parsing->d[w];
+
+	return true;
+}
@@ -85,7 +85,7 @@ void free_categories(Sentence);
 void free_categories_from_disjunct_array(Disjunct *, unsigned int);
 unsigned int count_disjuncts(Disjunct *);
 Disjunct * catenate_disjuncts(Disjunct *, Disjunct *);
-unsigned int eliminate_duplicate_disjuncts(Disjunct *, bool);
+unsigned int eliminate_duplicate_disjuncts(Sentence, Disjunct *, bool);
 int left_connector_count(Disjunct *);
 int right_connector_count(Disjunct *);
 
@@ -176,6 +176,7 @@ struct tracon_sharing_s
 void *save_disjuncts(Sentence, Tracon_sharing *);
 void restore_disjuncts(Sentence, void *, Tracon_sharing *);
 void free_saved_disjuncts(Sentence);
+bool reuse_parsing_disjuncts(Sentence, Tracon_sharing *);
 
 /** Get tracon by (dir, tracon_id). */
 static inline Connector *get_tracon(Tracon_sharing *ts, int dir, int id)
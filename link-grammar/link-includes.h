@@ -115,6 +115,10 @@ link_public_api(Dictionary)
      dictionary_create_default_lang(void);
 link_public_api(const char *)
      dictionary_get_lang(Dictionary);
+link_public_api(bool)
+     dictionary_compile_lang(const char * lang, const char * filename);
+link_public_api(Dictionary)
+     dictionary_create_lang_shared(const char * lang, const char * shm_name);
 
 link_public_api(void)
      dictionary_delete(Dictionary);
@@ -194,6 +198,18 @@ link_public_api(void)
      parse_options_set_max_parse_time(Parse_Options  opts, int secs);
 link_public_api(int)
      parse_options_get_max_parse_time(Parse_Options opts);
+link_public_api(void)
+     parse_options_set_max_parse_time_ms(Parse_Options opts, int msecs);
+link_public_api(int)
+     parse_options_get_max_parse_time_ms(Parse_Options opts);
+link_public_api(void)
+     parse_options_set_max_wall_time_ms(Parse_Options opts, int msecs);
+link_public_api(int)
+     parse_options_get_max_wall_time_ms(Parse_Options opts);
+link_public_api(void)
+     parse_options_set_anytime(Parse_Options opts, bool val);
+link_public_api(bool)
+     parse_options_get_anytime(Parse_Options opts);
 link_public_api(void)
      parse_options_set_cost_model_type(Parse_Options opts, Cost_Model_type cm);
 link_public_api(Cost_Model_type)
@@ -220,6 +236,10 @@ link_public_api(void)
      parse_options_set_repeatable_rand(Parse_Options opts, bool val);
 link_public_api(bool)
      parse_options_get_repeatable_rand(Parse_Options opts);
+link_public_api(void)
+     parse_options_set_count_threads(Parse_Options opts, int val);
+link_public_api(int)
+     parse_options_get_count_threads(Parse_Options opts);
 link_public_api(void)
      parse_options_reset_resources(Parse_Options opts);
 
@@ -286,9 +306,23 @@ link_public_api(float)
      sentence_disjunct_cost(Sentence sent, LinkageIdx linkage_num);
 link_public_api(int)
      sentence_link_cost(Sentence sent, LinkageIdx linkage_num);
+link_public_api(bool)
+     sentence_is_partial(Sentence sent);
+link_public_api(void)
+     sentence_cancel(Sentence sent);
 link_public_api(bool)
      sentence_display_wordgraph(Sentence sent, const char *modestr);
 
+/* Called by sentence_batch_parse() for each sentence, in input order.
+ * The sentence is deleted when it returns. */
+typedef void (*sentence_batch_callback)(Sentence sent, size_t index,
+                                        int num_linkages, void *data);
+link_public_api(int)
+     sentence_batch_parse(Dictionary dict, Parse_Options opts,
+                          const char **sentences, size_t num_sentences,
+                          int num_threads, sentence_batch_callback cb,
+                          void *data);
+
 /**********************************************************************
  *
  * Functions that create and manipulate Linkages.
@@ -308,6 +342,16 @@ link_public_api(Linkage)
 link_public_api(void)
      linkage_delete(Linkage linkage);
 
+/* Iterating over the valid linkages, each one processed on demand */
+typedef struct Linkage_iter_s * Linkage_iter;
+
+link_public_api(Linkage_iter)
+     linkage_iter_create(Sentence sent, Parse_Options opts);
+link_public_api(Linkage)
+     linkage_iter_next(Linkage_iter iter);
+link_public_api(void)
+     linkage_iter_delete(Linkage_iter iter);
+
 /* Individual links in the Linkage */
 link_public_api(size_t)
      linkage_get_num_links(const Linkage linkage);
@@ -17,6 +17,7 @@
 #include <string.h>
 
 #include "analyze-linkage.h"
+#include "api-structures.h"             // Sentence_s
 #include "connectors.h"                 // connector_string
 #include "dict-common/dict-common.h"    // MAX_TOKEN_LENGTH
 #include "linkage.h"
@@ -25,19 +26,19 @@
 /**
  * This returns a string that is the GCD of the two given strings.
  * If the GCD is equal to one of them, a pointer to it is returned.
- * Otherwise a new string for the GCD is put in the string set.
+ * Otherwise the GCD is written to \p l (which should have room for
+ * MAX_TOKEN_LENGTH+1 characters) and \p l is returned.
  *
  * Notes:
  * 1. The head and dependent indicators (lower-case h and d) are
  *    ignored, as the intersection cannot include them.
- * 2. The returned strings is not always in the same string set.
+ * 2. The result depends only on the connector descriptors.
  */
-const char *intersect_strings(String_set *sset, const Connector *c1,
-                                     const Connector *c2)
+const char *spell_link_name(char *l, const Connector *c1,
+                            const Connector *c2)
 {
 	const condesc_t *d1 = c1->desc;
 	const condesc_t *d2 = c2->desc;
-	char l[MAX_TOKEN_LENGTH + 1];
 
 	/* Ignore the head/dependent encoding at bit 0. */
 	lc_enc_t lc1_letters = d1->lc_letters >> 1;
@@ -78,21 +79,49 @@ const char *intersect_strings(String_set *sset, const Connector *c1,
 	while ((*s1++ != '0') && (*s2++ != 0));
 #endif
 
+	return l;
+}
+
+/**
+ * Like spell_link_name(), but put a new string for the GCD in the
+ * string set. The returned string is not always in the same string set.
+ */
+const char *intersect_strings(String_set *sset, const Connector *c1,
+                                     const Connector *c2)
+{
+	char l[MAX_TOKEN_LENGTH + 1];
+	const char *name = spell_link_name(l, c1, c2);
+
+	if (name != l) return name;
 	return string_set_add(l, sset);
 }
 
 /**
  * The name of the link is set to be the GCD of the names of
- * its two endpoints. Must be called after each extract_links(),
- * etc. since that call issues a brand-new set of links into
- * parse_info.
+ * its two endpoints. The link names are not needed for checking and
+ * post-processing the linkages, so this is done only for linkages that
+ * are handed to the user (see linkage_create()). Links that already
+ * have a name are skipped.
  */
 void compute_link_names(Linkage lkg, String_set *sset)
 {
 	size_t i;
 	for (i = 0; i < lkg->num_links; i++)
 	{
+		if (NULL != lkg->link_array[i].link_name) continue;
 		lkg->link_array[i].link_name = intersect_strings(sset,
 			lkg->link_array[i].lc, lkg->link_array[i].rc);
 	}
 }
+
+/**
+ * Return the name of link \p i of \p lkg, computing it if needed.
+ */
+const char *linkage_link_name(Linkage lkg, LinkIdx i)
+{
+	Link *lnk = &lkg->link_array[i];
+
+	if (NULL == lnk->link_name)
+		lnk->link_name = intersect_strings(lkg->sent->string_set, lnk->lc, lnk->rc);
+	return lnk->link_name;
+}
@@ -17,6 +17,8 @@
 #include "link-includes.h"
 
 void compute_link_names(Linkage, String_set *);
+const char *linkage_link_name(Linkage, LinkIdx);
+const char *spell_link_name(char *, const Connector *, const Connector *);
 const char *intersect_strings(String_set *, const Connector *,
                               const Connector *);
 #endif /* _ANALYZE_LINKAGE_H */
@@ -14,6 +14,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "analyze-linkage.h"            // compute_link_names
 #include "api-structures.h"
 #include "connectors.h"
 #include "dict-common/dict-api.h"       // linkage_get_categories
@@ -24,6 +25,7 @@
 #include "link-includes.h"
 #include "linkage.h"
 #include "lisjuncts.h"
+#include "parse/parse.h"                // extract_next_linkage
 #include "sat-solver/sat-encoder.h"
 #include "string-set.h"
 #include "tokenize/wordgraph.h"
@@ -173,7 +175,7 @@ static inline bool is_morphology_link(const char *link_name)
  *
  * The remap[] elements indicate the new WordIdx of the word.
  * A value which is -1 indicates a discarded word.
- * A NULL link_name indicates a discarded link.
+ * The discarded links are marked by their "discarded" field.
  */
 static void remap_linkages(Linkage lkg, const int *remap)
 {
@@ -183,7 +185,7 @@ static void remap_linkages(Linkage lkg, const int *remap)
 	{
 		Link *old_lnk = &lkg->link_array[i];
 
-		if (NULL != old_lnk->link_name &&  /* discarded link */
+		if (!old_lnk->discarded &&
 		   (-1 != remap[old_lnk->rw]) && (-1 != remap[old_lnk->lw]))
 		{
 			Link *new_lnk = &lkg->link_array[j];
@@ -204,6 +206,7 @@ static void remap_linkages(Linkage lkg, const int *remap)
 			old_lnk->rc = ctmp;
 
 			new_lnk->link_name = old_lnk->link_name;
+			new_lnk->discarded = false;
 
 			j++;
 		}
@@ -347,7 +350,7 @@ static void compute_chosen_words(Sentence sent, Linkage linkage,
 			if (is_morphology_link(lnk->link_name))
 			{
 				/* Mark link for discarding. */
-				lnk->link_name = NULL;
+				lnk->discarded = true;
 			}
 			else
 			{
@@ -800,6 +803,7 @@ Linkage linkage_create(LinkageIdx k, Sentence sent, Parse_Options opts)
 	}
 
 	/* Perform remaining initialization we haven't done yet...*/
+	compute_link_names(linkage, sent->string_set);
 	if (!IS_GENERATION(sent->dict))
 		compute_chosen_words(sent, linkage, opts);
 
@@ -813,6 +817,127 @@ void linkage_delete(Linkage linkage)
 	/* Currently a no-op */
 }
 
+/* ======================================================== */
+/* Linkage iterator.
+ *
+ * sentence_parse() extracts, checks and post-processes up to
+ * linkage_limit linkages before it returns. A caller that needs only
+ * the first few valid linkages can instead use:
+ *
+ *    Linkage_iter iter = linkage_iter_create(sent, opts);
+ *    while ((linkage = linkage_iter_next(iter)) != NULL) { ... }
+ *    linkage_iter_delete(iter);
+ *
+ * Here the parse stops after building the parse-set, and each call to
+ * linkage_iter_next() extracts the next valid linkage in cost order.
+ * Linkages with P.P. violations are skipped.
+ */
+
+struct Linkage_iter_s
+{
+	Sentence sent;
+	Parse_Options opts;
+	struct Linkage_s linkage;   /* The last returned linkage */
+	bool have_linkage;          /* linkage needs freeing */
+	unsigned int rank;          /* Of the next linkage in the parse-set */
+	LinkageIdx index;           /* Next linkage in sent->lnkages */
+	size_t num_returned;
+};
+
+/**
+ * Parse \p sent with the given minimum null count, leaving the
+ * parse-set in sent->extractor instead of processing the linkages.
+ * The caller's \p opts are not modified.
+ */
+static int deferred_parse(Sentence sent, Parse_Options opts,
+                          short min_null_count)
+{
+	struct Parse_Options_s deferred_opts = *opts;
+	deferred_opts.min_null_count = min_null_count;
+
+	sent->defer_linkages = true;
+	int rc = sentence_parse(sent, &deferred_opts);
+	sent->defer_linkages = false;
+
+	return rc;
+}
+
+/**
+ * Parse \p sent, deferring the linkage processing to linkage_iter_next().
+ * Return NULL on a parse error.
+ * As with sentence_parse(), \p opts must not be changed during the
+ * iteration. The linkages are not available through linkage_create().
+ */
+Linkage_iter linkage_iter_create(Sentence sent, Parse_Options opts)
+{
+	if (!sent || !opts) return NULL;
+	if (deferred_parse(sent, opts, opts->min_null_count) < 0) return NULL;
+
+	Linkage_iter iter = malloc(sizeof(struct Linkage_iter_s));
+	memset(iter, 0, sizeof(struct Linkage_iter_s));
+	iter->sent = sent;
+	iter->opts = opts;
+
+	return iter;
+}
+
+/**
+ * Return the next valid linkage, or NULL if there are no more.
+ * The returned linkage is valid until the next call.
+ * If no valid linkage is found with the null count of the parse, the
+ * sentence is parsed again with more nulls, up to the maximum null count.
+ */
+Linkage linkage_iter_next(Linkage_iter iter)
+{
+	if (!iter) return NULL;
+	Sentence sent = iter->sent;
+	Parse_Options opts = iter->opts;
+
+	if (iter->have_linkage)
+	{
+		free_linkage(&iter->linkage);
+		iter->have_linkage = false;
+	}
+
+	/* Generation and the SAT parser don't defer the linkages. */
+	if (NULL == sent->extractor)
+	{
+		if (iter->index >= sent->num_valid_linkages) return NULL;
+		return linkage_create(iter->index++, sent, opts);
+	}
+
+	while (!extract_next_linkage(sent, opts, &iter->linkage, &iter->rank))
+	{
+		if ((iter->num_returned > 0) ||
+		    (sent->null_count >= (unsigned int)opts->max_null_count))
+			return NULL;
+
+		int rc = deferred_parse(sent, opts, (short)(sent->null_count + 1));
+
+		if ((rc < 0) || (NULL == sent->extractor)) return NULL;
+		iter->rank = 0;
+	}
+
+	Linkage linkage = &iter->linkage;
+	iter->have_linkage = true;
+	iter->num_returned++;
+
+	compute_link_names(linkage, sent->string_set);
+	compute_chosen_words(sent, linkage, opts);
+	linkage->is_sent_long = (linkage->num_words >= opts->twopass_length);
+
+	return linkage;
+}
+
+void linkage_iter_delete(Linkage_iter iter)
+{
+	if (!iter) return;
+
+	if (iter->have_linkage) free_linkage(&iter->linkage);
+	free_deferred_linkages(iter->sent);
+	free(iter);
+}
+
 size_t linkage_get_num_words(const Linkage linkage)
 {
 	if (!linkage) return 0;
@@ -855,7 +980,7 @@ WordIdx linkage_get_link_rword(const Linkage linkage, LinkIdx index)
 const char * linkage_get_link_label(const Linkage linkage, LinkIdx index)
 {
 	if (!verify_link_index(linkage, index)) return NULL;
-	return linkage->link_array[index].link_name;
+	return linkage_link_name(linkage, index);
 }
 
 const char * linkage_get_link_llabel(const Linkage linkage, LinkIdx index)
@@ -77,9 +77,11 @@ struct Link_s
 {
 	uint16_t lw;            /* Offset into Linkage->word NOT Sentence->word */
 	uint16_t rw;            /* Offset into Linkage->word NOT Sentence->word */
+	bool discarded;         /* To be removed by remap_linkages() */
 	Connector * lc;
 	Connector * rc;
-	const char * link_name; /* Spelling of full link name */
+	const char * link_name; /* Spelling of full link name, or NULL if not
+	                           computed yet (see linkage_link_name()) */
 };
 
 void compute_generated_words(Sentence, Linkage);
@@ -320,6 +320,28 @@ bool sane_linkage_morphism(Sentence sent, Linkage lkg, Parse_Options opts)
 
 	lkg->wg_path = NULL;
 
+	/* First, a quick check that the chosen disjuncts are all from the
+	 * same alternatives. The linkages of extract_links() have already
+	 * passed it, but not those of extract_best_links() and the SAT
+	 * parser. */
+	if (0 != sent->alt_bitmap_len)
+	{
+		size_t alt_acc_len = 2 * sent->alt_bitmap_len;
+		uint64_t *alt_acc = alloca(alt_acc_len * sizeof(uint64_t));
+		memset(alt_acc, 0, alt_acc_len * sizeof(uint64_t));
+
+		for (i = 0; i < lkg->num_words; i++)
+		{
+			Disjunct *cdj = lkg->chosen_disjuncts[i];
+			if (NULL == cdj) continue;
+			if (!alt_bitmap_add(sent, alt_acc, cdj->originating_gword))
+			{
+				lgdebug(D_SLM, "lkg=%p Word %zu: Different alternative\n", lkg, i);
+				return false;
+			}
+		}
+	}
+
 	/* Populate the path word queue, initializing the path to NULL. */
 	for (next = sent->wordgraph->next; *next; next++)
 	{
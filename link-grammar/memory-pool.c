@@ -10,6 +10,9 @@
 /*************************************************************************/
 
 #include <errno.h>                      // errno
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+#include <threads.h>
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
 
 #include "error.h"
 #include "memory-pool.h"
@@ -40,6 +43,96 @@ static size_t align_size(size_t element_size)
 
 /* The address of the next allocated block is at the end of the block. */
 
+#if POOL_ALLOCATOR
+/*
+ * Per-thread arena of recycled pools.
+ *
+ * Each sentence creates its pools and deletes them when it is deleted.
+ * For a stream of sentences, this allocates and frees the same memory
+ * blocks over and over again (and for large blocks, it means mmap()
+ * and munmap() calls). Instead, pool_recycle() keeps the pool in the
+ * arena of the current thread, and pool_new() takes a matching pool
+ * from there if one exists, so its blocks are reused with their high
+ * water mark.
+ */
+typedef struct
+{
+	Pool_desc *pool[POOL_ARENA_SIZE]; /* Most recently recycled last */
+	unsigned int num_pools;
+	size_t bytes;
+} pool_arena;
+
+static TLS pool_arena arena;
+
+static Pool_desc *arena_remove_pool(unsigned int i)
+{
+	Pool_desc *mp = arena.pool[i];
+
+	arena.bytes -= mp->alloced_bytes;
+	arena.num_pools--;
+	memmove(&arena.pool[i], &arena.pool[i+1],
+	        (arena.num_pools - i) * sizeof(*arena.pool));
+
+	return mp;
+}
+
+/* pool_delete() is defined (and its debug macro is undefined) below. */
+static void arena_free_pool(Pool_desc *mp)
+{
+	pool_delete(mp);
+}
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+/* Free the arena of a thread when it exits. It is called in the
+ * exiting thread, so its argument (the same arena) is not needed. */
+static void free_tls_arena(void *ptr_to_arena)
+{
+	while (arena.num_pools > 0)
+		arena_free_pool(arena_remove_pool(arena.num_pools - 1));
+}
+
+static tss_t key;
+static void make_key(void)
+{
+	tss_create(&key, free_tls_arena);
+}
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+static size_t arena_max_bytes(void)
+{
+	size_t max_mbytes = POOL_ARENA_DEFAULT_MBYTES;
+	const char *arena_size = test_enabled("pool-arena");
+	if ((NULL != arena_size) && (':' == arena_size[0]))
+		max_mbytes = (size_t)atoi(arena_size+1);
+
+	return max_mbytes * 1024 * 1024;
+}
+
+/**
+ * Take out of the arena a recycled pool with the same element layout,
+ * whose blocks have at least \p num_elements (but not much more).
+ * @return The pool, or NULL if none.
+ */
+static Pool_desc *arena_take_pool(size_t num_elements, size_t element_size,
+                                  size_t alignment, bool zero_out)
+{
+	for (unsigned int i = arena.num_pools; i-- > 0; )
+	{
+		Pool_desc *mp = arena.pool[i];
+
+		if ((mp->element_size == element_size) &&
+		    (mp->alignment == alignment) && (mp->zero_out == zero_out) &&
+		    (mp->num_elements >= num_elements) &&
+		    (mp->num_elements <= 2 * num_elements))
+		{
+			return arena_remove_pool(i);
+		}
+	}
+
+	return NULL;
+}
+#endif /* POOL_ALLOCATOR */
+
 /**
  * Create a memory pool descriptor.
  * 1. If required, set the allocation size to a power of 2 of the element size.
@@ -52,22 +145,39 @@ Pool_desc *pool_new(const char *func, const char *name,
                     size_t num_elements, size_t element_size,
                     bool zero_out, bool align, bool exact)
 {
-	Pool_desc *mp = malloc(sizeof(Pool_desc));
-
-	mp->func = func;
-	mp->name = name;
+	Pool_desc *mp;
+	size_t alignment = MIN_ALIGNMENT;
 
 	if (align)
 	{
-		mp->element_size = align_size(element_size);
-		mp->alignment = MAX(MIN_ALIGNMENT, mp->element_size);
-		mp->alignment = MIN(MAX_ALIGNMENT, mp->alignment);
+		element_size = align_size(element_size);
+		alignment = MAX(MIN_ALIGNMENT, element_size);
+		alignment = MIN(MAX_ALIGNMENT, alignment);
 	}
-	else
+
+#if POOL_ALLOCATOR
+	mp = arena_take_pool(num_elements, element_size, alignment, zero_out);
+	if (NULL != mp)
 	{
-		mp->element_size = element_size;
-		mp->alignment = MIN_ALIGNMENT;
+		mp->func = func;
+		mp->name = name;
+#ifdef POOL_EXACT
+		mp->exact = exact;
+#endif /* POOL_EXACT */
+		pool_reuse(mp);
+
+		lgdebug(+D_MEMPOOL, "Recycled %zu elements (pool '%s' created in %s())\n",
+		        mp->alloced_elements, mp->name, mp->func);
+		return mp;
 	}
+#endif /* POOL_ALLOCATOR */
+
+	mp = malloc(sizeof(Pool_desc));
+
+	mp->func = func;
+	mp->name = name;
+	mp->element_size = element_size;
+	mp->alignment = alignment;
 	mp->data_size = ALIGN(num_elements * mp->element_size, FLDSIZE_NEXT);
 	mp->block_size = ALIGN(mp->data_size + FLDSIZE_NEXT, mp->alignment);
 
@@ -229,6 +339,44 @@ void pool_reuse(Pool_desc *mp)
 #endif // POOL_FREE
 }
 
+/**
+ * Delete the given memory pool, but keep it in the arena of the current
+ * thread so its memory blocks can be reused by pool_new().
+ * This is intended for pools whose lifetime is one sentence.
+ */
+void pool_recycle(Pool_desc *mp)
+{
+	if (NULL == mp) return;
+
+	size_t max_bytes = arena_max_bytes();
+	if (mp->alloced_bytes > max_bytes)
+	{
+		arena_free_pool(mp);
+		return;
+	}
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	/* Install a thread-exit handler, to free the arena on thread-exit. */
+	static once_flag flag = ONCE_FLAG_INIT;
+	call_once(&flag, make_key);
+
+	if (0 == arena.num_pools)
+		tss_set(key, &arena);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+	/* Make room by deleting the least recently recycled pools. */
+	while ((arena.num_pools == POOL_ARENA_SIZE) ||
+	       (arena.bytes + mp->alloced_bytes > max_bytes))
+	{
+		arena_free_pool(arena_remove_pool(0));
+	}
+
+	lgdebug(+D_MEMPOOL, "Recycle %zu (%zu) elements (pool '%s' created in %s())\n",
+	        mp->issued_elements, mp->alloced_elements, mp->name, mp->func);
+	arena.pool[arena.num_pools++] = mp;
+	arena.bytes += mp->alloced_bytes;
+}
+
 #ifdef POOL_FREE
 /**
  * Allow to reuse individual elements. They are added to a free list that is
@@ -313,6 +461,14 @@ void pool_reuse(Pool_desc *mp)
 	mp->issued_elements = 0;
 }
 
+/*
+ * The fake pool allocator doesn't keep recycled pools.
+ */
+void pool_recycle(Pool_desc *mp)
+{
+	pool_delete(mp);
+}
+
 /*
  * Delete the given memory pool.
  */
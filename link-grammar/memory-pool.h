@@ -24,6 +24,14 @@
 #define MIN_ALIGNMENT sizeof(void *)    // Minimum element alignment.
 #define MAX_ALIGNMENT 64                // Maximum element alignment.
 //#define POOL_FREE                       // Allow to reuse individual elements.
+
+/* Pools of sentences that have been deleted are kept (up to that many
+ * per thread) for reuse by the next sentences, in order to save the
+ * allocation of their memory blocks. */
+#define POOL_ARENA_SIZE 32
+/* The default memory cap of the recycled pools of a thread, in MB.
+ * Can be changed (0 to disable) by the "pool-arena:N" test option. */
+#define POOL_ARENA_DEFAULT_MBYTES 64
 /*#define POOL_EXACT // Not used for now and hence left undefined. */
 
 typedef struct Pool_desc_s Pool_desc;
@@ -32,6 +40,7 @@ Pool_desc *pool_new(const char *, const char *, size_t, size_t, bool, bool, bool
 void *pool_alloc_vec(Pool_desc *, size_t) GNUC_MALLOC;
 
 void pool_reuse(Pool_desc *);
+void pool_recycle(Pool_desc *);
 #ifndef DEBUG
 void pool_delete(Pool_desc *);
 #else
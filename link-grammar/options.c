@@ -79,6 +79,8 @@ Parse_Options parse_options_create(void)
 	po->perform_pp_prune = true;
 	po->twopass_length = 30;
 	po->repeatable_rand = true;
+	po->count_threads = 1;
+	po->anytime = false;
 	po->resources = resources_create();
 	po->display_morphology = true;
 	po->dialect = (dialect_info){ .conf = strdup("") };
@@ -290,6 +292,13 @@ void parse_options_set_spell_guess(Parse_Options opts, int dummy) {
 #if defined HAVE_HUNSPELL || defined HAVE_ASPELL
 	opts->use_spell_guess = dummy;
 #else
+	/* The dictionary-based spell guesser doesn't need library support. */
+	if (NULL != test_enabled("spell-symdel"))
+	{
+		opts->use_spell_guess = dummy;
+		return;
+	}
+
 	if (dummy && (verbosity > D_USER_BASIC))
 	{
 		prt_error("Error: Cannot enable spell guess; "
@@ -333,12 +342,93 @@ bool parse_options_get_repeatable_rand(Parse_Options opts) {
 	return opts->repeatable_rand;
 }
 
+/**
+ * Set the number of threads to use for counting the linkages of
+ * long sentences, and for post-processing them when there are many.
+ * 1 (the default) means doing that in the calling thread only.
+ */
+void parse_options_set_count_threads(Parse_Options opts, int val)
+{
+	if (val < 1) val = 1;
+#if !HAVE_THREADS_H || __EMSCRIPTEN__
+	if ((val > 1) && (verbosity > D_USER_BASIC))
+	{
+		prt_error("Warning: Cannot use %d counting threads; "
+		          "this library was built without thread support.\n", val);
+	}
+	val = 1;
+#endif /* !HAVE_THREADS_H || __EMSCRIPTEN__ */
+	opts->count_threads = (unsigned int)val;
+}
+
+int parse_options_get_count_threads(Parse_Options opts) {
+	return (int)opts->count_threads;
+}
+
 void parse_options_set_max_parse_time(Parse_Options opts, int dummy) {
 	opts->resources->max_parse_time = dummy;
 }
 
 int parse_options_get_max_parse_time(Parse_Options opts) {
-	return opts->resources->max_parse_time;
+	/* Round up a sub-second limit (set in milliseconds). */
+	double max_parse_time = opts->resources->max_parse_time;
+	int secs = (int)max_parse_time;
+	return (secs < max_parse_time) ? secs + 1 : secs;
+}
+
+/**
+ * Set the maximum parse time in milliseconds (negative: no limit).
+ */
+void parse_options_set_max_parse_time_ms(Parse_Options opts, int msecs)
+{
+	if (msecs < 0)
+		opts->resources->max_parse_time = MAX_PARSE_TIME_UNLIMITED;
+	else
+		opts->resources->max_parse_time = msecs / 1000.0;
+}
+
+int parse_options_get_max_parse_time_ms(Parse_Options opts)
+{
+	double max_parse_time = opts->resources->max_parse_time;
+	if (max_parse_time == MAX_PARSE_TIME_UNLIMITED) return -1;
+	return (int)(max_parse_time * 1000 + 0.5);
+}
+
+/**
+ * Set the maximum wall-clock parse time in milliseconds (negative: no
+ * limit). Unlike the parse time limit above, which is of the CPU time of
+ * the parsing thread, it also counts the time in which the thread
+ * doesn't run. Both limits may be set, and the first one to be reached
+ * stops the parsing.
+ */
+void parse_options_set_max_wall_time_ms(Parse_Options opts, int msecs)
+{
+	if (msecs < 0)
+		opts->resources->max_wall_time = MAX_PARSE_TIME_UNLIMITED;
+	else
+		opts->resources->max_wall_time = msecs / 1000.0;
+}
+
+int parse_options_get_max_wall_time_ms(Parse_Options opts)
+{
+	double max_wall_time = opts->resources->max_wall_time;
+	if (max_wall_time == MAX_PARSE_TIME_UNLIMITED) return -1;
+	return (int)(max_wall_time * 1000 + 0.5);
+}
+
+/**
+ * Anytime parsing: If a full parse cannot be done within the maximum
+ * parse time, return the linkages of a degraded parse (all links short,
+ * null words allowed) that is done in the remaining time, and mark the
+ * sentence as partial (see sentence_is_partial()). Also keep the valid
+ * linkages found until a timeout in post-processing.
+ */
+void parse_options_set_anytime(Parse_Options opts, bool val) {
+	opts->anytime = val;
+}
+
+bool parse_options_get_anytime(Parse_Options opts) {
+	return opts->anytime;
 }
 
 void parse_options_set_max_memory(Parse_Options opts, int dummy) {
@@ -27,6 +27,7 @@
 #include "fast-match.h"
 #include "resources.h"
 #include "tokenize/word-structures.h"   // for Word_struct
+#include "tracon-table.h"
 #include "utilities.h"
 
 /* This file contains the exhaustive search algorithm. */
@@ -43,6 +44,7 @@ const bool ENABLE_TABLE_LRCNT = true; // Also controls the above two caches.
 const bool USE_TABLE_TRACON = true;   // The table is always maintained.
 const bool USE_PSEUDOCOUNT = true;    // Controls only the non-cyclic solutions.
 
+#if !USE_LOCKFREE_COUNT_TABLE
 typedef struct Table_tracon_s Table_tracon;
 struct Table_tracon_s
 {
@@ -52,6 +54,7 @@ struct Table_tracon_s
 	null_count_m     null_count;
 	size_t           hash;       // Generation needs more than 32 bits.
 };
+#endif /* !USE_LOCKFREE_COUNT_TABLE */
 
 /* Most of the time, do_count() yields a zero leftcount/rightcount when it
  * parses a word range in which one end is a certain tracon and the other
@@ -74,7 +77,11 @@ struct Table_tracon_s
  *
  * The check_next filed indicates the next word to be checked. Each
  * word-vector is updated each time one of its elements gets updated, so
- * check_next skips all the words for which the count is known to be zero. */
+ * check_next skips all the words for which the count is known to be zero.
+ * Which words can be skipped depends on the sentence null-count, so
+ * check_nc records the one for which check_next has been computed. The
+ * rest of the information doesn't depend on it, so the whole count
+ * context can be reused when parsing again with a greater null-count. */
 
 typedef struct
 {
@@ -85,6 +92,7 @@ typedef struct
 	null_count_m null_count; /* status==0 valid up to this null count */
 	int8_t status;           /* -1: Needs update; 0: No count; 1: Count possible */
 	WordIdx_m check_next;    /* Next word to check */
+	null_count_m check_nc;   /* check_next is valid for this null count */
 } count_expectation;
 
 /* Using the word-vectors for very short sentences has too much overhead. */
@@ -109,6 +117,9 @@ typedef struct
 	uint32_t num_tracon_id;    /* Number of tracon IDs */
 } Table_lrcnt;
 
+/* Parallel counting (see parallel_count()). */
+typedef struct Parallel_count_s Parallel_count;
+
 struct count_context_s
 {
 	fast_matcher_t *mchxt;
@@ -118,13 +129,18 @@ struct count_context_s
 	bool    exhausted;
 	uint8_t num_growth;       /* Number of table growths, for debug */
 	bool    is_short;
-	uint32_t checktimer;      /* Avoid excess system calls */
+	uint32_t checktimer;      /* Avoid excess clock reads */
+#if USE_LOCKFREE_COUNT_TABLE
+	Tracon_table *table;      /* Shared by the counting threads */
+#else
 	size_t table_size;        /* Can exceed 2**32 during generation. */
 	size_t table_mask;        /* 2**table_size -1 */
 	size_t table_available_count; /* derated table_size by hash load factor */
 	Table_tracon ** table;
+#endif /* USE_LOCKFREE_COUNT_TABLE */
 	Table_lrcnt table_lrcnt[2];  /* Left/right wordvec */
 	Pool_desc *mlc_pool;         /* Match list cache */
+	Parallel_count *parallel;    /* Non-NULL while counting in parallel */
 	Resources current_resources;
 	COUNT_COST(uint64_t count_cost[3];)
 };
@@ -137,6 +153,66 @@ struct count_context_s
 /* Avoid pathological cases leading to failure */
 #define MAX_LOG2_TABLE_SIZE ((sizeof(size_t)==4) ? 25 : 34)
 
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+/* While counting in parallel, all the counting threads use a common
+ * tracon table. In order not to count the same range concurrently by
+ * several threads, do_count() reserves the table entry of the range
+ * before counting it. Other threads that need this count wait until it
+ * is stored. This cannot deadlock, since the ranges on which a
+ * do_count() invocation depends are always strictly smaller.
+ *
+ * The lock-free table (tracon-table.c) is used directly by all the
+ * threads. Else, a common locked table is used, which is merged into
+ * the table of the calling thread at the end. To reduce lock contention,
+ * it is split into shards (selected by the low bits of the entry hash),
+ * each one having its own lock, hash table and memory pool. A reserved
+ * entry has the count count_unknown. */
+#if !USE_LOCKFREE_COUNT_TABLE
+#define USE_TABLE_SHARDS 1
+#define LOG2_NUM_TABLE_SHARDS 6
+#define NUM_TABLE_SHARDS (1U << LOG2_NUM_TABLE_SHARDS)
+
+typedef struct
+{
+	mtx_t mutex;
+	cnd_t count_ready;         /* Signaled when reserved entries get a count */
+	Table_tracon **table;
+	size_t table_size;
+	size_t table_mask;
+	size_t table_available_count;
+	Pool_desc *pool;
+} Table_shard;
+#endif /* !USE_LOCKFREE_COUNT_TABLE */
+
+/* Parallel counting is done only for sentences of at least this length
+ * (the per-thread setup overhead is not worth it for shorter ones). */
+static const size_t min_len_parallel_count = 20; /* Just an estimation. */
+
+typedef struct
+{
+	Connector *le;            /* A right connector of word 0 */
+	int w;                    /* A word to which it may connect */
+} Split_point;
+
+struct Parallel_count_s
+{
+	mtx_t mutex;              /* Protects the fields up to "exhausted" */
+	size_t next_item;         /* Next split point to count */
+	bool exhausted;           /* Resources exhausted - stop counting */
+
+	Split_point *item;
+	size_t num_items;
+	int rw;
+	unsigned int null_count;
+
+	Sentence sent;
+	count_context_t *ctxt;    /* The count context of the calling thread */
+#if USE_TABLE_SHARDS
+	Table_shard shard[NUM_TABLE_SHARDS];
+#endif /* USE_TABLE_SHARDS */
+};
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
 /**
  * Provide an estimate for the number of Table_tracon entries that will
  * be needed.
@@ -163,6 +239,7 @@ static size_t estimate_tracon_entries(Sentence sent)
 	return tblsize;
 }
 
+#if !USE_LOCKFREE_COUNT_TABLE
 #if HAVE_THREADS_H && !__EMSCRIPTEN__
 /* Each thread will get its own version of the `kept_table`.
  * If the program creates zillions of threads, then there will
@@ -272,6 +349,7 @@ static void init_table(count_context_t *ctxt)
 
 	table_alloc(ctxt, logsz);
 }
+#endif /* !USE_LOCKFREE_COUNT_TABLE */
 
 static void free_table_lrcnt(count_context_t *ctxt)
 {
@@ -332,7 +410,7 @@ static void free_table_lrcnt(count_context_t *ctxt)
 		}
 	}
 
-	pool_delete(ctxt->mlc_pool);
+	pool_recycle(ctxt->mlc_pool);
 
 	for (unsigned int dir = 0; dir < 2; dir++)
 	{
@@ -427,7 +505,9 @@ static uint64_t hit, miss;  /* Table entry stats */
  */
 static void table_stat(count_context_t *ctxt)
 {
-#ifdef DEBUG_TABLE_STAT
+#if USE_LOCKFREE_COUNT_TABLE
+	tracon_table_stat(ctxt->table);
+#elif defined DEBUG_TABLE_STAT
 	if (!verbosity_level(+D_COUNT)) return;
 
 	size_t z = 0, nz = 0;  /* Number of entries with zero and non-zero counts */
@@ -526,9 +606,10 @@ static void table_stat(count_context_t *ctxt)
 	}
 
 	hit = miss = 0;
-#endif /* DEBUG_TABLE_STAT */
+#endif /* USE_LOCKFREE_COUNT_TABLE */
 }
 
+#if !USE_LOCKFREE_COUNT_TABLE
 static void table_grow(count_context_t *ctxt)
 {
 	// If we somehow hit the max size, disallow further growth.
@@ -556,8 +637,175 @@ static void table_grow(count_context_t *ctxt)
 	ctxt->num_growth++;
 }
 
+static Count_bin *table_find(count_context_t *ctxt, int l_id, int r_id,
+                             unsigned int null_count, size_t hash)
+{
+	for (Table_tracon *t = ctxt->table[hash & ctxt->table_mask]; t != NULL;
+	     t = t->next)
+	{
+		if ((t->l_id == l_id) && (t->r_id == r_id) &&
+		    (t->null_count == null_count))
+			return &t->count;
+	}
+
+	return NULL;
+}
+#endif /* !USE_LOCKFREE_COUNT_TABLE */
+
+#define NO_COUNT -1
+#if PERFORM_COUNT_HISTOGRAMMING
+#define INIT_NO_COUNT (Count_bin){.total = NO_COUNT}
+#else
+#define INIT_NO_COUNT NO_COUNT
+#endif
+Count_bin count_unknown = INIT_NO_COUNT;
+
+#if USE_TABLE_SHARDS
+static Table_shard *get_table_shard(Parallel_count *pc, size_t hash)
+{
+	return &pc->shard[hash & (NUM_TABLE_SHARDS - 1)];
+}
+
+static size_t shard_index(Table_shard *ts, size_t hash)
+{
+	return (hash >> LOG2_NUM_TABLE_SHARDS) & ts->table_mask;
+}
+
+static void shard_alloc(Table_shard *ts, size_t table_size)
+{
+	free(ts->table);
+	ts->table_size = table_size;
+	ts->table_mask = table_size - 1;
+	ts->table_available_count = table_size / INV_LOAD_FACTOR;
+	ts->table = malloc(table_size * sizeof(Table_tracon *));
+	memset(ts->table, 0, table_size * sizeof(Table_tracon *));
+}
+
+static void shard_grow(Table_shard *ts)
+{
+	if ((1ULL << MAX_LOG2_TABLE_SIZE) <= ts->table_size * NUM_TABLE_SHARDS)
+	{
+		ts->table_available_count = SIZE_MAX;
+		return;
+	}
+
+	shard_alloc(ts, ts->table_size * 2);
+
+	/* Rehash. */
+	Table_tracon *oe;
+	Pool_location loc = { 0 };
+	while ((oe = pool_next(ts->pool, &loc)) != NULL)
+	{
+		size_t ni = shard_index(ts, oe->hash);
+
+		if (ts->table[ni] == NULL) ts->table_available_count--;
+		oe->next = ts->table[ni];
+		ts->table[ni] = oe;
+	}
+}
+
+static Table_tracon *shard_find(Table_shard *ts, int l_id, int r_id,
+                                unsigned int null_count, size_t hash)
+{
+	for (Table_tracon *t = ts->table[shard_index(ts, hash)]; t != NULL;
+	     t = t->next)
+	{
+		if ((t->l_id == l_id) && (t->r_id == r_id) &&
+		    (t->null_count == null_count))
+			return t;
+	}
+
+	return NULL;
+}
+
+static Table_tracon *shard_add(Table_shard *ts, int l_id, int r_id,
+                               unsigned int null_count, size_t hash,
+                               Count_bin c)
+{
+	if (ts->table_available_count == 0) shard_grow(ts);
+
+	size_t i = shard_index(ts, hash);
+	Table_tracon *n = pool_alloc(ts->pool);
+
+	if (ts->table[i] == NULL)
+		ts->table_available_count--;
+
+	n->l_id = l_id;
+	n->r_id = r_id;
+	n->null_count = null_count;
+	n->next = ts->table[i];
+	n->count = c;
+	n->hash = hash;
+	ts->table[i] = n;
+
+	return n;
+}
+
 /**
- * Stores the value in the table.  Assumes it's not already there.
+ * Like table_lookup(), for the shared table of a parallel count.
+ * If the entry is reserved by another thread, wait for its count.
+ * Table entries are never moved or changed after they get their count,
+ * so the returned pointer can be used without holding the shard lock.
+ *
+ * @param reserve If the entry is not found, reserve it for the caller,
+ * which must then store its count by shared_table_store(). Else, a
+ * reserved entry is considered as not found.
+ */
+static Count_bin *shared_table_lookup(Parallel_count *pc, int l_id, int r_id,
+                                      unsigned int null_count, size_t hash,
+                                      bool reserve)
+{
+	Table_shard *ts = get_table_shard(pc, hash);
+
+	mtx_lock(&ts->mutex);
+	Table_tracon *t = shard_find(ts, l_id, r_id, null_count, hash);
+	if (reserve)
+	{
+		if (NULL == t)
+		{
+			shard_add(ts, l_id, r_id, null_count, hash, count_unknown);
+		}
+		else
+		{
+			while (hist_total(&t->count) == hist_total(&count_unknown))
+				cnd_wait(&ts->count_ready, &ts->mutex);
+		}
+	}
+	else if ((NULL != t) &&
+	         (hist_total(&t->count) == hist_total(&count_unknown)))
+	{
+		t = NULL;
+	}
+	mtx_unlock(&ts->mutex);
+
+	return (NULL == t) ? NULL : &t->count;
+}
+
+/**
+ * Like table_store(), for the shared table of a parallel count.
+ * The entry has been reserved by shared_table_lookup().
+ */
+static Count_bin shared_table_store(Parallel_count *pc, int l_id, int r_id,
+                                    unsigned int null_count, size_t hash,
+                                    w_Count_bin c)
+{
+	Table_shard *ts = get_table_shard(pc, hash);
+
+	mtx_lock(&ts->mutex);
+	Table_tracon *n = shard_find(ts, l_id, r_id, null_count, hash);
+	assert(NULL != n, "Unreserved table entry");
+	n->count = (Count_bin)c; /* c is already clamped (by parse_count_clamp()) */
+	cnd_broadcast(&ts->count_ready);
+	mtx_unlock(&ts->mutex);
+
+	return (Count_bin)c;
+}
+#endif /* USE_TABLE_SHARDS */
+
+#if USE_LOCKFREE_COUNT_TABLE
+/**
+ * Stores the value in the table. Its entry has been reserved by
+ * table_lookup().
  */
 static Count_bin table_store(count_context_t *ctxt,
                            int lw, int rw,
@@ -565,11 +813,58 @@ static Count_bin table_store(count_context_t *ctxt,
                            unsigned int null_count,
                            size_t hash, w_Count_bin c)
 {
-	if (ctxt->table_available_count == 0) table_grow(ctxt);
+	int l_id = (NULL != le) ? le->tracon_id : lw;
+	int r_id = (NULL != re) ? re->tracon_id : rw;
 
+	/* c is already clamped (by parse_count_clamp()) */
+	return tracon_table_store(ctxt->table, l_id, r_id, null_count, hash,
+	                          (Count_bin)c);
+}
+
+/**
+ * Return the count for this quintuple if there, NULL otherwise.
+ *
+ * @param hash[out] If non-null, the entry gets reserved if it is not
+ * found, and its count must then be stored by table_store(). An entry
+ * that is reserved by another thread is then waited for. For this
+ * table, the returned value is the handle of the reserved entry.
+ * If the table is full, the counting is stopped (see do_parse()).
+ * @return The count for this quintuple if there, NULL otherwise.
+ */
+inline Count_bin *
+table_lookup(count_context_t *ctxt, int lw, int rw,
+             const Connector *le, const Connector *re,
+             unsigned int null_count, size_t *hash)
+{
 	int l_id = (NULL != le) ? le->tracon_id : lw;
 	int r_id = (NULL != re) ? re->tracon_id : rw;
 
+	Count_bin *c = tracon_table_lookup(ctxt->table, l_id, r_id, null_count, hash);
+	if ((NULL == c) && (NULL != hash) && (0 == *hash))
+		ctxt->exhausted = true;
+
+	return c;
+}
+#else
+/**
+ * Stores the value in the table.  Assumes it's not already there.
+ */
+static Count_bin table_store(count_context_t *ctxt,
+                           int lw, int rw,
+                           const Connector *le, const Connector *re,
+                           unsigned int null_count,
+                           size_t hash, w_Count_bin c)
+{
+	int l_id = (NULL != le) ? le->tracon_id : lw;
+	int r_id = (NULL != re) ? re->tracon_id : rw;
+
+#if USE_TABLE_SHARDS
+	if (unlikely(ctxt->parallel != NULL))
+		return shared_table_store(ctxt->parallel, l_id, r_id, null_count, hash, c);
+#endif /* USE_TABLE_SHARDS */
+
+	if (ctxt->table_available_count == 0) table_grow(ctxt);
+
 	if (!USE_TABLE_TRACON)
 	{
 		// In case a table count already exists, check its consistency.
@@ -619,7 +914,22 @@ table_lookup(count_context_t *ctxt, int lw, int rw,
 	int l_id = (NULL != le) ? le->tracon_id : lw;
 	int r_id = (NULL != re) ? re->tracon_id : rw;
 	size_t h = pair_hash(lw, rw, l_id, r_id, null_count);
-	Table_tracon *t = ctxt->table[h & ctxt->table_mask];
+
+#if USE_TABLE_SHARDS
+	if (unlikely(ctxt->parallel != NULL))
+	{
+		/* The table of the calling thread doesn't change while counting
+		 * in parallel, so it is looked up first without locking. It may
+		 * already have counts from do_parse() with a lower null count. */
+		Count_bin *c = table_find(ctxt->parallel->ctxt, l_id, r_id,
+		                          null_count, h);
+		if (c != NULL) return c;
+
+		if (hash != NULL) *hash = h;
+		return shared_table_lookup(ctxt->parallel, l_id, r_id, null_count, h,
+		                           hash != NULL);
+	}
+#endif /* USE_TABLE_SHARDS */
 
 	if (!USE_TABLE_TRACON && (hash != NULL))
 	{
@@ -627,14 +937,11 @@ table_lookup(count_context_t *ctxt, int lw, int rw,
 		return NULL;
 	}
 
-	for (; t != NULL; t = t->next)
+	Count_bin *c = table_find(ctxt, l_id, r_id, null_count, h);
+	if (c != NULL)
 	{
-		if ((t->l_id == l_id) && (t->r_id == r_id) &&
-		    (t->null_count == null_count))
-		{
-			TABLE_STAT(hit++);
-			return &t->count;
-		}
+		TABLE_STAT(hit++);
+		return c;
 	}
 	TABLE_STAT(miss++);
 
@@ -642,6 +949,7 @@ table_lookup(count_context_t *ctxt, int lw, int rw,
 	TABLE_STAT(miss++);
 	return NULL;
 }
+#endif /* USE_LOCKFREE_COUNT_TABLE */
 
 extern  Count_bin *
 table_lookup(count_context_t *, int, int,
@@ -666,10 +974,12 @@ static void generate_word_skip_vector(count_context_t *ctxt, wordvecp wv,
 
 		if (wv == NULL) wv = ctxt->table_lrcnt[0].tracon_wvp[le->tracon_id];
 		unsigned int sent_nc = ctxt->sent->null_count;
+		wv[start_word - le->nearest_word].check_nc = sent_nc;
 		for (i = start_word + 1; i < end_word; i++)
 		{
 			wordvecp e = &wv[i - le->nearest_word];
 			e->check_next = INCREMENT_WORD;
+			e->check_nc = sent_nc;
 			if((e->status != 0) || (sent_nc > e->null_count))
 			{
 				wv[check_word - le->nearest_word].check_next = i;
@@ -699,10 +1009,12 @@ static void generate_word_skip_vector(count_context_t *ctxt, wordvecp wv,
 
 		if (wv == NULL) wv = ctxt->table_lrcnt[1].tracon_wvp[re->tracon_id];
 		unsigned int sent_nc = ctxt->sent->null_count;
+		wv[start_word - re->farthest_word].check_nc = sent_nc;
 		for (i = start_word + 1; i < end_word; i++)
 		{
 			wordvecp e = &wv[i - re->farthest_word];
 			e->check_next = INCREMENT_WORD;
+			e->check_nc = sent_nc;
 			if((e->status != 0) || (sent_nc > e->null_count))
 			{
 				wv[check_word - re->farthest_word].check_next = i;
@@ -881,6 +1193,7 @@ static wordvecp alloc_lrcnt_wv(count_context_t *ctxt, wordvecp *wvp,
 			(*wvp)[i].status = -1;
 			(*wvp)[i].null_count = -1;
 			(*wvp)[i].check_next = -1;
+			(*wvp)[i].check_nc = -1;
 		}
 	}
 
@@ -924,32 +1237,49 @@ static bool lrcnt_expectation_update(wordvecp wv, bool lrcnt_found,
 	return lrcnt_status_changed || (prev_null_count != wv->null_count);
 }
 
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+/**
+ * Propagate the exhausted indication between the counting threads.
+ * Only the calling thread checks the resources (the parse timer is
+ * per-thread), and the other threads stop when it finds them exhausted.
+ */
+static bool parallel_count_exhausted(Parallel_count *pc, bool exhausted)
+{
+	mtx_lock(&pc->mutex);
+	if (exhausted) pc->exhausted = true;
+	exhausted = pc->exhausted;
+	mtx_unlock(&pc->mutex);
+
+	return exhausted;
+}
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
 static bool is_panic(count_context_t *ctxt)
 {
 	/* Panic mode: Return a parse bypass indication if resources are
-	 * exhausted.  checktimer is a device to avoid a gazillion system calls
-	 * to get the timer value. On circa-2018 machines, it results in
-	 * several timer calls per second. */
+	 * exhausted or the parse is cancelled.  checktimer is a device to
+	 * avoid reading the clock on every call. The clock is read without
+	 * a system call (see resources_timer_expired()), so it can be
+	 * checked often enough for millisecond timeouts and a fast response
+	 * to sentence_cancel(). */
 	if (ctxt->exhausted) return true;
 	ctxt->checktimer++;
-	if (((0 == ctxt->checktimer%(1<<18)) && (ctxt->current_resources != NULL) &&
+	if (0 != ctxt->checktimer%(1<<14)) return false;
+
+	if ((ctxt->current_resources != NULL) &&
 	     //fprintf(stderr, "T") &&
-	     resources_exhausted(ctxt->current_resources)))
+	     resources_exhausted(ctxt->current_resources))
 	{
 		ctxt->exhausted = true;
-		return true;
 	}
 
-	return false;
-}
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	if (ctxt->parallel != NULL)
+		ctxt->exhausted = parallel_count_exhausted(ctxt->parallel, ctxt->exhausted);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
 
-#define NO_COUNT -1
-#if PERFORM_COUNT_HISTOGRAMMING
-#define INIT_NO_COUNT (Count_bin){.total = NO_COUNT}
-#else
-#define INIT_NO_COUNT NO_COUNT
-#endif
-Count_bin count_unknown = INIT_NO_COUNT;
+	return ctxt->exhausted;
+}
 
 /*
  * Lookup the tracon table for the count of the given range. If exists,
@@ -1402,9 +1732,15 @@ static Count_bin do_count(const char dlabel[], count_context_t *ctxt,
 			lrcnt_cache = &wvp[w - woffset];
 
 			/* Use the word-skip vector to skip over words that are
-			 * known to yield a zero count. */
+			 * known to yield a zero count. If it has been computed for
+			 * another null count, check each word and recompute it. */
 			next_word = lrcnt_cache->check_next;
-			if (next_word == INCREMENT_WORD) next_word = w + 1;
+			if ((next_word == INCREMENT_WORD) ||
+			    (lrcnt_cache->check_nc != ctxt->sent->null_count))
+			{
+				if (next_word != INCREMENT_WORD) lrcnt_cache_changed = true;
+				next_word = w + 1;
+			}
 
 			if (le != NULL)
 			{
@@ -1665,6 +2001,287 @@ static Count_bin do_count(const char dlabel[], count_context_t *ctxt,
 	return table_store(ctxt, lw, rw, le, re, null_count, h, total);
 }
 
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+/**
+ * Count the ranges that result from splitting the top-level range
+ * (see do_parse()) at word \p w, by the connector \p le of word 0.
+ * This is the Path 3 loop of do_count() for a single word, without
+ * its optimizations. The counts are not summed up - they are just left
+ * in the table, so the final count (by do_parse()) will find them there.
+ */
+static void count_split_point(count_context_t *ctxt, Connector *le, int w,
+                              int rw, unsigned int null_count)
+{
+	fast_matcher_t *mchxt = ctxt->mchxt;
+	const int lw = 0;
+
+	size_t mlb = form_match_list(mchxt, w, le, lw, NULL, rw, NULL, NULL);
+
+	for (size_t mle = mlb; get_match_list_element(mchxt, mle) != NULL; mle++)
+	{
+		Disjunct *d = get_match_list_element(mchxt, mle);
+		d->match_left = d->match_right = false;
+
+		for (unsigned int lnull_cnt = 0; lnull_cnt <= null_count; lnull_cnt++)
+		{
+			Count_bin lcount[4] = { NO_COUNT, NO_COUNT, NO_COUNT, NO_COUNT };
+			w_Count_bin leftcount =
+				scount("P", ctxt, lcount, lw, w, le, d->left, lnull_cnt);
+
+			if (0 < hist_total(&leftcount))
+				do_count("P", ctxt, w, rw, d->right, NULL, null_count - lnull_cnt);
+		}
+	}
+
+	pop_match_list(mchxt, mlb);
+}
+
+static void count_split_points(Parallel_count *pc, count_context_t *ctxt)
+{
+	while (!is_panic(ctxt))
+	{
+		mtx_lock(&pc->mutex);
+		size_t i = pc->next_item++;
+		mtx_unlock(&pc->mutex);
+
+		if (i >= pc->num_items) return;
+		count_split_point(ctxt, pc->item[i].le, pc->item[i].w,
+		                  pc->rw, pc->null_count);
+	}
+}
+
+/**
+ * Make in \p wsent a copy of \p sent that has its own disjuncts (they
+ * are modified during counting). The connectors are not modified during
+ * counting, so they are shared with \p sent.
+ * @param ncu[out] Per word and direction number of disjuncts, as an
+ * upper bound for alloc_fast_matcher().
+ * @return The memory block of the disjunct copies.
+ */
+static Disjunct *replicate_sentence(Sentence wsent, Sentence sent,
+                                    unsigned int *ncu[2])
+{
+	*wsent = *sent;
+	wsent->word = malloc(sent->length * sizeof(*wsent->word));
+	memcpy(wsent->word, sent->word, sent->length * sizeof(*wsent->word));
+	wsent->Table_tracon_pool = NULL;
+	wsent->wordvec_pool = NULL;
+
+	size_t num_disjuncts = 0;
+	for (WordIdx w = 0; w < sent->length; w++)
+		num_disjuncts += count_disjuncts(sent->word[w].d);
+
+	Disjunct *dmem = malloc(MAX(num_disjuncts, 1) * sizeof(Disjunct));
+	Disjunct *nd = dmem;
+
+	for (WordIdx w = 0; w < sent->length; w++)
+	{
+		Disjunct **dp = &wsent->word[w].d;
+
+		ncu[0][w] = ncu[1][w] = 0;
+		for (Disjunct *d = sent->word[w].d; d != NULL; d = d->next)
+		{
+			*nd = *d;
+			ncu[0][w] += (d->left != NULL);
+			ncu[1][w] += (d->right != NULL);
+			*dp = nd;
+			dp = &nd->next;
+			nd++;
+		}
+		*dp = NULL;
+	}
+
+	return dmem;
+}
+
+static int parallel_count_worker(void *arg)
+{
+	Parallel_count *pc = arg;
+	Sentence sent = pc->sent;
+	struct Sentence_s wsent;
+	unsigned int *ncu[2];
+
+	ncu[0] = alloca(sent->length * sizeof(*ncu[0]));
+	ncu[1] = alloca(sent->length * sizeof(*ncu[1]));
+	Disjunct *dmem = replicate_sentence(&wsent, sent, ncu);
+	fast_matcher_t *mchxt = alloc_fast_matcher(&wsent, ncu);
+
+	count_context_t *ctxt = malloc(sizeof(count_context_t));
+	memset(ctxt, 0, sizeof(count_context_t));
+
+	ctxt->sent = &wsent;
+	ctxt->mchxt = mchxt;
+	ctxt->islands_ok = pc->ctxt->islands_ok;
+	ctxt->parallel = pc;
+#if USE_LOCKFREE_COUNT_TABLE
+	ctxt->table = pc->ctxt->table;
+#endif /* USE_LOCKFREE_COUNT_TABLE */
+	ctxt->current_resources = NULL; /* Checked by the calling thread */
+	for (unsigned int dir = 0; dir < 2; dir++)
+	{
+		ctxt->table_lrcnt[dir].num_tracon_id =
+			pc->ctxt->table_lrcnt[dir].num_tracon_id;
+	}
+	init_table_lrcnt(ctxt);
+
+	count_split_points(pc, ctxt);
+
+	free_table_lrcnt(ctxt);
+	free(ctxt);
+	free_fast_matcher(&wsent, mchxt);
+	pool_recycle(wsent.wordvec_pool);
+	free(wsent.word);
+	free(dmem);
+
+	return 0;
+}
+
+#if USE_TABLE_SHARDS
+/**
+ * Move the entries of the shared table of a parallel count to the
+ * table of \p ctxt. Entries that it already has are skipped (there
+ * should be none, since table_lookup() looks it up first).
+ */
+static void table_merge_shards(count_context_t *ctxt, Parallel_count *pc)
+{
+	for (unsigned int i = 0; i < NUM_TABLE_SHARDS; i++)
+	{
+		Table_shard *ts = &pc->shard[i];
+		Table_tracon *se;
+		Pool_location loc = { 0 };
+
+		while ((se = pool_next(ts->pool, &loc)) != NULL)
+		{
+			if (NULL != table_find(ctxt, se->l_id, se->r_id, se->null_count,
+			                       se->hash))
+				continue;
+			if (ctxt->table_available_count == 0) table_grow(ctxt);
+
+			size_t ni = se->hash & ctxt->table_mask;
+			Table_tracon *n = pool_alloc(ctxt->sent->Table_tracon_pool);
+
+			if (ctxt->table[ni] == NULL) ctxt->table_available_count--;
+			*n = *se;
+			n->next = ctxt->table[ni];
+			ctxt->table[ni] = n;
+		}
+
+		mtx_destroy(&ts->mutex);
+		cnd_destroy(&ts->count_ready);
+		free(ts->table);
+		pool_delete(ts->pool);
+	}
+}
+#endif /* USE_TABLE_SHARDS */
+
+/**
+ * Count in parallel the ranges into which the top-level range of
+ * do_parse() is split (in do_count() Path 3) by the right connectors of
+ * word 0. This is done by opts->count_threads threads (including the
+ * calling one), which take these split points from a common list.
+ *
+ * Each thread uses its own copy of the sentence disjuncts and its own
+ * count context, but they all share the same tracon table (tracon IDs
+ * are the same in all the copies). The table of \p ctxt, which may
+ * already have the counts of lower null counts, is only read meanwhile.
+ * At the end, the shared table is merged into the table of \p ctxt
+ * (unless it is the lock-free table, which is the table of \p ctxt),
+ * and the actual count is done by do_count() as usual (mostly from the
+ * table).
+ */
+static void parallel_count(Sentence sent, count_context_t *ctxt,
+                           Parse_Options opts)
+{
+	const int rw = (int)sent->length;
+	Parallel_count *pc = malloc(sizeof(Parallel_count));
+	memset(pc, 0, sizeof(Parallel_count));
+
+	pc->sent = sent;
+	pc->ctxt = ctxt;
+	pc->rw = rw;
+	pc->null_count = sent->null_count;
+
+	/* Find the distinct (by tracon) right connectors of word 0. */
+	size_t num_le = 0;
+	Connector **le_list =
+		malloc(MAX(count_disjuncts(sent->word[0].d), 1) * sizeof(Connector *));
+	bool *seen = malloc(ctxt->table_lrcnt[0].num_tracon_id * sizeof(bool));
+	memset(seen, 0, ctxt->table_lrcnt[0].num_tracon_id * sizeof(bool));
+
+	for (Disjunct *d = sent->word[0].d; d != NULL; d = d->next)
+	{
+		if ((d->left != NULL) || (d->right == NULL)) continue;
+		if (seen[d->right->tracon_id]) continue;
+		seen[d->right->tracon_id] = true;
+		le_list[num_le++] = d->right;
+	}
+	free(seen);
+
+	/* The split points are ordered by word, so concurrently counted
+	 * ones mostly share only already counted ranges. */
+	pc->item = malloc(MAX(num_le * rw, 1) * sizeof(Split_point));
+	for (int w = 1; w < rw; w++)
+	{
+		for (size_t i = 0; i < num_le; i++)
+		{
+			Connector *le = le_list[i];
+			if ((w < le->nearest_word) || (w > le->farthest_word)) continue;
+			pc->item[pc->num_items++] = (Split_point){ .le = le, .w = w };
+		}
+	}
+	free(le_list);
+
+	mtx_init(&pc->mutex, mtx_plain);
+#if USE_TABLE_SHARDS
+	size_t shard_size = estimate_tracon_entries(sent) * INV_LOAD_FACTOR /
+	                    NUM_TABLE_SHARDS;
+	for (unsigned int i = 0; i < NUM_TABLE_SHARDS; i++)
+	{
+		Table_shard *ts = &pc->shard[i];
+
+		mtx_init(&ts->mutex, mtx_plain);
+		cnd_init(&ts->count_ready);
+		shard_alloc(ts, next_power_of_two_up(MAX(shard_size, 64)));
+		ts->pool = pool_new(__func__, "Table_tracon (shared)",
+		                    4096, sizeof(Table_tracon),
+		                    /*zero_out*/false, /*align*/false, /*exact*/false);
+	}
+#else
+	tracon_table_set_concurrent(ctxt->table, true);
+#endif /* USE_TABLE_SHARDS */
+
+	unsigned int num_threads = opts->count_threads - 1;
+	thrd_t *thread = alloca(num_threads * sizeof(thrd_t));
+	unsigned int num_started;
+
+	for (num_started = 0; num_started < num_threads; num_started++)
+	{
+		if (thrd_success !=
+		    thrd_create(&thread[num_started], parallel_count_worker, pc))
+			break;
+	}
+	lgdebug(+D_COUNT, "Parallel count: %u threads, %zu split points\n",
+	        num_started + 1, pc->num_items);
+
+	ctxt->parallel = pc;
+	count_split_points(pc, ctxt);
+
+	for (unsigned int i = 0; i < num_started; i++)
+		thrd_join(thread[i], NULL);
+	ctxt->parallel = NULL;
+
+#if USE_TABLE_SHARDS
+	table_merge_shards(ctxt, pc);
+#else
+	tracon_table_set_concurrent(ctxt->table, false);
+#endif /* USE_TABLE_SHARDS */
+
+	mtx_destroy(&pc->mutex);
+	free(pc->item);
+	free(pc);
+}
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
 /**
  * Returns the number of ways the sentence can be parsed with the
  * specified null count. Assumes that the fast-matcher and the count
@@ -1705,12 +2322,38 @@ int do_parse(Sentence sent, fast_matcher_t *mchxt, count_context_t *ctxt,
 	ctxt->islands_ok = opts->islands_ok;
 	ctxt->mchxt = mchxt;
 
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	if ((opts->count_threads > 1) && !ctxt->is_short &&
+	    (sent->length >= min_len_parallel_count) && !IS_GENERATION(sent->dict))
+	{
+		parallel_count(sent, ctxt, opts);
+	}
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
 	hist = do_count("E", ctxt, -1, sent->length, NULL, NULL, sent->null_count+1);
 
+#if USE_LOCKFREE_COUNT_TABLE
+	/* Some counts could not be stored, so they cannot be extracted. */
+	if (tracon_table_is_full(ctxt->table))
+		resources_set_memory_exhausted(opts->resources);
+#endif /* USE_LOCKFREE_COUNT_TABLE */
+
 	table_stat(ctxt);
 	return (int)hist_total(&hist);
 }
 
+/**
+ * Return the number of the tracon table entries.
+ */
+size_t count_table_entries(count_context_t *ctxt)
+{
+#if USE_LOCKFREE_COUNT_TABLE
+	return tracon_table_num_entries(ctxt->table);
+#else
+	return pool_num_elements_issued(ctxt->sent->Table_tracon_pool);
+#endif /* USE_LOCKFREE_COUNT_TABLE */
+}
+
 /* sent_length is used only as a hint for the hash table size ... */
 count_context_t * alloc_count_context(Sentence sent, Tracon_sharing *ts)
 {
@@ -1734,6 +2377,11 @@ count_context_t * alloc_count_context(Sentence sent, Tracon_sharing *ts)
 	 * one null link. */
 	/* ctxt->null_block = 1; */
 
+#if USE_LOCKFREE_COUNT_TABLE
+	assert((ts->next_id[0] < TRACON_TABLE_MAX_ID) &&
+	       (ts->next_id[1] < TRACON_TABLE_MAX_ID), "Too many tracons");
+	ctxt->table = tracon_table_new(estimate_tracon_entries(sent));
+#else
 	if (NULL != sent->Table_tracon_pool)
 	{
 		pool_reuse(sent->Table_tracon_pool);
@@ -1759,6 +2407,7 @@ count_context_t * alloc_count_context(Sentence sent, Tracon_sharing *ts)
 	}
 
 	init_table(ctxt);
+#endif /* USE_LOCKFREE_COUNT_TABLE */
 	return ctxt;
 }
 
@@ -1771,5 +2420,8 @@ void free_count_context(count_context_t *ctxt, Sentence sent)
 	            ctxt->count_cost[0], ctxt->count_cost[1], ctxt->count_cost[2]);)
 
 	free_table_lrcnt(ctxt);
+#if USE_LOCKFREE_COUNT_TABLE
+	tracon_table_delete(ctxt->table);
+#endif /* USE_LOCKFREE_COUNT_TABLE */
 	free(ctxt);
 }
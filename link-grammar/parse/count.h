@@ -25,6 +25,7 @@ Count_bin *table_lookup(count_context_t *, int, int,
 int do_parse(Sentence, fast_matcher_t*, count_context_t*, Parse_Options);
 bool no_count(count_context_t *, int, Connector *, unsigned int, unsigned int);
 match_list_cache *get_cached_match_list(count_context_t *, int, int, Connector *);
+size_t count_table_entries(count_context_t *);
 
 count_context_t *alloc_count_context(Sentence, Tracon_sharing*);
 void free_count_context(count_context_t*, Sentence);
@@ -27,6 +27,7 @@
 #include "memory-pool.h"
 #include "utilities.h"                  // Windows rand_r()
 #include "linkage/linkage.h"
+#include "tokenize/wordgraph.h"         // alt_bitmap_add
 #include "tokenize/word-structures.h"   // Word_Struct
 
 #define D_EXTRACT 5 /* General debug level for this file. */
@@ -45,6 +46,7 @@ typedef struct Parse_choice_struct Parse_choice;
  * The number of linkages in this parse is the product of the
  * counts of the two Parse_set elements. */
 typedef struct Parse_set_struct Parse_set;
+typedef struct Kbest_s Kbest;
 struct Parse_choice_struct
 {
 	Parse_choice * next;
@@ -69,6 +71,7 @@ struct Parse_set_struct
 	uint8_t        null_count; /* number of island words */
 
 	count_t count;             /* The number of ways to parse. */
+	Kbest *kbest;              /* Lowest-cost parses (NULL: not computed) */
 #ifdef RECOUNT
 	count_t recount;  /* Exactly the same as above, but counted at a later stage. */
 	count_t cut_count;  /* Count only low-cost parses, i.e. below the cost cutoff */
@@ -97,11 +100,16 @@ struct extractor_s
 	Pool_desc *    Pset_bucket_pool;
 	Pool_desc *    Parse_choice_pool;
 	bool           islands_ok;
+	bool           kbest_used;        /* Parse_set kbest needs freeing */
+	uint64_t *     alt_acc;           /* For alt_bitmap_add() (NULL: none) */
+	size_t         alt_acc_len;       /* Number of alt_acc elements */
 
 	/* thread-safe random number state */
 	unsigned int rand_state;
 };
 
+static void free_kbest(extractor_t *);
+
 /**
  * The first thing we do is we build a data structure to represent the
  * result of the entire parse search.  There will be a set of nodes
@@ -154,7 +162,7 @@ static void record_choice(
  * larger than what is needed. Thus, hash table load factor will be
  * small, usually around 0.25 or even less.
  */
-static int estimate_log2_table_size(Sentence sent)
+static int estimate_log2_table_size(Sentence sent, count_context_t *ctxt)
 {
 	/* Size estimate based on measurements (see #1402) */
 	double lscale = log2((double)sent->num_disjuncts + 1.0) -
@@ -164,10 +172,10 @@ static int estimate_log2_table_size(Sentence sent)
 	double dj_est = fmax(lo_est, hi_est);
 
 	/* For MST disjuncts, the number of elements issued for
-	 * pex->Pset_bucket_pool is almost exactly equal to the num elts
-	 * issued for sent->Table_tracon_pool.  This provides a better
+	 * pex->Pset_bucket_pool is almost exactly equal to the number of
+	 * the tracon table entries.  This provides a better
 	 * estimate when parsing with MST, when the above is too low.  */
-	double ntracon = (double)pool_num_elements_issued(sent->Table_tracon_pool);
+	double ntracon = (double)count_table_entries(ctxt);
 	double ltra = log2(ntracon) + 1.0;  // + 1.0 because floor()
 
 	int log2_table_size = (int)floor(fmax(dj_est, ltra));
@@ -215,14 +223,14 @@ static size_t estimate_parse_choice_allocations(Sentence sent)
 /**
  * Allocate the parse info struct
  */
-extractor_t * extractor_new(Sentence sent)
+extractor_t * extractor_new(Sentence sent, count_context_t *ctxt)
 {
 	extractor_t * pex = (extractor_t *) xalloc(sizeof(extractor_t));
 	memset(pex, 0, sizeof(extractor_t));
 	pex->rand_state = sent->rand_state;
 
 	/* Alloc the x_table */
-	int log2_table_size = estimate_log2_table_size(sent);
+	int log2_table_size = estimate_log2_table_size(sent, ctxt);
 	pex->log2_x_table_size = log2_table_size;
 	pex->x_table_size = (1 << log2_table_size);
 
@@ -245,6 +253,12 @@ extractor_t * extractor_new(Sentence sent)
 		         /*num_elements*/pcsze, sizeof(Parse_choice),
 		         /*zero_out*/false, /*align*/false, /*exact*/false);
 
+	if (0 != sent->alt_bitmap_len)
+	{
+		pex->alt_acc_len = 2 * sent->alt_bitmap_len;
+		pex->alt_acc = malloc(pex->alt_acc_len * sizeof(uint64_t));
+	}
+
 	return pex;
 }
 
@@ -278,6 +292,8 @@ void free_extractor(extractor_t * pex)
 
 	pex->parse_set = NULL;
 
+	if (pex->kbest_used) free_kbest(pex);
+
 	xfree((void *) pex->x_table, pex->x_table_size * sizeof(Pset_bucket*));
 	pex->x_table_size = 0;
 	pex->x_table = NULL;
@@ -293,8 +309,9 @@ void free_extractor(extractor_t * pex)
 	if (3012012 < pool_size(pex->Parse_choice_pool)) trim = true;
 #endif
 
-	pool_delete(pex->Pset_bucket_pool);
-	pool_delete(pex->Parse_choice_pool);
+	pool_recycle(pex->Pset_bucket_pool);
+	pool_recycle(pex->Parse_choice_pool);
+	free(pex->alt_acc);
 
 	xfree((void *) pex, sizeof(extractor_t));
 
@@ -365,6 +382,7 @@ static Pset_bucket * x_table_store(int lw, int rw,
 	n->set.count = 0;
 	n->set.first = NULL;
 	n->set.num_pc = 0;
+	n->set.kbest = NULL;
 
 	n->next = *t;
 	*t = n;
@@ -812,17 +830,25 @@ static bool is_zero_tracon(Connector *c)
 
 /**
  * Assemble the link array and the chosen_disjuncts of a linkage.
+ * If \p alt_acc is not NULL, also check that the chosen disjunct is
+ * from the same wordgraph alternative as the previous ones (the linked
+ * ones are known to be so, see alt_connection_possible()).
+ * Return false if it is not, as then the linkage has an invalid
+ * morphology (see sane_linkage_morphism()).
  */
-static void issue_link(Linkage lkg, int lr, Parse_choice *pc,
-                       const Parse_set *set)
+static bool issue_link(Linkage lkg, int lr, Parse_choice *pc,
+                       const Parse_set *set, uint64_t *alt_acc)
 {
 	Connector *lc = lr ? get_tracon_by_id(pc->md, pc->r_id, 1) : set->le;
-	if (is_zero_tracon(lc)) return; /* No choice to record. */
+	if (is_zero_tracon(lc)) return true; /* No choice to record. */
 
 	lkg->chosen_disjuncts[lr ? pc->set[1]->lw : pc->set[0]->rw] = pc->md;
+	if ((NULL != alt_acc) &&
+	    !alt_bitmap_add(lkg->sent, alt_acc, pc->md->originating_gword))
+		return false;
 
 	Connector *rc = lr ? set->re : get_tracon_by_id(pc->md, pc->l_id, 0);
-	if (is_zero_tracon(rc)) return; /* No choice to record. */
+	if (is_zero_tracon(rc)) return true; /* No choice to record. */
 
 	assert(lkg->num_links < lkg->lasz, "Linkage array too small!");
 	Link *link = &lkg->link_array[lkg->num_links];
@@ -830,14 +856,18 @@ static void issue_link(Linkage lkg, int lr, Parse_choice *pc,
 	link->rw = pc->set[lr]->rw;
 	link->lc = lc;
 	link->rc = rc;
+	link->link_name = NULL; /* Computed on demand */
+	link->discarded = false;
 	lkg->num_links++;
+
+	return true;
 }
 
-static void issue_links_for_choice(Linkage lkg, Parse_choice *pc,
-                                   const Parse_set *set)
+static bool issue_links_for_choice(Linkage lkg, Parse_choice *pc,
+                                   const Parse_set *set, uint64_t *alt_acc)
 {
-	issue_link(lkg, /*lr*/0, pc, set);
-	issue_link(lkg, /*lr*/1, pc, set);
+	return issue_link(lkg, /*lr*/0, pc, set, alt_acc) &&
+	       issue_link(lkg, /*lr*/1, pc, set, alt_acc);
 }
 
 /**
@@ -910,31 +940,36 @@ static void issue_links_for_choice(Linkage lkg, Parse_choice *pc,
  *
  * For S0: (Nindex % pc->set[0]->count) ranges from 0 to (S0ₘ-1).
  * For S1: (Nindex / pc->set[0]->count) ranges from 0 to (S1ₘ-1).
+ *
+ * Return false (leaving the linkage incomplete) as soon as a chosen
+ * disjunct is found to be from a different wordgraph alternative than
+ * a previous one (see issue_link()).
  */
-static void list_links(Linkage lkg, Parse_set * set, int index)
+static bool list_links(Linkage lkg, Parse_set * set, int index,
+                       uint64_t *alt_acc)
 {
 	Parse_choice *pc;
 	count_t n; /* No overflow - see extract_links() and process_linkages() */
 
 	assert(set != NULL, "Unexpected NULL Parse_set");
-	if (set->first == NULL) return;
+	if (set->first == NULL) return true;
 	for (pc = set->first; pc != NULL; pc = pc->next) {
 		n = pc->set[0]->count * pc->set[1]->count;
 		if (index < n) break;
 		index -= n;
 	}
 	assert(pc != NULL, "walked off the end in list_links");
-	issue_links_for_choice(lkg, pc, set);
 
-	list_links(lkg, pc->set[0], index % pc->set[0]->count);
-	list_links(lkg, pc->set[1], index / pc->set[0]->count);
+	return issue_links_for_choice(lkg, pc, set, alt_acc) &&
+	       list_links(lkg, pc->set[0], index % pc->set[0]->count, alt_acc) &&
+	       list_links(lkg, pc->set[1], index / pc->set[0]->count, alt_acc);
 }
 
-static void list_random_links(Linkage lkg, unsigned int *rand_state,
-                              Parse_set * set)
+static bool list_random_links(Linkage lkg, unsigned int *rand_state,
+                              Parse_set * set, uint64_t *alt_acc)
 {
 	assert(set != NULL, "Unexpected NULL Parse_set");
-	if (set->first == NULL) return;
+	if (set->first == NULL) return true;
 
 	/* Avoid calling rand_r() for the common case of a single element. */
 	unsigned int new_index = (set->num_pc == 1) ? 0 :
@@ -944,35 +979,303 @@ static void list_random_links(Linkage lkg, unsigned int *rand_state,
 	for (pc = set->first; new_index > 0; pc = pc->next)
 		new_index--;
 
-	issue_links_for_choice(lkg, pc, set);
-	list_random_links(lkg, rand_state, pc->set[0]);
-	list_random_links(lkg, rand_state, pc->set[1]);
+	/* Pick the random choices of both the sub-sets even if the first
+	 * one fails, so the rest of the random linkages don't depend on
+	 * the alternatives check. */
+	bool ok = issue_links_for_choice(lkg, pc, set, alt_acc);
+	ok = list_random_links(lkg, rand_state, pc->set[0], alt_acc) && ok;
+	ok = list_random_links(lkg, rand_state, pc->set[1], alt_acc) && ok;
+	return ok;
 }
 
 /**
  * Generate the list of all links of the index'th parsing of the
  * sentence.  For this to work, you must have already called parse, and
  * already built the whole_set.
+ *
+ * For sentences with word alternatives, return false if the chosen
+ * disjuncts are not all from the same alternatives, as such a linkage
+ * would anyway be rejected by sane_linkage_morphism(). Its extraction
+ * is then abandoned as soon as this is found.
  */
-void extract_links(extractor_t * pex, Linkage lkg)
+bool extract_links(extractor_t * pex, Linkage lkg)
 {
+	uint64_t *alt_acc = pex->alt_acc;
+	if (NULL != alt_acc) memset(alt_acc, 0, pex->alt_acc_len * sizeof(uint64_t));
+
 	int index = lkg->lifo.index;
+	bool ok;
 	if (index < 0)
 	{
 		bool repeatable = false;
 		if (0 == pex->rand_state) repeatable = true;
 		if (repeatable) pex->rand_state = index;
-		list_random_links(lkg, &pex->rand_state, pex->parse_set);
+		ok = list_random_links(lkg, &pex->rand_state, pex->parse_set, alt_acc);
 		if (repeatable)
 			pex->rand_state = 0;
 		else
 			lkg->sent->rand_state = pex->rand_state;
 	}
 	else {
-		list_links(lkg, pex->parse_set, index);
+		ok = list_links(lkg, pex->parse_set, index, alt_acc);
 	}
+
+	return ok;
+}
+
+/* ======================================================== */
+/* Lowest-cost linkages.
+ *
+ * When there are more linkages than can be examined, extracting random
+ * ones and sorting them by cost doesn't guarantee that the best
+ * linkages are found. Instead, enumerate the linkages of the
+ * parse-set in increasing cost order, using the lazy k-best algorithm
+ * of Huang & Chiang ("Better k-best parsing", 2005, algorithm 3).
+ *
+ * Each Parse_set keeps the list of its lowest-cost derivations found so
+ * far, and a heap of candidates for its next one. A derivation is a
+ * Parse_choice, along with the rank of the derivation used for each of
+ * its two Parse_set elements. The next-best derivation of a Parse_set
+ * is always one of the successors of those already found, i.e. it
+ * differs from one of them by using the next-ranked derivation for one
+ * of the Parse_set elements of its Parse_choice. So only the derivations
+ * that are actually needed get computed, after an initial pass over the
+ * whole parse-set that finds the best derivation of each Parse_set.
+ *
+ * The cost is that of VDAL_compare_linkages() - the disjunct cost, and
+ * then the link cost. The number of unused words is the same in all the
+ * linkages of a parse-set, and the P.P. violations are not known here.
+ */
+
+typedef struct
+{
+	float disjunct;            /* Sum of the chosen disjunct costs */
+	int link;                  /* Sum of the link lengths, minus 1 each */
+} Kbest_cost;
+
+typedef struct
+{
+	Parse_choice *pc;          /* NULL for a leaf */
+	unsigned int rank[2];      /* Derivation rank of pc->set[0], pc->set[1] */
+	Kbest_cost cost;
+} Kbest_deriv;
+
+struct Kbest_s
+{
+	Kbest_deriv *deriv;        /* Derivations found, in cost order */
+	unsigned int num_deriv;
+	unsigned int deriv_size;   /* Allocated number of elements */
+	Kbest_deriv *cand;         /* Min-heap of next-derivation candidates */
+	unsigned int num_cand;
+	unsigned int cand_size;    /* Allocated number of elements */
+	bool exhausted;            /* All the derivations have been found */
+};
+
+#define KBEST_COST_EPSILON 1.0e-6 /* Same as in VDAL_compare_linkages() */
+
+static bool kbest_cost_less(const Kbest_cost *c1, const Kbest_cost *c2)
+{
+	float diff = c1->disjunct - c2->disjunct;
+
+	if (KBEST_COST_EPSILON < diff) return false;
+	if (diff < -KBEST_COST_EPSILON) return true;
+	return c1->link < c2->link;
 }
 
+/**
+ * The cost of the links and chosen disjunct that are issued for \p pc.
+ * This must agree with issue_link().
+ */
+static Kbest_cost choice_cost(Parse_choice *pc, const Parse_set *set)
+{
+	Kbest_cost cost = { 0.0f, 0 };
+	bool chosen = false;
+
+	for (int lr = 0; lr < 2; lr++)
+	{
+		Connector *lc = lr ? get_tracon_by_id(pc->md, pc->r_id, 1) : set->le;
+		if (is_zero_tracon(lc)) continue;
+		chosen = true;
+
+		Connector *rc = lr ? set->re : get_tracon_by_id(pc->md, pc->l_id, 0);
+		if (is_zero_tracon(rc)) continue;
+		cost.link += pc->set[lr]->rw - pc->set[lr]->lw - 1;
+	}
+
+	if (chosen)
+	{
+		Disjunct *md = pc->md;
+		cost.disjunct = md->is_category ? md->category[0].cost : md->cost;
+	}
+
+	return cost;
+}
+
+static void kbest_heap_push(Kbest *kb, const Kbest_deriv *cand)
+{
+	if (kb->num_cand == kb->cand_size)
+	{
+		kb->cand_size = (0 == kb->cand_size) ? 4 : 2 * kb->cand_size;
+		kb->cand = realloc(kb->cand, kb->cand_size * sizeof(Kbest_deriv));
+	}
+
+	unsigned int i = kb->num_cand++;
+	while (i > 0)
+	{
+		unsigned int parent = (i - 1) / 2;
+		if (!kbest_cost_less(&cand->cost, &kb->cand[parent].cost)) break;
+		kb->cand[i] = kb->cand[parent];
+		i = parent;
+	}
+	kb->cand[i] = *cand;
+}
+
+static Kbest_deriv kbest_heap_pop(Kbest *kb)
+{
+	Kbest_deriv top = kb->cand[0];
+	Kbest_deriv last = kb->cand[--kb->num_cand];
+
+	unsigned int i = 0;
+	for (;;)
+	{
+		unsigned int child = 2 * i + 1;
+		if (child >= kb->num_cand) break;
+		if ((child + 1 < kb->num_cand) &&
+		    kbest_cost_less(&kb->cand[child + 1].cost, &kb->cand[child].cost))
+			child++;
+		if (!kbest_cost_less(&kb->cand[child].cost, &last.cost)) break;
+		kb->cand[i] = kb->cand[child];
+		i = child;
+	}
+	if (kb->num_cand > 0) kb->cand[i] = last;
+
+	return top;
+}
+
+static const Kbest_deriv *kbest_get(extractor_t *, Parse_set *, unsigned int);
+
+/**
+ * Push the candidate that uses \p pc with the given derivation ranks of
+ * its Parse_set elements, if these derivations exist.
+ */
+static void kbest_push_choice(extractor_t *pex, Parse_set *set,
+                              Parse_choice *pc, unsigned int r0,
+                              unsigned int r1)
+{
+	const Kbest_deriv *d0 = kbest_get(pex, pc->set[0], r0);
+	if (NULL == d0) return;
+	Kbest_cost cost0 = d0->cost;
+	const Kbest_deriv *d1 = kbest_get(pex, pc->set[1], r1);
+	if (NULL == d1) return;
+
+	Kbest_deriv cand = { .pc = pc, .rank = { r0, r1 } };
+	cand.cost = choice_cost(pc, set);
+	cand.cost.disjunct += cost0.disjunct + d1->cost.disjunct;
+	cand.cost.link += cost0.link + d1->cost.link;
+
+	kbest_heap_push(set->kbest, &cand);
+}
+
+/**
+ * Return the derivation of rank \p k (0 for the best one) of \p set,
+ * or NULL if there is no such derivation.
+ */
+static const Kbest_deriv *kbest_get(extractor_t *pex, Parse_set *set,
+                                    unsigned int k)
+{
+	static const Kbest_deriv leaf = { .pc = NULL };
+
+	/* Like list_links(), consider a set without choices as a leaf. */
+	if (set->first == NULL) return (0 == k) ? &leaf : NULL;
+
+	if (NULL == set->kbest)
+	{
+		Kbest *kb = malloc(sizeof(Kbest));
+		*kb = (Kbest){ .deriv = NULL };
+		set->kbest = kb;
+		pex->kbest_used = true;
+
+		for (Parse_choice *pc = set->first; pc != NULL; pc = pc->next)
+			kbest_push_choice(pex, set, pc, 0, 0);
+	}
+
+	Kbest *kb = set->kbest;
+	while (k >= kb->num_deriv)
+	{
+		if (kb->exhausted) return NULL;
+
+		if (kb->num_deriv > 0)
+		{
+			/* Push the successors of the last derivation. The second one
+			 * is pushed only for rank[0] == 0, so that each candidate is
+			 * pushed only once. */
+			Kbest_deriv last = kb->deriv[kb->num_deriv - 1];
+			kbest_push_choice(pex, set, last.pc, last.rank[0] + 1, last.rank[1]);
+			if (0 == last.rank[0])
+				kbest_push_choice(pex, set, last.pc, 0, last.rank[1] + 1);
+		}
+
+		if (0 == kb->num_cand)
+		{
+			kb->exhausted = true;
+			return NULL;
+		}
+
+		if (kb->num_deriv == kb->deriv_size)
+		{
+			kb->deriv_size = (0 == kb->deriv_size) ? 1 : 2 * kb->deriv_size;
+			kb->deriv = realloc(kb->deriv, kb->deriv_size * sizeof(Kbest_deriv));
+		}
+		kb->deriv[kb->num_deriv++] = kbest_heap_pop(kb);
+	}
+
+	return &kb->deriv[k];
+}
+
+static void list_best_links(extractor_t *pex, Linkage lkg, Parse_set *set,
+                            unsigned int rank)
+{
+	const Kbest_deriv *d = kbest_get(pex, set, rank);
+	if (NULL == d->pc) return;
+
+	issue_links_for_choice(lkg, d->pc, set, NULL);
+	list_best_links(pex, lkg, d->pc->set[0], d->rank[0]);
+	list_best_links(pex, lkg, d->pc->set[1], d->rank[1]);
+}
+
+/**
+ * Generate the links of the linkage of rank \p rank (0 for the
+ * lowest-cost one) of the sentence.
+ * Return \c false if there is no such linkage.
+ */
+bool extract_best_links(extractor_t *pex, Linkage lkg, unsigned int rank)
+{
+	if (NULL == kbest_get(pex, pex->parse_set, rank)) return false;
+
+	lkg->lifo.index = (int)rank;
+	list_best_links(pex, lkg, pex->parse_set, rank);
+	return true;
+}
+
+static void free_kbest(extractor_t *pex)
+{
+	for (unsigned int i = 0; i < pex->x_table_size; i++)
+	{
+		for (Pset_bucket *t = pex->x_table[i]; t != NULL; t = t->next)
+		{
+			Kbest *kb = t->set.kbest;
+			if (NULL == kb) continue;
+
+			free(kb->deriv);
+			free(kb->cand);
+			free(kb);
+		}
+	}
+	pex->kbest_used = false;
+}
+
+/* ======================================================== */
+
 static void mark_used_disjunct(Parse_set *set, bool *disjunct_used)
 {
 	if (set == NULL || set->first == NULL) return;
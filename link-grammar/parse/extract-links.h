@@ -18,14 +18,15 @@
 
 typedef struct extractor_s extractor_t;
 
-extractor_t* extractor_new(Sentence);
+extractor_t* extractor_new(Sentence, count_context_t*);
 void free_extractor(extractor_t*);
 
 bool build_parse_set(extractor_t*, Sentence,
                      fast_matcher_t*, count_context_t*,
                      unsigned int null_count, Parse_Options);
 
-void extract_links(extractor_t*, Linkage);
+bool extract_links(extractor_t*, Linkage);
+bool extract_best_links(extractor_t*, Linkage, unsigned int rank);
 
 void mark_used_disjuncts(extractor_t *, bool *);
 
@@ -47,27 +47,12 @@
 
 #define MATCH_LIST_SIZE_INIT 4096 /* the initial size of the match-list stack */
 #define MATCH_LIST_SIZE_INC 2     /* match-list stack increase size factor */
+#define MATCH_PREFETCH_DISTANCE 4 /* In match-table elements */
 
 #ifndef ML_COMPAT
 #define ML_COMPAT 0 /* 1: Disjunct order compatible to V5.6.2 (slower). */
 #endif /* ML_COMPAT */
 
-/*
- * Each lookup table entry points to list of disjuncts whose shallow
- * connector has the same uppercase part. These lists are sorted according
- * to the nearest_word of these connectors. The sorting is done using
- * "bucket sort" in which the number of bins is equal to the different
- * number of values of nearest word so only one sorting round is needed.
- */
-typedef struct sortbin_s sortbin;
-struct sortbin_s
-{
-	Match_node *head;
-#if ML_COMPAT
-	Match_node *tail;
-#endif
-};
-
 /**
  * Push a match-list element into the match-list array.
  */
@@ -87,145 +72,243 @@ static void push_match_list_element(fast_matcher_t *ctxt, uint16_t id, Disjunct
 }
 
 /**
- * Free all of the hash tables and Match_nodes
+ * Free all of the hash tables and match-table elements
  */
 void free_fast_matcher(Sentence sent, fast_matcher_t *mchxt)
 {
 	if (NULL == mchxt) return;
 
 	free(mchxt->l_table[0]);
+	free(mchxt->m_lc_letters);
 	xfree(mchxt->match_list, mchxt->match_list_size * sizeof(*mchxt->match_list));
 	lgdebug(+6, "Sentence length %zu, match_list_size %zu\n",
 	        mchxt->size, mchxt->match_list_size);
 
 	xfree(mchxt->l_table_size, mchxt->size * sizeof(unsigned int));
-	xfree(mchxt->l_table, mchxt->size * sizeof(Match_node **));
+	xfree(mchxt->l_table, mchxt->size * sizeof(match_table_entry *));
 	xfree(mchxt, sizeof(fast_matcher_t));
 }
 
-static Match_node *match_list_not_found = NULL;
+/* ======================================================================== */
+/*
+ * Filtering the match-list candidates by their lc part.
+ *
+ * The candidates of a match list are the elements of a match-table
+ * entry, i.e. they have the same uc part as the connector they are
+ * matched against, so only their lc part needs to be checked (see
+ * lc_easy_match()). Their lc_letters and lc_mask are in arrays, so
+ * the check can be done with vector instructions on several candidates
+ * at once. The implementation is selected at runtime according to the
+ * CPU capabilities.
+ */
 
-static Match_node **get_match_table_entry(unsigned int size, Match_node **t,
-                                          Connector * c, int dir)
+/**
+ * Check the lc part of up to 64 candidates against that of a connector.
+ * @return A bitmask in which bit i is set iff candidate i matches.
+ */
+static uint64_t lc_filter_scalar(const lc_enc_t *lc_letters,
+                                 const lc_enc_t *lc_mask, size_t num,
+                                 lc_enc_t c_letters, lc_enc_t c_mask)
 {
-	unsigned int h, s;
-	s = h = connector_uc_hash(c) & (size-1);
+	uint64_t match = 0;
 
-	if (dir == 1) {
-		while (NULL != t[h])
-		{
-			if (connector_uc_eq(t[h]->d->right, c)) break;
-
-			/* Increment and try again. Every hash bucket MUST have
-			 * a unique upper-case part, since later on, we only
-			 * compare the lower-case parts, assuming upper-case
-			 * parts are already equal. So just look for the next
-			 * unused hash bucket.
-			 */
-			h = (h + 1) & (size-1);
-			if (h == s) return &match_list_not_found;
-		}
-	}
-	else
+	for (size_t i = 0; i < num; i++)
 	{
-		while (NULL != t[h])
-		{
-			if (connector_uc_eq(t[h]->d->left, c)) break;
-			h = (h + 1) & (size-1);
-			if (h == s) return &match_list_not_found;
-		}
+		lc_enc_t m = lc_mask[i] & c_mask;
+		if (((lc_letters[i] ^ c_letters) & m) == (m & 1))
+			match |= (uint64_t)1 << i;
 	}
 
-	return &t[h];
+	return match;
 }
 
-/**
- * Add the match nodes at sbin to the table entry of their shallow connector.
- */
-static void add_to_table_entry(unsigned int tsize, Match_node **table,
-                               int dir, sortbin *sbin)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    !defined(__EMSCRIPTEN__)
+#define LC_FILTER_X86
+#include <immintrin.h>
+
+__attribute__((target("sse4.1")))
+static uint64_t lc_filter_sse41(const lc_enc_t *lc_letters,
+                                const lc_enc_t *lc_mask, size_t num,
+                                lc_enc_t c_letters, lc_enc_t c_mask)
 {
-	Match_node *m_next;
-	for (Match_node *m = sbin->head; NULL != m; m = m_next)
-	{
-		Connector *c = (0 == dir) ? m->d->left : m->d->right;
-		assert(NULL != c, "NULL connector");
+	const __m128i cl = _mm_set1_epi64x((long long)c_letters);
+	const __m128i cm = _mm_set1_epi64x((long long)c_mask);
+	const __m128i one = _mm_set1_epi64x(1);
+	uint64_t match = 0;
+	size_t i;
 
-		Match_node **xl = get_match_table_entry(tsize, table, c, dir);
-		assert(&match_list_not_found != xl, "get_match_table_entry: Overflow");
+	for (i = 0; i + 2 <= num; i += 2)
+	{
+		__m128i l = _mm_loadu_si128((const __m128i *)&lc_letters[i]);
+		__m128i m = _mm_and_si128(_mm_loadu_si128((const __m128i *)&lc_mask[i]), cm);
+		__m128i x = _mm_and_si128(_mm_xor_si128(l, cl), m);
+		__m128i eq = _mm_cmpeq_epi64(x, _mm_and_si128(m, one));
 
-		m_next = m->next; /* Remember before overwriting. */
+		match |= (uint64_t)_mm_movemask_pd(_mm_castsi128_pd(eq)) << i;
+	}
 
-		/* Insert m at head of list */
-		m->next = *xl;
-		*xl = m;
+	if (i < num)
+	{
+		match |= lc_filter_scalar(&lc_letters[i], &lc_mask[i], num - i,
+		                          c_letters, c_mask) << i;
 	}
+
+	return match;
 }
 
-/**
- * Put the nearest_word-sorted disjuncts at sbin into the given hash table.
- * Since add_to_table_entry() inserts at entry's head, insert in the
- * reverse order than the needed match-list order of nearest_word.
- *
- * @param tsize The hash table size.
- * @param table The hash table.
- * @param w The word to which these disjuncts belong.
- * @param dir 0: Put it into a right table; 1: Put it  into a left table.
- * @param sbin Indexed by the disjuncts' shallow-connector nearest_word.
- * @param sent_length Sentence length, for sbin index upper bound.
- */
-static void put_into_match_table(unsigned int tsize, Match_node **table,
-                                 int w, int dir, sortbin *sbin,
-                                 size_t sent_length)
+__attribute__((target("avx2")))
+static uint64_t lc_filter_avx2(const lc_enc_t *lc_letters,
+                               const lc_enc_t *lc_mask, size_t num,
+                               lc_enc_t c_letters, lc_enc_t c_mask)
 {
-	if (0 == dir)
+	const __m256i cl = _mm256_set1_epi64x((long long)c_letters);
+	const __m256i cm = _mm256_set1_epi64x((long long)c_mask);
+	const __m256i one = _mm256_set1_epi64x(1);
+	uint64_t match = 0;
+	size_t i;
+
+	for (i = 0; i + 4 <= num; i += 4)
 	{
-		/* Left match-list needed order: Increasing nearest_word. */
-		for (WordIdx sbw = 0; sbw < (WordIdx)w; sbw++)
-		{
-			add_to_table_entry(tsize, table, dir, &sbin[sbw]);
-		}
+		__m256i l = _mm256_loadu_si256((const __m256i *)&lc_letters[i]);
+		__m256i m = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&lc_mask[i]), cm);
+		__m256i x = _mm256_and_si256(_mm256_xor_si256(l, cl), m);
+		__m256i eq = _mm256_cmpeq_epi64(x, _mm256_and_si256(m, one));
+
+		match |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(eq)) << i;
 	}
-	else
+
+	if (i < num)
 	{
-		/* Right match-list needed order: Decreasing nearest_word. */
-		for (WordIdx sbw = sent_length-1; sbw > (WordIdx)w; sbw--)
-		{
-			add_to_table_entry(tsize, table, dir, &sbin[sbw]);
-		}
+		match |= lc_filter_sse41(&lc_letters[i], &lc_mask[i], num - i,
+		                         c_letters, c_mask) << i;
 	}
+
+	return match;
 }
+#endif /* __GNUC__ && x86 */
 
-static void clean_sortbin(sortbin *sbin, size_t sent_length)
+/**
+ * Select the lc filter implementation for this CPU.
+ * The "no-simd" test option selects the scalar one.
+ */
+static lc_filter_func select_lc_filter(void)
 {
-	for (unsigned int i = 0; i < sent_length; i++)
-				sbin[i].head = NULL;
+	if (test_enabled("no-simd")) return lc_filter_scalar;
+
+#ifdef LC_FILTER_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return lc_filter_avx2;
+	if (__builtin_cpu_supports("sse4.1")) return lc_filter_sse41;
+#endif /* LC_FILTER_X86 */
+
+	return lc_filter_scalar;
 }
 
+/* ======================================================================== */
+
 /**
- * Put the Match_node m into a list according to nearest_word.
- * This is a bucket sort.
+ * Find the match-table entry for the uc part \p uc_num while the table
+ * is built, and claim it if it is unused.
  */
-static void sort_by_nearest_word(Match_node *m, sortbin *sbin, int nearest_word)
+static match_table_entry *get_build_table_entry(unsigned int size,
+                                                match_table_entry *t,
+                                                connector_uc_hash_t uc_num)
 {
+	unsigned int h, s;
+	s = h = uc_num & (size-1);
 
-	sbin = &sbin[nearest_word]; /* Bucket selection. */
+	/* Every hash bucket MUST have a unique upper-case part, since later
+	 * on, we only compare the lower-case parts, assuming upper-case
+	 * parts are already equal. So just look for the next unused hash
+	 * bucket. */
+	while (0 != t[h].num)
+	{
+		if (t[h].uc_num == uc_num) return &t[h];
+		h = (h + 1) & (size-1);
+		assert(h != s, "get_build_table_entry: Overflow");
+	}
+
+	t[h].uc_num = uc_num;
+	return &t[h];
+}
+
+/**
+ * Build the match table \p t of the word \p w in direction \p dir (0:
+ * The left table, of the left connectors). Its entries refer to ranges
+ * of the match-table elements, which are sorted by the nearest_word of
+ * their connector in the needed match-list order: Decreasing
+ * nearest_word for the left table, and increasing for the right one.
+ * Elements with the same nearest_word are in the disjunct order (the
+ * reverse order if ML_COMPAT).
+ *
+ * @param wd Work area for the disjuncts of the word.
+ * @param slot Work area for their table entries.
+ * @param sbin Work area for the sorting, with an element per word.
+ */
+static void build_match_table(fast_matcher_t *ctxt, const Sentence sent,
+                              unsigned int tsize, match_table_entry *t,
+                              WordIdx w, int dir, Disjunct **wd,
+                              unsigned int *slot, unsigned int *sbin)
+{
+	size_t n = 0;
 
-#if ML_COMPAT
-	if (NULL == sbin->head)
+	for (Disjunct *d = sent->word[w].d; NULL != d; d = d->next)
 	{
-		sbin->head = m;
+		if (NULL != ((0 == dir) ? d->left : d->right)) wd[n++] = d;
 	}
-	else
+	if (0 == n) return;
+
+	/* Sort by nearest_word (a counting sort). The left table is in
+	 * decreasing nearest_word, so its sort key is reversed. */
+	memset(sbin, 0, (sent->length + 1) * sizeof(*sbin));
+	for (size_t i = 0; i < n; i++)
 	{
-		sbin->tail->next = m;
+		const Connector *c = (0 == dir) ? wd[i]->left : wd[i]->right;
+		unsigned int key = (0 == dir) ?
+			(unsigned int)(sent->length - 1 - c->nearest_word) : c->nearest_word;
+		sbin[key + 1]++;
+	}
+	for (size_t k = 1; k <= sent->length; k++)
+		sbin[k] += sbin[k - 1];
+	for (size_t j = 0; j < n; j++)
+	{
+		size_t i = ML_COMPAT ? (n - 1 - j) : j;
+		const Connector *c = (0 == dir) ? wd[i]->left : wd[i]->right;
+		unsigned int key = (0 == dir) ?
+			(unsigned int)(sent->length - 1 - c->nearest_word) : c->nearest_word;
+		slot[sbin[key]++] = (unsigned int)i;
+	}
+
+	/* Now wd[slot[]] is sorted. Count the elements of each table entry. */
+	for (size_t j = 0; j < n; j++)
+	{
+		Disjunct *d = wd[slot[j]];
+		const Connector *c = (0 == dir) ? d->left : d->right;
+		get_build_table_entry(tsize, t, connector_uc_num(c))->num++;
+	}
+
+	/* Assign the element ranges, and then fill them in the sorted order. */
+	for (unsigned int h = 0; h < tsize; h++)
+	{
+		if (0 == t[h].num) continue;
+		t[h].start = (unsigned int)ctxt->m_num;
+		ctxt->m_num += t[h].num;
+		t[h].num = 0;
+	}
+	for (size_t j = 0; j < n; j++)
+	{
+		Disjunct *d = wd[slot[j]];
+		const Connector *c = (0 == dir) ? d->left : d->right;
+		match_table_entry *te = get_build_table_entry(tsize, t, connector_uc_num(c));
+		size_t i = te->start + te->num++;
+
+		ctxt->m_d[i] = d;
+		ctxt->m_lc_letters[i] = c->desc->lc_letters;
+		ctxt->m_lc_mask[i] = c->desc->lc_mask;
+		ctxt->m_nearest_word[i] = c->nearest_word;
+		ctxt->m_farthest_word[i] = c->farthest_word;
 	}
-	sbin->tail = m;
-	m->next = NULL;
-#else
-	m->next = sbin->head;
-	sbin->head = m;
-#endif
 }
 
 fast_matcher_t* alloc_fast_matcher(const Sentence sent, unsigned int *ncu[])
@@ -238,32 +321,19 @@ fast_matcher_t* alloc_fast_matcher(const Sentence sent, unsigned int *ncu[])
 	ctxt->size = sent->length;
 	ctxt->l_table_size = xalloc(2 * sent->length * sizeof(unsigned int));
 	ctxt->r_table_size = ctxt->l_table_size + sent->length;
-	ctxt->l_table = xalloc(2 * sent->length * sizeof(Match_node **));
+	ctxt->l_table = xalloc(2 * sent->length * sizeof(match_table_entry *));
 	ctxt->r_table = ctxt->l_table + sent->length;
-	memset(ctxt->l_table, 0, 2 * sent->length * sizeof(Match_node **));
+	memset(ctxt->l_table, 0, 2 * sent->length * sizeof(match_table_entry *));
+	ctxt->lc_filter = select_lc_filter();
 
 	ctxt->match_list_size = MATCH_LIST_SIZE_INIT;
 	ctxt->match_list = xalloc(ctxt->match_list_size * sizeof(*ctxt->match_list));
 	ctxt->match_list_end = 0;
 
-	if (NULL != sent->Match_node_pool)
-	{
-		pool_reuse(sent->Match_node_pool);
-	}
-	else
-	{
-		sent->Match_node_pool =
-			pool_new(__func__, "Match_node",
-			         /*num_elements*/2048, sizeof(Match_node),
-			         /*zero_out*/false, /*align*/true, /*exact*/false);
-	}
-
-	sortbin *sbin = alloca(sent->length * sizeof(sortbin));
-
 	/* Calculate the sizes of the hash tables. */
 	unsigned int num_headers = 0;
-	Match_node **memblock_headers;
-	Match_node **hash_table_header;
+	match_table_entry *memblock_headers;
+	match_table_entry *hash_table_header;
 
 	for (WordIdx w = 0; w < sent->length; w++)
 	{
@@ -286,45 +356,45 @@ fast_matcher_t* alloc_fast_matcher(const Sentence sent, unsigned int *ncu[])
 		}
 	}
 
-	memblock_headers = malloc(num_headers * sizeof(Match_node *));
-	memset(memblock_headers, 0, num_headers * sizeof(Match_node *));
+	memblock_headers = malloc(num_headers * sizeof(match_table_entry));
+	memset(memblock_headers, 0, num_headers * sizeof(match_table_entry));
 	hash_table_header = memblock_headers;
 
+	/* The match-table elements. */
+	size_t num_elements = 0;
+	size_t max_word_disjuncts = 0;
 	for (WordIdx w = 0; w < sent->length; w++)
 	{
-		clean_sortbin(sbin, sent->length);
-
-		/* Sort the disjuncts of each word according to the nearest word
-		 * that their left and right shallow connectors can connect to.
-		 * For performance of the parsing stage, the loop over
-		 * the disjuncts is done separately for the left and right
-		 * connectors, so the Match_node memory of consequent disjuncts in
-		 * the match lists will be adjacent in memory (a noticeable
-		 * speedup due to a better use of the CPU cache). */
-		for (Disjunct *d = sent->word[w].d; NULL != d; d = d->next)
-		{
-			if (d->left != NULL)
-			{
-				Match_node *m = pool_alloc(sent->Match_node_pool);
-				m->d = d;
-				sort_by_nearest_word(m, sbin, d->left->nearest_word);
-			}
-		}
+		size_t n = 0;
 		for (Disjunct *d = sent->word[w].d; NULL != d; d = d->next)
 		{
-			if (d->right != NULL)
-			{
-				Match_node *m = pool_alloc(sent->Match_node_pool);
-				m->d = d;
-				sort_by_nearest_word(m, sbin, d->right->nearest_word);
-			}
+			num_elements += (NULL != d->left) + (NULL != d->right);
+			n++;
 		}
+		max_word_disjuncts = MAX(max_word_disjuncts, n);
+	}
+	size_t esize = sizeof(*ctxt->m_d) + 2 * sizeof(lc_enc_t) + 2;
+	char *elements = malloc(num_elements * esize + 1);
+	ctxt->m_lc_letters = (lc_enc_t *)elements;
+	ctxt->m_lc_mask = ctxt->m_lc_letters + num_elements;
+	ctxt->m_d = (Disjunct **)(ctxt->m_lc_mask + num_elements);
+	ctxt->m_nearest_word = (uint8_t *)(ctxt->m_d + num_elements);
+	ctxt->m_farthest_word = ctxt->m_nearest_word + num_elements;
+	ctxt->m_num = 0;
+
+	Disjunct **wd = malloc(max_word_disjuncts * sizeof(*wd) + 1);
+	unsigned int *slot = malloc(max_word_disjuncts * sizeof(*slot) + 1);
+	unsigned int *sbin = alloca((sent->length + 1) * sizeof(*sbin));
 
-		/* Build the hash tables. */
+	for (WordIdx w = 0; w < sent->length; w++)
+	{
+		/* Build the hash tables. For performance of the parsing stage,
+		 * the elements of the left and right tables are built separately,
+		 * so those of the same match list are adjacent in memory. */
 		for (int dir = 0; dir < 2; dir++)
 		{
 			unsigned int tsize = ncu[dir][w];
-			Match_node **t = hash_table_header;
+			match_table_entry *t = hash_table_header;
 
 			hash_table_header += tsize;
 
@@ -339,50 +409,18 @@ fast_matcher_t* alloc_fast_matcher(const Sentence sent, unsigned int *ncu[])
 				ctxt->r_table_size[w] = tsize;
 			}
 
-			put_into_match_table(tsize, t, w, dir, sbin, sent->length);
+			build_match_table(ctxt, sent, tsize, t, w, dir, wd, slot, sbin);
 		}
 	}
+	free(slot);
+	free(wd);
 
 	assert(memblock_headers + num_headers == hash_table_header,
 	   "Mismatch header sizes");
+	assert(num_elements == ctxt->m_num, "Mismatch match-table elements");
 	return ctxt;
 }
 
-#if 0
-/**
- * Print statistics on various connector matching aspects.
- * A summary can be found by the shell commands:
- * link-parser < file.batch | grep match_stats: | sort | uniq -c
- */
-static void match_stats(Connector *c1, Connector *c2)
-{
-	if (NULL == c1) printf("match_stats: cache\n");
-	if (NULL == c2) return;
-	if ((1 == c1->uc_start) && (1 == c2->uc_start) &&
-	    (c1->string[0] == c2->string[0]))
-	{
-		printf("match_stats: h/d mismatch\n");
-	}
-
-	if (0 == c1->lc_start) printf("match_stats: no lc (c1)\n");
-	if (0 == c2->lc_start) printf("match_stats: no lc (c2)\n");
-
-	if (string_set_cmp(c1->string, c2->string)) printf("match_stats: same\n");
-
-	const char *a = &c1->string[c1->lc_start];
-	const char *b = &c2->string[c2->lc_start];
-	do
-	{
-		if (*a != *b && (*a != '*') && (*b != '*')) printf("match_stats: lc false\n");
-		a++;
-		b++;
-	} while (*a != '\0' && *b != '\0');
-	printf("match_stats: lc true\n");
-}
-#else
-#define match_stats(a, b)
-#endif
-
 #ifdef DEBUG
 #undef N
 #define N(c) (c?connector_string(c):"")
@@ -422,44 +460,54 @@ static void print_match_list(fast_matcher_t *ctxt, uint16_t id, size_t mlb, int
 #define print_match_list(...)
 #endif
 
-typedef struct
-{
-	const condesc_t *desc;
-	bool match;
-} match_cache;
+static const match_table_entry match_entry_not_found = { .num = 0 };
 
 /**
- * Match the lower-case parts of connectors, and the head-dependent,
- * using a cache of the most recent compare.  Due to the way disjuncts
- * are written, we are often asked to compare to the same connector
- * 3 or 4 times in a row. So if we already did that compare, just use
- * the cached result. (i.e. the caching here is almost trivial, but it
- * works well).
+ * Find the match-table entry of the uc part of \p c.
+ * @return The entry; its \c num is 0 if there are no candidates.
  */
-static bool do_match_with_cache(Connector *a, Connector *b, match_cache *c_con)
+static const match_table_entry *
+get_match_table_entry(unsigned int size, const match_table_entry *t,
+                      Connector *c)
 {
-	/* The following uses a string-set compare - string_set_cmp() cannot
-	 * be used here because c_con->string may be NULL. */
-	match_stats(c_con->string == a->string ? NULL : a, NULL);
-	UNREACHABLE(connector_desc(a) == NULL); // clang static analyzer suppression.
-	if (c_con->desc == connector_desc(a))
+	connector_uc_hash_t uc_num = connector_uc_num(c);
+	unsigned int h, s;
+	s = h = connector_uc_hash(c) & (size-1);
+
+	while (0 != t[h].num)
 	{
-		/* The match_cache desc field is initialized to NULL, and this is
-		 * enough because the connector desc field cannot be NULL, as it
-		 * actually fetched a non-empty match list. */
-		PRAGMA_MAYBE_UNINITIALIZED
-		return c_con->match;
-		PRAGMA_END
+		if (t[h].uc_num == uc_num) return &t[h];
+		h = (h + 1) & (size-1);
+		if (h == s) break;
 	}
 
-	/* No cache match. Check if the connectors match and cache the result.
-	 * We know that the uc parts of the connectors are the same, because
-	 * we fetch the matching lists according to the uc part or the
-	 * connectors to be matched. So the uc parts are not checked here. */
-	c_con->match = lc_easy_match(connector_desc(a), connector_desc(b));
-	c_con->desc = connector_desc(a);
+	return &match_entry_not_found;
+}
+
+/**
+ * Find the end of the candidates of a match-table entry (the elements
+ * from \p begin to \p end) whose connector can reach the word \p w:
+ * Their nearest_word is at least \p w (for the left table, in which it
+ * is decreasing), or at most \p w (for the right table, in which it is
+ * increasing). Since these candidates are a prefix of the entry, they
+ * are found by a binary search.
+ */
+static inline size_t match_range_end(const uint8_t *nearest_word,
+                                     size_t begin, size_t end, int dir, int w)
+{
+	while (begin < end)
+	{
+		size_t mid = begin + (end - begin) / 2;
+		bool reachable = (0 == dir) ?
+			(nearest_word[mid] >= w) : (nearest_word[mid] <= w);
+
+		if (reachable)
+			begin = mid + 1;
+		else
+			end = mid;
+	}
 
-	return c_con->match;
+	return begin;
 }
 
 typedef struct
@@ -538,7 +586,7 @@ static size_t terminate_match_list(fast_matcher_t *ctxt, uint16_t id,
  * actually matches lc or rc or both. The lw and rw are the words from
  * which lc and rc came respectively.
  *
- * The list is returned in an array of Match_nodes.  This list
+ * The list is returned in the match-list array.  This list
  * contains no duplicates, because when processing the ml list, only
  * elements whose match_left is true are included, and such elements are
  * not included again when processing the mr list.
@@ -562,12 +610,16 @@ form_match_list(fast_matcher_t *ctxt, int w,
                 Connector *rc, int rw,
                 match_list_cache *mlcl, match_list_cache *mlcr)
 {
-	Match_node *mx, *mr_end;
 	size_t front = get_match_list_position(ctxt);
-	Match_node *ml = NULL, *mr = NULL; /* Initialize in case of NULL lc or rc. */
+	/* Initialize in case of NULL lc or rc. */
+	const match_table_entry *ml = &match_entry_not_found;
+	const match_table_entry *mr = &match_entry_not_found;
+	size_t ml_end, mr_end = 0;
 	match_list_cache *cmx;
-	match_cache mc;
 	gword_cache gc = { .same_alternative = false };
+	Disjunct **m_d = ctxt->m_d;
+	const uint8_t *nearest_word = ctxt->m_nearest_word;
+	const uint8_t *farthest_word = ctxt->m_farthest_word;
 
 	if (mlcl == NULL)
 	{
@@ -578,9 +630,9 @@ form_match_list(fast_matcher_t *ctxt, int w,
 		 * callers and is left here for documentation. */
 		if ((lc != NULL) /* && (w <= lc->farthest_word) */)
 		{
-			ml = *get_match_table_entry(ctxt->l_table_size[w], ctxt->l_table[w], lc, 0);
+			ml = get_match_table_entry(ctxt->l_table_size[w], ctxt->l_table[w], lc);
 		}
-		if ((lc != NULL) && (ml == NULL)) /* lc optimization */
+		if ((lc != NULL) && (ml->num == 0)) /* lc optimization */
 			return terminate_match_list(ctxt, -1, front, w, lc, lw, rc, rw, mlcl, mlcr);
 	}
 
@@ -588,9 +640,9 @@ form_match_list(fast_matcher_t *ctxt, int w,
 	{
 		if ((rc != NULL) && (w >= rc->farthest_word))
 		{
-			mr = *get_match_table_entry(ctxt->r_table_size[w], ctxt->r_table[w], rc, 1);
+			mr = get_match_table_entry(ctxt->r_table_size[w], ctxt->r_table[w], rc);
 		}
-		if ((ml == NULL) && (mlcl == NULL) && (mr == NULL))
+		if ((ml->num == 0) && (mlcl == NULL) && (mr->num == 0))
 			return terminate_match_list(ctxt, -2, front, w, lc, lw, rc, rw, mlcl, mlcr);
 	}
 
@@ -606,12 +658,14 @@ form_match_list(fast_matcher_t *ctxt, int w,
 
 	if (mlcr == NULL)
 	{
-		for (mx = mr; mx != NULL; mx = mx->next)
+		mr_end = match_range_end(nearest_word, mr->start, mr->start + mr->num,
+		                         1, rw);
+		for (size_t i = mr->start; i < mr_end; i++)
 		{
-			if (mx->d->right->nearest_word > rw) break;
-			mx->d->match_left = false;
+			if (i + MATCH_PREFETCH_DISTANCE < mr_end)
+				PREFETCH(m_d[i + MATCH_PREFETCH_DISTANCE]);
+			m_d[i]->match_left = false;
 		}
-		mr_end = mx;
 	}
 	else
 	{
@@ -619,26 +673,38 @@ form_match_list(fast_matcher_t *ctxt, int w,
 		{
 			cmx->d->match_left = false;
 		}
-		mr_end = NULL; /* Prevent a gcc "may be uninitialized" warning */
 	}
 
 	/* Construct the list of things that could match the left. */
 	if (mlcl == NULL)
 	{
-		mc.desc = NULL;
 		gc.gword = NULL;
 
-		for (mx = ml; mx != NULL; mx = mx->next)
+		ml_end = match_range_end(nearest_word, ml->start, ml->start + ml->num,
+		                         0, lw);
+
+		uint64_t lc_match = 0;
+		for (size_t i = ml->start; i < ml_end; i++)
 		{
-			if (mx->d->left->nearest_word < lw) break;
-			if (lw < mx->d->left->farthest_word) continue;
+			size_t bit = (i - ml->start) % 64;
+			if (0 == bit)
+			{
+				lc_match = ctxt->lc_filter(&ctxt->m_lc_letters[i],
+				                           &ctxt->m_lc_mask[i],
+				                           MIN(64, ml_end - i),
+				                           lc->desc->lc_letters, lc->desc->lc_mask);
+			}
+			if (i + MATCH_PREFETCH_DISTANCE < ml_end)
+				PREFETCH(m_d[i + MATCH_PREFETCH_DISTANCE]);
+			if (lw < farthest_word[i]) continue;
 
-			mx->d->match_left = do_match_with_cache(mx->d->left, lc, &mc) &&
-			                    alt_connection_possible(mx->d->left, lc, &gc);
-			if (!mx->d->match_left) continue;
-			mx->d->match_right = false;
+			Disjunct *d = m_d[i];
+			d->match_left = ((lc_match >> bit) & 1) &&
+			                alt_connection_possible(d->left, lc, &gc);
+			if (!d->match_left) continue;
+			d->match_right = false;
 
-			push_match_list_element(ctxt, lid, mx->d);
+			push_match_list_element(ctxt, lid, d);
 		}
 
 		if ((lc != NULL) && is_no_match_list(ctxt, front)) /* lc optimization */
@@ -661,18 +727,28 @@ form_match_list(fast_matcher_t *ctxt, int w,
 	 * list. */
 	if (mlcr == NULL)
 	{
-		mc.desc = NULL;
 		gc.gword = NULL;
-		for (mx = mr; mx != mr_end; mx = mx->next)
+
+		uint64_t lc_match = 0;
+		for (size_t i = mr->start; i < mr_end; i++)
 		{
-			if (rw > mx->d->right->farthest_word) continue;
+			size_t bit = (i - mr->start) % 64;
+			if (0 == bit)
+			{
+				lc_match = ctxt->lc_filter(&ctxt->m_lc_letters[i],
+				                           &ctxt->m_lc_mask[i],
+				                           MIN(64, mr_end - i),
+				                           rc->desc->lc_letters, rc->desc->lc_mask);
+			}
+			if (rw > farthest_word[i]) continue;
 
-			if ((lc != NULL) && !mx->d->match_left) continue; /* lc optimization */
-			mx->d->match_right = do_match_with_cache(mx->d->right, rc, &mc) &&
-			                     alt_connection_possible(mx->d->right, rc, &gc);
-			if (!mx->d->match_right || mx->d->match_left) continue;
+			Disjunct *d = m_d[i];
+			if ((lc != NULL) && !d->match_left) continue; /* lc optimization */
+			d->match_right = ((lc_match >> bit) & 1) &&
+			                 alt_connection_possible(d->right, rc, &gc);
+			if (!d->match_right || d->match_left) continue;
 
-			push_match_list_element(ctxt, lid, mx->d);
+			push_match_list_element(ctxt, lid, d);
 		}
 	}
 	else
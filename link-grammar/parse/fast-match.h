@@ -15,6 +15,7 @@
 
 #include <stddef.h>                     // for size_t
 #include "api-types.h"
+#include "connectors.h"                 // lc_enc_t
 #include "disjunct-utils.h"             // Disjunct_struct
 #include "error.h"                      // lgdebug
 #include "link-includes.h"              // for Sentence
@@ -26,12 +27,21 @@ typedef struct
 	Count_bin count;             /* the counts for that linkage */
 } match_list_cache;
 
-typedef struct Match_node_struct Match_node;
-struct Match_node_struct
+/**
+ * A match-table entry. It refers to the disjuncts whose shallow
+ * connector (on the table side) has the given uppercase part, which
+ * are a range of the match-table element arrays (in match-list order).
+ */
+typedef struct
 {
-	Match_node * next;
-	Disjunct * d;
-};
+	connector_uc_hash_t uc_num;
+	unsigned int start;          /* Index of its first element */
+	unsigned int num;            /* Number of its elements (0: unused) */
+} match_table_entry;
+
+/* Filter up to 64 match-table elements by their lc part. */
+typedef uint64_t (*lc_filter_func)(const lc_enc_t *, const lc_enc_t *,
+                                   size_t, lc_enc_t, lc_enc_t);
 
 typedef struct fast_matcher_s fast_matcher_t;
 struct fast_matcher_s
@@ -41,8 +51,20 @@ struct fast_matcher_s
 	unsigned int *r_table_size;
 
 	/* the beginnings of the hash tables */
-	Match_node *** l_table;
-	Match_node *** r_table;
+	match_table_entry ** l_table;
+	match_table_entry ** r_table;
+
+	/* The match-table elements, as a structure of arrays, so that the
+	 * candidates of a match list can be filtered with vector
+	 * instructions. The connector fields are of the shallow connector
+	 * on the table side. */
+	Disjunct ** m_d;
+	lc_enc_t * m_lc_letters;
+	lc_enc_t * m_lc_mask;
+	uint8_t * m_nearest_word;
+	uint8_t * m_farthest_word;
+	size_t m_num;                /* Number of elements */
+	lc_filter_func lc_filter;
 
 	/* I'll pedantically maintain my own array of these cells */
 	Disjunct ** match_list;      /* match-list stack */
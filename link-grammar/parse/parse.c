@@ -172,6 +172,23 @@ static void process_linkages(Sentence sent, extractor_t* pex,
 	bool pick_randomly = sent->overflowed ||
 	    (sent->num_linkages_found > (int) opts->linkage_limit);
 
+	/* But fill a part of the linkage array with the lowest-cost
+	 * linkages, so the best ones are never missed, unless variety is
+	 * wanted (generation, or linkage shuffling). The rest are still
+	 * picked randomly, because the lowest-cost linkages are very similar
+	 * to each other, and in long sentences they may all have P.P.
+	 * violations. The test "random-linkages" restores the random
+	 * selection for comparison. */
+#define BEST_LINKAGES_DIVISOR 4 /* Pick 1/4 of the linkages by cost */
+	size_t num_best = 0;
+	if (pick_randomly && !IS_GENERATION(sent->dict) &&
+	    !sent->dict->shuffle_linkages && !test_enabled("random-linkages"))
+	{
+		num_best = (sent->num_linkages_alloced + BEST_LINKAGES_DIVISOR - 1) /
+		           BEST_LINKAGES_DIVISOR;
+	}
+	unsigned int rank = 0;
+
 	sent->num_valid_linkages = 0;
 	size_t N_invalid_morphism = 0;
 
@@ -212,17 +229,29 @@ static void process_linkages(Sentence sent, extractor_t* pex,
 		Linkage lkg = &sent->lnkages[in];
 		Linkage_info * lifo = &lkg->lifo;
 
-		/* Negative values tell extract-links to pick randomly; for
-		 * reproducible-rand, the actual value is the rand seed. */
-		lifo->index = pick_randomly ? -(itry+1) : itry;
-
 		if (need_init)
 		{
 			partial_init_linkage(sent, lkg, sent->length);
 			need_init = false;
 		}
-		extract_links(pex, lkg);
-		compute_link_names(lkg, sent->string_set);
+
+		bool extracted = false;
+		bool alt_ok = true;
+		if (in < num_best)
+		{
+			extracted = extract_best_links(pex, lkg, rank++);
+			if (!extracted) num_best = 0; /* No more linkages */
+		}
+		if (!extracted)
+		{
+			/* Negative values tell extract-links to pick randomly; for
+			 * reproducible-rand, the actual value is the rand seed.
+			 * The tries of the lowest-cost linkages are not counted, so
+			 * the same random linkages are picked regardless of them. */
+			int irand = itry - (int)rank;
+			lifo->index = pick_randomly ? -(irand+1) : irand;
+			alt_ok = extract_links(pex, lkg);
+		}
 
 		if (verbosity_level(+D_PL))
 		{
@@ -230,9 +259,9 @@ static void process_linkages(Sentence sent, extractor_t* pex,
 			print_chosen_disjuncts_words(lkg, /*prt_opt*/true);
 		}
 
-		if (need_sane_morphism)
+		if (need_sane_morphism || !alt_ok)
 		{
-			if (sane_linkage_morphism(sent, lkg, opts))
+			if (alt_ok && sane_linkage_morphism(sent, lkg, opts))
 			{
 				remove_empty_words(lkg);
 
@@ -257,6 +286,14 @@ static void process_linkages(Sentence sent, extractor_t* pex,
 		if (IS_GENERATION(sent->dict))
 			compute_generated_words(sent, lkg);
 
+		/* The link array is allocated for the worst case. Keep only
+		 * what is used, since many linkages may be kept. */
+		if (lkg->lasz > lkg->num_links)
+		{
+			lkg->lasz = MAX(lkg->num_links, 1);
+			lkg->link_array = realloc(lkg->link_array, lkg->lasz * sizeof(Link));
+		}
+
 		need_init = true;
 		in++;
 		if (in >= sent->num_linkages_alloced) break;
@@ -279,6 +316,59 @@ static void process_linkages(Sentence sent, extractor_t* pex,
 	}
 }
 
+/**
+ * Extract into \p lkg the next valid linkage of a parse that has been
+ * done with deferred linkages (see linkage_iter_create()), in cost order.
+ * Like process_linkages() and post_process_lkgs() do for the linkage
+ * array, linkages with an invalid morphology are skipped, and the rest
+ * are post-processed and scored. But linkages with P.P. violations are
+ * skipped too.
+ * \p rank is the rank of the next linkage to try, and it gets updated.
+ * Return \c false if there are no more valid linkages.
+ */
+bool extract_next_linkage(Sentence sent, Parse_Options opts, Linkage lkg,
+                          unsigned int *rank)
+{
+	extractor_t *pex = sent->extractor;
+
+	if (NULL == pex) return false;
+
+	while (*rank < MAX_TRIES)
+	{
+		memset(lkg, 0, sizeof(struct Linkage_s));
+		partial_init_linkage(sent, lkg, sent->length);
+
+		if (!extract_best_links(pex, lkg, (*rank)++))
+		{
+			free_linkage(lkg);
+			return false;
+		}
+
+		if (!sane_linkage_morphism(sent, lkg, opts))
+		{
+			free_linkage(lkg);
+			continue;
+		}
+		remove_empty_words(lkg);
+
+		if (!post_process_one_lkg(sent, opts, lkg))
+		{
+			free_linkage(lkg);
+			continue;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+void free_deferred_linkages(Sentence sent)
+{
+	free_extractor(sent->extractor);
+	sent->extractor = NULL;
+}
+
 /**
  * Linkage-equivalent predicate. Return zero if they are equivalent,
  * else return +1 or -1. This does provide a stable sort; inequivalent
@@ -290,8 +380,10 @@ static void process_linkages(Sentence sent, extractor_t* pex,
  */
 static int linkage_equiv_p(Linkage lpv, Linkage lnx)
 {
-	// Compare link endpoints
-	for (uint32_t li=0; li<lpv->num_links; li++)
+	// Compare link endpoints. The link arrays are trimmed to the
+	// number of links, so don't look beyond the shorter one.
+	uint32_t num_links = MIN(lpv->num_links, lnx->num_links);
+	for (uint32_t li=0; li<num_links; li++)
 	{
 		Link * plk = &lpv->link_array[li];
 		Link * nlk = &lnx->link_array[li];
@@ -304,6 +396,8 @@ static int linkage_equiv_p(Linkage lpv, Linkage lnx)
 		int rwd = plk->rw - nlk->rw;
 		if (rwd) return rwd;
 	}
+	if (lpv->num_links != lnx->num_links)
+		return (int)lpv->num_links - (int)lnx->num_links;
 
 	// Compare link names. This is slightly more expensive than the
 	// check above, so we defer this check.
@@ -312,11 +406,18 @@ static int linkage_equiv_p(Linkage lpv, Linkage lnx)
 		Link * plk = &lpv->link_array[li];
 		Link * nlk = &lnx->link_array[li];
 
+		// The link name depends only on the connector types, so it
+		// needs to be computed only if they are different.
+		if ((plk->lc->desc == nlk->lc->desc) &&
+		    (plk->rc->desc == nlk->rc->desc)) continue;
+
 		// Note (see intersect_strings()):
 		// link_name is not always in the same string set, so inequality
 		// test cannot be done here.
-		if (plk->link_name == nlk->link_name) continue;
-		int lncmp = strcmp(plk->link_name, nlk->link_name);
+		const char *pln = linkage_link_name(lpv, li);
+		const char *nln = linkage_link_name(lnx, li);
+		if (pln == nln) continue;
+		int lncmp = strcmp(pln, nln);
 		if (lncmp) return lncmp;
 	}
 
@@ -518,6 +619,7 @@ static void deduplicate_linkages(Sentence sent, int linkage_limit)
 static void sort_linkages(Sentence sent, Parse_Options opts)
 {
 	if (0 == sent->num_linkages_found) return;
+	if (0 == sent->num_linkages_alloced) return; /* Deferred linkages */
 
 	/* It they're randomized, don't bother sorting */
 	if (0 != sent->rand_state && sent->dict->shuffle_linkages) return;
@@ -594,6 +696,8 @@ void classic_parse(Sentence sent, Parse_Options opts)
 	ncu[0] = alloca(sent->length * sizeof(*ncu[0]));
 	ncu[1] = alloca(sent->length * sizeof(*ncu[1]));
 
+	free_deferred_linkages(sent);
+
 	/* Null-count optimization not implemented for islands_ok==true. */
 	if (opts->islands_ok)
 		optimize_pruning = false;
@@ -684,9 +788,24 @@ void classic_parse(Sentence sent, Parse_Options opts)
 
 		if (NULL != ts_pruning)
 		{
-			free_tracon_sharing(ts_parsing);
-			ts_parsing = pack_sentence_for_parsing(sent);
-			print_time(opts, "Encoded for parsing");
+			/* If pruning for this null count has left the same disjuncts
+			 * as before, the parsing tracons, the fast matcher and the
+			 * count context can be reused. The latter holds counts per
+			 * null count, so the counts of the previous parses remain
+			 * valid. */
+			bool reuse = !IS_GENERATION(sent->dict) &&
+				reuse_parsing_disjuncts(sent, ts_parsing);
+
+			if (!reuse)
+			{
+				free_tracon_sharing(ts_parsing);
+				ts_parsing = pack_sentence_for_parsing(sent);
+				print_time(opts, "Encoded for parsing");
+			}
+			else
+			{
+				print_time(opts, "Reused parsing encoding");
+			}
 
 			if (!more_pruning_possible)
 			{
@@ -698,18 +817,24 @@ void classic_parse(Sentence sent, Parse_Options opts)
 					free_saved_memblock(saved_memblock);
 			}
 
-			gword_record_in_connector(sent);
+			if (!reuse)
+			{
+				gword_record_in_connector(sent);
+
+				free_fast_matcher(sent, mchxt);
+				mchxt = alloc_fast_matcher(sent, ncu);
+				print_time(opts, "Initialized fast matcher");
 
-			free_fast_matcher(sent, mchxt);
-			mchxt = alloc_fast_matcher(sent, ncu);
-			print_time(opts, "Initialized fast matcher");
-			if (resources_exhausted(opts->resources)) goto parse_end_cleanup;
+				free_count_context(ctxt, sent);
+				ctxt = NULL;
+				if (resources_exhausted(opts->resources)) goto parse_end_cleanup;
+			}
 		}
 
 		free_linkages(sent);
 
-		free_count_context(ctxt, sent);
-		ctxt = alloc_count_context(sent, ts_parsing);
+		if (NULL == ctxt)
+			ctxt = alloc_count_context(sent, ts_parsing);
 
 		sent->num_linkages_found = do_parse(sent, mchxt, ctxt, opts);
 
@@ -728,7 +853,19 @@ void classic_parse(Sentence sent, Parse_Options opts)
 
 		if (sent->num_linkages_found > 0)
 		{
-			extractor_t * pex = extractor_new(sent);
+			extractor_t * pex = extractor_new(sent, ctxt);
+
+			if (sent->defer_linkages && !IS_GENERATION(sent->dict))
+			{
+				/* Keep the parse-set; the linkages are extracted one by
+				 * one by extract_next_linkage(). */
+				sent->overflowed = build_parse_set(pex, sent, mchxt, ctxt,
+				                                   sent->null_count, opts);
+				print_time(opts, "Built parse set");
+				sent->extractor = pex;
+				break;
+			}
+
 			setup_linkages(sent, pex, mchxt, ctxt, opts);
 			process_linkages(sent, pex, opts);
 			if (IS_GENERATION(sent->dict))
@@ -741,6 +878,13 @@ void classic_parse(Sentence sent, Parse_Options opts)
 			post_process_lkgs(sent, opts);
 			if (resources_exhausted(opts->resources))
 			{
+				/* In anytime mode, keep the linkages that have been
+				 * found valid before the timeout. */
+				if (opts->anytime && (sent->num_valid_linkages > 0))
+				{
+					sent->partial = true;
+					break;
+				}
 				sent->num_linkages_found = 0;
 				sent->num_valid_linkages = 0;
 				sent->num_linkages_post_processed = 0;
@@ -1,4 +1,6 @@
 
 
 void classic_parse(Sentence, Parse_Options);
+bool extract_next_linkage(Sentence, Parse_Options, Linkage, unsigned int *);
+void free_deferred_linkages(Sentence);
 int VDAL_compare_linkages(Linkage, Linkage);
@@ -12,6 +12,7 @@
 
 #include "api-structures.h"
 #include "prepare/build-disjuncts.h"
+#include "prepare/disjunct-cache.h"     // disjunct_cache_dialect
 #include "connectors.h"
 #include "dict-common/dict-common.h"    // Dictionary_s
 #include "disjunct-utils.h"
@@ -106,13 +107,17 @@ static void build_sentence_disjuncts(Sentence sent, float cost_cutoff,
 	size_t num_con_alloced = pool_num_elements_issued(sent->Connector_pool);
 #endif
 
+	unsigned int dialect = 0;
+	if (NULL != sent->dict->disjunct_cache)
+		dialect = disjunct_cache_dialect(sent->dict->disjunct_cache, opts);
+
 	for (size_t w = 0; w < sent->length; w++)
 	{
 		Disjunct * d = NULL;
 		for (X_node * x = sent->word[w].x; x != NULL; x = x->next)
 		{
-			Disjunct *dx = build_disjuncts_for_exp(sent, x->exp, x->string,
-				&x->word->gword_set_head, cost_cutoff, opts);
+			Disjunct *dx =
+				build_disjuncts_for_x_node(sent, x, cost_cutoff, dialect, opts);
 			d = catenate_disjuncts(dx, d);
 		}
 		sent->word[w].d = d;
@@ -127,8 +132,8 @@ static void build_sentence_disjuncts(Sentence sent, float cost_cutoff,
 #endif
 
 	/* Delete the memory pools created in build_disjuncts_for_exp(). */
-	pool_delete(sent->Clause_pool);
-	pool_delete(sent->Tconnector_pool);
+	pool_recycle(sent->Clause_pool);
+	pool_recycle(sent->Tconnector_pool);
 	sent->Clause_pool = NULL;
 	sent->Tconnector_pool = NULL;
 }
@@ -167,8 +172,8 @@ static void create_wildcard_word_disjunct_list(Sentence sent,
 
 	Word *word0 = &wc_word_list->word[0];
 	unsigned int Ndeleted;
-	Ndeleted = eliminate_duplicate_disjuncts(word0->d, false);
-	Ndeleted += eliminate_duplicate_disjuncts(word0->d, true);
+	Ndeleted = eliminate_duplicate_disjuncts(wc_word_list, word0->d, false);
+	Ndeleted += eliminate_duplicate_disjuncts(wc_word_list, word0->d, true);
 	print_time(opts, "Eliminated duplicate disjuncts (%u deleted)", Ndeleted);
 
 	wc_word_list->min_len_encoding = 2; /* Don't share/encode. */
@@ -213,13 +218,14 @@ void prepare_to_parse(Sentence sent, Parse_Options opts)
 	unsigned int Ndeleted = 0;
 	for (i=0; i<sent->length; i++)
 	{
-		Ndeleted += eliminate_duplicate_disjuncts(sent->word[i].d, false);
+		Ndeleted += eliminate_duplicate_disjuncts(sent, sent->word[i].d, false);
 		if (IS_GENERATION(sent->dict))
 		{
 			if ((sent->word[i].d != NULL) && (sent->word[i].d->is_category != 0))
 			{
 				/* Also with different word_string. */
-				Ndeleted += eliminate_duplicate_disjuncts(sent->word[i].d, true);
+				Ndeleted +=
+					eliminate_duplicate_disjuncts(sent, sent->word[i].d, true);
 
 				/* XXX This ordinal numbering is just plain wrong.
 				 * Most of the disjuncts have already been pruned away,
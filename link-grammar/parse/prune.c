@@ -239,7 +239,7 @@ GNUC_UNUSED static void print_power_table(Sentence sent, power_table *pt)
  */
 static void power_table_delete(power_table *pt)
 {
-	pool_delete(pt->memory_pool);
+	pool_recycle(pt->memory_pool);
 	free(pt->table_size[0]);
 	free(pt->table[0][0]);
 	free(pt->table[0]);
@@ -1305,7 +1305,7 @@ static multiset_table *cms_table_new(Sentence sent)
 
 static void cms_table_delete(multiset_table *mt)
 {
-	if (mt->mp != NULL) pool_delete(mt->mp);
+	if (mt->mp != NULL) pool_recycle(mt->mp);
 	free(mt);
 }
 
@@ -0,0 +1,613 @@
+/*************************************************************************/
+/* Copyright (c) 2026 The Link Grammar project                           */
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+/*
+ * A lock-free alternative to the chained count table of count.c.
+ * Enabled by "configure --enable-lockfree-count-table".
+ *
+ * It is an open-addressing hash table whose buckets are cache lines.
+ * Each bucket slot consists of a key word and a count. The key word
+ * packs l_id, r_id, null_count and the slot state:
+ *
+ *    (l_id+1):27 | r_id:27 | null_count:8 | state:2
+ *
+ * A slot gets its key by a CAS of an empty key word, in the RESERVED
+ * state. Its count is written by the thread that reserved it, which then
+ * changes its state to COUNTED (by a release CAS). Threads that need a
+ * reserved count wait until it gets COUNTED (this is the only blocking
+ * operation). Counts are never changed after that, so pointers to them
+ * remain valid until the table is deleted.
+ *
+ * When the table load gets high, a new generation of twice the size is
+ * allocated. The slots of the old generation are then moved to it
+ * incrementally, a chunk of buckets on each insertion. Moved slots get
+ * the MOVED state (empty slots get the MOVED_EMPTY key), so lookups that
+ * encounter them continue in the next generation. Only one migration is
+ * done at a time. Old generations are kept until the table is deleted,
+ * as concurrent lookups may still use them. The largest generation
+ * doesn't grow; when it gets full, new keys are not inserted anymore
+ * (see tracon_table_is_full()).
+ */
+
+#if USE_LOCKFREE_COUNT_TABLE
+#include <stdatomic.h>
+#include <stdint.h>
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+#include <threads.h>
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+#include "error.h"
+#include "tracon-table.h"
+#include "utilities.h"
+
+#define D_TTBL 8 /* Debug level for this file */
+
+/* Slot states. */
+#define SLOT_EMPTY 0               /* Also the key word of an empty slot */
+#define SLOT_RESERVED 1            /* Its count is being computed */
+#define SLOT_COUNTED 2
+#define SLOT_MOVED 3               /* Moved to the next generation */
+#define SLOT_INSERTED 4            /* Only as a find_slot() result */
+#define SLOT_FULL 5                /* Only as a find_slot() result */
+#define STATE_MASK 3
+
+/* The key word of an empty slot that may not be used anymore. */
+#define MOVED_EMPTY ((uint64_t)SLOT_MOVED)
+
+#define CACHE_LINE_SIZE 64
+#define BUCKET_SLOTS 5
+#define INV_LOAD_FACTOR 2          /* One divided by the max. load factor */
+#define MIGRATE_CHUNK 16           /* Buckets to migrate on each insertion */
+#define MAX_LOG2_NUM_BUCKETS ((sizeof(size_t)==4) ? 22 : 31)
+#define WAIT_SPINS 128             /* Before sleeping on a reserved count */
+#define NUM_WAIT_STRIPES 64        /* Selected by the key hash */
+
+typedef struct
+{
+	_Alignas(CACHE_LINE_SIZE) _Atomic uint64_t key[BUCKET_SLOTS];
+	Count_bin count[BUCKET_SLOTS];
+} Tracon_bucket;
+
+typedef struct Tracon_gen_s Tracon_gen;
+struct Tracon_gen_s
+{
+	Tracon_bucket *bucket;
+	size_t mask;                   /* Number of buckets - 1 */
+	size_t max_used;               /* Grow when that many slots are used */
+	atomic_size_t used;            /* Number of used slots */
+	atomic_flag growing;           /* Set when the next generation is made */
+	_Atomic(Tracon_gen *) next;    /* The next (bigger) generation */
+	atomic_size_t migrate_next;    /* Next bucket to migrate */
+	atomic_size_t migrate_done;    /* Number of migrated buckets */
+};
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+/* Threads that wait for a reserved count sleep on the condition
+ * variable of its key stripe. */
+typedef struct
+{
+	mtx_t mutex;
+	cnd_t count_ready;
+	atomic_uint waiters;
+} Wait_stripe;
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+struct Tracon_table_s
+{
+	_Atomic(Tracon_gen *) current; /* Lookups start at this generation */
+	Tracon_gen *first;             /* The generations are chained by "next" */
+	bool concurrent;               /* Used now by more than one thread */
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	Wait_stripe wait[NUM_WAIT_STRIPES];
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+};
+
+static uint64_t make_key(int l_id, int r_id, unsigned int null_count)
+{
+	return ((uint64_t)(l_id + 1) << 37) | ((uint64_t)r_id << 10) |
+	       ((uint64_t)null_count << 2);
+}
+
+static size_t key_hash(uint64_t key)
+{
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	return (size_t)key;
+}
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+static Wait_stripe *get_wait_stripe(Tracon_table *t, uint64_t key)
+{
+	return &t->wait[key_hash(key) % NUM_WAIT_STRIPES];
+}
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+/**
+ * Wait until the slot \p sp of \p key gets out of the RESERVED state.
+ * @return Its new key word.
+ */
+static uint64_t wait_for_count(Tracon_table *t, uint64_t key,
+                               _Atomic uint64_t *sp)
+{
+	uint64_t k;
+
+	for (unsigned int i = 0; i < WAIT_SPINS; i++)
+	{
+		k = atomic_load_explicit(sp, memory_order_acquire);
+		if ((k & STATE_MASK) != SLOT_RESERVED) return k;
+	}
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	Wait_stripe *w = get_wait_stripe(t, key);
+
+	/* The waiters counter is incremented before checking the slot, and
+	 * tracon_table_store() checks it after changing the slot (both
+	 * sequentially consistent), so the wakeup cannot be missed. */
+	atomic_fetch_add(&w->waiters, 1);
+	mtx_lock(&w->mutex);
+	while (((k = atomic_load(sp)) & STATE_MASK) == SLOT_RESERVED)
+		cnd_wait(&w->count_ready, &w->mutex);
+	mtx_unlock(&w->mutex);
+	atomic_fetch_sub(&w->waiters, 1);
+#else
+	assert(0, "Waiting for a reserved count without threads");
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+	return k;
+}
+
+static Tracon_gen *gen_new(size_t num_buckets)
+{
+	Tracon_gen *g = malloc(sizeof(Tracon_gen));
+
+	g->bucket = aligned_alloc(CACHE_LINE_SIZE,
+	                          num_buckets * sizeof(Tracon_bucket));
+	memset(g->bucket, 0, num_buckets * sizeof(Tracon_bucket));
+	g->mask = num_buckets - 1;
+	g->max_used = num_buckets * BUCKET_SLOTS / INV_LOAD_FACTOR;
+	atomic_init(&g->used, 0);
+	atomic_flag_clear(&g->growing);
+	atomic_init(&g->next, NULL);
+	atomic_init(&g->migrate_next, 0);
+	atomic_init(&g->migrate_done, 0);
+
+	lgdebug(+D_TTBL, "Tracon table generation: %zu buckets\n", num_buckets);
+	return g;
+}
+
+/**
+ * Create a table for (an estimated) \p num_entries entries.
+ */
+Tracon_table *tracon_table_new(size_t num_entries)
+{
+	Tracon_table *t = malloc(sizeof(Tracon_table));
+
+	size_t num_buckets =
+		next_power_of_two_up(MAX(num_entries * INV_LOAD_FACTOR / BUCKET_SLOTS, 1));
+	if (num_buckets > (1ULL << MAX_LOG2_NUM_BUCKETS))
+		num_buckets = 1ULL << MAX_LOG2_NUM_BUCKETS;
+
+	t->first = gen_new(num_buckets);
+	atomic_init(&t->current, t->first);
+	t->concurrent = false;
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	for (unsigned int i = 0; i < NUM_WAIT_STRIPES; i++)
+	{
+		mtx_init(&t->wait[i].mutex, mtx_plain);
+		cnd_init(&t->wait[i].count_ready);
+		atomic_init(&t->wait[i].waiters, 0);
+	}
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+	return t;
+}
+
+void tracon_table_delete(Tracon_table *t)
+{
+	if (NULL == t) return;
+
+	Tracon_gen *next;
+	for (Tracon_gen *g = t->first; g != NULL; g = next)
+	{
+		next = atomic_load_explicit(&g->next, memory_order_relaxed);
+		aligned_free(g->bucket);
+		free(g);
+	}
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	for (unsigned int i = 0; i < NUM_WAIT_STRIPES; i++)
+	{
+		mtx_destroy(&t->wait[i].mutex);
+		cnd_destroy(&t->wait[i].count_ready);
+	}
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+	free(t);
+}
+
+static bool gen_is_largest(Tracon_gen *g)
+{
+	return g->mask + 1 >= (1ULL << MAX_LOG2_NUM_BUCKETS);
+}
+
+/**
+ * Return true if no more keys can be inserted into \p g. This is only
+ * for the largest generation, which cannot grow. Its load is kept at
+ * the max. load factor, so lookups still end at an empty slot.
+ */
+static bool gen_is_full(Tracon_gen *g)
+{
+	return gen_is_largest(g) &&
+	       (atomic_load_explicit(&g->used, memory_order_relaxed) >= g->max_used);
+}
+
+/**
+ * Start a new generation if \p g is the current one and is too loaded.
+ */
+static void gen_grow(Tracon_table *t, Tracon_gen *g)
+{
+	if (atomic_load_explicit(&g->used, memory_order_relaxed) < g->max_used)
+		return;
+	if (atomic_load_explicit(&t->current, memory_order_acquire) != g) return;
+	if (gen_is_largest(g)) return;
+	if (atomic_flag_test_and_set(&g->growing)) return;
+
+	atomic_store_explicit(&g->next, gen_new(2 * (g->mask + 1)),
+	                      memory_order_release);
+}
+
+static void slot_inserted(Tracon_table *t, Tracon_gen *g)
+{
+	if (t->concurrent)
+	{
+		atomic_fetch_add_explicit(&g->used, 1, memory_order_relaxed);
+	}
+	else
+	{
+		atomic_store_explicit(&g->used,
+			atomic_load_explicit(&g->used, memory_order_relaxed) + 1,
+			memory_order_relaxed);
+	}
+	gen_grow(t, g);
+}
+
+/**
+ * Insert \p key, which is being migrated, into the next generation
+ * \p ng, as reserved. Return its bucket and slot in \p bp and \p sp.
+ *
+ * The key cannot already be in \p ng: A slot never becomes empty
+ * again, and a key is always inserted at the first empty slot of its
+ * probe chain (if this slot has been made MOVED_EMPTY meanwhile, the
+ * key is inserted in the next generation instead). So a key is never
+ * after a MOVED_EMPTY slot in its probe chain, and find_slot() can
+ * safely continue in the next generation when it encounters one.
+ * Also, \p ng cannot be migrated now.
+ */
+static void insert_migrated(Tracon_table *t, Tracon_gen *ng, uint64_t key,
+                            Tracon_bucket **bp, unsigned int *sp)
+{
+	for (size_t i = key_hash(key) & ng->mask; ; i = (i + 1) & ng->mask)
+	{
+		Tracon_bucket *b = &ng->bucket[i];
+
+		for (unsigned int s = 0; s < BUCKET_SLOTS; s++)
+		{
+			uint64_t k = SLOT_EMPTY;
+			if (atomic_compare_exchange_strong_explicit(&b->key[s], &k,
+			       key | SLOT_RESERVED,
+			       memory_order_acq_rel, memory_order_acquire))
+			{
+				slot_inserted(t, ng);
+				*bp = b;
+				*sp = s;
+				return;
+			}
+		}
+	}
+}
+
+static void migrate_bucket(Tracon_table *t, Tracon_gen *g, Tracon_gen *ng,
+                           size_t i)
+{
+	Tracon_bucket *b = &g->bucket[i];
+
+	for (unsigned int s = 0; s < BUCKET_SLOTS; s++)
+	{
+		Tracon_bucket *nb = NULL;
+		unsigned int ns = 0;
+		uint64_t k = atomic_load_explicit(&b->key[s], memory_order_acquire);
+
+		for (;;)
+		{
+			if (SLOT_EMPTY == k)
+			{
+				if (atomic_compare_exchange_weak_explicit(&b->key[s], &k,
+				       MOVED_EMPTY, memory_order_acq_rel, memory_order_acquire))
+					break;
+				continue;
+			}
+
+			uint64_t key = k & ~(uint64_t)STATE_MASK;
+			unsigned int state = k & STATE_MASK;
+			if (SLOT_MOVED == state) break;
+
+			if (NULL == nb) insert_migrated(t, ng, key, &nb, &ns);
+
+			if (SLOT_RESERVED == state)
+			{
+				/* Its count will be stored in the next generation. However,
+				 * it may get its count here before we mark it as moved. */
+				if (atomic_compare_exchange_strong_explicit(&b->key[s], &k,
+				       key | SLOT_MOVED,
+				       memory_order_acq_rel, memory_order_acquire))
+					break;
+				continue;
+			}
+
+			/* SLOT_COUNTED. Only the migrating thread changes it. */
+			nb->count[ns] = b->count[s];
+			atomic_store_explicit(&nb->key[ns], key | SLOT_COUNTED,
+			                      memory_order_release);
+			atomic_store_explicit(&b->key[s], key | SLOT_MOVED,
+			                      memory_order_release);
+			break;
+		}
+	}
+}
+
+/**
+ * Migrate the next chunk of buckets of the current generation, if it
+ * has a next generation.
+ */
+static void migrate_chunk(Tracon_table *t)
+{
+	Tracon_gen *g = atomic_load_explicit(&t->current, memory_order_acquire);
+	Tracon_gen *ng = atomic_load_explicit(&g->next, memory_order_acquire);
+	if (NULL == ng) return;
+
+	size_t num_buckets = g->mask + 1;
+	size_t start = atomic_fetch_add_explicit(&g->migrate_next, MIGRATE_CHUNK,
+	                                         memory_order_relaxed);
+	if (start >= num_buckets) return;
+	size_t end = MIN(start + MIGRATE_CHUNK, num_buckets);
+
+	for (size_t i = start; i < end; i++)
+		migrate_bucket(t, g, ng, i);
+
+	size_t done = atomic_fetch_add_explicit(&g->migrate_done, end - start,
+	                                        memory_order_acq_rel);
+	if (done + (end - start) == num_buckets)
+	{
+		atomic_store_explicit(&t->current, ng, memory_order_release);
+		gen_grow(t, ng);
+	}
+}
+
+/**
+ * Find the slot of \p key, following moved slots to the next
+ * generations. If \p insert is true and the key is not found, insert it
+ * as reserved. A MOVED_EMPTY slot ends the search in a generation
+ * (see insert_migrated()).
+ * @param bp[out] The bucket of the slot.
+ * @param sp[out] The slot number in the bucket.
+ * @return The slot state, SLOT_INSERTED if it has just been inserted,
+ * SLOT_FULL if it could not be inserted because the table is full, or
+ * SLOT_EMPTY if it is not found (and \p insert is false).
+ */
+static unsigned int find_slot(Tracon_table *t, uint64_t key, bool insert,
+                              Tracon_bucket **bp, unsigned int *sp)
+{
+	Tracon_gen *g = atomic_load_explicit(&t->current, memory_order_acquire);
+
+next_generation:
+	for (size_t i = key_hash(key) & g->mask; ; i = (i + 1) & g->mask)
+	{
+		Tracon_bucket *b = &g->bucket[i];
+
+		for (unsigned int s = 0; s < BUCKET_SLOTS; s++)
+		{
+			uint64_t k = atomic_load_explicit(&b->key[s], memory_order_acquire);
+
+			while (SLOT_EMPTY == k)
+			{
+				if (!insert) return SLOT_EMPTY;
+				if (gen_is_full(g)) return SLOT_FULL;
+
+				if (!t->concurrent)
+				{
+					atomic_store_explicit(&b->key[s], key | SLOT_RESERVED,
+					                      memory_order_relaxed);
+				}
+				else if (!atomic_compare_exchange_weak_explicit(&b->key[s], &k,
+				            key | SLOT_RESERVED,
+				            memory_order_acq_rel, memory_order_acquire))
+				{
+					continue;
+				}
+
+				slot_inserted(t, g);
+				*bp = b;
+				*sp = s;
+				return SLOT_INSERTED;
+			}
+
+			if ((MOVED_EMPTY == k) ||
+			    (((k & ~(uint64_t)STATE_MASK) == key) &&
+			     ((k & STATE_MASK) == SLOT_MOVED)))
+			{
+				g = atomic_load_explicit(&g->next, memory_order_acquire);
+				goto next_generation;
+			}
+
+			if ((k & ~(uint64_t)STATE_MASK) != key) continue;
+
+			*bp = b;
+			*sp = s;
+			return k & STATE_MASK;
+		}
+	}
+}
+
+/**
+ * Return the count of the given key if it is known, NULL otherwise.
+ *
+ * @param slot[out] If non-NULL and the key is not found, insert it as
+ * reserved and return its slot handle here. The caller must then store
+ * its count by tracon_table_store(). If it is found reserved (by another
+ * thread), wait for its count. If NULL, a reserved key is considered as
+ * not found. If the table is full, the key is not inserted and the
+ * handle is 0; its count is then not stored.
+ */
+Count_bin *tracon_table_lookup(Tracon_table *t, int l_id, int r_id,
+                               unsigned int null_count, size_t *slot)
+{
+	uint64_t key = make_key(l_id, r_id, null_count);
+	bool reserve = (NULL != slot);
+	Tracon_bucket *b;
+	unsigned int s;
+
+	for (;;)
+	{
+		switch (find_slot(t, key, reserve, &b, &s))
+		{
+			case SLOT_EMPTY:
+				return NULL;
+			case SLOT_INSERTED:
+				*slot = (size_t)(uintptr_t)&b->key[s];
+				migrate_chunk(t);
+				return NULL;
+			case SLOT_FULL:
+				*slot = 0;
+				return NULL;
+			case SLOT_COUNTED:
+				return &b->count[s];
+		}
+
+		/* Reserved by another thread (or just moved). */
+		if (!reserve) return NULL;
+
+		uint64_t k = wait_for_count(t, key, &b->key[s]);
+		if ((k & STATE_MASK) == SLOT_COUNTED) return &b->count[s];
+		/* Moved - look for it again. */
+	}
+}
+
+/**
+ * Store the count \p c of the given key, which has been reserved by
+ * tracon_table_lookup() at \p slot (if it is 0, the table is full and
+ * \p c is just returned).
+ */
+Count_bin tracon_table_store(Tracon_table *t, int l_id, int r_id,
+                             unsigned int null_count, size_t slot,
+                             Count_bin c)
+{
+	uint64_t key = make_key(l_id, r_id, null_count);
+	_Atomic uint64_t *kp = (_Atomic uint64_t *)(uintptr_t)slot;
+
+	if (0 == slot) return c;
+
+	for (;;)
+	{
+		/* The keys are at the start of the bucket. */
+		Tracon_bucket *b = (Tracon_bucket *)
+			((uintptr_t)kp & ~(uintptr_t)(CACHE_LINE_SIZE - 1));
+		b->count[kp - b->key] = c;
+
+		uint64_t k = key | SLOT_RESERVED;
+		if (!t->concurrent)
+		{
+			/* It may have been moved by a nested insertion. */
+			if (atomic_load_explicit(kp, memory_order_relaxed) == k)
+			{
+				atomic_store_explicit(kp, key | SLOT_COUNTED, memory_order_relaxed);
+				return c;
+			}
+		}
+		else if (atomic_compare_exchange_strong(kp, &k, key | SLOT_COUNTED))
+		{
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+			Wait_stripe *w = get_wait_stripe(t, key);
+			if (0 != atomic_load(&w->waiters))
+			{
+				mtx_lock(&w->mutex);
+				cnd_broadcast(&w->count_ready);
+				mtx_unlock(&w->mutex);
+			}
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+			return c;
+		}
+
+		/* It has been moved to the next generation. */
+		unsigned int s;
+		unsigned int state = find_slot(t, key, false, &b, &s);
+		assert(SLOT_RESERVED == state, "Unreserved table entry (state %u)",
+		       state);
+		kp = &b->key[s];
+	}
+}
+
+/**
+ * Tell whether the table is going to be used by more than one thread.
+ * This must be set only while it is used by a single thread.
+ */
+void tracon_table_set_concurrent(Tracon_table *t, bool concurrent)
+{
+	t->concurrent = concurrent;
+}
+
+/**
+ * Return the number of table entries. If a migration is in progress,
+ * this is only an approximation.
+ */
+size_t tracon_table_num_entries(Tracon_table *t)
+{
+	size_t num_entries = 0;
+
+	for (Tracon_gen *g = t->first; g != NULL;
+	     g = atomic_load_explicit(&g->next, memory_order_acquire))
+	{
+		num_entries =
+			MAX(num_entries, atomic_load_explicit(&g->used, memory_order_relaxed));
+	}
+
+	return num_entries;
+}
+
+/**
+ * Return true if keys could not be inserted because the table is full.
+ * Its counts are then incomplete, so the parse cannot continue.
+ */
+bool tracon_table_is_full(Tracon_table *t)
+{
+	return gen_is_full(atomic_load_explicit(&t->current, memory_order_acquire));
+}
+
+void tracon_table_stat(Tracon_table *t)
+{
+	if (!verbosity_level(+D_TTBL)) return;
+
+	unsigned int num_gens = 0;
+	size_t num_buckets = 0;
+	for (Tracon_gen *g = t->first; g != NULL;
+	     g = atomic_load_explicit(&g->next, memory_order_acquire))
+	{
+		num_gens++;
+		num_buckets = g->mask + 1;
+	}
+
+	prt_error("Info: Tracon table: %u generation%s, %zu buckets, "
+	          "%zu entries (%.2f%%)\n", num_gens, (num_gens == 1) ? "" : "s",
+	          num_buckets, tracon_table_num_entries(t),
+	          100.0f * tracon_table_num_entries(t) / (num_buckets * BUCKET_SLOTS));
+}
+#endif /* USE_LOCKFREE_COUNT_TABLE */
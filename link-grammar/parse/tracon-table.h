@@ -0,0 +1,40 @@
+/*************************************************************************/
+/* Copyright (c) 2026 The Link Grammar project                           */
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+#ifndef _TRACON_TABLE_H
+#define _TRACON_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>                     // size_t
+
+#include "histogram.h"                  // Count_bin
+
+#if USE_LOCKFREE_COUNT_TABLE
+/* Tracon IDs and word numbers in table keys must be less than that. */
+#define TRACON_TABLE_MAX_ID ((1 << 27) - 2)
+
+typedef struct Tracon_table_s Tracon_table;
+
+Tracon_table *tracon_table_new(size_t);
+void tracon_table_delete(Tracon_table *);
+
+Count_bin *tracon_table_lookup(Tracon_table *, int, int, unsigned int,
+                               size_t *);
+Count_bin tracon_table_store(Tracon_table *, int, int, unsigned int, size_t,
+                             Count_bin);
+void tracon_table_set_concurrent(Tracon_table *, bool);
+
+size_t tracon_table_num_entries(Tracon_table *);
+bool tracon_table_is_full(Tracon_table *);
+void tracon_table_stat(Tracon_table *);
+#endif /* USE_LOCKFREE_COUNT_TABLE */
+
+#endif /* _TRACON_TABLE_H */
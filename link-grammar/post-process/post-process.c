@@ -15,12 +15,17 @@
 
 #include <memory.h>
 #include <stdint.h>
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+#include <threads.h>
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
 
 #include "post-process.h"
 
 #include "api-structures.h"
 #include "connectors.h"
+#include "dict-common/dict-common.h"    // MAX_TOKEN_LENGTH
 #include "error.h"
+#include "linkage/analyze-linkage.h"    // spell_link_name
 #include "linkage/linkage.h"
 #include "linkage/score.h"
 #include "pp_knowledge.h"
@@ -30,6 +35,7 @@
 #include "string-set.h"
 
 #define PP_MAX_DOMAINS 128
+#define D_PP 5 /* Debug level for this file */
 
 /**
  * post_process_match -- compare two link-types.
@@ -251,153 +257,310 @@ const char * linkage_get_violation_name(const Linkage linkage)
 	return linkage->lifo.pp_violation_msg;
 }
 
-/************************ rule application *******************************/
+/************************** link classes *********************************/
 
-static void clear_visited(PP_data *pp_data)
+#define PP_BITSET_WORDS(nbits) (((nbits) + 63) / 64)
+
+static inline void bitset_set(uint64_t *bs, size_t i)
 {
-	memset(pp_data->visited, 0, pp_data->num_words * sizeof(bool));
+	bs[i/64] |= (uint64_t)1 << (i%64);
 }
 
-static bool apply_rules(PP_data *pp_data,
-                        bool (applyfn) (PP_data *, Linkage, pp_rule *),
-                        Linkage sublinkage,
-                        pp_rule *rule_array,
-                        const char **msg)
+static inline bool bitset_test(const uint64_t *bs, size_t i)
 {
-	int i;
-	for (i = 0; (*msg = rule_array[i].msg) != NULL; i++)
+	return (bs[i/64] >> (i%64)) & 1;
+}
+
+/** Return the index of the lowest bit set in \p bs, or SIZE_MAX. */
+static size_t bitset_first(const uint64_t *bs, size_t nwords)
+{
+	for (size_t w = 0; w < nwords; w++)
 	{
-		if (!applyfn(pp_data, sublinkage, &(rule_array[i])))
-		{
-			rule_array[i].use_count ++;
-			return false;
-		}
+		if (0 == bs[w]) continue;
+		size_t i = w * 64;
+		for (uint64_t x = bs[w]; !(x & 1); x >>= 1) i++;
+		return i;
 	}
-	return true;
+	return SIZE_MAX;
 }
 
-static bool
-apply_relevant_rules(Postprocessor *pp,
-                     bool (applyfn)(PP_data *, Linkage, pp_rule *),
-                     Linkage sublinkage,
-                     pp_rule *rule_array,
-                     int *relevant_rules,
-                     const char **msg)
-{
-	int i, idx;
-	PP_data *pp_data = &pp->pp_data;
+/**
+ * Compute the rule-related properties of the links between connectors
+ * of the types of \p lnk. The matching is done here once per link
+ * type, so the per-linkage rule checks can then use only bitset
+ * operations.
+ */
+static Pp_link_class *pp_link_class_new(Postprocessor *pp, const Link *lnk)
+{
+	pp_knowledge *kno = pp->knowledge;
+	size_t one_words = PP_BITSET_WORDS(kno->n_contains_one_rules);
+	size_t none_words = PP_BITSET_WORDS(kno->n_contains_none_rules);
+	size_t cycle_words = PP_BITSET_WORDS(kno->n_form_a_cycle_rules);
+	size_t nwords = 2 * one_words + 2 * none_words + cycle_words;
+
+	/* The link name is kept in the class (unless it is a connector
+	 * name), as the string set of the sentence cannot be used here
+	 * concurrently. */
+	char buf[MAX_TOKEN_LENGTH + 1];
+	const char *name = spell_link_name(buf, lnk->lc, lnk->rc);
+	size_t name_size = (name == buf) ? strlen(buf) + 1 : 0;
+
+	Pp_link_class *lc =
+		malloc(sizeof(Pp_link_class) + nwords * sizeof(uint64_t) + name_size);
+	memset(lc->bits, 0, nwords * sizeof(uint64_t));
+	if (0 != name_size)
+		name = memcpy(&lc->bits[nwords], buf, name_size);
+	lc->ldesc = lnk->lc->desc;
+	lc->rdesc = lnk->rc->desc;
+	lc->name = name;
+	lc->one_selector = lc->bits;
+	lc->one_member = lc->one_selector + one_words;
+	lc->none_selector = lc->one_member + one_words;
+	lc->none_member = lc->none_selector + none_words;
+	lc->cycle_member = lc->none_member + none_words;
+
+	for (size_t r = 0; r < kno->n_contains_one_rules; r++)
+	{
+		pp_rule *rule = &kno->contains_one_rules[r];
+		if (post_process_match(rule->selector, name))
+			bitset_set(lc->one_selector, r);
+		if (string_in_list(name, rule->link_array))
+			bitset_set(lc->one_member, r);
+	}
+	for (size_t r = 0; r < kno->n_contains_none_rules; r++)
+	{
+		pp_rule *rule = &kno->contains_none_rules[r];
+		if (post_process_match(rule->selector, name))
+			bitset_set(lc->none_selector, r);
+		if (string_in_list(name, rule->link_array))
+			bitset_set(lc->none_member, r);
+	}
+	for (size_t r = 0; r < kno->n_form_a_cycle_rules; r++)
+	{
+		if (pp_linkset_match(kno->form_a_cycle_rules[r].link_set, name))
+			bitset_set(lc->cycle_member, r);
+	}
 
-	/* If we didn't accumulate link names for this sentence, we need
-	 *  to apply all rules. */
-	if (pp_linkset_population(pp->set_of_links_of_sentence) == 0) {
-		return apply_rules(pp_data, applyfn, sublinkage, rule_array, msg);
+	lc->flags = 0;
+	if (pp_linkset_match(kno->ignore_these_links, name))
+		lc->flags |= PPLC_IGNORE;
+	if (pp_linkset_match(kno->domain_starter_links, name))
+		lc->flags |= PPLC_DOMAIN_STARTER;
+	if (pp_linkset_match(kno->urfl_domain_starter_links, name))
+		lc->flags |= PPLC_URFL_STARTER;
+	if (pp_linkset_match(kno->urfl_only_domain_starter_links, name))
+		lc->flags |= PPLC_URFL_ONLY_STARTER;
+	if (pp_linkset_match(kno->left_domain_starter_links, name))
+		lc->flags |= PPLC_LEFT_STARTER;
+	if (pp_linkset_match(kno->domain_contains_links, name))
+		lc->flags |= PPLC_DOMAIN_CONTAINS;
+	if (pp_linkset_match(kno->restricted_links, name))
+		lc->flags |= PPLC_RESTRICTED;
+
+	lc->domain_type = SIZE_MAX;
+	if (lc->flags & (PPLC_DOMAIN_STARTER | PPLC_URFL_STARTER |
+	                 PPLC_URFL_ONLY_STARTER | PPLC_LEFT_STARTER))
+	{
+		lc->domain_type = find_domain_name(pp, name);
 	}
 
-	/* We did, and we don't. */
-	for (i = 0; (idx = relevant_rules[i]) != -1; i++)
+	return lc;
+}
+
+static inline size_t pp_link_class_hash(const condesc_t *ldesc,
+                                        const condesc_t *rdesc)
+{
+	uintptr_t h = (uintptr_t)ldesc * 31 + (uintptr_t)rdesc;
+	return (size_t)(h ^ (h >> 7) ^ (h >> 17));
+}
+
+static void pp_link_class_table_grow(PP_data *pp_data)
+{
+	size_t old_size = pp_data->lc_table_size;
+	Pp_link_class **old_table = pp_data->lc_table;
+
+	pp_data->lc_table_size *= 2;
+	pp_data->lc_table = malloc(pp_data->lc_table_size * sizeof(Pp_link_class *));
+	memset(pp_data->lc_table, 0, pp_data->lc_table_size * sizeof(Pp_link_class *));
+
+	size_t mask = pp_data->lc_table_size - 1;
+	for (size_t i = 0; i < old_size; i++)
 	{
-		*msg = rule_array[idx].msg;
-		if (!applyfn(pp_data, sublinkage, &(rule_array[idx]))) return false;
+		if (NULL == old_table[i]) continue;
+		size_t h =
+			pp_link_class_hash(old_table[i]->ldesc, old_table[i]->rdesc) & mask;
+		while (NULL != pp_data->lc_table[h]) h = (h + 1) & mask;
+		pp_data->lc_table[h] = old_table[i];
 	}
-	return true;
+	free(old_table);
 }
 
 /**
- * returns true if and only if all groups containing the specified link
- * contain at least one from the required list. (as determined by exact
- * string matching)
+ * Return the link class of \p lnk. The link name depends only on the
+ * types of the connectors at the link ends, so these are used as the
+ * key, and the link name need not be computed for each linkage.
  */
-static bool
-apply_contains_one(PP_data *pp_data, Linkage sublinkage, pp_rule *rule)
+static const Pp_link_class *pp_link_class(Postprocessor *pp, const Link *lnk)
+{
+	PP_data *pp_data = &pp->pp_data;
+	const condesc_t *ldesc = lnk->lc->desc;
+	const condesc_t *rdesc = lnk->rc->desc;
+
+	if (2 * (pp_data->lc_count + 1) > pp_data->lc_table_size)
+		pp_link_class_table_grow(pp_data);
+
+	size_t mask = pp_data->lc_table_size - 1;
+	size_t h = pp_link_class_hash(ldesc, rdesc) & mask;
+	for (; NULL != pp_data->lc_table[h]; h = (h + 1) & mask)
+	{
+		const Pp_link_class *lc = pp_data->lc_table[h];
+		if ((lc->ldesc == ldesc) && (lc->rdesc == rdesc)) return lc;
+	}
+
+	pp_data->lc_table[h] = pp_link_class_new(pp, lnk);
+	pp_data->lc_count++;
+	return pp_data->lc_table[h];
+}
+
+/************************ rule application *******************************/
+
+static void clear_visited(PP_data *pp_data)
 {
-	DTreeLeaf * dtl;
-	size_t d, count;
+	memset(pp_data->visited, 0, pp_data->num_words * sizeof(bool));
+}
 
-	for (d=0; d<pp_data->N_domains; d++)
+static bool apply_rules(Postprocessor *pp,
+                        bool (applyfn) (PP_data *, Linkage, pp_rule *, size_t),
+                        Linkage sublinkage,
+                        pp_rule *rule_array,
+                        const char **msg)
+{
+	int i;
+	for (i = 0; (*msg = rule_array[i].msg) != NULL; i++)
 	{
-		for (dtl = pp_data->domain_array[d].child;
-		     dtl != NULL &&
-		        !post_process_match(rule->selector,
-		           sublinkage->link_array[dtl->link].link_name);
-		     dtl = dtl->next) {}
-		if (dtl != NULL)
+		if (!applyfn(&pp->pp_data, sublinkage, &(rule_array[i]), i))
 		{
-			/* selector link of rule appears in this domain */
-			count=0;
-			for (dtl = pp_data->domain_array[d].child; dtl != NULL; dtl = dtl->next)
-			{
-				if (string_in_list(sublinkage->link_array[dtl->link].link_name,
-				                   rule->link_array))
-				{
-					count=1;
-					break;
-				}
-			}
-			if (count == 0) return false;
+			if (pp->count_rule_use) rule_array[i].use_count ++;
+			return false;
 		}
 	}
 	return true;
 }
 
+/**
+ * Report the first (by rule order) rule of \p rule_array whose bit is
+ * set in \p failed (if any), considering only the relevant rules.
+ * Return true iff there is no such rule.
+ */
+static bool report_failed_rule(Postprocessor *pp, uint64_t *failed,
+                               const uint64_t *relevant, size_t nwords,
+                               pp_rule *rule_array, const char **msg)
+{
+	for (size_t w = 0; w < nwords; w++)
+		failed[w] &= relevant[w];
+
+	size_t r = bitset_first(failed, nwords);
+	if (SIZE_MAX == r) return true;
+
+	*msg = rule_array[r].msg;
+	/* Rule use is counted only when all the rules are applied. */
+	if (pp->count_rule_use &&
+	    (pp_linkset_population(pp->set_of_links_of_sentence) == 0))
+		rule_array[r].use_count++;
+	return false;
+}
 
 /**
- * Returns true if and only if:
- * all groups containing the selector link do not contain anything
- * from the link_array contained in the rule. Uses exact string matching.
+ * Apply the contains_one rules to all the domains, and then the
+ * contains_none rules. For each domain, the link-class bitsets of its
+ * links are OR-ed; a contains_one rule fails if its selector link
+ * appears in a domain that doesn't contain any of its required links,
+ * and a contains_none rule fails if its selector link appears in a
+ * domain that contains one of its forbidden links.
  */
-static bool
-apply_contains_none(PP_data *pp_data, Linkage sublinkage, pp_rule *rule)
+static bool apply_contains_rules(Postprocessor *pp, const char **msg)
 {
-	size_t d;
+	PP_data *pp_data = &pp->pp_data;
+	pp_knowledge *kno = pp->knowledge;
+	size_t one_words = PP_BITSET_WORDS(kno->n_contains_one_rules);
+	size_t none_words = PP_BITSET_WORDS(kno->n_contains_none_rules);
+	size_t nwords = 2 * (one_words + none_words);
+	uint64_t *bits = alloca(MAX(nwords, 1) * 2 * sizeof(uint64_t));
+	uint64_t *one_failed = bits;
+	uint64_t *none_failed = one_failed + one_words;
+	uint64_t *one_sel = none_failed + none_words;
+	uint64_t *one_mem = one_sel + one_words;
+	uint64_t *none_sel = one_mem + one_words;
+	uint64_t *none_mem = none_sel + none_words;
+
+	memset(one_failed, 0, (one_words + none_words) * sizeof(uint64_t));
 
-	for (d=0; d<pp_data->N_domains; d++)
+	for (size_t d = 0; d < pp_data->N_domains; d++)
 	{
-		DTreeLeaf * dtl;
-		for (dtl = pp_data->domain_array[d].child;
-		     dtl != NULL &&
-		         !post_process_match(rule->selector,
-		                  sublinkage->link_array[dtl->link].link_name);
-		     dtl = dtl->next) {}
-		if (dtl != NULL)
+		memset(one_sel, 0, nwords * sizeof(uint64_t));
+		for (DTreeLeaf *dtl = pp_data->domain_array[d].child; dtl != NULL;
+		     dtl = dtl->next)
 		{
-			/* selector link of rule appears in this domain */
-			for (dtl = pp_data->domain_array[d].child; dtl != NULL; dtl = dtl->next)
+			const Pp_link_class *lc = pp_data->link_class[dtl->link];
+
+			for (size_t w = 0; w < one_words; w++)
+			{
+				one_sel[w] |= lc->one_selector[w];
+				one_mem[w] |= lc->one_member[w];
+			}
+			for (size_t w = 0; w < none_words; w++)
 			{
-				if (string_in_list(sublinkage->link_array[dtl->link].link_name,
-				                   rule->link_array))
-					return false;
+				none_sel[w] |= lc->none_selector[w];
+				none_mem[w] |= lc->none_member[w];
 			}
 		}
+
+		for (size_t w = 0; w < one_words; w++)
+			one_failed[w] |= one_sel[w] & ~one_mem[w];
+		for (size_t w = 0; w < none_words; w++)
+			none_failed[w] |= none_sel[w] & none_mem[w];
 	}
-	return true;
+
+	if (!report_failed_rule(pp, one_failed, pp->relevant_contains_one_mask,
+	                        one_words, kno->contains_one_rules, msg))
+		return false;
+	return report_failed_rule(pp, none_failed, pp->relevant_contains_none_mask,
+	                          none_words, kno->contains_none_rules, msg);
 }
 
 /**
- * Returns true if and only if
+ * Returns true if and only if, for each contains_one rule,
  * (1) the sentence doesn't contain the selector link for the rule, or
  * (2) it does, and it also contains one or more from the rule's link set
  */
 static bool
-apply_contains_one_globally(PP_data *pp_data, Linkage sublinkage, pp_rule *rule)
+apply_contains_one_globally(Postprocessor *pp, Linkage sublinkage,
+                            const char **msg)
 {
-	size_t i;
-	for (i = 0; i < sublinkage->num_links; i++)
-	{
-		if (post_process_match(rule->selector, sublinkage->link_array[i].link_name)) break;
-	}
-	if (i == sublinkage->num_links) return true;
+	PP_data *pp_data = &pp->pp_data;
+	pp_knowledge *kno = pp->knowledge;
+	size_t one_words = PP_BITSET_WORDS(kno->n_contains_one_rules);
+	uint64_t *one_sel = alloca(MAX(one_words, 1) * 2 * sizeof(uint64_t));
+	uint64_t *one_mem = one_sel + one_words;
 
-	/* selector link of rule appears in sentence */
-	size_t count = 0;
-	for (size_t j = 0; j < sublinkage->num_links && count == 0; j++)
+	memset(one_sel, 0, 2 * one_words * sizeof(uint64_t));
+	for (size_t i = 0; i < sublinkage->num_links; i++)
 	{
-		if (string_in_list(sublinkage->link_array[j].link_name, rule->link_array))
+		const Pp_link_class *lc = pp_data->link_class[i];
+		if (NULL == lc) continue;
+
+		for (size_t w = 0; w < one_words; w++)
 		{
-			count = 1;
-			break;
+			one_sel[w] |= lc->one_selector[w];
+			one_mem[w] |= lc->one_member[w];
 		}
 	}
-	if (count == 0) return false; else return true;
+
+	for (size_t w = 0; w < one_words; w++)
+		one_sel[w] &= ~one_mem[w];
+
+	return report_failed_rule(pp, one_sel, pp->relevant_contains_one_mask,
+	                          one_words, kno->contains_one_rules, msg);
 }
 
 /**
@@ -434,7 +597,8 @@ static void reachable_without_dfs(PP_data *pp_data,
  * these links.
  */
 static bool
-apply_must_form_a_cycle(PP_data *pp_data, Linkage sublinkage, pp_rule *rule)
+apply_must_form_a_cycle(PP_data *pp_data, Linkage sublinkage, pp_rule *rule,
+                        size_t rule_idx)
 {
 	List_o_links *lol;
 	size_t w;
@@ -444,7 +608,8 @@ apply_must_form_a_cycle(PP_data *pp_data, Linkage sublinkage, pp_rule *rule)
 		for (lol = pp_data->word_links[w]; lol != NULL; lol = lol->next)
 		{
 			if (w > lol->word) continue; /* only consider each edge once */
-			if (!pp_linkset_match(rule->link_set, sublinkage->link_array[lol->link].link_name)) continue;
+			if (!bitset_test(pp_data->link_class[lol->link]->cycle_member,
+			                 rule_idx)) continue;
 
 			clear_visited(pp_data);
 			reachable_without_dfs(pp_data, sublinkage, w, lol->word, w);
@@ -456,7 +621,8 @@ apply_must_form_a_cycle(PP_data *pp_data, Linkage sublinkage, pp_rule *rule)
 	{
 		w = sublinkage->link_array[lol->link].lw;
 		/* (w, lol->word) are the left and right ends of the edge we're considering */
-		if (!pp_linkset_match(rule->link_set, sublinkage->link_array[lol->link].link_name)) continue;
+		if (!bitset_test(pp_data->link_class[lol->link]->cycle_member,
+		                 rule_idx)) continue;
 
 		clear_visited(pp_data);
 		reachable_without_dfs(pp_data, sublinkage, w, lol->word, w);
@@ -474,7 +640,8 @@ apply_must_form_a_cycle(PP_data *pp_data, Linkage sublinkage, pp_rule *rule)
  * of the root word of the domain.
  */
 static bool
-apply_bounded(PP_data *pp_data, Linkage sublinkage, pp_rule *rule)
+apply_bounded(PP_data *pp_data, Linkage sublinkage, pp_rule *rule,
+              size_t rule_idx)
 {
 	size_t d, lw;
 	List_o_links * lol;
@@ -513,14 +680,13 @@ static void build_graph(Postprocessor *pp, Linkage sublinkage)
 
 	for (size_t link = 0; link < sublinkage->num_links; link++)
 	{
-		if (NULL == sublinkage->link_array[link].link_name) continue;
+		if (NULL == pp_data->link_class[link]) continue;
 
 		List_o_links * lol = (List_o_links *) malloc(sizeof(List_o_links));
 		lol->link = link;
 		lol->word = sublinkage->link_array[link].rw;
 
-		if (pp_linkset_match(pp->knowledge->ignore_these_links,
-		                     sublinkage->link_array[link].link_name))
+		if (pp_data->link_class[link]->flags & PPLC_IGNORE)
 		{
 			lol->next = pp_data->links_to_ignore;
 			pp_data->links_to_ignore = lol;
@@ -598,8 +764,7 @@ static void depth_first_search(Postprocessor *pp, Linkage sublinkage,
 	{
 		if (!pp_data->visited[lol->word] && (lol->word != root) &&
 		       !(lol->word < root && lol->word < w &&
-		       pp_linkset_match(pp->knowledge->restricted_links,
-		                sublinkage->link_array[lol->link].link_name)))
+		       (pp_data->link_class[lol->link]->flags & PPLC_RESTRICTED)))
 		{
 			depth_first_search(pp, sublinkage, lol->word, root, start_link);
 		}
@@ -626,8 +791,7 @@ static void bad_depth_first_search(Postprocessor *pp, Linkage sublinkage,
 		assert(lol->word < pp_data->num_words, "Bad word index");
 		if ((!pp_data->visited[lol->word]) && !(w == root && lol->word < w) &&
 		     !(lol->word < root && lol->word < w &&
-		          pp_linkset_match(pp->knowledge->restricted_links,
-		                sublinkage->link_array[lol->link].link_name)))
+		          (pp_data->link_class[lol->link]->flags & PPLC_RESTRICTED)))
 		{
 			bad_depth_first_search(pp, sublinkage, lol->word, root, start_link);
 		}
@@ -655,8 +819,7 @@ static void d_depth_first_search(Postprocessor *pp, Linkage sublinkage,
 		if (!pp_data->visited[lol->word] && !(w == root && lol->word >= right) &&
 		    !(w == root && lol->word < root) &&
 		       !(lol->word < root && lol->word < w &&
-		          pp_linkset_match(pp->knowledge->restricted_links,
-		                   sublinkage->link_array[lol->link].link_name)))
+		          (pp_data->link_class[lol->link]->flags & PPLC_RESTRICTED)))
 		{
 			d_depth_first_search(pp,sublinkage,lol->word,root,right,start_link);
 		}
@@ -709,14 +872,15 @@ static void build_domains(Postprocessor *pp, Linkage sublinkage)
 
 	for (size_t link = 0; link<sublinkage->num_links; link++)
 	{
-		if (NULL == sublinkage->link_array[link].link_name) continue;
-		const char *s = sublinkage->link_array[link].link_name;
+		if (NULL == pp_data->link_class[link]) continue;
+		const char *s = pp_data->link_class[link]->name;
+		unsigned int flags = pp_data->link_class[link]->flags;
 
-		if (pp_linkset_match(pp->knowledge->ignore_these_links, s)) continue;
-		if (pp_linkset_match(pp->knowledge->domain_starter_links, s))
+		if (flags & PPLC_IGNORE) continue;
+		if (flags & PPLC_DOMAIN_STARTER)
 		{
 			setup_domain_array(pp, s, link);
-			if (pp_linkset_match(pp->knowledge->domain_contains_links, s))
+			if (flags & PPLC_DOMAIN_CONTAINS)
 				add_link_to_domain(pp_data, link);
 
 			clear_visited(pp_data);
@@ -724,7 +888,7 @@ static void build_domains(Postprocessor *pp, Linkage sublinkage)
 			                   sublinkage->link_array[link].lw, link);
 		}
 		else
-		if (pp_linkset_match(pp->knowledge->urfl_domain_starter_links, s))
+		if (flags & PPLC_URFL_STARTER)
 		{
 			setup_domain_array(pp, s, link);
 			/* always add the starter link to its urfl domain */
@@ -735,7 +899,7 @@ static void build_domains(Postprocessor *pp, Linkage sublinkage)
 			                       sublinkage->link_array[link].lw, link);
 		}
 		else
-		if (pp_linkset_match(pp->knowledge->urfl_only_domain_starter_links, s))
+		if (flags & PPLC_URFL_ONLY_STARTER)
 		{
 			setup_domain_array(pp, s, link);
 			/* do not add the starter link to its urfl_only domain */
@@ -745,7 +909,7 @@ static void build_domains(Postprocessor *pp, Linkage sublinkage)
 			                     sublinkage->link_array[link].rw, link);
 		}
 		else
-		if (pp_linkset_match(pp->knowledge->left_domain_starter_links, s))
+		if (flags & PPLC_LEFT_STARTER)
 		{
 			setup_domain_array(pp, s, link);
 			/* do not add the starter link to a left domain */
@@ -764,7 +928,8 @@ static void build_domains(Postprocessor *pp, Linkage sublinkage)
 	/* sanity check: all links in all domains have a legal domain name */
 	for (size_t d = 0; d < pp_data->N_domains; d++)
 	{
-		size_t i = find_domain_name(pp, pp_data->domain_array[d].string);
+		size_t start_link = pp_data->domain_array[d].start_link;
+		size_t i = pp_data->link_class[start_link]->domain_type;
 		if (i == SIZE_MAX)
 			prt_error("Error: post_process(): Need an entry for %s in LINK_TYPE_TABLE\n",
 			          pp_data->domain_array[d].string);
@@ -825,10 +990,7 @@ internal_process(Postprocessor *pp, Linkage sublinkage, const char **msg)
 	PP_data *pp_data = &pp->pp_data;
 
 	/* quick test: try applying just the relevant global rules */
-	if (!apply_relevant_rules(pp, apply_contains_one_globally,
-	                          sublinkage,
-	                          pp->knowledge->contains_one_rules,
-	                          pp->relevant_contains_one_rules, msg))
+	if (!apply_contains_one_globally(pp, sublinkage, msg))
 	{
 		for (size_t i = 0; i < pp_data->wowlen; i++)
 			pp_data->word_links[i] = NULL;
@@ -849,15 +1011,10 @@ internal_process(Postprocessor *pp, Linkage sublinkage, const char **msg)
 #endif
 
 	/* The order below should be optimal for most cases */
-	if (!apply_relevant_rules(pp, apply_contains_one, sublinkage,
-	                          pp->knowledge->contains_one_rules,
-	                          pp->relevant_contains_one_rules, msg)) return 1;
-	if (!apply_relevant_rules(pp, apply_contains_none, sublinkage,
-	                          pp->knowledge->contains_none_rules,
-	                          pp->relevant_contains_none_rules, msg)) return 1;
-	if (!apply_rules(pp_data, apply_must_form_a_cycle, sublinkage,
+	if (!apply_contains_rules(pp, msg)) return 1;
+	if (!apply_rules(pp, apply_must_form_a_cycle, sublinkage,
 	                 pp->knowledge->form_a_cycle_rules,msg)) return 1;
-	if (!apply_rules(pp_data, apply_bounded, sublinkage,
+	if (!apply_rules(pp, apply_bounded, sublinkage,
 	                 pp->knowledge->bounded_rules, msg)) return 1;
 	return 0; /* This linkage satisfied all the rules */
 }
@@ -891,6 +1048,11 @@ static void prune_irrelevant_rules(Postprocessor *pp)
 	}
 	pp->relevant_contains_one_rules[rcoIDX] = -1;  /* end sentinel */
 
+	memset(pp->relevant_contains_one_mask, 0,
+	       PP_BITSET_WORDS(pp->knowledge->n_contains_one_rules) * sizeof(uint64_t));
+	for (int i = 0; i < rcoIDX; i++)
+		bitset_set(pp->relevant_contains_one_mask, pp->relevant_contains_one_rules[i]);
+
 	for (cnIDX = 0; ; cnIDX++)
 	{
 		rule = &(pp->knowledge->contains_none_rules[cnIDX]);
@@ -903,6 +1065,11 @@ static void prune_irrelevant_rules(Postprocessor *pp)
 	}
 	pp->relevant_contains_none_rules[rcnIDX] = -1;
 
+	memset(pp->relevant_contains_none_mask, 0,
+	       PP_BITSET_WORDS(pp->knowledge->n_contains_none_rules) * sizeof(uint64_t));
+	for (int i = 0; i < rcnIDX; i++)
+		bitset_set(pp->relevant_contains_none_mask, pp->relevant_contains_none_rules[i]);
+
 	if (verbosity_level(5))
 	{
 		err_msg(lg_Debug, "PP: Saw %zu unique link names in all linkages.\n\\",
@@ -925,6 +1092,63 @@ static void pp_new_domain_array(PP_data *pp_data)
 	memset(pp_data->domain_array, 0, pp_data->domlen * sizeof(Domain));
 }
 
+/**
+ * Allocate the per-linkage scratch arrays of \p pp_data.
+ */
+static void pp_data_init(PP_data *pp_data)
+{
+	pp_data->vlength = PP_INITLEN;
+	pp_data->visited = (bool*) malloc(pp_data->vlength * sizeof(bool));
+	memset(pp_data->visited, 0, pp_data->vlength * sizeof(bool));
+
+	pp_data->links_to_ignore = NULL;
+	pp_new_domain_array(pp_data);
+
+	pp_data->wowlen = PP_INITLEN;
+	pp_data->word_links = (List_o_links **) malloc(pp_data->wowlen * sizeof(List_o_links*));
+	memset(pp_data->word_links, 0, pp_data->wowlen * sizeof(List_o_links *));
+
+	pp_data->num_words = 0;
+	pp_data->N_domains = 0;
+
+	pp_data->lc_table_size = 256;
+	pp_data->lc_table = malloc(pp_data->lc_table_size * sizeof(Pp_link_class *));
+	memset(pp_data->lc_table, 0, pp_data->lc_table_size * sizeof(Pp_link_class *));
+	pp_data->lc_count = 0;
+
+	pp_data->lclen = PP_INITLEN;
+	pp_data->link_class = malloc(pp_data->lclen * sizeof(Pp_link_class *));
+}
+
+static void pp_data_free(PP_data *pp_data)
+{
+	post_process_free_data(pp_data);
+	free(pp_data->visited);
+	free(pp_data->domain_array);
+	free(pp_data->word_links);
+
+	for (size_t i = 0; i < pp_data->lc_table_size; i++)
+		free(pp_data->lc_table[i]);
+	free(pp_data->lc_table);
+	free(pp_data->link_class);
+}
+
+/**
+ * Return a bitset with the first \p nbits bits set, meaning that all
+ * the rules are relevant.
+ */
+static uint64_t *pp_all_rules_mask(size_t nbits)
+{
+	size_t nwords = PP_BITSET_WORDS(nbits);
+	uint64_t *mask = malloc(MAX(nwords, 1) * sizeof(uint64_t));
+
+	memset(mask, 0, nwords * sizeof(uint64_t));
+	for (size_t i = 0; i < nbits; i++)
+		bitset_set(mask, i);
+
+	return mask;
+}
+
 /**
  * read rules from path and initialize the appropriate fields in
  * a postprocessor structure, a pointer to which is returned.
@@ -932,7 +1156,6 @@ static void pp_new_domain_array(PP_data *pp_data)
 Postprocessor * post_process_new(pp_knowledge * kno)
 {
 	Postprocessor *pp;
-	PP_data *pp_data;
 
 	if (NULL == kno) return NULL;
 
@@ -949,31 +1172,24 @@ Postprocessor * post_process_new(pp_knowledge * kno)
 	                      *(sizeof pp->relevant_contains_none_rules[0]));
 	pp->relevant_contains_one_rules[0] = -1;
 	pp->relevant_contains_none_rules[0] = -1;
+	pp->relevant_contains_one_mask =
+		pp_all_rules_mask(pp->knowledge->n_contains_one_rules);
+	pp->relevant_contains_none_mask =
+		pp_all_rules_mask(pp->knowledge->n_contains_none_rules);
 	pp->violation = NULL;
 	pp->n_local_rules_firing = 0;
 	pp->n_global_rules_firing = 0;
 
 	pp->q_pruned_rules = false;
+	pp->count_rule_use = true;
 
-	pp_data = &pp->pp_data;
-	pp_data->vlength = PP_INITLEN;
-	pp_data->visited = (bool*) malloc(pp_data->vlength * sizeof(bool));
-	memset(pp_data->visited, 0, pp_data->vlength * sizeof(bool));
-
-	pp_data->links_to_ignore = NULL;
-	pp_new_domain_array(pp_data);
-
-	pp_data->wowlen = PP_INITLEN;
-	pp_data->word_links = (List_o_links **) malloc(pp_data->wowlen * sizeof(List_o_links*));
-	memset(pp_data->word_links, 0, pp_data->wowlen * sizeof(List_o_links *));
+	pp_data_init(&pp->pp_data);
 
 	return pp;
 }
 
 void post_process_free(Postprocessor *pp)
 {
-	PP_data *pp_data;
-
 	/* frees up memory associated with pp, previously allocated by open */
 	if (pp == NULL) return;
 	string_set_delete(pp->string_set);
@@ -981,14 +1197,12 @@ void post_process_free(Postprocessor *pp)
 	pp_linkset_close(pp->set_of_links_in_an_active_rule);
 	free(pp->relevant_contains_one_rules);
 	free(pp->relevant_contains_none_rules);
+	free(pp->relevant_contains_one_mask);
+	free(pp->relevant_contains_none_mask);
 	pp->knowledge = NULL;
 	pp->violation = NULL;
 
-	pp_data = &pp->pp_data;
-	post_process_free_data(pp_data);
-	free(pp_data->visited);
-	free(pp_data->domain_array);
-	free(pp_data->word_links);
+	pp_data_free(&pp->pp_data);
 
 	free(pp);
 }
@@ -1004,8 +1218,9 @@ static void post_process_scan_linkage(Postprocessor *pp, Linkage linkage)
 	if (pp == NULL) return;
 	for (i = 0; i < linkage->num_links; i++)
 	{
+		/* The class names live as long as the postprocessor. */
 		pp_linkset_add(pp->set_of_links_of_sentence,
-			linkage->link_array[i].link_name);
+			pp_link_class(pp, &linkage->link_array[i])->name);
 	}
 }
 
@@ -1091,6 +1306,18 @@ void do_post_process(Postprocessor *pp, Linkage sublinkage, bool is_long)
 	}
 	clear_visited(pp_data);
 
+	if (pp_data->lclen < sublinkage->num_links)
+	{
+		pp_data->lclen = sublinkage->num_links + PP_INITLEN;
+		pp_data->link_class = realloc(pp_data->link_class,
+		                              pp_data->lclen * sizeof(Pp_link_class *));
+	}
+	for (size_t i = 0; i < sublinkage->num_links; i++)
+	{
+		const Link *lnk = &sublinkage->link_array[i];
+		pp_data->link_class[i] = lnk->discarded ? NULL : pp_link_class(pp, lnk);
+	}
+
 	/* For long sentences, we can save some time by pruning the rules
 	 * which can't possibly be used during postprocessing the linkages
 	 * of this sentence. For short sentences, this is pointless. */
@@ -1122,8 +1349,152 @@ void do_post_process(Postprocessor *pp, Linkage sublinkage, bool is_long)
 	report_pp_stats(pp);
 }
 
+#define TCD 512 /* timer checking divisor */
+
+/* The linkages are post-processed in chunks of consecutive linkages.
+ * The resources are checked after each chunk, and when several threads
+ * are used, each one repeatedly takes the next unprocessed chunk. */
+#define PP_CHUNK_SIZE 64
+
+/* Don't bother with threads for fewer linkages. Just an estimation. */
+static const size_t min_lkgs_parallel_pp = 4 * PP_CHUNK_SIZE;
+
+typedef struct
+{
+	size_t N_post_processed;
+	size_t N_invalid;                /* Got a P.P. violation */
+	bool done;
+} Pp_chunk;
+
+typedef struct
+{
+	Sentence sent;
+	Parse_Options opts;
+	Postprocessor *pp;
+	bool is_long;
+	bool stop;                       /* Resources exhausted */
+	size_t next_chunk;
+	size_t num_chunks;
+	Pp_chunk *chunk;
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	mtx_t mutex;                     /* Protects next_chunk and stop */
+	bool parallel;
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+} Pp_work;
+
+static bool pp_next_chunk(Pp_work *pw, size_t *c)
+{
+	bool got_chunk;
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	if (pw->parallel) mtx_lock(&pw->mutex);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+	got_chunk = !pw->stop && (pw->next_chunk < pw->num_chunks);
+	if (got_chunk) *c = pw->next_chunk++;
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	if (pw->parallel) mtx_unlock(&pw->mutex);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+	return got_chunk;
+}
+
+static void pp_stop(Pp_work *pw)
+{
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	if (pw->parallel) mtx_lock(&pw->mutex);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+	pw->stop = true;
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	if (pw->parallel) mtx_unlock(&pw->mutex);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+}
+
+/**
+ * Post-process chunks of linkages, using \p pp for the per-linkage
+ * state. Only the linkages of the taken chunks are written, so several
+ * threads can do that concurrently, each with its own \p pp.
+ * The resources are checked only if \p check_resources is set (by the
+ * calling thread), because the timer state is not thread-safe.
+ */
+static void pp_process_chunks(Pp_work *pw, Postprocessor *pp,
+                              bool check_resources)
+{
+	size_t N_linkages_alloced = pw->sent->num_linkages_alloced;
+	size_t c;
+
+	while (pp_next_chunk(pw, &c))
+	{
+		Pp_chunk *pc = &pw->chunk[c];
+		size_t end = MIN((c + 1) * PP_CHUNK_SIZE, N_linkages_alloced);
+
+		for (size_t in = c * PP_CHUNK_SIZE; in < end; in++)
+		{
+			Linkage lkg = &pw->sent->lnkages[in];
+			Linkage_info *lifo = &lkg->lifo;
+
+			if (lifo->N_violations) continue;
+
+			do_post_process(pp, lkg, pw->is_long);
+			post_process_free_data(&pp->pp_data);
+
+			if (NULL != pp->violation)
+			{
+				pc->N_invalid++;
+				lifo->N_violations++;
+
+				/* Set the message, only if not set */
+				if (NULL == lifo->pp_violation_msg)
+					lifo->pp_violation_msg = pp->violation;
+			}
+			pc->N_post_processed++;
+
+			linkage_score(lkg, pw->opts);
+		}
+		pc->done = true;
+
+		if (check_resources && resources_exhausted(pw->opts->resources))
+			pp_stop(pw);
+	}
+}
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+/**
+ * Each worker thread uses a private copy of the postprocessor, which
+ * shares the rules and the pruned rule lists (these are only read
+ * here), but has its own per-linkage state.
+ * The rule use counts are shared too, so only the calling thread
+ * updates them.
+ */
+static int pp_worker(void *arg)
+{
+	Pp_work *pw = arg;
+	Postprocessor wpp = *pw->pp;
+
+	wpp.n_global_rules_firing = 0;
+	wpp.n_local_rules_firing = 0;
+	wpp.violation = NULL;
+	wpp.count_rule_use = false;
+	pp_data_init(&wpp.pp_data);
+
+	pp_process_chunks(pw, &wpp, /*check_resources*/false);
+
+	pp_data_free(&wpp.pp_data);
+
+	mtx_lock(&pw->mutex);
+	pw->pp->n_global_rules_firing += wpp.n_global_rules_firing;
+	pw->pp->n_local_rules_firing += wpp.n_local_rules_firing;
+	mtx_unlock(&pw->mutex);
+
+	return 0;
+}
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
 /**
  * This does basic post-processing for all linkages.
+ *
+ * If opts->count_threads > 1 and there are many linkages, they are
+ * post-processed in parallel. The result doesn't depend on the number
+ * of threads (unless the resources get exhausted).
  */
 void post_process_lkgs(Sentence sent, Parse_Options opts)
 {
@@ -1149,8 +1520,6 @@ void post_process_lkgs(Sentence sent, Parse_Options opts)
 		return;
 	}
 
-#define TCD 512 /* timer checking divisor */
-
 	/* (optional) First pass: just visit the linkages */
 	/* The purpose of the first pass is to make the post-processing
 	 * more efficient.  Because (hopefully) by the time the real work
@@ -1170,51 +1539,93 @@ void post_process_lkgs(Sentence sent, Parse_Options opts)
 
 			if (((TCD-1) == in%TCD) && resources_exhausted(opts->resources)) break;
 		}
+
+		/* Prune here (instead of in do_post_process()), so the
+		 * pruned rule lists are ready before any worker starts. */
+		if (!pp->q_pruned_rules) prune_irrelevant_rules(pp);
+		pp->q_pruned_rules = true;
 	}
 
 	/* Second pass: actually perform post-processing */
-	for (in=0; in < N_linkages_alloced; in++)
+	Pp_work pw =
 	{
-		Linkage lkg = &sent->lnkages[in];
-		Linkage_info *lifo = &lkg->lifo;
-
-		if (lifo->N_violations) continue;
+		.sent = sent,
+		.opts = opts,
+		.pp = pp,
+		.is_long = twopass,
+		.num_chunks = (N_linkages_alloced + PP_CHUNK_SIZE - 1) / PP_CHUNK_SIZE,
+	};
+	pw.chunk = malloc(MAX(pw.num_chunks, 1) * sizeof(Pp_chunk));
+	memset(pw.chunk, 0, MAX(pw.num_chunks, 1) * sizeof(Pp_chunk));
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	/* The worker threads don't update the rule use counts; keep them
+	 * exact when they are reported. */
+	if ((opts->count_threads > 1) &&
+	    (N_linkages_alloced >= min_lkgs_parallel_pp) && !verbosity_level(9))
+	{
+		unsigned int num_threads =
+			MIN(opts->count_threads, pw.num_chunks) - 1;
+		thrd_t *thread = malloc(num_threads * sizeof(thrd_t));
+		unsigned int num_started;
 
-		do_post_process(pp, lkg, twopass);
-		post_process_free_data(&pp->pp_data);
+		pw.parallel = true;
+		mtx_init(&pw.mutex, mtx_plain);
 
-		if (NULL != pp->violation)
+		for (num_started = 0; num_started < num_threads; num_started++)
 		{
-			N_valid_linkages--;
-			lifo->N_violations++;
-
-			/* Set the message, only if not set */
-			if (NULL == lifo->pp_violation_msg)
-				lifo->pp_violation_msg = pp->violation;
+			if (thrd_success !=
+			    thrd_create(&thread[num_started], pp_worker, &pw))
+				break;
 		}
-		N_linkages_post_processed++;
+		lgdebug(+D_PP, "Parallel post-processing: %u threads, %zu chunks\n",
+		        num_started + 1, pw.num_chunks);
+
+		pp_process_chunks(&pw, pp, /*check_resources*/true);
 
-		linkage_score(lkg, opts);
-		if (((TCD-1) == in%TCD) && resources_exhausted(opts->resources)) break;
+		for (unsigned int i = 0; i < num_started; i++)
+			thrd_join(thread[i], NULL);
+
+		mtx_destroy(&pw.mutex);
+		free(thread);
+	}
+	else
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+	{
+		pp_process_chunks(&pw, pp, /*check_resources*/true);
 	}
 
-	/* If the timer expired, then we never finished post-processing.
-	 * Mark the remaining sentences as bad, as otherwise strange
-	 * results get reported. */
-	for (; in < N_linkages_alloced; in++)
+	/* Sum up the chunk results. If the timer expired, then we never
+	 * finished post-processing. Mark the remaining linkages as bad, as
+	 * otherwise strange results get reported. */
+	for (size_t c = 0; c < pw.num_chunks; c++)
 	{
-		Linkage lkg = &sent->lnkages[in];
-		Linkage_info *lifo = &lkg->lifo;
+		Pp_chunk *pc = &pw.chunk[c];
 
-		if (lifo->N_violations) continue;
+		if (pc->done)
+		{
+			N_linkages_post_processed += pc->N_post_processed;
+			N_valid_linkages -= pc->N_invalid;
+			continue;
+		}
+
+		size_t end = MIN((c + 1) * PP_CHUNK_SIZE, N_linkages_alloced);
+		for (in = c * PP_CHUNK_SIZE; in < end; in++)
+		{
+			Linkage lkg = &sent->lnkages[in];
+			Linkage_info *lifo = &lkg->lifo;
 
-		N_valid_linkages--;
-		lifo->N_violations++;
+			if (lifo->N_violations) continue;
 
-		/* Set the message, only if not set */
-		if (NULL == lifo->pp_violation_msg)
-			lifo->pp_violation_msg = "Timeout during postprocessing";
+			N_valid_linkages--;
+			lifo->N_violations++;
+
+			/* Set the message, only if not set */
+			if (NULL == lifo->pp_violation_msg)
+				lifo->pp_violation_msg = "Timeout during postprocessing";
+		}
 	}
+	free(pw.chunk);
 
 	print_time(opts, "Postprocessed all linkages");
 
@@ -1228,6 +1639,33 @@ void post_process_lkgs(Sentence sent, Parse_Options opts)
 	sent->num_valid_linkages = N_valid_linkages;
 }
 
+/**
+ * Post-process and score a single linkage, for linkages that are
+ * extracted on demand (see linkage_iter_next()). There is no rule
+ * pruning, since the linkages are not scanned in advance.
+ * Return \c true iff the linkage has no P.P. violations.
+ */
+bool post_process_one_lkg(Sentence sent, Parse_Options opts, Linkage lkg)
+{
+	Postprocessor *pp = sent->postprocessor;
+
+	if (NULL != pp)
+	{
+		do_post_process(pp, lkg, /*is_long*/false);
+		post_process_free_data(&pp->pp_data);
+
+		if (NULL != pp->violation)
+		{
+			lkg->lifo.N_violations++;
+			if (NULL == lkg->lifo.pp_violation_msg)
+				lkg->lifo.pp_violation_msg = pp->violation;
+		}
+	}
+
+	linkage_score(lkg, opts);
+	return (0 == lkg->lifo.N_violations);
+}
+
 /* ================ compute the domain names ============= */
 /*
  * The code below is used in one place only: when printing the domain
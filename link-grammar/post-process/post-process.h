@@ -34,6 +34,7 @@ Postprocessor * post_process_new(pp_knowledge *);
 void post_process_free(Postprocessor *);
 
 void post_process_lkgs(Sentence, Parse_Options);
+bool post_process_one_lkg(Sentence, Parse_Options, Linkage);
 
 void     do_post_process(Postprocessor *, Linkage, bool);
 void     post_process_free_data(PP_data * ppd);
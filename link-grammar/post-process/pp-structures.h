@@ -15,12 +15,14 @@
 #define _PP_STRUCTURES_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "api-types.h"
 #include "post-process.h"
 
 typedef struct Domain_s Domain;
 typedef struct DTreeLeaf_s DTreeLeaf;
 typedef struct List_o_links_struct List_o_links;
+typedef struct Pp_link_class_s Pp_link_class;
 
 struct Domain_s
 {
@@ -53,6 +55,14 @@ struct PP_data_s
 
 	bool *visited;                  /* For the depth-first search */
 	size_t vlength;                 /* Length of visited array */
+
+	/* Link classes, by link type (see pp_link_class()). They are kept
+	 * for all the linkages of the sentence. */
+	Pp_link_class **lc_table;       /* Open addressing, by link type */
+	size_t lc_table_size;           /* A power of 2 */
+	size_t lc_count;                /* Number of classes in lc_table */
+	const Pp_link_class **link_class; /* Per link of the current linkage */
+	size_t lclen;                   /* Allocated size of link_class */
 };
 
 /* A new Postprocessor struct is alloc'ed for each sentence. It contains
@@ -68,6 +78,9 @@ struct Postprocessor_s
 	int *relevant_contains_one_rules;        /* -1-terminated list of indices  */
 	int *relevant_contains_none_rules;
 	bool q_pruned_rules;       /* don't prune rules more than once in p.p. */
+	bool count_rule_use;       /* Update the rules' use_count (diagnostic) */
+	uint64_t *relevant_contains_one_mask;  /* The above, as rule bitsets */
+	uint64_t *relevant_contains_none_mask;
 	String_set *string_set;      /* Link names seen for sentence */
 
 	/* Per-linkage state; this data must be reset prior to processing
@@ -93,6 +106,33 @@ struct List_o_links_struct
 	List_o_links * next;
 };
 
+/* The rule-related properties of a link type (a pair of connector
+ * types). They are computed once per distinct link type of a sentence,
+ * so the rules can then be checked using bitset operations instead of
+ * string matching. */
+#define PPLC_IGNORE              (1<<0)
+#define PPLC_DOMAIN_STARTER      (1<<1)
+#define PPLC_URFL_STARTER        (1<<2)
+#define PPLC_URFL_ONLY_STARTER   (1<<3)
+#define PPLC_LEFT_STARTER        (1<<4)
+#define PPLC_DOMAIN_CONTAINS     (1<<5)
+#define PPLC_RESTRICTED          (1<<6)
+
+struct Pp_link_class_s
+{
+	const struct condesc_struct *ldesc; /* Key: link connector types */
+	const struct condesc_struct *rdesc;
+	const char *name;          /* The link name */
+	unsigned int flags;        /* PPLC_* */
+	size_t domain_type;        /* For domain starters; SIZE_MAX if none */
+	uint64_t *one_selector;    /* Matches the contains_one rule selector */
+	uint64_t *one_member;      /* Matches a link in the contains_one rule */
+	uint64_t *none_selector;   /* Same for the contains_none rules */
+	uint64_t *none_member;
+	uint64_t *cycle_member;    /* Matches the form_a_cycle rule links */
+	uint64_t bits[];           /* The storage of the above bitsets */
+};
+
 /* from pp_linkset.c */
 typedef struct pp_linkset_node_s
 {
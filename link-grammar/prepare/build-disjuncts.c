@@ -17,7 +17,11 @@
 #include "connectors.h"
 #include "dict-common/dict-structures.h"  // Exp_struct, exp_stringify
 #include "dict-common/dict-common.h"      // Dictionary
+#include "dict-common/dict-utils.h"       // copy_Exp
+#include "disjunct-cache.h"
 #include "disjunct-utils.h"
+#include "tokenize/word-structures.h"     // X_node
+#include "tokenize/tok-structures.h"      // Gword_struct
 #include "utilities.h"
 
 /* Temporary connectors used while converting expressions into disjunct lists */
@@ -26,7 +30,11 @@ struct Tconnector_struct
 {
 	Tconnector * next;
 	Exp *e; /* a CONNECTOR_type element from which to get the connector  */
-	Connector *tracon; /* the created tracon, set through memory sharing */
+	union
+	{
+		Connector *tracon; /* the created tracon, set through memory sharing */
+		size_t template_con; /* the same for disjunct templates (index+1) */
+	};
 };
 
 typedef struct clause_struct Clause;
@@ -45,6 +53,9 @@ typedef struct
 	int exp_pos;
 } clause_context;
 
+#define CLAUSE_POOL_SIZE 4096
+#define TCONNECTOR_POOL_SIZE 32768
+
 #ifdef DEBUG
 static void print_Tconnector_list(Tconnector * e);
 static void print_clause_list(Clause * c);
@@ -317,49 +328,20 @@ build_disjunct(Sentence sent, Clause * cl, const char * wstring,
 	return dis;
 }
 
-Disjunct *build_disjuncts_for_exp(Sentence sent, Exp* exp, const char *word,
-                                  const gword_set *gs, float cost_cutoff,
-                                  Parse_Options opts)
+/**
+ * If there are more than the allowed number of disjuncts,
+ * then randomly discard some of them. The discard is done
+ * with uniform weighting; no attempt to look at the cost
+ * is made. A fancier algo might selectively choose those
+ * with lower cost.
+ * We don't care for now that this doesn't work if discnt > INT_MAX.
+ */
+static Disjunct *trim_disjuncts(Sentence sent, Disjunct *dis,
+                                Parse_Options opts)
 {
-	clause_context ct = { 0 };
-	ct.cost_cutoff = cost_cutoff;
-
-	if (unlikely(sent->Clause_pool == NULL))
-	{
-		ct.Clause_pool = pool_new(__func__, "Clause",
-		                          /*num_elements*/4096, sizeof(Clause),
-		                          /*zero_out*/false, /*align*/false, /*exact*/false);
-		ct.Tconnector_pool = pool_new(__func__, "Tconnector",
-		                              /*num_elements*/32768, sizeof(Tconnector),
-		                              /*zero_out*/false, /*align*/false, /*exact*/false);
-		/* Keep for freeing at the caller. */
-		sent->Clause_pool = ct.Clause_pool;
-		sent->Tconnector_pool = ct.Tconnector_pool;
-	}
-	else
-	{
-		ct.Clause_pool = sent->Clause_pool;
-		ct.Tconnector_pool = sent->Tconnector_pool;
-	}
-
-	// printf("%s\n", lg_exp_stringify(exp));
-	Clause *c = build_clause(exp, &ct, NULL);
-	// print_clause_list(c);
-	Disjunct *dis = build_disjunct(sent, c, word, gs, cost_cutoff, opts);
-	// print_disjunct_list(dis);
-	pool_reuse(ct.Clause_pool);
-	pool_reuse(ct.Tconnector_pool);
-
 	/* We are done, in the convectional case. */
 	if (NULL == opts || 0 == opts->max_disjuncts) return dis;
 
-	/* If there are more than the allowed number of disjuncts,
-	 * then randomly discard some of them. The discard is done
-	 * with uniform weighting; no attempt to look at the cost
-	 * is made. A fancier algo might selectively choose those
-	 * with lower cost.
-	 * We don't care for now that this doesn't work if discnt > INT_MAX.
-	 */
 	int maxdj = opts->max_disjuncts;
 	int discnt = count_disjuncts(dis);
 	if (discnt < maxdj) return dis;
@@ -383,6 +365,388 @@ Disjunct *build_disjuncts_for_exp(Sentence sent, Exp* exp, const char *word,
 	return kdis;
 }
 
+/**
+ * Set the memory pools of \p ct to those of \p sent, creating them on
+ * first use. They are freed by the caller (see build_sentence_disjuncts()).
+ */
+static void sentence_clause_pools(Sentence sent, clause_context *ct)
+{
+	if (unlikely(sent->Clause_pool == NULL))
+	{
+		sent->Clause_pool = pool_new(__func__, "Clause",
+		                          /*num_elements*/CLAUSE_POOL_SIZE, sizeof(Clause),
+		                          /*zero_out*/false, /*align*/false, /*exact*/false);
+		sent->Tconnector_pool = pool_new(__func__, "Tconnector",
+		                              /*num_elements*/TCONNECTOR_POOL_SIZE, sizeof(Tconnector),
+		                              /*zero_out*/false, /*align*/false, /*exact*/false);
+	}
+
+	ct->Clause_pool = sent->Clause_pool;
+	ct->Tconnector_pool = sent->Tconnector_pool;
+}
+
+Disjunct *build_disjuncts_for_exp(Sentence sent, Exp* exp, const char *word,
+                                  const gword_set *gs, float cost_cutoff,
+                                  Parse_Options opts)
+{
+	clause_context ct = { 0 };
+	ct.cost_cutoff = cost_cutoff;
+	sentence_clause_pools(sent, &ct);
+
+	// printf("%s\n", lg_exp_stringify(exp));
+	Clause *c = build_clause(exp, &ct, NULL);
+	// print_clause_list(c);
+	Disjunct *dis = build_disjunct(sent, c, word, gs, cost_cutoff, opts);
+	// print_disjunct_list(dis);
+	pool_reuse(ct.Clause_pool);
+	pool_reuse(ct.Tconnector_pool);
+
+	return trim_disjuncts(sent, dis, opts);
+}
+
+/* ======================================================================== */
+/* Disjunct templates.
+ *
+ * A disjunct template is the expansion of a dictionary expression into
+ * disjuncts, independently of any sentence. Templates are kept in the
+ * dictionary disjunct cache (see disjunct-cache.c), so the expression
+ * of frequent words doesn't need to get expanded again for each
+ * sentence.
+ *
+ * The template connectors refer to the connectors of the expression by
+ * their ordinal (depth-first) position in it. The sentence copy of the
+ * expression gets the same positions (see disjunct_cache_key()), so the
+ * connectors which remain after expression pruning can be identified.
+ * A template disjunct is used only if all of its connectors remain.
+ * Since expression pruning only removes connectors (along with the AND
+ * subexpressions that contain them), this yields the same disjuncts, in
+ * the same order, as building them from the pruned expression.
+ */
+
+typedef struct
+{
+	const condesc_t *desc;
+	bool multi;
+} Template_leaf;
+
+typedef struct
+{
+	int32_t next;          /* Index of the next connector (-1 if none) */
+	uint16_t pos;          /* Position in the expression */
+} Template_connector;
+
+typedef struct
+{
+	float cost;
+	int32_t left, right;   /* Index of the first connector (-1 if none) */
+} Template_disjunct;
+
+struct Disjunct_template_s
+{
+	size_t size;           /* Total memory, for the cache accounting */
+	unsigned int num_leaves;
+	unsigned int num_connectors;
+	unsigned int num_disjuncts;
+	Template_leaf *leaf;   /* Indexed by position in the expression */
+	Template_connector *con;
+	Template_disjunct *dis;
+};
+
+size_t disjunct_template_size(const Disjunct_template *dt)
+{
+	return dt->size;
+}
+
+/**
+ * Eliminate unary nodes exactly like purge_Exp() does, so the
+ * disjuncts will be generated in the order they are generated from
+ * the pruned sentence expressions.
+ */
+static void eliminate_unary_nodes(Exp *e)
+{
+	if (e->type == CONNECTOR_type) return;
+
+	for (Exp *opd = e->operand_first; opd != NULL; opd = opd->operand_next)
+		eliminate_unary_nodes(opd);
+
+	if ((e->operand_first != NULL) && (e->operand_first->operand_next == NULL))
+	{
+		Exp *opd = e->operand_first;
+		opd->cost += e->cost;
+		opd->operand_next = e->operand_next;
+		*e = *opd;
+	}
+}
+
+static void set_template_leaves(const Exp *e, Template_leaf *leaf)
+{
+	if (e->type == CONNECTOR_type)
+	{
+		leaf[e->pos].desc = e->condesc;
+		leaf[e->pos].multi = e->multi;
+		return;
+	}
+
+	for (Exp *opd = e->operand_first; opd != NULL; opd = opd->operand_next)
+		set_template_leaves(opd, leaf);
+}
+
+/**
+ * Build a disjunct template for the dictionary expression \p dict_exp.
+ * The template connector lists share memory in the same way the
+ * disjuncts that build_disjunct() builds do.
+ * Return NULL if the expression is too big to be cached.
+ */
+Disjunct_template *build_disjunct_template(const Exp *dict_exp,
+                                           float cost_cutoff,
+                                           Parse_Options opts)
+{
+	if (count_clause(dict_exp) > DISJUNCT_CACHE_MAX_CLAUSES) return NULL;
+
+	Pool_desc *Exp_pool = pool_new(__func__, "Exp",
+	                               /*num_elements*/256, sizeof(Exp),
+	                               /*zero_out*/false, /*align*/false, /*exact*/false);
+	clause_context ct = { 0 };
+	ct.cost_cutoff = cost_cutoff;
+	ct.Clause_pool = pool_new(__func__, "Clause",
+	                          /*num_elements*/CLAUSE_POOL_SIZE, sizeof(Clause),
+	                          /*zero_out*/false, /*align*/false, /*exact*/false);
+	ct.Tconnector_pool = pool_new(__func__, "Tconnector",
+	                              /*num_elements*/TCONNECTOR_POOL_SIZE, sizeof(Tconnector),
+	                              /*zero_out*/false, /*align*/false, /*exact*/false);
+
+	Exp *e = copy_Exp((Exp *)dict_exp, Exp_pool, opts); /* Dialect costs */
+	eliminate_unary_nodes(e);
+	Clause *clist = build_clause(e, &ct, NULL);
+
+	size_t num_clauses = 0, num_tconnectors = 0;
+	for (Clause *cl = clist; cl != NULL; cl = cl->next)
+	{
+		num_clauses++;
+		for (Tconnector *t = cl->c; t != NULL; t = t->next)
+			num_tconnectors++;
+	}
+
+	Template_connector *con = malloc(num_tconnectors * sizeof(*con) + 1);
+	Template_disjunct *dis = malloc(num_clauses * sizeof(*dis) + 1);
+	unsigned int num_con = 0, num_dis = 0;
+
+	for (Clause *cl = clist; cl != NULL; cl = cl->next)
+	{
+		if (unlikely(NULL == cl->c)) continue; /* no connectors */
+		if (cl->totcost > cost_cutoff) continue;
+
+		Template_disjunct *ndis = &dis[num_dis++];
+		ndis->cost = cl->totcost;
+		ndis->left = ndis->right = -1;
+
+		/* Like build_disjunct(), but using connector indices. */
+		int32_t *jet[2] = { &ndis->left, &ndis->right };
+		bool is_tracon[2] = { false, false };
+		for (Tconnector *t = cl->c; t != NULL; t = t->next)
+		{
+			int idir = ('+' == t->e->dir);
+
+			if (is_tracon[idir]) continue; /* this direction is complete */
+			if (0 != t->template_con)
+			{
+				*(jet[idir]) = (int32_t)(t->template_con - 1);
+				is_tracon[idir] = true;
+				continue;
+			}
+
+			Template_connector *n = &con[num_con];
+			t->template_con = ++num_con;
+			n->pos = t->e->pos;
+			n->next = -1;
+
+			*(jet[idir]) = (int32_t)(n - con);
+			jet[idir] = &n->next;
+		}
+	}
+
+	Disjunct_template *dt;
+	size_t leaf_size = ct.exp_pos * sizeof(*dt->leaf);
+	size_t con_size = num_con * sizeof(*dt->con);
+	size_t dis_size = num_dis * sizeof(*dt->dis);
+	size_t size = sizeof(*dt) + leaf_size + con_size + dis_size;
+
+	dt = malloc(size);
+	dt->size = size;
+	dt->num_leaves = ct.exp_pos;
+	dt->num_connectors = num_con;
+	dt->num_disjuncts = num_dis;
+	dt->leaf = (Template_leaf *)&dt[1];
+	dt->dis = (Template_disjunct *)((char *)dt->leaf + leaf_size);
+	dt->con = (Template_connector *)((char *)dt->dis + dis_size);
+	set_template_leaves(e, dt->leaf);
+	memcpy(dt->con, con, con_size);
+	memcpy(dt->dis, dis, dis_size);
+
+	free(con);
+	free(dis);
+	pool_recycle(ct.Clause_pool);
+	pool_recycle(ct.Tconnector_pool);
+	pool_recycle(Exp_pool);
+
+	return dt;
+}
+
+/**
+ * Record the farthest_word of each connector that remained in the
+ * (pruned) sentence expression \p e, indexed by its expression position.
+ */
+static void mark_remaining_leaves(const Exp *e, int *leaf_fw)
+{
+	if (e->type == CONNECTOR_type)
+	{
+		leaf_fw[e->pos] = e->farthest_word;
+		return;
+	}
+
+	for (Exp *opd = e->operand_first; opd != NULL; opd = opd->operand_next)
+		mark_remaining_leaves(opd, leaf_fw);
+}
+
+/**
+ * Return true iff all the connectors of the template connector list
+ * starting at \p i remained in the sentence expression.
+ */
+static bool template_connector_alive(const Disjunct_template *dt, int32_t i,
+                                     const int *leaf_fw, int8_t *alive)
+{
+	if (i < 0) return true;
+	if (0 != alive[i]) return (alive[i] > 0);
+
+	const Template_connector *tc = &dt->con[i];
+	bool a = (leaf_fw[tc->pos] >= 0) &&
+	         template_connector_alive(dt, tc->next, leaf_fw, alive);
+	alive[i] = a ? 1 : -1;
+
+	return a;
+}
+
+static Connector *template_connector(Sentence sent,
+                                     const Disjunct_template *dt, int32_t i,
+                                     const int *leaf_fw, Connector **tracon)
+{
+	if (i < 0) return NULL;
+	if (NULL != tracon[i]) return tracon[i];
+
+	const Template_connector *tc = &dt->con[i];
+	Connector *n = connector_new(sent->Connector_pool, dt->leaf[tc->pos].desc);
+	tracon[i] = n;
+
+	n->exp_pos = tc->pos;
+	n->multi = dt->leaf[tc->pos].multi;
+	n->farthest_word = leaf_fw[tc->pos];
+	n->next = template_connector(sent, dt, tc->next, leaf_fw, tracon);
+
+	return n;
+}
+
+/**
+ * Return the number of Tconnector_pool elements that
+ * build_disjuncts_from_template() needs for its work arrays.
+ */
+static size_t template_work_elements(const Disjunct_template *dt)
+{
+	size_t bytes = dt->num_connectors * (sizeof(Connector *) + sizeof(int8_t)) +
+	               dt->num_leaves * sizeof(int);
+
+	return bytes / sizeof(Tconnector) + 1;
+}
+
+/**
+ * Build the disjuncts of the X_node \p x out of the template \p dt.
+ * The work arrays are allocated from the sentence Tconnector pool
+ * (which isn't otherwise in use between building the disjuncts of the
+ * X_nodes), so template_work_elements() of it must be less than
+ * TCONNECTOR_POOL_SIZE.
+ */
+static Disjunct *build_disjuncts_from_template(Sentence sent,
+                                               const Disjunct_template *dt,
+                                               const X_node *x)
+{
+	clause_context ct;
+	sentence_clause_pools(sent, &ct);
+
+	/* Pointers first, for their alignment. */
+	Connector **tracon =
+		pool_alloc_vec(ct.Tconnector_pool, template_work_elements(dt));
+	int *leaf_fw = (int *)&tracon[dt->num_connectors];
+	int8_t *alive = (int8_t *)&leaf_fw[dt->num_leaves];
+
+	memset(tracon, 0, dt->num_connectors * sizeof(*tracon));
+	memset(alive, 0, dt->num_connectors * sizeof(*alive));
+	for (unsigned int i = 0; i < dt->num_leaves; i++)
+		leaf_fw[i] = -1;
+	mark_remaining_leaves(x->exp, leaf_fw);
+
+	Disjunct *dis = NULL;
+	for (unsigned int i = 0; i < dt->num_disjuncts; i++)
+	{
+		const Template_disjunct *td = &dt->dis[i];
+
+		if (!template_connector_alive(dt, td->left, leaf_fw, alive) ||
+		    !template_connector_alive(dt, td->right, leaf_fw, alive))
+			continue;
+
+		Disjunct *ndis = pool_alloc(sent->Disjunct_pool);
+		ndis->left = template_connector(sent, dt, td->left, leaf_fw, tracon);
+		ndis->right = template_connector(sent, dt, td->right, leaf_fw, tracon);
+		ndis->word_string = x->string;
+		ndis->cost = td->cost;
+		ndis->is_category = 0;
+		ndis->originating_gword = (gword_set *)&x->word->gword_set_head;
+		ndis->next = dis;
+		dis = ndis;
+	}
+
+	pool_reuse(ct.Tconnector_pool);
+
+	return dis;
+}
+
+/**
+ * Build the disjuncts of the X_node \p x, using the dictionary disjunct
+ * cache if possible.
+ * @param dialect The dialect identifier from disjunct_cache_dialect().
+ */
+Disjunct *build_disjuncts_for_x_node(Sentence sent, const X_node *x,
+                                     float cost_cutoff, unsigned int dialect,
+                                     Parse_Options opts)
+{
+	Disjunct_cache *dc = sent->dict->disjunct_cache;
+
+	if ((NULL == dc) || (NULL == x->dict_exp))
+	{
+		return build_disjuncts_for_exp(sent, x->exp, x->string,
+		                               &x->word->gword_set_head,
+		                               cost_cutoff, opts);
+	}
+
+	const Disjunct_template *dt;
+	bool full;
+	if (!disjunct_cache_lookup(dc, x->dict_exp, cost_cutoff, dialect, &dt,
+	                           &full) && !full)
+	{
+		Disjunct_template *ndt =
+			build_disjunct_template(x->dict_exp, cost_cutoff, opts);
+		dt = disjunct_cache_insert(dc, x->dict_exp, cost_cutoff, dialect, ndt);
+	}
+
+	if ((NULL == dt) || (template_work_elements(dt) >= TCONNECTOR_POOL_SIZE))
+	{
+		return build_disjuncts_for_exp(sent, x->exp, x->string,
+		                               &x->word->gword_set_head,
+		                               cost_cutoff, opts);
+	}
+
+	Disjunct *dis = build_disjuncts_from_template(sent, dt, x);
+	return trim_disjuncts(sent, dis, opts);
+}
+
 #ifdef DEBUG
 /* Misc printing functions, useful for debugging */
 
@@ -16,8 +16,15 @@
 
 #include "api-types.h"
 #include "link-includes.h"
+#include "disjunct-cache.h"             // Disjunct_template
+#include "tokenize/word-structures.h"   // X_node
 
 Disjunct *build_disjuncts_for_exp(Sentence sent, Exp *, const char *,
                                   const gword_set *, float cost_cutoff,
                                   Parse_Options opts);
+Disjunct *build_disjuncts_for_x_node(Sentence, const X_node *, float,
+                                     unsigned int, Parse_Options);
+
+Disjunct_template *build_disjunct_template(const Exp *, float, Parse_Options);
+size_t disjunct_template_size(const Disjunct_template *);
 #endif /* _LINKGRAMMAR_BUILD_DISJUNCTS_H */
@@ -0,0 +1,346 @@
+/*************************************************************************/
+/* Copyright (c) 2026 The Link Grammar project                           */
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+/*
+ * Dictionary disjunct cache.
+ *
+ * Expanding the dictionary expressions of the sentence words into
+ * disjuncts is done for each sentence anew, even though the
+ * expressions of frequent words (like "the" and "of") are the same in
+ * every sentence. This cache keeps disjunct templates (see
+ * build-disjuncts.c) of dictionary expressions, so they are expanded
+ * only once per dictionary.
+ *
+ * The cache key is the dictionary expression, the dialect setup (which
+ * changes the expression costs) and the disjunct cost cutoff. The
+ * templates are immutable once inserted, and are freed only when the
+ * dictionary is deleted, so the sentences can use them without holding
+ * the cache lock. When the memory cap is reached, no more templates are
+ * inserted.
+ */
+
+#include <stdint.h>
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+#include <threads.h>
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+#include "api-structures.h"             // Parse_Options_s
+#include "build-disjuncts.h"            // disjunct_template_size
+#include "dict-common/dialect.h"        // dialect_info
+#include "dict-common/dict-common.h"    // Dictionary_s
+#include "disjunct-cache.h"
+#include "error.h"
+#include "utilities.h"
+
+#define D_DCACHE 6 /* Debug level for this file */
+
+typedef struct cache_entry_s cache_entry;
+struct cache_entry_s
+{
+	cache_entry *next;
+	const Exp *exp;
+	float cost_cutoff;
+	unsigned int dialect;
+	Disjunct_template *dt;     /* NULL if the expression is not cacheable */
+};
+
+struct Disjunct_cache_s
+{
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	mtx_t mutex;
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+	cache_entry **table;
+	size_t table_size;         /* Always a power of 2 */
+	size_t num_entries;
+
+	size_t bytes;              /* Memory used by the templates */
+	size_t max_bytes;
+
+	/* Dialect cost tables that have been seen (the dialect id is the
+	 * index in this array plus 1). */
+	float **dialect;
+	unsigned int num_dialects;
+	unsigned int num_dialect_tags;
+
+	size_t hits;
+	size_t misses;
+};
+
+static inline void cache_lock(Disjunct_cache *dc)
+{
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	mtx_lock(&dc->mutex);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+}
+
+static inline void cache_unlock(Disjunct_cache *dc)
+{
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	mtx_unlock(&dc->mutex);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+}
+
+/**
+ * Create a disjunct cache for \p dict.
+ * Return NULL if the dictionary expressions are not permanent (dynamic
+ * dictionaries), in generation mode, or if disabled by the
+ * "disjunct-cache:0" test option.
+ */
+Disjunct_cache *disjunct_cache_create(Dictionary dict)
+{
+	if (IS_DYNAMIC_DICT(dict) || IS_GENERATION(dict)) return NULL;
+
+	size_t max_mbytes = DISJUNCT_CACHE_DEFAULT_SIZE;
+	const char *cache_size = test_enabled("disjunct-cache");
+	if ((NULL != cache_size) && (':' == cache_size[0]))
+		max_mbytes = (size_t)atoi(cache_size+1);
+	if (0 == max_mbytes) return NULL;
+
+	Disjunct_cache *dc = malloc(sizeof(*dc));
+	memset(dc, 0, sizeof(*dc));
+
+	dc->max_bytes = max_mbytes * 1024 * 1024;
+	dc->table_size = 1024;
+	dc->table = calloc(dc->table_size, sizeof(*dc->table));
+	dc->num_dialect_tags = dict->dialect_tag.num;
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	mtx_init(&dc->mutex, mtx_plain);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+	return dc;
+}
+
+void disjunct_cache_print_stats(Disjunct_cache *dc)
+{
+	if (NULL == dc) return;
+
+	prt_error("Info: Disjunct cache: %zu entries, %zuK bytes, "
+	          "%zu hits, %zu misses\n",
+	          dc->num_entries, dc->bytes / 1024, dc->hits, dc->misses);
+}
+
+void disjunct_cache_delete(Disjunct_cache *dc)
+{
+	if (NULL == dc) return;
+
+	for (size_t i = 0; i < dc->table_size; i++)
+	{
+		cache_entry *next;
+		for (cache_entry *e = dc->table[i]; e != NULL; e = next)
+		{
+			next = e->next;
+			free(e->dt);
+			free(e);
+		}
+	}
+	free(dc->table);
+
+	for (unsigned int i = 0; i < dc->num_dialects; i++)
+		free(dc->dialect[i]);
+	free(dc->dialect);
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	mtx_destroy(&dc->mutex);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+	free(dc);
+}
+
+/**
+ * Assign the connectors of \p e their depth-first position.
+ * Return false if there are too many connectors.
+ */
+static bool set_exp_positions(Exp *e, unsigned int *pos)
+{
+	if (e->type == CONNECTOR_type)
+	{
+		if (*pos > UINT16_MAX) return false;
+		e->pos = (*pos)++;
+		return true;
+	}
+
+	for (Exp *opd = e->operand_first; opd != NULL; opd = opd->operand_next)
+	{
+		if (!set_exp_positions(opd, pos)) return false;
+	}
+
+	return true;
+}
+
+/**
+ * Prepare the sentence copy \p e of the dictionary expression \p dict_exp
+ * for using the disjunct cache.
+ * @return The cache key for it, or NULL if it cannot be cached.
+ */
+const Exp *disjunct_cache_key(Dictionary dict, const Exp *dict_exp, Exp *e)
+{
+	if (NULL == dict->disjunct_cache) return NULL;
+
+	unsigned int pos = 0;
+	if (!set_exp_positions(e, &pos)) return NULL;
+
+	return dict_exp;
+}
+
+/**
+ * Return the identifier of the dialect setup of \p opts.
+ * Expressions that are expanded using different dialect cost tables
+ * are cached separately.
+ */
+unsigned int disjunct_cache_dialect(Disjunct_cache *dc, Parse_Options opts)
+{
+	const float *cost_table = opts->dialect.cost_table;
+	if ((NULL == cost_table) || (0 == dc->num_dialect_tags)) return 0;
+
+	/* Element 0 of the cost table is not used. */
+	size_t table_size = dc->num_dialect_tags * sizeof(*cost_table);
+	unsigned int id;
+
+	cache_lock(dc);
+	for (id = 0; id < dc->num_dialects; id++)
+	{
+		if (0 == memcmp(dc->dialect[id], cost_table + 1, table_size))
+			break;
+	}
+	if (id == dc->num_dialects)
+	{
+		dc->dialect = realloc(dc->dialect,
+		                      (dc->num_dialects + 1) * sizeof(*dc->dialect));
+		dc->dialect[id] = malloc(table_size);
+		memcpy(dc->dialect[id], cost_table + 1, table_size);
+		dc->num_dialects++;
+	}
+	cache_unlock(dc);
+
+	return id + 1;
+}
+
+static size_t cache_hash(const Exp *exp, float cost_cutoff,
+                         unsigned int dialect, size_t table_size)
+{
+	uint32_t cutoff_bits;
+	memcpy(&cutoff_bits, &cost_cutoff, sizeof(cutoff_bits));
+
+	size_t h = (size_t)((uintptr_t)exp / sizeof(Exp));
+	h = h * 31 + cutoff_bits;
+	h = h * 31 + dialect;
+	h ^= h >> 17;
+
+	return h & (table_size - 1);
+}
+
+static cache_entry *cache_find(Disjunct_cache *dc, const Exp *exp,
+                               float cost_cutoff, unsigned int dialect)
+{
+	size_t h = cache_hash(exp, cost_cutoff, dialect, dc->table_size);
+
+	for (cache_entry *e = dc->table[h]; e != NULL; e = e->next)
+	{
+		if ((e->exp == exp) && (e->cost_cutoff == cost_cutoff) &&
+		    (e->dialect == dialect))
+			return e;
+	}
+
+	return NULL;
+}
+
+static void cache_grow(Disjunct_cache *dc)
+{
+	size_t new_size = dc->table_size * 2;
+	cache_entry **new_table = calloc(new_size, sizeof(*new_table));
+
+	for (size_t i = 0; i < dc->table_size; i++)
+	{
+		cache_entry *next;
+		for (cache_entry *e = dc->table[i]; e != NULL; e = next)
+		{
+			next = e->next;
+			size_t h = cache_hash(e->exp, e->cost_cutoff, e->dialect, new_size);
+			e->next = new_table[h];
+			new_table[h] = e;
+		}
+	}
+
+	free(dc->table);
+	dc->table = new_table;
+	dc->table_size = new_size;
+	lgdebug(+D_DCACHE, "Disjunct cache table grown to %zu\n", new_size);
+}
+
+/**
+ * Look up the disjunct template of \p exp.
+ * @param dtp[out] The cached template (NULL if \p exp is not cacheable).
+ * @param full[out] On a miss, whether the memory cap of the cache has
+ * been reached (so the template should not be inserted).
+ * @return true if found, false otherwise.
+ */
+bool disjunct_cache_lookup(Disjunct_cache *dc, const Exp *exp,
+                           float cost_cutoff, unsigned int dialect,
+                           const Disjunct_template **dtp, bool *full)
+{
+	cache_lock(dc);
+	cache_entry *e = cache_find(dc, exp, cost_cutoff, dialect);
+	if (NULL != e)
+	{
+		dc->hits++;
+	}
+	else
+	{
+		dc->misses++;
+		*full = (dc->bytes >= dc->max_bytes);
+	}
+	cache_unlock(dc);
+
+	*dtp = (NULL == e) ? NULL : e->dt;
+	return (NULL != e);
+}
+
+/**
+ * Insert the template \p dt of \p exp into the cache. The cache takes
+ * the ownership of \p dt (which may be NULL to mark \p exp as not
+ * cacheable).
+ * @return The cached template. It may be another template of \p exp,
+ * if such a one has been inserted meanwhile by another thread.
+ */
+const Disjunct_template *
+disjunct_cache_insert(Disjunct_cache *dc, const Exp *exp, float cost_cutoff,
+                      unsigned int dialect, Disjunct_template *dt)
+{
+	cache_lock(dc);
+	cache_entry *e = cache_find(dc, exp, cost_cutoff, dialect);
+	if (NULL != e)
+	{
+		cache_unlock(dc);
+		free(dt);
+		return e->dt;
+	}
+
+	if (dc->num_entries >= dc->table_size) cache_grow(dc);
+
+	e = malloc(sizeof(*e));
+	e->exp = exp;
+	e->cost_cutoff = cost_cutoff;
+	e->dialect = dialect;
+	e->dt = dt;
+
+	size_t h = cache_hash(exp, cost_cutoff, dialect, dc->table_size);
+	e->next = dc->table[h];
+	dc->table[h] = e;
+
+	dc->num_entries++;
+	dc->bytes += sizeof(*e);
+	if (NULL != dt) dc->bytes += disjunct_template_size(dt);
+	cache_unlock(dc);
+
+	return dt;
+}
@@ -0,0 +1,40 @@
+/*************************************************************************/
+/* Copyright (c) 2026 The Link Grammar project                           */
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+#ifndef _LINKGRAMMAR_DISJUNCT_CACHE_H
+#define _LINKGRAMMAR_DISJUNCT_CACHE_H
+
+#include "api-types.h"
+#include "link-includes.h"
+
+/* The default memory cap of the disjunct cache, in MB.
+ * Can be changed (0 to disable) by the "disjunct-cache:N" test option. */
+#define DISJUNCT_CACHE_DEFAULT_SIZE 64
+
+/* Dictionary expressions that expand to more clauses than that are not
+ * cached (their expansion before expression pruning is too costly). */
+#define DISJUNCT_CACHE_MAX_CLAUSES 32768
+
+typedef struct Disjunct_cache_s Disjunct_cache;
+typedef struct Disjunct_template_s Disjunct_template;
+
+Disjunct_cache *disjunct_cache_create(Dictionary);
+void disjunct_cache_delete(Disjunct_cache *);
+
+const Exp *disjunct_cache_key(Dictionary, const Exp *, Exp *);
+unsigned int disjunct_cache_dialect(Disjunct_cache *, Parse_Options);
+bool disjunct_cache_lookup(Disjunct_cache *, const Exp *, float, unsigned int,
+                           const Disjunct_template **, bool *);
+const Disjunct_template *disjunct_cache_insert(Disjunct_cache *, const Exp *,
+                                               float, unsigned int,
+                                               Disjunct_template *);
+void disjunct_cache_print_stats(Disjunct_cache *);
+#endif /* _LINKGRAMMAR_DISJUNCT_CACHE_H */
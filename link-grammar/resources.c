@@ -42,7 +42,6 @@ int getrusage(int who, struct rusage *rusage);
 #include "resources.h"
 #include "utilities.h"
 
-#define MAX_PARSE_TIME_UNLIMITED -1
 #define MAX_MEMORY_UNLIMITED ((size_t) -1)
 
 /** Returns the CPU usage time, for this thread only, in seconds. */
@@ -57,6 +56,22 @@ static double current_usage_time(void)
 #endif
 }
 
+/**
+ * Returns the monotonic wall-clock time, in seconds.
+ * On Linux, CLOCK_MONOTONIC is read through the vDSO without a system
+ * call, so this is cheap enough for the checks in the parsing loops.
+ */
+static double current_wall_time(void)
+{
+#if defined CLOCK_MONOTONIC
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ((double) ts.tv_nsec) / 1000000000.0);
+#else
+	return ((double) clock())/CLOCKS_PER_SEC;
+#endif
+}
+
 Resources resources_create(void)
 {
 	Resources r;
@@ -64,6 +79,11 @@ Resources resources_create(void)
 
 	r = (Resources) xalloc(sizeof(struct Resources_s));
 	r->max_parse_time = MAX_PARSE_TIME_UNLIMITED;
+	r->max_wall_time = MAX_PARSE_TIME_UNLIMITED;
+	r->time_share = 1.0;
+	r->cancel = NULL;
+	r->wall_time_when_parse_started = current_wall_time();
+	r->next_usage_check = 0;
 	now = current_usage_time();
 	r->when_created = now;
 	r->when_last_called = now;
@@ -85,6 +105,9 @@ void resources_delete(Resources r)
 void resources_reset(Resources r)
 {
 	r->when_last_called = r->time_when_parse_started = current_usage_time();
+	r->wall_time_when_parse_started = current_wall_time();
+	r->next_usage_check = 0;
+	r->time_share = 1.0;
 	r->space_when_parse_started = get_space_in_use();
 	r->timer_expired = false;
 	r->memory_exhausted = false;
@@ -104,6 +127,8 @@ void resources_reset_space(Resources r)
 
 bool resources_exhausted(Resources r)
 {
+	if (resources_cancelled(r)) return true;
+	if (r->memory_exhausted) return true;
 	if (!r->timer_expired && !resources_timer_expired(r)) return false;
 
 	if (!r->timer_expired && (verbosity_level(D_USER_TIMES)))
@@ -132,17 +157,101 @@ bool resources_exhausted(Resources r)
 }
 #endif
 
+/**
+ * Check the wall-clock and CPU time limits.
+ * Reading the thread CPU time needs a system call. But the CPU time of
+ * the thread cannot advance faster than the wall-clock time, so it is
+ * read only when enough wall-clock time has elapsed for the CPU time
+ * limit to be possibly reached.
+ */
 bool resources_timer_expired(Resources r)
 {
-	if (r->max_parse_time == MAX_PARSE_TIME_UNLIMITED) return false;
-	else return (r->timer_expired ||
-	     (current_usage_time() - r->time_when_parse_started > r->max_parse_time));
+	if (r->timer_expired) return true;
+	if (!resources_time_limited(r)) return false;
+
+	double now = current_wall_time();
+
+	if ((r->max_wall_time != MAX_PARSE_TIME_UNLIMITED) &&
+	    (now - r->wall_time_when_parse_started >
+	     r->max_wall_time * r->time_share))
+		return true;
+
+	if ((r->max_parse_time != MAX_PARSE_TIME_UNLIMITED) &&
+	    (now >= r->next_usage_check))
+	{
+		double max_parse_time = r->max_parse_time * r->time_share;
+		double used = current_usage_time() - r->time_when_parse_started;
+		if (used > max_parse_time) return true;
+#if defined RUSAGE_THREAD
+		r->next_usage_check = now + (max_parse_time - used);
+#endif
+	}
+
+	return false;
+}
+
+bool resources_time_limited(Resources r)
+{
+	return (r->max_parse_time != MAX_PARSE_TIME_UNLIMITED) ||
+	       (r->max_wall_time != MAX_PARSE_TIME_UNLIMITED);
+}
+
+/**
+ * Limit the parse time to the given share of the time limits, without
+ * restarting the timers. Used by the anytime parsing to split the time
+ * budget between its stages.
+ */
+void resources_set_time_share(Resources r, double share)
+{
+	r->time_share = share;
+	r->next_usage_check = 0;
+	r->timer_expired = false;
+}
+
+/**
+ * Parsing of the sentence whose cancellation flag is given is about to
+ * start (NULL: it has ended). Parsing is aborted as if the resources
+ * are exhausted if the flag gets set (see sentence_cancel()).
+ * A cancelled parse is then reported as a timeout.
+ */
+void resources_set_cancel(Resources r, const cancel_flag *cancel)
+{
+	if ((NULL == cancel) && resources_cancelled(r))
+		r->timer_expired = true;
+	r->cancel = cancel;
+}
+
+bool resources_cancelled(Resources r)
+{
+	return (NULL != r->cancel) && *r->cancel;
 }
 
 bool resources_memory_exhausted(Resources r)
 {
+	if (r->memory_exhausted) return true;
 	if (r->max_memory == MAX_MEMORY_UNLIMITED) return false;
-	else return (r->memory_exhausted || (get_space_in_use() > r->max_memory));
+	else return (get_space_in_use() > r->max_memory);
+}
+
+/**
+ * Restart the timers of \p r and set its exhausted indications. For
+ * reporting in \p r the outcome of parses that used other resources.
+ */
+void resources_set_exhausted(Resources r, bool timer_expired,
+                             bool memory_exhausted)
+{
+	resources_reset(r);
+	r->timer_expired = timer_expired;
+	r->memory_exhausted = memory_exhausted;
+}
+
+/**
+ * Abort the parsing as if the memory is exhausted. For parse data
+ * structures that cannot grow anymore.
+ */
+void resources_set_memory_exhausted(Resources r)
+{
+	r->memory_exhausted = true;
 }
 
 #define RES_COL_WIDTH 52
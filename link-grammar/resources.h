@@ -16,13 +16,22 @@
 #include "api-types.h"
 #include "link-includes.h"
 
+#define MAX_PARSE_TIME_UNLIMITED -1
+
 void      print_time(Parse_Options opts, const char * s, ...) GNUC_PRINTF(2,3);
 void      print_total_space(Parse_Options opts);
 void      resources_reset(Resources r);
 void      resources_reset_space(Resources r);
 bool      resources_timer_expired(Resources r);
 bool      resources_memory_exhausted(Resources r);
+void      resources_set_memory_exhausted(Resources r);
+void      resources_set_exhausted(Resources r, bool timer_expired,
+                                  bool memory_exhausted);
 bool      resources_exhausted(Resources r);
+bool      resources_time_limited(Resources r);
+void      resources_set_time_share(Resources r, double share);
+void      resources_set_cancel(Resources r, const cancel_flag *cancel);
+bool      resources_cancelled(Resources r);
 Resources resources_create(void);
 void      resources_delete(Resources ti);
 #endif /* _RESOURCES_H */
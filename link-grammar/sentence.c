@@ -11,6 +11,10 @@
 /*                                                                       */
 /*************************************************************************/
 
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+#include <threads.h>
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
 #include "api-structures.h"
 #include "dict-common/dict-common.h"
 #include "dict-common/dict-utils.h"
@@ -23,6 +27,7 @@
 #include "resources.h"
 #include "sat-solver/sat-encoder.h"
 #include "tokenize/lookup-exprs.h"
+#include "tokenize/tok-structures.h"    // Gword, gword_set
 #include "tokenize/tokenize.h"
 #include "tokenize/wordgraph.h"         // wordgraph_delete
 #include "tokenize/word-structures.h"   // Word_struct
@@ -52,6 +57,16 @@ Sentence sentence_create(const char *input_string, Dictionary dict)
 	sent->X_node_pool = pool_new(__func__, "X_node", /*num_elements*/256,
 	                             sizeof(X_node), /*zero_out*/false,
 	                             /*align*/false, /*exact*/false);
+	sent->Gword_pool = pool_new(__func__, "Gword", /*num_elements*/256,
+	                             sizeof(Gword), /*zero_out*/false,
+	                             /*align*/false, /*exact*/false);
+	sent->gword_set_pool = pool_new(__func__, "gword_set", /*num_elements*/256,
+	                             sizeof(gword_set), /*zero_out*/false,
+	                             /*align*/false, /*exact*/false);
+	sent->Gword_list_pool = pool_new(__func__, "Gword_list",
+	                             /*num_elements*/GWORD_LIST_POOL_SIZE,
+	                             sizeof(Gword *), /*zero_out*/false,
+	                             /*align*/false, /*exact*/false);
 
 	sent->postprocessor = post_process_new(dict->base_knowledge);
 
@@ -78,17 +93,8 @@ Sentence sentence_create(const char *input_string, Dictionary dict)
 	return sent;
 }
 
-int sentence_split(Sentence sent, Parse_Options opts)
+static int split_sentence(Sentence sent, Parse_Options opts)
 {
-	/* 0 == global_rand_state denotes "repeatable rand".
-	 * If non-zero, set it here so that anysplit can use it.
-	 */
-	if (false == opts->repeatable_rand && 0 == sent->rand_state)
-	{
-		if (0 == global_rand_state) global_rand_state = 42;
-		sent->rand_state = global_rand_state;
-	}
-
 	/* Tokenize */
 	if (!separate_sentence(sent, opts))
 	{
@@ -120,10 +126,31 @@ int sentence_split(Sentence sent, Parse_Options opts)
 	return 0;
 }
 
+int sentence_split(Sentence sent, Parse_Options opts)
+{
+	/* 0 == global_rand_state denotes "repeatable rand".
+	 * If non-zero, set it here so that anysplit can use it.
+	 */
+	if (false == opts->repeatable_rand && 0 == sent->rand_state)
+	{
+		if (0 == global_rand_state) global_rand_state = 42;
+		sent->rand_state = global_rand_state;
+	}
+
+	/* The tokenizer looks up the same strings many times; with a
+	 * dynamic dictionary, look up each of them only once. */
+	dict_memo_start(sent->dict);
+	int rc = split_sentence(sent, opts);
+	dict_memo_end(sent->dict);
+
+	return rc;
+}
+
 void sentence_delete(Sentence sent)
 {
 	if (!sent) return;
 	sat_sentence_delete(sent);
+	free_deferred_linkages(sent);
 	free_sentence_disjuncts(sent, /*categories_too*/true);
 	free_words(sent);
 	wordgraph_delete(sent);
@@ -135,19 +162,21 @@ void sentence_delete(Sentence sent)
 	free(sent->disjunct_used);
 
 	global_rand_state = sent->rand_state;
-	pool_delete(sent->Match_node_pool);
-	pool_delete(sent->Table_tracon_pool);
-	pool_delete(sent->wordvec_pool);
-	pool_delete(sent->Exp_pool);
-	pool_delete(sent->X_node_pool);
+	pool_recycle(sent->Table_tracon_pool);
+	pool_recycle(sent->wordvec_pool);
+	pool_recycle(sent->Exp_pool);
+	pool_recycle(sent->X_node_pool);
+	pool_recycle(sent->Gword_pool);
+	pool_recycle(sent->gword_set_pool);
+	pool_recycle(sent->Gword_list_pool);
 
 	/* Usually the memory pools created in build_disjuncts_for_exp() are
 	 * deleted in build_sentence_disjuncts(). Delete them here in case
 	 * build_disjuncts_for_exp() is directly called. */
 	if (sent->Clause_pool != NULL)
 	{
-		pool_delete(sent->Clause_pool);
-		pool_delete(sent->Tconnector_pool);
+		pool_recycle(sent->Clause_pool);
+		pool_recycle(sent->Tconnector_pool);
 	}
 
 	// This is a hack. Should just ask the backend to "do the right
@@ -228,6 +257,106 @@ int sentence_link_cost(Sentence sent, LinkageIdx i)
 	return sent->lnkages[i].lifo.link_cost;
 }
 
+/**
+ * Return TRUE if the parse has been cut short by a timeout in the
+ * anytime parsing mode (see parse_options_set_anytime()). The
+ * linkages, if any, are then of a degraded parse, or are those that
+ * have been post-processed before the timeout.
+ */
+bool sentence_is_partial(Sentence sent)
+{
+	if (!sent) return false;
+	return sent->partial;
+}
+
+/**
+ * Abort the parsing of \p sent. This may be called from any thread,
+ * typically while sentence_parse() is running in another one. The
+ * parse then returns as if its time limit has been reached. The
+ * cancellation is not reset, so a following sentence_parse() of the
+ * same sentence (e.g. a parse with null words) returns immediately too.
+ */
+void sentence_cancel(Sentence sent)
+{
+	if (!sent) return;
+	sent->cancel = true;
+}
+
+/* Anytime parsing: The share of the time budget that is given to the
+ * full parse, and the maximum link length of the degraded parse that
+ * is done in the remaining time. */
+#define ANYTIME_FULL_PARSE_SHARE 0.5
+#define ANYTIME_SHORT_LENGTH 8
+
+static void parse_sentence(Sentence sent, Parse_Options opts)
+{
+	for (WordIdx w = 0; w < sent->length; w++)
+	{
+		for (X_node *x = sent->word[w].x; x != NULL; x = x->next)
+			set_connector_farthest_word(x->exp, (int)w, (int)sent->length, opts);
+	}
+
+	/* Expressions were set up during the tokenize stage.
+	 * Prune them, and then parse.
+	 */
+	expression_prune(sent, opts);
+	print_time(opts, "Finished expression pruning");
+
+#if USE_SAT_SOLVER
+	if (opts->use_sat_solver)
+	{
+		sat_parse(sent, opts);
+	}
+	else
+#endif
+	{
+		classic_parse(sent, opts);
+	}
+	print_time(opts, "Finished parse");
+}
+
+/**
+ * Parse in a part of the time budget, and if this doesn't yield valid
+ * linkages in time, parse again in the remaining time with all the
+ * links short and null words allowed. This is much faster, and usually
+ * still yields linkages that are useful for most of the sentence.
+ * The second parse can start from the expressions of the first one,
+ * since the first parse was less restricted.
+ */
+static void anytime_parse(Sentence sent, Parse_Options opts)
+{
+	Resources r = opts->resources;
+
+	resources_set_time_share(r, ANYTIME_FULL_PARSE_SHARE);
+	parse_sentence(sent, opts);
+	bool expired = resources_timer_expired(r);
+	resources_set_time_share(r, 1.0);
+	if (!expired || (sent->num_valid_linkages > 0)) return;
+	if (resources_cancelled(r)) return;
+
+	if (verbosity >= D_USER_TIMES)
+		prt_error("#### Anytime: Parsing with short links\n");
+
+	bool all_short = opts->all_short;
+	size_t short_length = opts->short_length;
+	short min_null_count = opts->min_null_count;
+	short max_null_count = opts->max_null_count;
+
+	opts->all_short = true;
+	opts->short_length = MIN(short_length, ANYTIME_SHORT_LENGTH);
+	opts->min_null_count = 0;
+	opts->max_null_count = (short)sent->length;
+
+	free_sentence_disjuncts(sent, /*categories_too*/true);
+	parse_sentence(sent, opts);
+	sent->partial = true;
+
+	opts->all_short = all_short;
+	opts->short_length = short_length;
+	opts->min_null_count = min_null_count;
+	opts->max_null_count = max_null_count;
+}
+
 int sentence_parse(Sentence sent, Parse_Options opts)
 {
 	Dictionary dict = sent->dict;
@@ -281,30 +410,23 @@ int sentence_parse(Sentence sent, Parse_Options opts)
 		return -2;
 	}
 
+	free_deferred_linkages(sent);
 	resources_reset(opts->resources);
-	for (WordIdx w = 0; w < sent->length; w++)
-	{
-		for (X_node *x = sent->word[w].x; x != NULL; x = x->next)
-			set_connector_farthest_word(x->exp, (int)w, (int)sent->length, opts);
-	}
-
-	/* Expressions were set up during the tokenize stage.
-	 * Prune them, and then parse.
-	 */
-	expression_prune(sent, opts);
-	print_time(opts, "Finished expression pruning");
+	resources_set_cancel(opts->resources, &sent->cancel);
+	sent->partial = false;
 
+	bool anytime = opts->anytime && resources_time_limited(opts->resources) &&
+	               !IS_GENERATION(dict);
 #if USE_SAT_SOLVER
-	if (opts->use_sat_solver)
-	{
-		sat_parse(sent, opts);
-	}
-	else
+	if (opts->use_sat_solver) anytime = false;
 #endif
-	{
-		classic_parse(sent, opts);
-	}
-	print_time(opts, "Finished parse");
+
+	if (anytime)
+		anytime_parse(sent, opts);
+	else
+		parse_sentence(sent, opts);
+
+	resources_set_cancel(opts->resources, NULL);
 
 	if ((verbosity > 0) && !IS_GENERATION(sent->dict) &&
 	   (PARSE_NUM_OVERFLOW < sent->num_linkages_found))
@@ -316,3 +438,290 @@ int sentence_parse(Sentence sent, Parse_Options opts)
 	}
 	return sent->num_valid_linkages;
 }
+
+/***************************************************************
+*
+* Parsing a batch of sentences
+*
+****************************************************************/
+
+/* The resources state of the parse of a batch sentence. */
+typedef struct
+{
+	bool timer_expired;
+	bool memory_exhausted;
+} batch_status;
+
+/**
+ * Parse one sentence of a batch.
+ * @param status[out] Its resources state, also accumulated in \p total.
+ * @return The number of valid linkages (negative on error).
+ */
+static int batch_parse_one(Sentence sent, Parse_Options opts,
+                           batch_status *status, batch_status *total)
+{
+	int num_linkages = -1;
+	if (0 == sentence_split(sent, opts))
+		num_linkages = sentence_parse(sent, opts);
+
+	status->timer_expired = parse_options_timer_expired(opts);
+	status->memory_exhausted = parse_options_memory_exhausted(opts);
+	total->timer_expired |= status->timer_expired;
+	total->memory_exhausted |= status->memory_exhausted;
+
+	return num_linkages;
+}
+
+/**
+ * Set the resources state of \p opts to \p status, as if it has been
+ * used for the parse that \p status belongs to.
+ */
+static void batch_set_status(Parse_Options opts, const batch_status *status)
+{
+	resources_set_exhausted(opts->resources, status->timer_expired,
+	                        status->memory_exhausted);
+}
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+/* Sentences that have been parsed but not delivered yet are kept in a
+ * ring of that many slots per thread. This bounds the memory that is
+ * used when a sentence takes much longer than the ones after it. */
+#define BATCH_SLOTS_PER_THREAD 4
+
+typedef struct
+{
+	Sentence sent;
+	int num_linkages;
+	batch_status status;
+	bool ready;
+} batch_slot;
+
+typedef struct
+{
+	Dictionary dict;
+	const char **sentences;
+	size_t num_sentences;
+
+	mtx_t mutex;
+	cnd_t parsed;              /* A sentence is ready for delivery */
+	cnd_t slot_free;           /* A sentence has been delivered */
+	size_t next;               /* The next sentence to parse */
+	size_t delivered;          /* Number of delivered sentences */
+	batch_slot *slot;          /* Sentence i is in slot[i % num_slots] */
+	size_t num_slots;
+} batch_s;
+
+typedef struct
+{
+	batch_s *batch;
+	Parse_Options opts;        /* A private copy */
+	batch_status total;        /* Of all the sentences it has parsed */
+} batch_worker;
+
+/**
+ * Make a private copy of \p opts for a batch parsing thread (the
+ * parse functions modify it).
+ * Parse_Options has no internal state of its own (the deferred-linkage
+ * mode of linkage_iter_create() is kept in the Sentence), so a plain
+ * copy parses exactly like sentence_parse() with \p opts.
+ */
+static Parse_Options batch_options_copy(Parse_Options opts)
+{
+	Parse_Options copy = malloc(sizeof(*copy));
+
+	*copy = *opts;
+	copy->resources = resources_create();
+	copy->resources->max_parse_time = opts->resources->max_parse_time;
+	copy->resources->max_wall_time = opts->resources->max_wall_time;
+	copy->resources->max_memory = opts->resources->max_memory;
+	copy->dialect = (dialect_info){ .conf = strdup(opts->dialect.conf) };
+
+	return copy;
+}
+
+static int batch_parse_worker(void *arg)
+{
+	batch_worker *bw = arg;
+	batch_s *b = bw->batch;
+
+	mtx_lock(&b->mutex);
+	while (b->next < b->num_sentences)
+	{
+		size_t i = b->next;
+		if (i >= b->delivered + b->num_slots)
+		{
+			cnd_wait(&b->slot_free, &b->mutex);
+			continue;
+		}
+		b->next++;
+		mtx_unlock(&b->mutex);
+
+		Sentence sent = sentence_create(b->sentences[i], b->dict);
+		batch_status status;
+		int num_linkages = batch_parse_one(sent, bw->opts, &status, &bw->total);
+
+		mtx_lock(&b->mutex);
+		batch_slot *bs = &b->slot[i % b->num_slots];
+		bs->sent = sent;
+		bs->num_linkages = num_linkages;
+		bs->status = status;
+		bs->ready = true;
+		cnd_broadcast(&b->parsed);
+	}
+	mtx_unlock(&b->mutex);
+
+	return 0;
+}
+
+/**
+ * Parse the batch using \p num_threads parsing threads. The calling
+ * thread only delivers the results.
+ * @return true on success, false if no thread could be started.
+ */
+static bool batch_parse_threads(Dictionary dict, Parse_Options opts,
+                                const char **sentences, size_t num_sentences,
+                                unsigned int num_threads,
+                                sentence_batch_callback cb, void *data)
+{
+	batch_s b = (batch_s)
+	{
+		.dict = dict,
+		.sentences = sentences,
+		.num_sentences = num_sentences,
+		.num_slots = num_threads * BATCH_SLOTS_PER_THREAD,
+	};
+	b.slot = calloc(b.num_slots, sizeof(*b.slot));
+	mtx_init(&b.mutex, mtx_plain);
+	cnd_init(&b.parsed);
+	cnd_init(&b.slot_free);
+
+	thrd_t *thread = malloc(num_threads * sizeof(*thread));
+	batch_worker *bw = malloc(num_threads * sizeof(*bw));
+	unsigned int num_started = 0;
+
+	for (unsigned int i = 0; i < num_threads; i++)
+	{
+		bw[num_started] =
+			(batch_worker){ .batch = &b, .opts = batch_options_copy(opts) };
+		if (thrd_success !=
+		    thrd_create(&thread[num_started], batch_parse_worker,
+		                &bw[num_started]))
+		{
+			parse_options_delete(bw[num_started].opts);
+			break;
+		}
+		num_started++;
+	}
+
+	if (0 < num_started)
+	{
+		for (size_t i = 0; i < num_sentences; i++)
+		{
+			batch_slot *bs = &b.slot[i % b.num_slots];
+
+			mtx_lock(&b.mutex);
+			while (!bs->ready)
+				cnd_wait(&b.parsed, &b.mutex);
+			batch_slot result = *bs;
+			bs->ready = false;
+			mtx_unlock(&b.mutex);
+
+			batch_set_status(opts, &result.status);
+			if (NULL != cb) cb(result.sent, i, result.num_linkages, data);
+			sentence_delete(result.sent);
+
+			mtx_lock(&b.mutex);
+			b.delivered++;
+			cnd_broadcast(&b.slot_free);
+			mtx_unlock(&b.mutex);
+		}
+	}
+
+	batch_status total = { false };
+	for (unsigned int i = 0; i < num_started; i++)
+	{
+		thrd_join(thread[i], NULL);
+		total.timer_expired |= bw[i].total.timer_expired;
+		total.memory_exhausted |= bw[i].total.memory_exhausted;
+		parse_options_delete(bw[i].opts);
+	}
+	if (0 < num_started) batch_set_status(opts, &total);
+
+	cnd_destroy(&b.slot_free);
+	cnd_destroy(&b.parsed);
+	mtx_destroy(&b.mutex);
+	free(b.slot);
+	free(bw);
+	free(thread);
+
+	return (0 < num_started);
+}
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+/**
+ * Parse \p num_sentences sentences, using up to \p num_threads threads.
+ * For each sentence, \p cb is invoked in the calling thread with the
+ * sentence, its index in \p sentences, its number of valid linkages
+ * (negative on an error, like sentence_parse()) and \p data.
+ * The callbacks are invoked in the input order, and the sentence is
+ * deleted when its callback returns.
+ *
+ * The parsing threads are created once per batch, so their thread-local
+ * caches are reused across its sentences. Each thread parses with its
+ * own copy of \p opts.
+ *
+ * During each callback, parse_options_timer_expired() and
+ * parse_options_memory_exhausted() of \p opts report on the parse of
+ * its sentence. After the batch, they report whether this happened to
+ * any of the sentences. This doesn't depend on the number of threads.
+ *
+ * @return The number of sentences, or -1 on an argument error.
+ */
+int sentence_batch_parse(Dictionary dict, Parse_Options opts,
+                         const char **sentences, size_t num_sentences,
+                         int num_threads, sentence_batch_callback cb,
+                         void *data)
+{
+	if ((NULL == dict) || (NULL == opts) ||
+	    ((NULL == sentences) && (0 < num_sentences)))
+	{
+		prt_error("Error: sentence_batch_parse(): Bad argument\n");
+		return -1;
+	}
+	if (INT_MAX < num_sentences)
+	{
+		prt_error("Error: sentence_batch_parse(): Too many sentences\n");
+		return -1;
+	}
+
+	/* Done here once instead of in each options copy. */
+	if (opts->disjunct_cost == UNINITIALIZED_MAX_DISJUNCT_COST)
+		opts->disjunct_cost = dict->default_max_disjunct_cost;
+	if (opts->max_disjuncts == UNINITIALIZED_MAX_DISJUNCTS)
+		opts->max_disjuncts = dict->default_max_disjuncts;
+
+	if (num_threads < 1) num_threads = 1;
+	if ((size_t)num_threads > num_sentences) num_threads = (int)num_sentences;
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	if ((1 < num_threads) &&
+	    batch_parse_threads(dict, opts, sentences, num_sentences,
+	                        (unsigned int)num_threads, cb, data))
+	{
+		return (int)num_sentences;
+	}
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+	batch_status status, total = { false };
+	for (size_t i = 0; i < num_sentences; i++)
+	{
+		Sentence sent = sentence_create(sentences[i], dict);
+		int num_linkages = batch_parse_one(sent, opts, &status, &total);
+
+		if (NULL != cb) cb(sent, i, num_linkages, data);
+		sentence_delete(sent);
+	}
+	batch_set_status(opts, &total);
+
+	return (int)num_sentences;
+}
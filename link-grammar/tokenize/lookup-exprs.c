@@ -19,6 +19,7 @@
 #include "dict-common/dict-utils.h"
 #include "error.h"
 #include "lookup-exprs.h"
+#include "prepare/disjunct-cache.h"     // disjunct_cache_key
 #include "print/print.h"
 #include "tokenize.h"
 #include "tok-structures.h"
@@ -95,6 +96,7 @@ static X_node * build_word_expressions(Sentence sent, const Gword *w,
 		y->next = x;
 		x = y;
 		x->exp = copy_Exp(dn->exp, sent->Exp_pool, opts);
+		x->dict_exp = disjunct_cache_key(dict, dn->exp, x->exp);
 		if (NULL == s)
 		{
 			x->string = dn->string;
@@ -127,6 +129,7 @@ static X_node * build_word_expressions(Sentence sent, const Gword *w,
 		X_node * y = pool_alloc(sent->X_node_pool);
 		y->next = NULL;
 		y->exp = make_zeroary_node(sent->Exp_pool);
+		y->dict_exp = NULL;
 	}
 
 	assert(NULL != x, "Word '%s': NULL X-node", w->subword);
@@ -194,6 +197,7 @@ static void add_empty_word(Sentence sent, X_node *x)
 		Exp *an = make_and_node(sent->Exp_pool, zn, x->exp);
 
 		x->exp = an;
+		x->dict_exp = NULL; /* Not a dictionary expression anymore. */
 	}
 }
 
@@ -334,6 +338,25 @@ bool build_sentence_expressions(Sentence sent, Parse_Options opts)
 		}
 	}
 
+	// Look up all the alternatives at once, if the dict can do that
+	if (NULL != dict->lookup_bulk)
+	{
+		size_t num = 0;
+		for (size_t i=0; i<sent->length; i++)
+			num += altlen(sent->word[i].alternatives);
+
+		const char **alts = malloc(num * sizeof(*alts));
+		num = 0;
+		for (size_t i=0; i<sent->length; i++)
+		{
+			const char **a = sent->word[i].alternatives;
+			for (size_t j=0; NULL != a && NULL != a[j]; j++)
+				alts[num++] = a[j];
+		}
+		dict_memo_prefetch(dict, alts, num);
+		free(alts);
+	}
+
 	// Perform X_node lookups
 	bool have_unknown_words = false;
 	dict->start_lookup(dict, sent);
@@ -0,0 +1,714 @@
+/*************************************************************************/
+/* Copyright (c) 2026 The Link Grammar project                           */
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+/*
+ * Spell-guess suggestions for unknown words.
+ *
+ * The suggestions come either from the spell checker (Hunspell or
+ * Aspell, see spellcheck-*.c), or, if the "spell-symdel" test option
+ * is set at dictionary creation, from a symmetric-delete index over the
+ * dictionary words. The latter proposes only dictionary words (or
+ * run-ons of two dictionary words), and doesn't need a spell checker.
+ *
+ * Symmetric delete: each dictionary word is indexed under itself and
+ * under each of its strings with one character deleted. A query word
+ * is looked up the same way; words sharing an index string with it are
+ * at edit distance of at most 2 from it, which covers a single
+ * insertion, deletion, substitution or transposition. The candidates
+ * are then verified and ranked by their actual edit distance.
+ *
+ * The suggestions (including no suggestions, and the indication that
+ * the word is known to the spell checker) are cached per word, since
+ * the same unknown words tend to repeat and getting suggestions is
+ * slow. The cache is bounded; the least-recently-used entry is evicted
+ * when it is full. It is shared by all the sentences of the dictionary,
+ * so the suggestions are copied out of it.
+ */
+
+#include <stdint.h>
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+#include <threads.h>
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+#include "dict-common/dict-common.h"    // Dictionary_s
+#include "dict-common/dict-defines.h"   // SUBSCRIPT_MARK
+#include "error.h"
+#include "spell-guess.h"
+#include "spellcheck.h"
+#include "utilities.h"
+
+#define D_SPELL 6 /* Debug level for this file */
+
+#define SYMDEL_MAX_CHARS 32         /* Longer words are not handled */
+#define SYMDEL_MAX_DISTANCE 2
+#define SYMDEL_MAX_SUGGESTIONS 15
+
+typedef struct
+{
+	uint32_t hash;
+	uint32_t word;             /* Index in words[] plus 1 (0: empty) */
+} delete_entry;
+
+typedef struct
+{
+	char *text;                /* The words, each one NUL-terminated */
+	size_t text_size;
+	uint32_t *word;            /* Word offsets in text[] */
+	size_t num_words;
+
+	uint32_t *word_table;      /* Index in word[] plus 1 (0: empty) */
+	size_t word_table_mask;
+
+	delete_entry *del_table;
+	size_t del_table_mask;
+	size_t num_deletes;
+} Symdel_index;
+
+typedef struct spell_entry_s spell_entry;
+struct spell_entry_s
+{
+	spell_entry *next;         /* Hash bucket chain */
+	spell_entry *lru_prev;     /* More recently used */
+	spell_entry *lru_next;     /* Less recently used */
+	size_t hash;
+
+	char *word;
+	char **sug;
+	int num_sug;               /* -1: The word is known */
+};
+
+struct Spell_guess_s
+{
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	mtx_t mutex;
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+	Dictionary dict;
+	bool use_symdel;
+	Symdel_index *symdel;      /* Built on first use */
+
+	spell_entry **table;
+	size_t table_size;         /* Always a power of 2 */
+	size_t num_entries;
+	size_t max_entries;
+
+	spell_entry *lru_first;    /* Most recently used */
+	spell_entry *lru_last;     /* Least recently used */
+
+	size_t hits;
+	size_t misses;
+	size_t evictions;
+};
+
+static inline void cache_lock(Spell_guess *sg)
+{
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	mtx_lock(&sg->mutex);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+}
+
+static inline void cache_unlock(Spell_guess *sg)
+{
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	mtx_unlock(&sg->mutex);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+}
+
+/* ======================================================================= */
+/* Symmetric-delete index */
+
+/** The characters of a word, each packed (as bytes) in an uint32_t. */
+typedef struct
+{
+	uint32_t c[SYMDEL_MAX_CHARS+1];
+	uint8_t pos[SYMDEL_MAX_CHARS+2]; /* Byte offset of each character */
+	size_t n;
+} char_array;
+
+/**
+ * Split the first \p len bytes of \p s to characters.
+ * Return false if it has too many characters.
+ */
+static bool split_chars(char_array *ca, const char *s, size_t len)
+{
+	size_t b = 0;
+
+	ca->n = 0;
+	while (b < len)
+	{
+		if (ca->n > SYMDEL_MAX_CHARS) return false;
+
+		int cl = utf8_charlen(&s[b]);
+		if ((cl <= 0) || (b + cl > len)) cl = 1; /* Invalid UTF-8 */
+
+		uint32_t c = 0;
+		for (int i = 0; i < cl; i++)
+			c = (c << 8) | (unsigned char)s[b+i];
+		ca->pos[ca->n] = (uint8_t)b;
+		ca->c[ca->n++] = c;
+		b += cl;
+	}
+	ca->pos[ca->n] = (uint8_t)b;
+
+	return true;
+}
+
+static uint32_t hash_bytes(uint32_t h, const char *s, size_t len)
+{
+	for (size_t i = 0; i < len; i++)
+		h = (h ^ (unsigned char)s[i]) * 16777619u;
+	return h;
+}
+
+/** Hash \p s with its character \p i deleted (no deletion if i < 0). */
+static uint32_t delete_hash(const char *s, const char_array *ca, int i)
+{
+	uint32_t h = 2166136261u;
+
+	if (i < 0) return hash_bytes(h, s, ca->pos[ca->n]);
+
+	h = hash_bytes(h, s, ca->pos[i]);
+	return hash_bytes(h, s + ca->pos[i+1], ca->pos[ca->n] - ca->pos[i+1]);
+}
+
+/**
+ * Return true if \p s (of length \p len) is a word that can be a spell
+ * guess: Not a macro, an idiom, a morpheme or punctuation.
+ */
+static bool is_guessable(const char *s, size_t len)
+{
+	if ((0 == len) || (len > 4 * SYMDEL_MAX_CHARS)) return false;
+
+	for (size_t i = 0; i < len; i++)
+	{
+		unsigned char c = (unsigned char)s[i];
+		if (c >= 0x80) continue;
+		if (((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z'))) continue;
+		if ((0 < i) && (i < len-1) && ((c == '\'') || (c == '-'))) continue;
+		return false;
+	}
+
+	return true;
+}
+
+static size_t base_len(const char *s)
+{
+	const char *sm = strchr(s, SUBSCRIPT_MARK);
+	return (NULL == sm) ? strlen(s) : (size_t)(sm - s);
+}
+
+static const char *symdel_word(const Symdel_index *si, uint32_t w)
+{
+	return &si->text[si->word[w]];
+}
+
+/** Return the index of \p s (of length \p len) in \p si, or -1. */
+static ssize_t symdel_find(const Symdel_index *si, const char *s, size_t len)
+{
+	uint32_t h = hash_bytes(2166136261u, s, len);
+
+	for (size_t i = h & si->word_table_mask; ; i = (i + 1) & si->word_table_mask)
+	{
+		if (0 == si->word_table[i]) return -1;
+
+		uint32_t w = si->word_table[i] - 1;
+		const char *ws = symdel_word(si, w);
+		if ((0 == strncmp(ws, s, len)) && ('\0' == ws[len])) return w;
+	}
+}
+
+static size_t count_nodes(const Dict_node *dn, size_t *text_size)
+{
+	size_t n = 0;
+
+	for (; dn != NULL; dn = dn->right)
+	{
+		n += 1 + count_nodes(dn->left, text_size);
+		*text_size += base_len(dn->string) + 1;
+	}
+
+	return n;
+}
+
+static void collect_words(Symdel_index *si, const Dict_node *dn)
+{
+	for (; dn != NULL; dn = dn->right)
+	{
+		collect_words(si, dn->left);
+
+		const char *s = dn->string;
+		size_t len = base_len(s);
+		if (!is_guessable(s, len)) continue;
+		if (-1 != symdel_find(si, s, len)) continue;
+
+		uint32_t w = (uint32_t)si->num_words++;
+		si->word[w] = (uint32_t)si->text_size;
+		memcpy(&si->text[si->text_size], s, len);
+		si->text[si->text_size + len] = '\0';
+		si->text_size += len + 1;
+
+		size_t i = hash_bytes(2166136261u, s, len) & si->word_table_mask;
+		while (0 != si->word_table[i]) i = (i + 1) & si->word_table_mask;
+		si->word_table[i] = w + 1;
+	}
+}
+
+static void symdel_insert(Symdel_index *si, uint32_t hash, uint32_t w)
+{
+	size_t i = hash & si->del_table_mask;
+	while (0 != si->del_table[i].word) i = (i + 1) & si->del_table_mask;
+	si->del_table[i] = (delete_entry){ .hash = hash, .word = w + 1 };
+}
+
+static void symdel_delete(Symdel_index *si)
+{
+	if (NULL == si) return;
+
+	free(si->text);
+	free(si->word);
+	free(si->word_table);
+	free(si->del_table);
+	free(si);
+}
+
+static Symdel_index *symdel_build(Dictionary dict)
+{
+	size_t text_size = 0;
+	size_t num_nodes = count_nodes(dict->root, &text_size);
+	if ((0 == num_nodes) || (text_size >= UINT32_MAX)) return NULL;
+
+	Symdel_index *si = malloc(sizeof(*si));
+	memset(si, 0, sizeof(*si));
+	si->text = malloc(text_size);
+	si->word = malloc(num_nodes * sizeof(*si->word));
+
+	size_t table_size = 1;
+	while (table_size < 2 * num_nodes) table_size *= 2;
+	si->word_table = calloc(table_size, sizeof(*si->word_table));
+	si->word_table_mask = table_size - 1;
+
+	collect_words(si, dict->root);
+
+	/* Index each word under itself and under its one-character deletes. */
+	char_array ca;
+	size_t num_deletes = 0;
+	for (uint32_t w = 0; w < si->num_words; w++)
+	{
+		const char *s = symdel_word(si, w);
+		if (split_chars(&ca, s, strlen(s))) num_deletes += ca.n + 1;
+	}
+
+	table_size = 1;
+	while (table_size < 2 * num_deletes) table_size *= 2;
+	si->del_table = calloc(table_size, sizeof(*si->del_table));
+	si->del_table_mask = table_size - 1;
+
+	for (uint32_t w = 0; w < si->num_words; w++)
+	{
+		const char *s = symdel_word(si, w);
+		if (!split_chars(&ca, s, strlen(s))) continue;
+
+		for (int i = -1; i < (int)ca.n; i++)
+			symdel_insert(si, delete_hash(s, &ca, i), w);
+	}
+	si->num_deletes = num_deletes;
+
+	lgdebug(+D_SPELL, "Symdel index: %zu words, %zu deletes\n",
+	        si->num_words, si->num_deletes);
+
+	return si;
+}
+
+/**
+ * Return the Damerau-Levenshtein distance (optimal string alignment)
+ * between \p a and \p b, or a value above \p max if it is above it.
+ */
+static size_t edit_distance(const char_array *a, const char_array *b,
+                            size_t max)
+{
+	size_t d[SYMDEL_MAX_CHARS+2][SYMDEL_MAX_CHARS+2];
+
+	if (((a->n > b->n) ? a->n - b->n : b->n - a->n) > max) return max + 1;
+
+	for (size_t i = 0; i <= a->n; i++) d[i][0] = i;
+	for (size_t j = 0; j <= b->n; j++) d[0][j] = j;
+
+	for (size_t i = 1; i <= a->n; i++)
+	{
+		for (size_t j = 1; j <= b->n; j++)
+		{
+			size_t cost = (a->c[i-1] == b->c[j-1]) ? 0 : 1;
+			size_t m = d[i-1][j-1] + cost;
+			if (d[i-1][j] + 1 < m) m = d[i-1][j] + 1;
+			if (d[i][j-1] + 1 < m) m = d[i][j-1] + 1;
+			if ((i > 1) && (j > 1) &&
+			    (a->c[i-1] == b->c[j-2]) && (a->c[i-2] == b->c[j-1]) &&
+			    (d[i-2][j-2] + 1 < m))
+				m = d[i-2][j-2] + 1;
+			d[i][j] = m;
+		}
+	}
+
+	return d[a->n][b->n];
+}
+
+typedef struct
+{
+	const char *word;
+	size_t distance;
+	size_t len_diff;
+	bool first_diff;           /* The first character is different */
+} candidate;
+
+static int candidate_cmp(const void *p1, const void *p2)
+{
+	const candidate *c1 = p1;
+	const candidate *c2 = p2;
+
+	if (c1->distance != c2->distance)
+		return (c1->distance < c2->distance) ? -1 : 1;
+	if (c1->len_diff != c2->len_diff)
+		return (c1->len_diff < c2->len_diff) ? -1 : 1;
+	if (c1->first_diff != c2->first_diff)
+		return c1->first_diff ? 1 : -1;
+	return strcmp(c1->word, c2->word);
+}
+
+/**
+ * Suggest dictionary words at a small edit distance from \p word, and
+ * its splits into two dictionary words (separated by a blank).
+ * Return the number of suggestions, or -1 if \p word is a dictionary
+ * word.
+ */
+static int symdel_suggest(const Symdel_index *si, const char *word,
+                          char ***sug)
+{
+	size_t len = strlen(word);
+	char_array q, ca;
+
+	*sug = NULL;
+	if (-1 != symdel_find(si, word, len)) return -1;
+	if (!split_chars(&q, word, len)) return 0;
+
+	candidate *cand = NULL;
+	size_t num_cand = 0, cand_alloced = 0;
+
+	for (int i = -1; i < (int)q.n; i++)
+	{
+		uint32_t h = delete_hash(word, &q, i);
+
+		for (size_t t = h & si->del_table_mask; 0 != si->del_table[t].word;
+		     t = (t + 1) & si->del_table_mask)
+		{
+			if (si->del_table[t].hash != h) continue;
+
+			const char *s = symdel_word(si, si->del_table[t].word - 1);
+			bool dup = false;
+			for (size_t c = 0; c < num_cand; c++)
+				if (cand[c].word == s) { dup = true; break; }
+			if (dup) continue;
+
+			split_chars(&ca, s, strlen(s));
+			size_t distance = edit_distance(&q, &ca, SYMDEL_MAX_DISTANCE);
+			if (distance > SYMDEL_MAX_DISTANCE) continue;
+
+			if (num_cand == cand_alloced)
+			{
+				cand_alloced = (0 == cand_alloced) ? 16 : 2 * cand_alloced;
+				cand = realloc(cand, cand_alloced * sizeof(*cand));
+			}
+			cand[num_cand++] = (candidate)
+			{
+				.word = s,
+				.distance = distance,
+				.len_diff = (q.n > ca.n) ? q.n - ca.n : ca.n - q.n,
+				.first_diff = (q.c[0] != ca.c[0]),
+			};
+		}
+	}
+
+	if (num_cand > 1) qsort(cand, num_cand, sizeof(*cand), candidate_cmp);
+	if (num_cand > SYMDEL_MAX_SUGGESTIONS) num_cand = SYMDEL_MAX_SUGGESTIONS;
+
+	/* Run-ons of two dictionary words. */
+	const char *runon[SYMDEL_MAX_CHARS];
+	size_t num_runons = 0;
+	for (size_t i = 1; i < q.n; i++)
+	{
+		size_t split = q.pos[i];
+		if ((-1 != symdel_find(si, word, split)) &&
+		    (-1 != symdel_find(si, word + split, len - split)))
+			runon[num_runons++] = word + split;
+	}
+
+	int n = (int)(num_runons + num_cand);
+	if (0 < n)
+	{
+		char **s = malloc(n * sizeof(*s));
+		for (size_t i = 0; i < num_runons; i++)
+		{
+			size_t split = runon[i] - word;
+			s[i] = malloc(len + 2);
+			memcpy(s[i], word, split);
+			s[i][split] = ' ';
+			strcpy(&s[i][split+1], runon[i]);
+		}
+		for (size_t i = 0; i < num_cand; i++)
+			s[num_runons + i] = strdup(cand[i].word);
+		*sug = s;
+	}
+	free(cand);
+
+	return n;
+}
+
+/* ======================================================================= */
+/* Suggestion cache */
+
+/**
+ * Create the spell guesser of \p dict.
+ * Return NULL if there is no spell checker and the "spell-symdel" test
+ * option is not set, or in generation mode.
+ */
+Spell_guess *spell_guess_create(Dictionary dict)
+{
+	if (IS_GENERATION(dict)) return NULL;
+
+	bool use_symdel = !IS_DYNAMIC_DICT(dict) &&
+		(NULL != test_enabled("spell-symdel"));
+	if (!use_symdel && (NULL == dict->spell_checker)) return NULL;
+
+	size_t max_entries = SPELL_CACHE_DEFAULT_SIZE;
+	const char *cache_size = test_enabled("spell-cache");
+	if ((NULL != cache_size) && (':' == cache_size[0]))
+		max_entries = (size_t)atoi(cache_size+1);
+
+	Spell_guess *sg = malloc(sizeof(*sg));
+	memset(sg, 0, sizeof(*sg));
+
+	sg->dict = dict;
+	sg->use_symdel = use_symdel;
+	sg->max_entries = max_entries;
+	sg->table_size = 64;
+	while (sg->table_size < max_entries) sg->table_size *= 2;
+	sg->table = calloc(sg->table_size, sizeof(*sg->table));
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	mtx_init(&sg->mutex, mtx_plain);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+	return sg;
+}
+
+void spell_guess_free_suggest(char **sug, int n)
+{
+	for (int i = 0; i < n; i++)
+		free(sug[i]);
+	free(sug);
+}
+
+static char **copy_suggest(char **sug, int n)
+{
+	if (n <= 0) return NULL;
+
+	char **copy = malloc(n * sizeof(*copy));
+	for (int i = 0; i < n; i++)
+		copy[i] = strdup(sug[i]);
+
+	return copy;
+}
+
+static void free_entry(spell_entry *e)
+{
+	spell_guess_free_suggest(e->sug, e->num_sug);
+	free(e->word);
+	free(e);
+}
+
+void spell_guess_print_stats(Spell_guess *sg)
+{
+	if (NULL == sg) return;
+
+	prt_error("Info: Spell-guess cache: %zu entries, %zu hits, %zu misses, "
+	          "%zu evictions\n",
+	          sg->num_entries, sg->hits, sg->misses, sg->evictions);
+	if (NULL != sg->symdel)
+		prt_error("Info: Spell-guess index: %zu words, %zu deletes\n",
+		          sg->symdel->num_words, sg->symdel->num_deletes);
+}
+
+void spell_guess_delete(Spell_guess *sg)
+{
+	if (NULL == sg) return;
+
+	spell_entry *next;
+	for (spell_entry *e = sg->lru_first; e != NULL; e = next)
+	{
+		next = e->lru_next;
+		free_entry(e);
+	}
+	free(sg->table);
+	symdel_delete(sg->symdel);
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	mtx_destroy(&sg->mutex);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+	free(sg);
+}
+
+static size_t cache_hash(const char *word)
+{
+	size_t h = 5381;
+
+	for (const char *p = word; *p != '\0'; p++)
+		h = h * 33 + (unsigned char)*p;
+	h ^= h >> 17;
+
+	return h;
+}
+
+static spell_entry *cache_find(Spell_guess *sg, const char *word, size_t hash)
+{
+	for (spell_entry *e = sg->table[hash & (sg->table_size - 1)];
+	     e != NULL; e = e->next)
+	{
+		if ((e->hash == hash) && (0 == strcmp(e->word, word)))
+			return e;
+	}
+
+	return NULL;
+}
+
+static void lru_unlink(Spell_guess *sg, spell_entry *e)
+{
+	if (NULL == e->lru_prev)
+		sg->lru_first = e->lru_next;
+	else
+		e->lru_prev->lru_next = e->lru_next;
+
+	if (NULL == e->lru_next)
+		sg->lru_last = e->lru_prev;
+	else
+		e->lru_next->lru_prev = e->lru_prev;
+}
+
+static void lru_push(Spell_guess *sg, spell_entry *e)
+{
+	e->lru_prev = NULL;
+	e->lru_next = sg->lru_first;
+	if (NULL == sg->lru_first)
+		sg->lru_last = e;
+	else
+		sg->lru_first->lru_prev = e;
+	sg->lru_first = e;
+}
+
+/** Evict the least-recently-used entry. */
+static void cache_evict(Spell_guess *sg)
+{
+	spell_entry *e = sg->lru_last;
+
+	spell_entry **p = &sg->table[e->hash & (sg->table_size - 1)];
+	while (*p != e) p = &(*p)->next;
+	*p = e->next;
+	lru_unlink(sg, e);
+
+	sg->num_entries--;
+	sg->evictions++;
+	free_entry(e);
+}
+
+/** Get the suggestions for \p word from the spell checker or the index. */
+static int get_suggestions(Spell_guess *sg, const char *word, char ***sug)
+{
+	*sug = NULL;
+
+	if (sg->use_symdel)
+	{
+		cache_lock(sg);
+		if (NULL == sg->symdel)
+		{
+			sg->symdel = symdel_build(sg->dict);
+			if (NULL == sg->symdel) sg->use_symdel = false;
+		}
+		cache_unlock(sg);
+		if (NULL == sg->symdel) return 0;
+
+		return symdel_suggest(sg->symdel, word, sug);
+	}
+
+	void *spell_checker = sg->dict->spell_checker;
+	if (NULL == spell_checker) return 0;
+	if (spellcheck_test(spell_checker, word)) return -1;
+
+	char **alternates = NULL;
+	int n = spellcheck_suggest(spell_checker, &alternates, word);
+	*sug = copy_suggest(alternates, n);
+	if (alternates) spellcheck_free_suggest(spell_checker, alternates, n);
+
+	return n;
+}
+
+/**
+ * Get the spelling suggestions for \p word.
+ * Return -1 if the word is known to the spell checker (and then there
+ * are no suggestions), else the number of suggestions. Multi-word
+ * (run-on) suggestions are separated by blanks.
+ *
+ * The suggestions (if any) are returned in \p sug, which the caller
+ * owns and should free with spell_guess_free_suggest().
+ */
+int spell_guess_suggest(Spell_guess *sg, const char *word, char ***sug)
+{
+	if (0 == sg->max_entries) return get_suggestions(sg, word, sug);
+
+	size_t hash = cache_hash(word);
+
+	cache_lock(sg);
+	spell_entry *e = cache_find(sg, word, hash);
+	if (NULL != e)
+	{
+		sg->hits++;
+		lru_unlink(sg, e);
+		lru_push(sg, e);
+		int n = e->num_sug;
+		*sug = copy_suggest(e->sug, n);
+		cache_unlock(sg);
+
+		return n;
+	}
+	sg->misses++;
+	cache_unlock(sg);
+
+	int n = get_suggestions(sg, word, sug);
+
+	cache_lock(sg);
+	if (NULL == cache_find(sg, word, hash)) /* Not added concurrently */
+	{
+		if (sg->num_entries == sg->max_entries) cache_evict(sg);
+
+		e = malloc(sizeof(*e));
+		e->hash = hash;
+		e->word = strdup(word);
+		e->sug = copy_suggest(*sug, n);
+		e->num_sug = n;
+
+		spell_entry **bucket = &sg->table[hash & (sg->table_size - 1)];
+		e->next = *bucket;
+		*bucket = e;
+		lru_push(sg, e);
+		sg->num_entries++;
+	}
+	cache_unlock(sg);
+
+	return n;
+}
@@ -0,0 +1,30 @@
+/*************************************************************************/
+/* Copyright (c) 2026 The Link Grammar project                           */
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+#ifndef _LINKGRAMMAR_SPELL_GUESS_H
+#define _LINKGRAMMAR_SPELL_GUESS_H
+
+#include "api-types.h"
+#include "link-includes.h"
+
+/* The default maximum number of words in the spell-guess cache.
+ * Can be changed (0 to disable) by the "spell-cache:N" test option. */
+#define SPELL_CACHE_DEFAULT_SIZE 4096
+
+typedef struct Spell_guess_s Spell_guess;
+
+Spell_guess *spell_guess_create(Dictionary);
+void spell_guess_delete(Spell_guess *);
+void spell_guess_print_stats(Spell_guess *);
+
+int spell_guess_suggest(Spell_guess *, const char *, char ***);
+void spell_guess_free_suggest(char **, int);
+#endif /* _LINKGRAMMAR_SPELL_GUESS_H */
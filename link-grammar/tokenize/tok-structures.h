@@ -16,6 +16,7 @@
 #define _TOK_STRUCTURES_H_
 
 #include <stddef.h>
+#include <stdint.h>
 #include "api-types.h"
 #include "link-includes.h"
 
@@ -33,10 +34,9 @@
  * Memory management:
  * A copy-on-write semantics is used when constructing a new gword_set.  It
  * means that all the gword sets with one element are shared.  These gword
- * sets are part of the Gword structure. Copied and added element are
- * alloc'ed and chained. The result is that the chain_next of the gword
- * sets that are part of each gword contain the list of alloc'ed elements -
- * to be used in gword_set_delete() called *only* in sentence_delete().
+ * sets are part of the Gword structure. Copied and added elements are
+ * allocated from the gword_set pool of the sentence, which is freed
+ * *only* with its wordgraph (in sentence_delete()).
  * This ensures that the gword_set of connectors doesn't get stale when
  * their disjuncts are deleted and later restored in one-step parse when
  * min_null_count=0 and max_null count>0 (see classic_parse()).
@@ -45,10 +45,9 @@ struct gword_set
 {
 	Gword *o_gword;
 	struct gword_set *next;
-	struct gword_set *chain_next;
 };
 
-gword_set *gword_set_union(gword_set *, gword_set *);
+gword_set *gword_set_union(Sentence, gword_set *, gword_set *);
 
 typedef enum
 {
@@ -164,6 +163,8 @@ struct Gword_struct
 	const Gword **hier_position; /* Unsplit_word/alternative_id pointer list, up
 	                                to the original sentence word. */
 	size_t hier_depth;           /* Number of pointer pairs in hier_position */
+	const uint64_t *alt_bitmap;  /* Alternatives bitmaps - see
+	                                wordgraph_alt_bitmaps(). NULL if none. */
 
 	/* XXX Experimental. Only used after the linkage (by compute_chosen_words())
 	 * for an element in the linkage display wordgraph path that represents
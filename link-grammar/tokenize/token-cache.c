@@ -0,0 +1,526 @@
+/*************************************************************************/
+/* Copyright (c) 2026 The Link Grammar project                           */
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+/*
+ * Tokenization cache.
+ *
+ * separate_word() strips punctuation, splits affixes, and does the
+ * capitalization handling, regex guessing and spell guessing anew for
+ * each occurrence of a word, even though the result depends only on
+ * the word string, a few Gword fields and a few options. Since natural
+ * text is Zipfian, most words have been seen before.
+ *
+ * So the tokenization of a word is recorded as the list of its calls
+ * to issue_word_alternative() and the final state (status etc.) of the
+ * word and of the subwords it created. On the next occurrence of the
+ * same word with the same key (see Token_key), the calls are replayed
+ * and the final state is restored, which reproduces exactly the same
+ * wordgraph. The created subwords are tokenized in turn, so they are
+ * looked up in the cache too.
+ *
+ * The cache is bounded; the least-recently-used entry is evicted when
+ * it is full. Entries are reference counted, so a sentence can replay
+ * an entry without holding the cache lock.
+ */
+
+#include <stdint.h>
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+#include <threads.h>
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+#include "api-structures.h"             // Sentence_s
+#include "dict-common/dict-common.h"    // Dictionary_s
+#include "error.h"
+#include "token-cache.h"
+#include "tokenize.h"                   // issue_word_alternative
+#include "utilities.h"
+
+#define D_TCACHE 6 /* Debug level for this file */
+
+typedef struct
+{
+	const char *label;
+	const char **token;        /* Prefixes, then stems, then suffixes */
+	int num[3];                /* Number of prefixes, stems, suffixes */
+	int target;                /* -1: The word; else a created subword */
+} Issue_record;
+
+typedef struct
+{
+	const char *regex_name;
+	unsigned int status;
+	Morpheme_type morpheme_type;
+	Tokenizing_step tokenizing_step;
+} Word_state;
+
+typedef struct token_entry_s token_entry;
+struct token_entry_s
+{
+	token_entry *next;         /* Hash bucket chain */
+	token_entry *lru_prev;     /* More recently used */
+	token_entry *lru_next;     /* Less recently used */
+	size_t hash;
+
+	char *word;
+	Token_key key;
+
+	Issue_record *issue;
+	size_t num_issues;
+
+	/* [0] is the word itself, then the created subwords in their
+	 * creation order. */
+	Word_state *state;
+	size_t num_states;
+
+	unsigned int refcount;     /* Sentences currently replaying it */
+	bool evicted;              /* To be freed when refcount drops to 0 */
+};
+
+struct Token_cache_s
+{
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	mtx_t mutex;
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+	token_entry **table;
+	size_t table_size;         /* Always a power of 2 */
+	size_t num_entries;
+	size_t max_entries;
+
+	token_entry *lru_first;    /* Most recently used */
+	token_entry *lru_last;     /* Least recently used */
+
+	size_t hits;
+	size_t misses;
+	size_t evictions;
+};
+
+/* The tokenization of a word in progress (see separate_sentence()). */
+struct Token_recording_s
+{
+	Gword *word;
+	Gword *mark;               /* The last word before the recording */
+	size_t hash;
+	Token_key key;
+
+	Issue_record *issue;
+	size_t num_issues;
+	size_t issues_alloced;
+
+	bool bad;                  /* Cannot be replayed */
+};
+
+static inline void cache_lock(Token_cache *tc)
+{
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	mtx_lock(&tc->mutex);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+}
+
+static inline void cache_unlock(Token_cache *tc)
+{
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	mtx_unlock(&tc->mutex);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+}
+
+/**
+ * Create a tokenization cache for \p dict.
+ * Return NULL for dictionaries whose content may change (dynamic
+ * dictionaries), in generation mode, for random morphology (anysplit),
+ * or if disabled by the "token-cache:0" test option.
+ */
+Token_cache *token_cache_create(Dictionary dict)
+{
+	if (IS_DYNAMIC_DICT(dict) || IS_GENERATION(dict)) return NULL;
+	if ((NULL != dict->affix_table) && (NULL != dict->affix_table->anysplit))
+		return NULL;
+
+	size_t max_entries = TOKEN_CACHE_DEFAULT_SIZE;
+	const char *cache_size = test_enabled("token-cache");
+	if ((NULL != cache_size) && (':' == cache_size[0]))
+		max_entries = (size_t)atoi(cache_size+1);
+	if (0 == max_entries) return NULL;
+
+	Token_cache *tc = malloc(sizeof(*tc));
+	memset(tc, 0, sizeof(*tc));
+
+	tc->max_entries = max_entries;
+	tc->table_size = 64;
+	while (tc->table_size < max_entries) tc->table_size *= 2;
+	tc->table = calloc(tc->table_size, sizeof(*tc->table));
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	mtx_init(&tc->mutex, mtx_plain);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+	return tc;
+}
+
+static void free_issues(Issue_record *issue, size_t num_issues)
+{
+	for (size_t i = 0; i < num_issues; i++)
+	{
+		int num_tokens = issue[i].num[0] + issue[i].num[1] + issue[i].num[2];
+		for (int t = 0; t < num_tokens; t++)
+			free((char *)issue[i].token[t]);
+		free(issue[i].token);
+		free((char *)issue[i].label);
+	}
+	free(issue);
+}
+
+static void free_entry(token_entry *e)
+{
+	free_issues(e->issue, e->num_issues);
+	free(e->state);
+	free(e->word);
+	free(e);
+}
+
+void token_cache_print_stats(Token_cache *tc)
+{
+	if (NULL == tc) return;
+
+	prt_error("Info: Token cache: %zu entries, %zu hits, %zu misses, "
+	          "%zu evictions\n",
+	          tc->num_entries, tc->hits, tc->misses, tc->evictions);
+}
+
+void token_cache_delete(Token_cache *tc)
+{
+	if (NULL == tc) return;
+
+	token_entry *next;
+	for (token_entry *e = tc->lru_first; e != NULL; e = next)
+	{
+		next = e->lru_next;
+		free_entry(e);
+	}
+	free(tc->table);
+
+#if HAVE_THREADS_H && !__EMSCRIPTEN__
+	mtx_destroy(&tc->mutex);
+#endif /* HAVE_THREADS_H && !__EMSCRIPTEN__ */
+
+	free(tc);
+}
+
+static size_t cache_hash(const char *word, const Token_key *key)
+{
+	size_t h = 5381;
+
+	for (const char *p = word; *p != '\0'; p++)
+		h = h * 33 + (unsigned char)*p;
+	h = h * 31 + (size_t)((uintptr_t)key->regex_name / sizeof(void *));
+	h = h * 31 + key->split_counter;
+	h = h * 31 + key->status;
+	h = h * 31 + key->morpheme_type;
+	h = h * 31 + key->tokenizing_step;
+	h = h * 31 + (size_t)key->use_spell_guess;
+	h = h * 31 + (key->capitalizable * 2 + key->dictcap);
+	h ^= h >> 17;
+
+	return h;
+}
+
+static bool key_eq(const Token_key *k1, const Token_key *k2)
+{
+	return (k1->regex_name == k2->regex_name) &&
+	       (k1->split_counter == k2->split_counter) &&
+	       (k1->status == k2->status) &&
+	       (k1->morpheme_type == k2->morpheme_type) &&
+	       (k1->tokenizing_step == k2->tokenizing_step) &&
+	       (k1->use_spell_guess == k2->use_spell_guess) &&
+	       (k1->capitalizable == k2->capitalizable) &&
+	       (k1->dictcap == k2->dictcap);
+}
+
+static token_entry *cache_find(Token_cache *tc, const char *word,
+                               const Token_key *key, size_t hash)
+{
+	for (token_entry *e = tc->table[hash & (tc->table_size - 1)];
+	     e != NULL; e = e->next)
+	{
+		if ((e->hash == hash) && key_eq(&e->key, key) &&
+		    (0 == strcmp(e->word, word)))
+			return e;
+	}
+
+	return NULL;
+}
+
+static void lru_unlink(Token_cache *tc, token_entry *e)
+{
+	if (NULL == e->lru_prev)
+		tc->lru_first = e->lru_next;
+	else
+		e->lru_prev->lru_next = e->lru_next;
+
+	if (NULL == e->lru_next)
+		tc->lru_last = e->lru_prev;
+	else
+		e->lru_next->lru_prev = e->lru_prev;
+}
+
+static void lru_push(Token_cache *tc, token_entry *e)
+{
+	e->lru_prev = NULL;
+	e->lru_next = tc->lru_first;
+	if (NULL == tc->lru_first)
+		tc->lru_last = e;
+	else
+		tc->lru_first->lru_prev = e;
+	tc->lru_first = e;
+}
+
+/** Evict the least-recently-used entry. */
+static void cache_evict(Token_cache *tc)
+{
+	token_entry *e = tc->lru_last;
+
+	token_entry **p = &tc->table[e->hash & (tc->table_size - 1)];
+	while (*p != e) p = &(*p)->next;
+	*p = e->next;
+	lru_unlink(tc, e);
+
+	tc->num_entries--;
+	tc->evictions++;
+	if (0 == e->refcount)
+		free_entry(e);
+	else
+		e->evicted = true;
+}
+
+static void release_entry(Token_cache *tc, token_entry *e)
+{
+	cache_lock(tc);
+	e->refcount--;
+	bool free_it = e->evicted && (0 == e->refcount);
+	cache_unlock(tc);
+
+	if (free_it) free_entry(e);
+}
+
+static void set_word_state(Gword *w, const Word_state *s)
+{
+	w->regex_name = s->regex_name;
+	w->status = s->status;
+	w->morpheme_type = s->morpheme_type;
+	w->tokenizing_step = s->tokenizing_step;
+}
+
+static void get_word_state(Word_state *s, const Gword *w)
+{
+	s->regex_name = w->regex_name;
+	s->status = w->status;
+	s->morpheme_type = w->morpheme_type;
+	s->tokenizing_step = w->tokenizing_step;
+}
+
+/**
+ * If the tokenization of word \p w with key \p key is in the cache,
+ * reproduce it and return true. Else return false.
+ */
+bool token_cache_replay(Sentence sent, Gword *w, const Token_key *key)
+{
+	Token_cache *tc = sent->dict->token_cache;
+	if (NULL == tc) return false;
+
+	size_t hash = cache_hash(w->subword, key);
+
+	cache_lock(tc);
+	token_entry *e = cache_find(tc, w->subword, key, hash);
+	if (NULL == e)
+	{
+		tc->misses++;
+		cache_unlock(tc);
+		return false;
+	}
+	tc->hits++;
+	e->refcount++;
+	lru_unlink(tc, e);
+	lru_push(tc, e);
+	cache_unlock(tc);
+
+	lgdebug(+D_TCACHE, "Replaying '%s': %zu alternatives\n",
+	        w->subword, e->num_issues);
+
+	/* The created subwords, in their creation order. */
+	Gword **created = malloc(e->num_states * sizeof(*created));
+	size_t num_created = 0;
+
+	Gword *last = sent->last_word;
+	for (size_t i = 0; i < e->num_issues; i++)
+	{
+		const Issue_record *ir = &e->issue[i];
+		Gword *target = (ir->target < 0) ? w : created[ir->target];
+
+		issue_word_alternative(sent, target, ir->label,
+		                       ir->num[0], ir->token,
+		                       ir->num[1], ir->token + ir->num[0],
+		                       ir->num[2], ir->token + ir->num[0] + ir->num[1]);
+
+		for (; last->chain_next != NULL; last = last->chain_next)
+		{
+			assert(num_created+1 < e->num_states, "Replay of '%s': "
+			       "Too many subwords", w->subword);
+			created[num_created++] = last->chain_next;
+		}
+	}
+	assert(num_created+1 == e->num_states, "Replay of '%s': "
+	       "%zu subwords instead of %zu",
+	       w->subword, num_created, e->num_states-1);
+
+	set_word_state(w, &e->state[0]);
+	for (size_t i = 0; i < num_created; i++)
+		set_word_state(created[i], &e->state[i+1]);
+
+	free(created);
+	release_entry(tc, e);
+
+	return true;
+}
+
+/**
+ * Start recording the tokenization of word \p w with key \p key.
+ * Its calls to issue_word_alternative() are recorded by
+ * token_cache_record_issue(), until token_cache_record_end() is called.
+ */
+void token_cache_record_start(Sentence sent, Gword *w, const Token_key *key)
+{
+	if (NULL == sent->dict->token_cache) return;
+
+	Token_recording *tr = malloc(sizeof(*tr));
+	memset(tr, 0, sizeof(*tr));
+	tr->word = w;
+	tr->mark = sent->last_word;
+	tr->key = *key;
+
+	sent->token_recording = tr;
+}
+
+/**
+ * Return the creation index of \p w (which must have been created
+ * since the recording has started), or -1 if it is the recorded word.
+ */
+static int created_index(const Token_recording *tr, const Gword *w)
+{
+	if (w == tr->word) return -1;
+
+	int i = 0;
+	for (const Gword *c = tr->mark->chain_next; c != NULL; c = c->chain_next)
+	{
+		if (c == w) return i;
+		i++;
+	}
+
+	return -2;
+}
+
+/** Record a call to issue_word_alternative(). */
+void token_cache_record_issue(Sentence sent, Gword *unsplit_word,
+                              const char *label,
+                              int prefnum, const char * const *prefix,
+                              int stemnum, const char * const *stem,
+                              int suffnum, const char * const *suffix)
+{
+	Token_recording *tr = sent->token_recording;
+	if (tr->bad) return;
+
+	int target = created_index(tr, unsplit_word);
+	if (-2 == target)
+	{
+		/* Not supposed to happen; just don't cache this word. */
+		lgdebug(+D_TCACHE, "Word '%s' issues alternatives of '%s'\n",
+		        tr->word->subword, unsplit_word->subword);
+		tr->bad = true;
+		return;
+	}
+
+	if (tr->num_issues == tr->issues_alloced)
+	{
+		tr->issues_alloced = 2 * tr->issues_alloced + 4;
+		tr->issue = realloc(tr->issue, tr->issues_alloced * sizeof(*tr->issue));
+	}
+
+	Issue_record *ir = &tr->issue[tr->num_issues++];
+	ir->label = strdup(label);
+	ir->target = target;
+	ir->num[0] = prefnum;
+	ir->num[1] = stemnum;
+	ir->num[2] = suffnum;
+
+	const char * const *affix[] = { prefix, stem, suffix };
+	ir->token = malloc((prefnum + stemnum + suffnum) * sizeof(*ir->token));
+
+	int t = 0;
+	for (int a = 0; a < 3; a++)
+	{
+		for (int n = 0; n < ir->num[a]; n++)
+			ir->token[t++] = strdup(affix[a][n]);
+	}
+}
+
+/**
+ * Finish the recording of the tokenization of word \p w, and put it in
+ * the cache.
+ */
+void token_cache_record_end(Sentence sent, Gword *w)
+{
+	Token_recording *tr = sent->token_recording;
+	if (NULL == tr) return;
+	sent->token_recording = NULL;
+
+	Token_cache *tc = sent->dict->token_cache;
+	if (tr->bad)
+	{
+		free_issues(tr->issue, tr->num_issues);
+		free(tr);
+		return;
+	}
+
+	token_entry *e = malloc(sizeof(*e));
+	memset(e, 0, sizeof(*e));
+	e->word = strdup(w->subword);
+	e->key = tr->key;
+	e->hash = cache_hash(e->word, &e->key);
+	e->issue = tr->issue;
+	e->num_issues = tr->num_issues;
+
+	for (const Gword *c = tr->mark; c != NULL; c = c->chain_next)
+		e->num_states++;
+	e->state = malloc(e->num_states * sizeof(*e->state));
+	get_word_state(&e->state[0], w);
+	size_t i = 1;
+	for (const Gword *c = tr->mark->chain_next; c != NULL; c = c->chain_next)
+		get_word_state(&e->state[i++], c);
+
+	free(tr);
+
+	cache_lock(tc);
+	if (NULL != cache_find(tc, e->word, &e->key, e->hash))
+	{
+		/* Inserted meanwhile by another thread. */
+		cache_unlock(tc);
+		free_entry(e);
+		return;
+	}
+
+	if (tc->num_entries >= tc->max_entries) cache_evict(tc);
+
+	token_entry **bucket = &tc->table[e->hash & (tc->table_size - 1)];
+	e->next = *bucket;
+	*bucket = e;
+	lru_push(tc, e);
+	tc->num_entries++;
+	cache_unlock(tc);
+}
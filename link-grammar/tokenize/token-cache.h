@@ -0,0 +1,51 @@
+/*************************************************************************/
+/* Copyright (c) 2026 The Link Grammar project                           */
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+#ifndef _LINKGRAMMAR_TOKEN_CACHE_H
+#define _LINKGRAMMAR_TOKEN_CACHE_H
+
+#include "api-types.h"
+#include "link-includes.h"
+#include "tok-structures.h"
+
+/* The default maximum number of words in the tokenization cache.
+ * Can be changed (0 to disable) by the "token-cache:N" test option. */
+#define TOKEN_CACHE_DEFAULT_SIZE 8192
+
+typedef struct Token_cache_s Token_cache;
+typedef struct Token_recording_s Token_recording;
+
+/* The word state (other than its string) and the options that the
+ * tokenization of a word depends on. */
+typedef struct
+{
+	const char *regex_name;
+	size_t split_counter;
+	unsigned int status;
+	Morpheme_type morpheme_type;
+	Tokenizing_step tokenizing_step;
+	int use_spell_guess;
+	bool capitalizable;         /* In a capitalizable position */
+	bool dictcap;               /* The "dictcap" test option */
+} Token_key;
+
+Token_cache *token_cache_create(Dictionary);
+void token_cache_delete(Token_cache *);
+void token_cache_print_stats(Token_cache *);
+
+bool token_cache_replay(Sentence, Gword *, const Token_key *);
+void token_cache_record_start(Sentence, Gword *, const Token_key *);
+void token_cache_record_issue(Sentence, Gword *, const char *,
+                              int, const char * const *,
+                              int, const char * const *,
+                              int, const char * const *);
+void token_cache_record_end(Sentence, Gword *);
+#endif /* _LINKGRAMMAR_TOKEN_CACHE_H */
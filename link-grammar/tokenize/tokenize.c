@@ -27,9 +27,10 @@
 #include "dict-common/regex-morph.h"
 #include "error.h"
 #include "print/print-util.h"
-#include "spellcheck.h"
+#include "spell-guess.h"
 #include "string-set.h"
 #include "tokenize.h"
+#include "token-cache.h"
 #include "tok-structures.h"
 #include "utilities.h"
 #include "wordgraph.h"
@@ -81,7 +82,6 @@ static bool is_entity(Dictionary dict, const char * str)
 	return word_contains(dict, regex_name, ENTITY_MARKER);
 }
 
-#if defined HAVE_HUNSPELL || defined HAVE_ASPELL
 /**
  * Return true if word is a proper name.
  * XXX This is a cheap hack that works only in English, and is
@@ -115,7 +115,6 @@ static bool contains_digits(const char * s, locale_t dict_locale)
 	}
 	return false;
 }
-#endif /* defined HAVE_HUNSPELL || defined HAVE_ASPELL */
 
 /**
  * Find if a string is equal to a character in afdict class afdict_classnum.
@@ -455,7 +454,6 @@ static PER_GWORD_FUNC(set_word_status)//(Sentence sent, Gword *w, int *arg)
 			}
 			break;
 
-#if defined HAVE_HUNSPELL || defined HAVE_ASPELL
 		case WS_RUNON:
 		case WS_SPELL:
 		/* Currently used to mark words that are a result of a spelling. */
@@ -466,7 +464,6 @@ static PER_GWORD_FUNC(set_word_status)//(Sentence sent, Gword *w, int *arg)
 			}
 			w->status |= status;
 			break;
-#endif /* HAVE_HUNSPELL */
 
 		default:
 			assert(0, "Invalid status 0x%x\n", status);
@@ -541,6 +538,12 @@ Gword *issue_word_alternative(Sentence sent, Gword *unsplit_word,
 	Gword *sole_alternative_of_itself = NULL;
 #endif
 
+	if (NULL != sent->token_recording)
+	{
+		token_cache_record_issue(sent, unsplit_word, label, prefnum, prefix,
+		                         stemnum, stem, suffnum, suffix);
+	}
+
 	if (unsplit_word->split_counter > MAX_SPLITS)
 	{
 		prt_error("Error: Word %s reached %d splits. "
@@ -715,10 +718,10 @@ Gword *issue_word_alternative(Sentence sent, Gword *unsplit_word,
 
 				/* Scan its "prev" words and add it as their "next" word */
 				for (q = unsplit_word->prev; *q; q++)
-					gwordlist_append(&(*q)->next, unsplit_word);
+					gword_link_append(sent, &(*q)->next, unsplit_word);
 				/* Scan its "next" words and add it as their "prev" word */
 				for (q = unsplit_word->next; *q; q++)
-					gwordlist_append(&(*q)->prev, unsplit_word);
+					gword_link_append(sent, &(*q)->prev, unsplit_word);
 				word_label(sent, unsplit_word, "+", label);
 				word_label(sent, unsplit_word, NULL, "R");
 				unsplit_word->status |= WS_UNSPLIT;
@@ -821,11 +824,11 @@ Gword *issue_word_alternative(Sentence sent, Gword *unsplit_word,
 						Gword **n;
 
 						/* Create the "prev" link for subword */
-						gwordlist_append(&subword->prev, *p);
+						gword_link_append(sent, &subword->prev, *p);
 
 						if (unsplit_word->status & WS_HASALT)
 						{
-							gwordlist_append(&(*p)->next, subword);
+							gword_link_append(sent, &(*p)->next, subword);
 						}
 						else
 						{
@@ -867,11 +870,11 @@ Gword *issue_word_alternative(Sentence sent, Gword *unsplit_word,
 						Gword **p;
 
 						/* Create the "next" link for subword */
-						gwordlist_append(&subword->next, *n);
+						gword_link_append(sent, &subword->next, *n);
 
 						if (unsplit_word->status & WS_HASALT)
 						{
-							gwordlist_append(&(*n)->prev, subword);
+							gword_link_append(sent, &(*n)->prev, subword);
 						}
 						else
 						{
@@ -908,8 +911,8 @@ Gword *issue_word_alternative(Sentence sent, Gword *unsplit_word,
 						subword->end = subword->start + strlen_cache[ai];
 					}
 
-					gwordlist_append(&psubword->next, subword);
-					gwordlist_append(&subword->prev, psubword);
+					gword_link_append(sent, &psubword->next, subword);
+					gword_link_append(sent, &subword->prev, psubword);
 				}
 
 				subword->alternative_id = alternative_id;
@@ -1617,7 +1620,6 @@ static bool morpheme_split(Sentence sent, Gword *unsplit_word, const char *word)
 	return word_can_split;
 }
 
-#if defined HAVE_HUNSPELL || defined HAVE_ASPELL
 static bool is_known_word(Sentence sent, const char *word)
 {
 	return (dict_has_word(sent->dict, word) ||
@@ -1633,7 +1635,7 @@ static bool is_known_word(Sentence sent, const char *word)
  * Return true if corrections have been issued, else false.
  *
  * Notes:
- * 1. spellcheck_suggest(), which is invoked by this function, returns
+ * 1. spell_guess_suggest(), which is invoked by this function, returns
  * guesses for words containing digits (including words consisting of digits
  * only). However, this doesn't cause a problem because this function is not
  * invoked for such words (since they are considered a proper name).
@@ -1654,16 +1656,14 @@ static bool guess_misspelled_word(Sentence sent, Gword *unsplit_word,
 	char **alternates = NULL;
 	const char *word = unsplit_word->subword;
 
-	/* If the spell-checker knows about this word, and we don't ...
-	 * Dang. We should fix it someday. Accept it as such. */
-	if (spellcheck_test(dict->spell_checker, word)) return false;
-
-	/* Else, ask the spell-checker for alternate spellings
-	 * and see if these are in the dict. */
-	n = spellcheck_suggest(dict->spell_checker, &alternates, word);
+	/* Ask the spell-checker for alternate spellings and see if these
+	 * are in the dict. If the spell-checker knows about this word, and
+	 * we don't ... Dang. We should fix it someday. Accept it as such. */
+	n = spell_guess_suggest(dict->spell_guess, word, &alternates);
+	if (n < 0) return false;
 	if (verbosity_level(+D_SW))
 	{
-		lgdebug(0, "spellcheck_suggest for %s:\\", word);
+		lgdebug(0, "spell_guess_suggest for %s:\\", word);
 		if (0 == n)
 			lgdebug(0, " (nothing)\n");
 		else
@@ -1740,11 +1740,10 @@ static bool guess_misspelled_word(Sentence sent, Gword *unsplit_word,
 			}
 		}
 	}
-	if (alternates) spellcheck_free_suggest(dict->spell_checker, alternates, n);
+	if (alternates) spell_guess_free_suggest(alternates, n);
 
 	return ((num_guesses > 0) || (runon_word_corrections > 0));
 }
-#endif /* HAVE_HUNSPELL */
 
 static bool matchspan_fixed(const Afdict_class *mpunc, const char *w,
                             int *start, int *end)
@@ -2855,7 +2854,6 @@ static void separate_word(Sentence sent, Gword *unsplit_word, Parse_Options opts
 
 	word_is_known |= word_can_split;
 
-#if defined HAVE_HUNSPELL || defined HAVE_ASPELL
 	/* If the word is unknown, then it might be a run-on of two words or a
 	 * misspelled word. Ask the spell-checker to split the word, if possible,
 	 * and/or offer guesses.
@@ -2871,12 +2869,11 @@ static void separate_word(Sentence sent, Gword *unsplit_word, Parse_Options opts
 	if (!word_can_lrmsplit && !word_is_known &&
 	    !contains_digits(word, dict->lctype) &&
 	    !is_proper_name(word, dict->lctype) &&
-	    opts->use_spell_guess && dict->spell_checker)
+	    opts->use_spell_guess && dict->spell_guess)
 	{
 		bool spell_suggest = guess_misspelled_word(sent, unsplit_word, opts);
 		lgdebug(+D_SW, "Spell suggest=%d\n", spell_suggest);
 	}
-#endif /* defined HAVE_HUNSPELL || defined HAVE_ASPELL */
 
 	lgdebug(+D_SW, "END: Word '%s' in_dict=%d is_known=%d status=%s\n",
 	        unsplit_word->subword, !!(unsplit_word->status & WS_INDICT),
@@ -2888,6 +2885,38 @@ static void separate_word(Sentence sent, Gword *unsplit_word, Parse_Options opts
 #endif
 }
 
+/**
+ * Separate the word to subwords, or reproduce its separation from the
+ * tokenization cache if it has been done before (see token-cache.c).
+ */
+static void tokenize_word(Sentence sent, Gword *word, Parse_Options opts)
+{
+	/* Don't use the cache when debugging the word splits. */
+	if ((NULL == sent->dict->token_cache) || (verbosity >= D_SW))
+	{
+		separate_word(sent, word, opts);
+		return;
+	}
+
+	const Token_key key =
+	{
+		.regex_name = word->regex_name,
+		.split_counter = word->split_counter,
+		.status = word->status,
+		.morpheme_type = word->morpheme_type,
+		.tokenizing_step = word->tokenizing_step,
+		.use_spell_guess = opts->use_spell_guess,
+		.capitalizable = is_capitalizable(sent->dict, word),
+		.dictcap = (NULL != test_enabled("dictcap")),
+	};
+
+	if (token_cache_replay(sent, word, &key)) return;
+
+	token_cache_record_start(sent, word, &key);
+	separate_word(sent, word, opts);
+	token_cache_record_end(sent, word);
+}
+
 /**
  * Make the string 's' be the next word of the sentence.
  *
@@ -2909,8 +2938,8 @@ static Gword *issue_sentence_word(const Sentence sent, const char *const s)
 	new_word->unsplit_word = sent->wordgraph;
 	new_word->label = "S"; /* a sentence word */
 
-	gwordlist_append(&last_word->next, new_word);
-	gwordlist_append(&new_word->prev, last_word);
+	gword_link_append(sent, &last_word->next, new_word);
+	gword_link_append(sent, &new_word->prev, last_word);
 
 	gwordqueue_add(sent, new_word);
 
@@ -2998,6 +3027,137 @@ static void wordgraph_terminator(Sentence const sent)
 	#define BAD_UTF goto failure;
 #endif
 
+typedef struct
+{
+	const char **s;
+	size_t num;
+	size_t alloced;
+} Lookup_set;
+
+static void lookup_set_add(Sentence sent, Lookup_set *ls, const char *s)
+{
+	if ('\0' == *s) return;
+
+	if (ls->num == ls->alloced)
+	{
+		ls->alloced = 2 * ls->alloced + 64;
+		ls->s = realloc(ls->s, ls->alloced * sizeof(*ls->s));
+	}
+	ls->s[ls->num++] = string_set_add(s, sent->string_set);
+}
+
+/**
+ * Add to \p ls the word \p w, and the stems and suffixes it can be
+ * split to.
+ */
+static void lookup_set_add_splits(Sentence sent, Lookup_set *ls, const char *w)
+{
+	Dictionary afdict = sent->dict->affix_table;
+	const Afdict_class *suffix_list = AFCLASS(afdict, AFDICT_SUF);
+	const Afdict_class *stemsubscr_list = AFCLASS(afdict, AFDICT_STEMSUBSCR);
+	size_t wlen = strlen(w);
+	char *stem = alloca(wlen + MAX_WORD + 1);
+
+	lookup_set_add(sent, ls, w);
+
+	for (int i = 0; i < suffix_list->length - suffix_list->Nregexes; i++)
+	{
+		const char *suffix = suffix_list->string[i];
+		size_t slen = strlen(suffix);
+		if ((slen >= wlen) || (0 != strcmp(w + wlen - slen, suffix))) continue;
+
+		lookup_set_add(sent, ls, suffix);
+		strncpy(stem, w, wlen - slen);
+		stem[wlen - slen] = '\0';
+		lookup_set_add(sent, ls, stem);
+
+		for (size_t si = 0; si < stemsubscr_list->length; si++)
+		{
+			const char *stemsubscr = stemsubscr_list->string[si];
+			if (strlen(stemsubscr) > MAX_WORD) continue;
+			strcpy(&stem[wlen - slen], stemsubscr);
+			lookup_set_add(sent, ls, stem);
+		}
+	}
+}
+
+/**
+ * Strip off the first matching string of \p punc_list from the start
+ * (\p at_end false) or the end of \p w, and add it to \p ls.
+ * Return true if something was stripped.
+ */
+static bool lookup_set_strip(Sentence sent, Lookup_set *ls, char *w,
+                             const Afdict_class *punc_list, bool at_end)
+{
+	size_t wlen = strlen(w);
+
+	for (int i = 0; i < punc_list->length - punc_list->Nregexes; i++)
+	{
+		const char *punc = punc_list->string[i];
+		size_t plen = strlen(punc);
+		if (plen >= wlen) continue;
+
+		if (at_end)
+		{
+			if (0 != strcmp(w + wlen - plen, punc)) continue;
+			w[wlen - plen] = '\0';
+		}
+		else
+		{
+			if (0 != strncmp(w, punc, plen)) continue;
+			memmove(w, w + plen, wlen - plen + 1);
+		}
+		lookup_set_add(sent, ls, punc);
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * With a dictionary that supports bulk lookup, look up in one go the
+ * strings that the tokenizer is likely to look up for the sentence
+ * words: the words, their downcased versions, and what remains after
+ * stripping punctuation and suffixes off them.  It doesn't need to be
+ * exact - strings that are missed here are just looked up one by one.
+ */
+static void prefetch_lookups(Sentence sent)
+{
+	Dictionary dict = sent->dict;
+	if ((NULL == dict->lookup_bulk) || (NULL == dict->affix_table)) return;
+
+	const Afdict_class *lpunc = AFCLASS(dict->affix_table, AFDICT_LPUNC);
+	const Afdict_class *rpunc = AFCLASS(dict->affix_table, AFDICT_RPUNC);
+	Lookup_set ls = { 0 };
+
+	for (Gword *w = sent->wordgraph; NULL != w; w = w->next ? w->next[0] : NULL)
+	{
+		if (MT_WORD != w->morpheme_type) continue;
+
+		size_t wsize = strlen(w->subword) + MB_LEN_MAX + 1;
+		char *word[2] = { malloc(wsize), malloc(wsize) };
+		strcpy(word[0], w->subword);
+		downcase_utf8_str(word[1], w->subword, wsize, dict->lctype);
+
+		for (size_t i = 0; i < ARRAY_SIZE(word); i++)
+		{
+			if ((1 == i) && (0 == strcmp(word[0], word[1]))) break;
+
+			lookup_set_add_splits(sent, &ls, word[i]);
+			while (lookup_set_strip(sent, &ls, word[i], lpunc, false))
+				lookup_set_add_splits(sent, &ls, word[i]);
+			while (lookup_set_strip(sent, &ls, word[i], rpunc, true))
+				lookup_set_add_splits(sent, &ls, word[i]);
+		}
+
+		free(word[0]);
+		free(word[1]);
+	}
+
+	dict_memo_prefetch(dict, ls.s, ls.num);
+	free(ls.s);
+}
+
 /**
  * Split up the string in `sent->orig_sentence` into distinct words.
  * The resulting word-sequence DAG is stored in the sent->word[]
@@ -3068,6 +3228,7 @@ bool separate_sentence(Sentence sent, Parse_Options opts)
 		add_gword(sent, RIGHT_WALL_WORD, NULL, MT_WALL);
 
 	wordgraph_terminator(sent);
+	prefetch_lookups(sent);
 
 	Gword *word;
 	while ((word = wordgraph_getqueue_word(sent)))
@@ -3087,7 +3248,7 @@ bool separate_sentence(Sentence sent, Parse_Options opts)
 			;
 #endif /* DEBUG_WORDGRAPH */
 		else
-			separate_word(sent, word, opts);
+			tokenize_word(sent, word, opts);
 
 		word->tokenizing_step = TS_DONE;
 	}
@@ -3207,6 +3368,7 @@ void flatten_wordgraph(Sentence sent, Parse_Options opts)
 		wordgraph_hier_position(wg_word);
 		max_words++;
 	}
+	wordgraph_alt_bitmaps(sent);
 
 	/* Populate the pathpos word queue */
 	for (next = sent->wordgraph->next; *next; next++)
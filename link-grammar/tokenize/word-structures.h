@@ -24,6 +24,7 @@ struct X_node_struct
 {
 	const char * string;       /* the word itself */
 	Exp * exp;
+	const Exp * dict_exp;      /* disjunct cache key (NULL if not cached) */
 	X_node *next;
 	const Gword *word;         /* originating Wordgraph word */
 };
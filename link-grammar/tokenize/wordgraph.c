@@ -24,7 +24,7 @@
 
 Gword *gword_new(Sentence sent, const char *s)
 {
-	Gword *gword = malloc(sizeof(Gword));
+	Gword *gword = pool_alloc(sent->Gword_pool);
 
 	memset(gword, 0, sizeof(Gword));
 	assert(NULL != s, "Null-string subword");
@@ -64,6 +64,39 @@ void gwordlist_append(Gword ***arrp, Gword *p)
 	(*arrp)[n] = p;
 }
 
+/**
+ * Append \p p to \p *arrp, which is a next or prev list of a wordgraph
+ * word of \p sent.
+ *
+ * These lists are allocated in the Gword_list pool of the sentence, and
+ * are freed with it. Their allocated size (including the terminating
+ * NULL) is the smallest power of 2 that can hold them, so it is not
+ * recorded, and they get copied only when they grow beyond it.
+ */
+void gword_link_append(Sentence sent, Gword ***arrp, Gword *p)
+{
+	size_t n = gwordlist_len((const Gword **)*arrp);
+	size_t size = 2;
+
+	while (size < n + 1) size *= 2;
+	if (n + 2 > size)
+	{
+		assert(2 * size < GWORD_LIST_POOL_SIZE,
+		       "Word '%s': Too many next/prev words", p->subword);
+
+		Gword **arr = pool_alloc_vec(sent->Gword_list_pool, 2 * size);
+		if (0 != n) memcpy(arr, *arrp, n * sizeof(*arr));
+		*arrp = arr;
+	}
+	else if (0 == n)
+	{
+		*arrp = pool_alloc_vec(sent->Gword_list_pool, size);
+	}
+
+	(*arrp)[n] = p;
+	(*arrp)[n+1] = NULL;
+}
+
 void gwordlist_free(Gword ** gw)
 {
 	free(gw);
@@ -400,6 +433,173 @@ bool in_same_alternative(Gword *w1, Gword *w2)
 	return false;
 }
 
+/* An (unsplit_word, alternative_id) pair of a hier_position vector. */
+typedef struct
+{
+	const Gword *unsplit_word;
+	const Gword *alternative_id;
+	unsigned int first, last;   /* Pairs of this unsplit_word */
+} alt_pair;
+
+static int alt_pair_cmp(const void *a, const void *b)
+{
+	const alt_pair *p1 = a;
+	const alt_pair *p2 = b;
+
+	if (p1->unsplit_word != p2->unsplit_word)
+		return ((uintptr_t)p1->unsplit_word < (uintptr_t)p2->unsplit_word) ? -1 : 1;
+	if (p1->alternative_id != p2->alternative_id)
+		return ((uintptr_t)p1->alternative_id < (uintptr_t)p2->alternative_id) ? -1 : 1;
+	return 0;
+}
+
+/**
+ * Compute the alternatives bitmaps of the wordgraph words, so that
+ * in_same_alternative() can be checked for a whole linkage by bitwise
+ * operations (see alt_bitmap_add()).
+ *
+ * A bit is assigned to each alternative of an unsplit_word that has
+ * more than one alternative. The bitmap of a word consists of two
+ * bitmaps, of sent->alt_bitmap_len uint64_t elements each:
+ * The "member" bitmap has the bits of the alternatives (at any
+ * hierarchy level) in which the word is found.
+ * The "conflict" bitmap has the bits of the other alternatives of the
+ * same unsplit_words.
+ * Two words are not in the same alternative iff the member bitmap of
+ * one of them intersects the conflict bitmap of the other one.
+ *
+ * The hier_position of the words must have already been computed.
+ */
+void wordgraph_alt_bitmaps(Sentence sent)
+{
+	size_t num_pairs = 0;
+	size_t num_words = 0;
+
+	for (Gword *w = sent->wordgraph; NULL != w; w = w->chain_next)
+	{
+		if (0 == w->hier_depth) continue;
+		num_pairs += w->hier_depth;
+		num_words++;
+	}
+	if (0 == num_pairs) return;
+
+	alt_pair *pair = malloc(num_pairs * sizeof(alt_pair));
+	size_t n = 0;
+	for (Gword *w = sent->wordgraph; NULL != w; w = w->chain_next)
+	{
+		for (size_t i = 0; i < w->hier_depth; i++)
+		{
+			pair[n].unsplit_word = w->hier_position[2*i];
+			pair[n].alternative_id = w->hier_position[2*i+1];
+			n++;
+		}
+	}
+	qsort(pair, num_pairs, sizeof(alt_pair), alt_pair_cmp);
+
+	/* Remove duplicates, and find the pair range of each unsplit_word.
+	 * Only unsplit words with more than one alternative get bits. */
+	n = 0;
+	for (size_t i = 0; i < num_pairs; i++)
+	{
+		if ((0 < n) && (0 == alt_pair_cmp(&pair[n-1], &pair[i]))) continue;
+		pair[n++] = pair[i];
+	}
+	num_pairs = n;
+
+	size_t num_bits = 0;
+	for (size_t first = 0, last; first < num_pairs; first = last)
+	{
+		for (last = first + 1; last < num_pairs; last++)
+		{
+			if (pair[last].unsplit_word != pair[first].unsplit_word) break;
+		}
+		for (size_t i = first; i < last; i++)
+		{
+			pair[i].first = first;
+			pair[i].last = last;
+		}
+		if (1 < last - first) num_bits += last - first;
+	}
+
+	if (0 == num_bits)
+	{
+		free(pair);
+		return;
+	}
+
+	/* The bit of pair i is i, but pairs of unsplit words with a single
+	 * alternative are then unused. It isn't worth the trouble to
+	 * compress them out. */
+	size_t len = (num_pairs + 63) / 64;
+	sent->alt_bitmap_len = len;
+	sent->alt_bitmap = calloc(num_words * 2 * len, sizeof(uint64_t));
+
+	uint64_t *bm = sent->alt_bitmap;
+	for (Gword *w = sent->wordgraph; NULL != w; w = w->chain_next)
+	{
+		if (0 == w->hier_depth) continue;
+
+		bool has_bits = false;
+		for (size_t i = 0; i < w->hier_depth; i++)
+		{
+			alt_pair key =
+			{
+				.unsplit_word = w->hier_position[2*i],
+				.alternative_id = w->hier_position[2*i+1],
+			};
+			const alt_pair *p =
+				bsearch(&key, pair, num_pairs, sizeof(alt_pair), alt_pair_cmp);
+			assert(NULL != p, "Missing hier_position pair");
+			if (1 == p->last - p->first) continue;
+
+			size_t bit = p - pair;
+			bm[bit/64] |= (uint64_t)1 << (bit%64);
+			for (size_t b = p->first; b < p->last; b++)
+			{
+				if (b == bit) continue;
+				bm[len + b/64] |= (uint64_t)1 << (b%64);
+			}
+			has_bits = true;
+		}
+
+		if (has_bits)
+		{
+			w->alt_bitmap = bm;
+			bm += 2 * len;
+		}
+	}
+
+	free(pair);
+}
+
+/**
+ * Check whether the word of \p gs is in the same alternative as each
+ * of the words whose bitmaps have been accumulated in \p acc, and if so,
+ * add its bitmaps to \p acc. \p acc should initially be zeroed, and be
+ * of 2*sent->alt_bitmap_len elements.
+ * A word set of more than one word (of an eliminated duplicate
+ * disjunct) is not checked.
+ *
+ * Return false iff a word not in the same alternative is found.
+ */
+bool alt_bitmap_add(const Sentence sent, uint64_t *acc, const gword_set *gs)
+{
+	if (NULL != gs->next) return true;
+	const uint64_t *bm = gs->o_gword->alt_bitmap;
+	if (NULL == bm) return true;
+
+	const size_t len = sent->alt_bitmap_len;
+	uint64_t conflict = 0;
+	for (size_t i = 0; i < len; i++)
+		conflict |= (bm[i] & acc[len+i]) | (bm[len+i] & acc[i]);
+	if (0 != conflict) return false;
+
+	for (size_t i = 0; i < 2 * len; i++)
+		acc[i] |= bm[i];
+
+	return true;
+}
+
 /**
  * Get the real unsplit word of the given word.
  * While the Wordgraph is getting constructed, when a subword has itself as one
@@ -492,35 +692,14 @@ GNUC_UNUSED static int gword_set_len(const gword_set *gl)
 }
 #endif
 
-/**
- * Return a new gword_set element, initialized from the given element.
- * @param old_e Existing element.
- */
-static gword_set *gword_set_element_new(gword_set *old_e)
-{
-	gword_set *new_e = malloc(sizeof(gword_set));
-	*new_e = (gword_set){0};
-
-	new_e->o_gword = old_e->o_gword;
-	gword_set *chain_next = old_e->chain_next;
-	old_e->chain_next = new_e;
-	new_e->chain_next = chain_next;
-
-	return new_e;
-}
-
-static void gword_set_element_free(gword_set * e)
-{
-	free(e);
-}
-
 /**
  * Add an element to existing gword_set. Uniqueness is assumed.
  * @return A new set with the element.
  */
-static gword_set *gword_set_add(gword_set *gset, gword_set *ge)
+static gword_set *gword_set_add(Sentence sent, gword_set *gset, gword_set *ge)
 {
-	gword_set *n = gword_set_element_new(ge);
+	gword_set *n = pool_alloc(sent->gword_set_pool);
+	n->o_gword = ge->o_gword;
 	n->next = gset;
 	gset = n;
 
@@ -539,7 +718,8 @@ static gword_set *gword_set_add(gword_set *gset, gword_set *ge)
  * just gets returned if there is nothing to add to it. Else - a new gword
  * set is returned.
  */
-gword_set *gword_set_union(gword_set *kept, gword_set *eliminated)
+gword_set *gword_set_union(Sentence sent, gword_set *kept,
+                           gword_set *eliminated)
 {
 	/* Preserve the gword pointers of the eliminated disjunct if different. */
 	gword_set *preserved_set = NULL;
@@ -552,14 +732,14 @@ gword_set *gword_set_union(gword_set *kept, gword_set *eliminated)
 			if (e->o_gword == k->o_gword) break;
 		if (NULL != k) continue;
 
-		preserved_set = gword_set_add(preserved_set, e);
+		preserved_set = gword_set_add(sent, preserved_set, e);
 	}
 
 	if (preserved_set)
 	{
 		/* Preserve the originating gword pointers of the remaining disjunct. */
 		for (gword_set *k = kept; NULL != k; k = k->next)
-			preserved_set = gword_set_add(preserved_set, k);
+			preserved_set = gword_set_add(sent, preserved_set, k);
 		kept = preserved_set;
 	}
 
@@ -581,42 +761,22 @@ static void word_queue_delete(Sentence sent)
 	sent->word_queue_last = NULL;
 }
 
-/**
- * Delete the gword_set associated with the Wordgraph.
- * @param w First Wordgraph word.
- */
-static void gword_set_delete(Gword *w)
-{
-	if (NULL == w) return;
-	for (w = w->chain_next; NULL != w; w = w->chain_next)
-	{
-		gword_set *n;
-		for (gword_set *f = w->gword_set_head.chain_next; NULL != f; f = n)
-		{
-			n = f->chain_next;
-			gword_set_element_free(f);
-		}
-	}
-}
-
 void wordgraph_delete(Sentence sent)
 {
 	word_queue_delete(sent);
 
-	Gword *w = sent->wordgraph;
-	gword_set_delete(w);
-
-	while (NULL != w)
+	for (Gword *w = sent->wordgraph; NULL != w; w = w->chain_next)
 	{
-		Gword *w_tofree = w;
-
-		free(w->prev);
-		free(w->next);
 		free(w->hier_position);
 		free(w->null_subwords);
-		w = w->chain_next;
-		free(w_tofree);
 	}
+	free(sent->alt_bitmap);
+	sent->alt_bitmap = NULL;
+	sent->alt_bitmap_len = 0;
+	pool_reuse(sent->Gword_pool);
+	pool_reuse(sent->gword_set_pool);
+	pool_reuse(sent->Gword_list_pool);
+
 	sent->last_word = NULL;
 	sent->wordgraph = NULL;
 }
@@ -20,7 +20,12 @@
  * start. See issue_sentence_word. */
 #define IS_SENTENCE_WORD(sent, gword) (gword->unsplit_word == sent->wordgraph)
 
+/* Number of elements in a block of the next/prev word lists pool.
+ * A word can have up to half of it next or prev words. */
+#define GWORD_LIST_POOL_SIZE 4096
+
 Gword *gword_new(Sentence, const char *);
+void gword_link_append(Sentence, Gword ***, Gword *);
 void gwordlist_append(Gword ***, Gword *);
 void gwordlist_free(Gword **);
 
@@ -39,6 +44,8 @@ void wordgraph_delete(Sentence);
 const Gword **wordgraph_hier_position(Gword *);
 void print_hier_position(const Gword *);
 bool in_same_alternative(Gword *, Gword *);
+void wordgraph_alt_bitmaps(Sentence);
+bool alt_bitmap_add(const Sentence, uint64_t *, const gword_set *);
 Gword *find_real_unsplit_word(Gword *, bool);
 
 size_t wordgraph_pathpos_len(Wordgraph_pathpos *);
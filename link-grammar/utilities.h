@@ -262,6 +262,7 @@ static inline char *_strndupa3(char *new_s, const char *s, size_t n)
 #define NORETURN __attribute__ ((__noreturn__))
 #define ATTR_PURE __attribute__ ((__pure__))
 #define NO_SAN __attribute__ ((no_sanitize_address, no_sanitize_undefined))
+#define PREFETCH(addr) __builtin_prefetch(addr)
 
 /* Define when configuring with ASAN/UBSAN - for fast dict load (of course
  * only when not debugging dict code.) */
@@ -283,6 +284,7 @@ static inline char *_strndupa3(char *new_s, const char *s, size_t n)
 #define NORETURN
 #define ATTR_PURE
 #define NO_SAN_DICT
+#define PREFETCH(addr)
 
 #define likely(x) x
 #define unlikely(x) x
@@ -33,6 +33,8 @@ static struct
 	int repeatable_rand;
 	int spell_guess;
 	int short_length;
+	int count_threads;
+	int anytime;
 	int batch_mode;
 	int panic_mode;
 	int allow_null;
@@ -72,6 +74,7 @@ static int variables_cmd(const Switch*, int);
 
 Switch default_switches[] =
 {
+	{"anytime",    Bool, "Degraded linkages on timeout",    &local.anytime},
 	{"bad",        Bool, "Display of bad linkages",         &local.display_bad},
 	{"batch",      Bool, "Batch mode",                      &local.batch_mode},
 	{"constituents", Int,  "Generate constituent output",   &local.display_constituents},
@@ -103,6 +106,7 @@ Switch default_switches[] =
 	{"spell",      Int, "Up to this many spell-guesses per unknown word", &local.spell_guess},
 #endif /* HAVE_HUNSPELL */
 	{"test",       String, "Comma-separated test features", &local.test},
+	{"threads",    Int,  "Threads for counting and post-processing linkages", &local.count_threads},
 	{"timeout",    Int,  "Abort parsing after this many seconds", &local.timeout},
 #ifdef USE_SAT_SOLVER
 	{"use-sat",    Bool, "Use Boolean SAT-based parser",    &local.use_sat_solver},
@@ -1030,6 +1034,8 @@ void put_opts_in_local_vars(Command_Options* copts)
 	local.repeatable_rand = parse_options_get_repeatable_rand(opts);
 	local.spell_guess = parse_options_get_spell_guess(opts);
 	local.short_length = parse_options_get_short_length(opts);
+	local.count_threads = parse_options_get_count_threads(opts);
+	local.anytime = parse_options_get_anytime(opts);
 	local.cost_model = parse_options_get_cost_model_type(opts);
 	local.max_cost = parse_options_get_disjunct_cost(opts);
 #if USE_SAT_SOLVER
@@ -1070,6 +1076,8 @@ void put_local_vars_in_opts(Command_Options* copts)
 	parse_options_set_repeatable_rand(opts, local.repeatable_rand);
 	parse_options_set_spell_guess(opts, local.spell_guess);
 	parse_options_set_short_length(opts, local.short_length);
+	parse_options_set_count_threads(opts, local.count_threads);
+	parse_options_set_anytime(opts, local.anytime);
 	parse_options_set_cost_model_type(opts, local.cost_model);
 	parse_options_set_disjunct_cost(opts, local.max_cost);
 #if USE_SAT_SOLVER
@@ -0,0 +1,88 @@
+/*
+ * link-dict-compile.c
+ *
+ * Precompile the dictionary of a language, so it will load faster.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <link-includes.h>
+
+static void usage(const char *progname, int status)
+{
+	fprintf((0 == status) ? stdout : stderr,
+	        "Usage: %s [-o FILE | -s NAME] [-v LEVEL] LANGUAGE\n"
+	        "Precompile the dictionary of LANGUAGE.\n\n"
+	        "  -o FILE   Write the precompiled dictionary to FILE.\n"
+	        "            By default it is written next to the dictionary file\n"
+	        "            (e.g. \"en/4.0.dict.bin\"), where it is used when the\n"
+	        "            dictionary is created.\n"
+	        "  -s NAME   Publish the dictionary as the shared memory object\n"
+	        "            NAME (e.g. \"/lg-en\"), for programs that use\n"
+	        "            dictionary_create_lang_shared().\n"
+	        "  -v LEVEL  Verbosity level.\n"
+	        "  -h        Display this help.\n",
+	        progname);
+	exit(status);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *filename = NULL;
+	const char *shm_name = NULL;
+	int verbosity = 1;
+	int c;
+
+	while ((c = getopt(argc, argv, "ho:s:v:")) != -1)
+	{
+		switch (c)
+		{
+			case 'o':
+				filename = optarg;
+				break;
+			case 's':
+				shm_name = optarg;
+				break;
+			case 'v':
+				verbosity = atoi(optarg);
+				break;
+			case 'h':
+				usage(argv[0], 0);
+				break;
+			default:
+				usage(argv[0], 1);
+		}
+	}
+	if ((optind != argc - 1) || ((NULL != filename) && (NULL != shm_name)))
+		usage(argv[0], 1);
+
+	/* The library verbosity is set through the parse options. */
+	Parse_Options opts = parse_options_create();
+	parse_options_set_verbosity(opts, verbosity);
+
+	bool rc;
+	if (NULL != shm_name)
+	{
+		Dictionary dict = dictionary_create_lang_shared(argv[optind], shm_name);
+		rc = (NULL != dict);
+		dictionary_delete(dict);
+	}
+	else
+	{
+		rc = dictionary_compile_lang(argv[optind], filename);
+	}
+	parse_options_delete(opts);
+
+	if (!rc)
+	{
+		fprintf(stderr, "Fatal error: Unable to precompile the dictionary.\n");
+		return 1;
+	}
+
+	if ((0 < verbosity) && (NULL == shm_name))
+		printf("Precompiled dictionary written.\n");
+
+	return 0;
+}
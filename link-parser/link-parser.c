@@ -964,11 +964,19 @@ open_error:
 			if (parse_options_timer_expired(opts))
 				fprintf(stdout, "Timer is expired!\n");
 
+			if (sentence_is_partial(sent))
+				fprintf(stdout, "Partial parse (anytime mode).\n");
+
 			if (parse_options_memory_exhausted(opts))
 				fprintf(stdout, "Memory is exhausted!\n");
 		}
 
-		if (copts->panic_mode && parse_options_resources_exhausted(opts))
+		/* Don't override the linkages of an anytime partial parse. */
+		bool have_partial = sentence_is_partial(sent) &&
+		                    (sentence_num_valid_linkages(sent) > 0);
+
+		if (copts->panic_mode && parse_options_resources_exhausted(opts) &&
+		    !have_partial)
 		{
 			batch_errors++;
 			if (verbosity > 0)
@@ -0,0 +1,300 @@
+/*************************************************************************/
+/* Copyright (c) 2026 The Link Grammar project                           */
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+// Unit test of the precompiled dictionary (dictionary_compile_lang()).
+// Check that the "en" dictionary gets precompiled, that it is then
+// loaded from its precompiled form and parses exactly like the text
+// dictionary, and that a stale or truncated precompiled dictionary is
+// not used (the text dictionary is read instead).
+//
+// The dictionary is compiled in a temporary copy of the "en" directory
+// (only its 4.0.dict is actually copied, the rest are symlinks), which
+// is made the current directory so it is found first.
+
+#include <string>
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#endif /* !_WIN32 */
+#include "link-grammar/link-includes.h"
+
+#ifndef _WIN32
+#define BIN_FILE "en/4.0.dict.bin"
+
+static const char *sents[] = {
+	"It was covered with bites.",
+	"I have no idea what that is.",
+	"We ate popcorn and watched movies on TV for three days.",
+	"The line extends 10 miles offshore.",
+	"One of the things you do when you stop your bicycle is apply the brake.",
+	"Sweat stood on his brow, fury was bright in his one good eye.",
+	"This is a the test.",
+};
+
+// Return a string that describes the parse results of the sentence.
+static std::string parse_result(Dictionary dict, Parse_Options opts,
+                                const char *sent_str)
+{
+	Sentence sent = sentence_create(sent_str, dict);
+	if (!sent) {
+		fprintf (stderr, "Fatal error: Unable to create parser\n");
+		exit(2);
+	}
+
+	sentence_split(sent, opts);
+	int num_linkages = sentence_parse(sent, opts);
+
+	char buf[128];
+	snprintf(buf, sizeof(buf), "found=%d valid=%d nulls=%d\n",
+	         sentence_num_linkages_found(sent), num_linkages,
+	         sentence_null_count(sent));
+	std::string result = buf;
+
+	if (5 < num_linkages) num_linkages = 5;
+	for (int li = 0; li < num_linkages; li++)
+	{
+		Linkage linkage = linkage_create(li, sent, opts);
+		char *str = linkage_print_diagram(linkage, true, 200);
+		result += str;
+		linkage_free_diagram(str);
+		linkage_delete(linkage);
+	}
+	sentence_delete(sent);
+
+	return result;
+}
+
+static void compare_parses(Dictionary dict, Dictionary text_dict,
+                           Parse_Options opts, const char *what)
+{
+	for (const char *s : sents)
+	{
+		std::string expected = parse_result(text_dict, opts, s);
+		std::string actual = parse_result(dict, opts, s);
+		if (actual != expected) {
+			fprintf (stderr, "Fatal error: Different result with the %s "
+			         "dictionary for \"%s\":\n%s\nInstead of:\n%s\n",
+			         what, s, actual.c_str(), expected.c_str());
+			exit(3);
+		}
+	}
+}
+
+static void copy_file(const char *from, const char *to)
+{
+	FILE *in = fopen(from, "rb");
+	FILE *out = fopen(to, "wb");
+	if (!in || !out) {
+		fprintf (stderr, "Fatal error: Cannot copy %s to %s\n", from, to);
+		exit(4);
+	}
+
+	char buf[8192];
+	size_t n;
+	while (0 < (n = fread(buf, 1, sizeof(buf), in)))
+	{
+		if (n != fwrite(buf, 1, n, out)) {
+			fprintf (stderr, "Fatal error: Cannot write %s\n", to);
+			exit(4);
+		}
+	}
+	fclose(in);
+	if (0 != fclose(out)) {
+		fprintf (stderr, "Fatal error: Cannot write %s\n", to);
+		exit(4);
+	}
+}
+
+// Create "en" in the current directory, with a copy of 4.0.dict and
+// symlinks to the rest of the files of the "en" dictionary directory
+// \p dict_dir (an absolute path).
+static void make_dict_dir(const char *dict_dir)
+{
+	DIR *dir = opendir(dict_dir);
+	if (!dir || (0 != mkdir("en", 0755))) {
+		fprintf (stderr, "Fatal error: Cannot create the \"en\" directory\n");
+		exit(4);
+	}
+
+	struct dirent *de;
+	while (NULL != (de = readdir(dir)))
+	{
+		if ('.' == de->d_name[0]) continue;
+		std::string from = std::string(dict_dir) + "/" + de->d_name;
+		std::string to = std::string("en/") + de->d_name;
+
+		if (0 == strcmp(de->d_name, "4.0.dict"))
+		{
+			copy_file(from.c_str(), to.c_str());
+		}
+		else if (0 != symlink(from.c_str(), to.c_str())) {
+			fprintf (stderr, "Fatal error: Cannot create %s\n", to.c_str());
+			exit(4);
+		}
+	}
+	closedir(dir);
+}
+
+static void remove_dict_dir(void)
+{
+	DIR *dir = opendir("en");
+	if (!dir) return;
+
+	struct dirent *de;
+	while (NULL != (de = readdir(dir)))
+	{
+		if ('.' == de->d_name[0]) continue;
+		unlink((std::string("en/") + de->d_name).c_str());
+	}
+	closedir(dir);
+	rmdir("en");
+}
+
+static std::string messages;
+static void collect_messages(lg_errinfo *ei, void *data)
+{
+	messages += ei->text;
+}
+
+// Create the "en" dictionary of the current directory, and tell whether
+// its precompiled dictionary has been used. The messages of the
+// dictionary creation are then in "messages".
+static Dictionary create_dict(Parse_Options opts, bool *precompiled)
+{
+	messages.clear();
+	parse_options_set_verbosity(opts, 4);
+	lg_error_handler old_handler = lg_error_set_handler(collect_messages, NULL);
+	Dictionary dict = dictionary_create_lang("en");
+	lg_error_set_handler(old_handler, NULL);
+	parse_options_set_verbosity(opts, 1);
+
+	if (!dict) {
+		fprintf (stderr, "Fatal error: Unable to open the dictionary\n");
+		exit(1);
+	}
+	*precompiled =
+		(std::string::npos != messages.find("Using precompiled dictionary"));
+	return dict;
+}
+
+static void compile_dict(void)
+{
+	struct stat buf;
+	if (!dictionary_compile_lang("en", NULL) ||
+	    (0 != stat(BIN_FILE, &buf)) || (0 == buf.st_size)) {
+		fprintf (stderr, "Fatal error: The dictionary didn't get compiled\n");
+		exit(5);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	setlocale(LC_ALL, "en_US.UTF-8");
+	dictionary_set_data_dir(DICTIONARY_DIR "/data");
+
+	Parse_Options opts = parse_options_create();
+
+	// The reference dictionary; never use a precompiled dictionary for it.
+	parse_options_set_test(opts, "text-dict");
+	Dictionary text_dict = dictionary_create_lang("en");
+	parse_options_set_test(opts, "");
+	if (!text_dict) {
+		fprintf (stderr, "Fatal error: Unable to open the dictionary\n");
+		exit(1);
+	}
+
+	// DICTIONARY_DIR may be relative to the current directory.
+	char *dict_dir = realpath(DICTIONARY_DIR "/data/en", NULL);
+	char tmpdir[] = "/tmp/lg-dict-compile-XXXXXX";
+	if (!dict_dir || !mkdtemp(tmpdir) || (0 != chdir(tmpdir))) {
+		fprintf (stderr, "Fatal error: Cannot create a temporary directory\n");
+		exit(4);
+	}
+	make_dict_dir(dict_dir);
+	free(dict_dir);
+
+	bool precompiled;
+
+	// Compile it, and then it is loaded from its precompiled form.
+	compile_dict();
+	Dictionary dict = create_dict(opts, &precompiled);
+	if (!precompiled) {
+		fprintf (stderr, "Fatal error: The precompiled dictionary "
+		         "is not used:\n%s\n", messages.c_str());
+		exit(6);
+	}
+	compare_parses(dict, text_dict, opts, "precompiled");
+	dictionary_delete(dict);
+
+	// After the dictionary file has been changed, the text dictionary
+	// is read.
+	struct stat buf;
+	if (0 != stat("en/4.0.dict", &buf)) {
+		fprintf (stderr, "Fatal error: Cannot stat en/4.0.dict\n");
+		exit(4);
+	}
+	struct utimbuf times = { buf.st_atime, buf.st_mtime - 10 };
+	if (0 != utime("en/4.0.dict", &times)) {
+		fprintf (stderr, "Fatal error: Cannot set the time of en/4.0.dict\n");
+		exit(4);
+	}
+	dict = create_dict(opts, &precompiled);
+	if (precompiled) {
+		fprintf (stderr, "Fatal error: A stale precompiled dictionary "
+		         "is used\n");
+		exit(7);
+	}
+	compare_parses(dict, text_dict, opts, "text (stale precompiled)");
+	dictionary_delete(dict);
+
+	// A truncated precompiled dictionary is not used too.
+	compile_dict();
+	if ((0 != stat(BIN_FILE, &buf)) ||
+	    (0 != truncate(BIN_FILE, buf.st_size / 2))) {
+		fprintf (stderr, "Fatal error: Cannot truncate " BIN_FILE "\n");
+		exit(4);
+	}
+	dict = create_dict(opts, &precompiled);
+	if (precompiled ||
+	    (std::string::npos == messages.find("Truncated file"))) {
+		fprintf (stderr, "Fatal error: A truncated precompiled dictionary "
+		         "is used:\n%s\n", messages.c_str());
+		exit(8);
+	}
+	compare_parses(dict, text_dict, opts, "text (truncated precompiled)");
+	dictionary_delete(dict);
+	printf("Precompiled dictionary: Used, and not used when stale or truncated\n");
+
+	remove_dict_dir();
+	if ((0 != chdir("/")) || (0 != rmdir(tmpdir))) {
+		fprintf (stderr, "Fatal error: Cannot remove %s\n", tmpdir);
+		exit(4);
+	}
+
+	dictionary_delete(text_dict);
+	parse_options_delete(opts);
+
+	return 0;
+}
+#else
+int main(int argc, char* argv[])
+{
+	printf("This test is not supported on this system\n");
+	return 77; // Skipped
+}
+#endif /* !_WIN32 */
@@ -0,0 +1,196 @@
+/*************************************************************************/
+/* Copyright (c) 2026 The Link Grammar project                           */
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+// Unit test of the shared dictionary (dictionary_create_lang_shared()).
+// Check that a dictionary gets published, that another dictionary gets
+// attached to it, and that both parse exactly like the text dictionary.
+// Also check that an unfinished shared dictionary (of a publishing
+// process that died) is removed only after its timeout.
+
+#include <string>
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_SHM_OPEN
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* HAVE_SHM_OPEN */
+#include "link-grammar/link-includes.h"
+
+#ifdef HAVE_SHM_OPEN
+static const char *sents[] = {
+	"It was covered with bites.",
+	"I have no idea what that is.",
+	"We ate popcorn and watched movies on TV for three days.",
+	"The line extends 10 miles offshore.",
+	"One of the things you do when you stop your bicycle is apply the brake.",
+	"Sweat stood on his brow, fury was bright in his one good eye.",
+	"This is a the test.",
+};
+
+// Return a string that describes the parse results of the sentence.
+static std::string parse_result(Dictionary dict, Parse_Options opts,
+                                const char *sent_str)
+{
+	Sentence sent = sentence_create(sent_str, dict);
+	if (!sent) {
+		fprintf (stderr, "Fatal error: Unable to create parser\n");
+		exit(2);
+	}
+
+	sentence_split(sent, opts);
+	int num_linkages = sentence_parse(sent, opts);
+
+	char buf[128];
+	snprintf(buf, sizeof(buf), "found=%d valid=%d nulls=%d\n",
+	         sentence_num_linkages_found(sent), num_linkages,
+	         sentence_null_count(sent));
+	std::string result = buf;
+
+	if (5 < num_linkages) num_linkages = 5;
+	for (int li = 0; li < num_linkages; li++)
+	{
+		Linkage linkage = linkage_create(li, sent, opts);
+		char *str = linkage_print_diagram(linkage, true, 200);
+		result += str;
+		linkage_free_diagram(str);
+		linkage_delete(linkage);
+	}
+	sentence_delete(sent);
+
+	return result;
+}
+
+static void compare_parses(Dictionary dict, Dictionary text_dict,
+                           Parse_Options opts, const char *what)
+{
+	for (const char *s : sents)
+	{
+		std::string expected = parse_result(text_dict, opts, s);
+		std::string actual = parse_result(dict, opts, s);
+		if (actual != expected) {
+			fprintf (stderr, "Fatal error: Different result with the %s "
+			         "dictionary for \"%s\":\n%s\nInstead of:\n%s\n",
+			         what, s, actual.c_str(), expected.c_str());
+			exit(3);
+		}
+	}
+}
+
+// Return the size of the shared memory object, or -1 if it doesn't exist.
+// If it is not empty, check that it is a complete dictionary.
+static off_t shm_size(const char *shm_name)
+{
+	int fd = shm_open(shm_name, O_RDONLY, 0);
+	if (-1 == fd) return -1;
+
+	struct stat buf;
+	if (0 != fstat(fd, &buf)) {
+		fprintf (stderr, "Fatal error: Cannot stat %s\n", shm_name);
+		exit(4);
+	}
+	if (0 < buf.st_size)
+	{
+		char magic[8] = "";
+		if ((sizeof(magic) != pread(fd, magic, sizeof(magic), 0)) ||
+		    (0 != strcmp(magic, "LGDICTB"))) {
+			fprintf (stderr, "Fatal error: %s is not complete\n", shm_name);
+			exit(4);
+		}
+	}
+	close(fd);
+
+	return buf.st_size;
+}
+
+static bool attached;
+static void find_attach_message(lg_errinfo *ei, void *data)
+{
+	if (NULL != strstr(ei->text, "Using shared dictionary"))
+		attached = true;
+}
+
+int main(int argc, char* argv[])
+{
+	setlocale(LC_ALL, "en_US.UTF-8");
+	dictionary_set_data_dir(DICTIONARY_DIR "/data");
+
+	char shm_name[64];
+	snprintf(shm_name, sizeof(shm_name), "/lg-test-%ld", (long)getpid());
+	shm_unlink(shm_name);
+
+	Parse_Options opts = parse_options_create();
+	Dictionary text_dict = dictionary_create_lang("en");
+	if (!text_dict) {
+		fprintf (stderr, "Fatal error: Unable to open the dictionary\n");
+		exit(1);
+	}
+
+	// An unfinished shared dictionary, like one whose publishing process
+	// died. Since it has just been created, it is not removed.
+	int fd = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (-1 == fd) {
+		fprintf (stderr, "Fatal error: Cannot create %s\n", shm_name);
+		exit(4);
+	}
+	close(fd);
+
+	Dictionary dict = dictionary_create_lang_shared("en", shm_name);
+	if (!dict || (0 != shm_size(shm_name))) {
+		fprintf (stderr, "Fatal error: A new unfinished shared dictionary "
+		         "got replaced\n");
+		exit(5);
+	}
+	dictionary_delete(dict);
+
+	// After its timeout, it is removed and the dictionary is published.
+	parse_options_set_test(opts, "shm-publish-timeout:0");
+	Dictionary published_dict = dictionary_create_lang_shared("en", shm_name);
+	parse_options_set_test(opts, "");
+	if (!published_dict || (0 >= shm_size(shm_name))) {
+		fprintf (stderr, "Fatal error: The dictionary didn't get published\n");
+		exit(5);
+	}
+	compare_parses(published_dict, text_dict, opts, "published");
+
+	// Now the next dictionary gets attached to it.
+	parse_options_set_verbosity(opts, 4);
+	lg_error_handler old_handler =
+		lg_error_set_handler(find_attach_message, NULL);
+	Dictionary shared_dict = dictionary_create_lang_shared("en", shm_name);
+	lg_error_set_handler(old_handler, NULL);
+	parse_options_set_verbosity(opts, 1);
+	if (!shared_dict || !attached) {
+		fprintf (stderr, "Fatal error: Not attached to the shared dictionary\n");
+		exit(6);
+	}
+	compare_parses(shared_dict, text_dict, opts, "shared");
+	printf("Shared dictionary %s: Published and attached\n", shm_name);
+
+	dictionary_delete(shared_dict);
+	dictionary_delete(published_dict);
+	dictionary_delete(text_dict);
+	parse_options_delete(opts);
+	shm_unlink(shm_name);
+
+	return 0;
+}
+#else
+int main(int argc, char* argv[])
+{
+	printf("Shared dictionaries are not supported on this system\n");
+	return 77; // Skipped
+}
+#endif /* HAVE_SHM_OPEN */
@@ -0,0 +1,140 @@
+/*************************************************************************/
+/* Copyright (c) 2026 The Link Grammar project                           */
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+// Unit test of the dictionary disjunct cache.
+// Parse the sentences of a corpus file with a dictionary that uses the
+// disjunct cache and with one that doesn't, and check that the results
+// are identical.
+
+#include <string>
+#include <vector>
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "link-grammar/link-includes.h"
+
+// More than the sentences of each of the basic corpora.
+static const size_t max_sentences = 1000;
+static const int max_linkages = 5;
+
+static std::vector<std::string> read_corpus(const char *path)
+{
+	std::vector<std::string> sents;
+	FILE *fp = fopen(path, "r");
+	if (!fp) {
+		fprintf (stderr, "Fatal error: Unable to open %s\n", path);
+		exit(1);
+	}
+
+	char line[1024];
+	while (sents.size() < max_sentences && fgets(line, sizeof(line), fp))
+	{
+		line[strcspn(line, "\r\n")] = '\0';
+		if ('\0' == line[0] || '!' == line[0] || '%' == line[0]) continue;
+		sents.push_back(('*' == line[0]) ? &line[1] : line);
+	}
+	fclose(fp);
+
+	return sents;
+}
+
+// Return a string that describes the parse results of the sentence.
+static std::string parse_result(Dictionary dict, Parse_Options opts,
+                                const std::string &sent_str)
+{
+	Sentence sent = sentence_create(sent_str.c_str(), dict);
+	if (!sent) {
+		fprintf (stderr, "Fatal error: Unable to create parser\n");
+		exit(2);
+	}
+
+	sentence_split(sent, opts);
+	int num_linkages = sentence_parse(sent, opts);
+
+	char buf[128];
+	snprintf(buf, sizeof(buf), "found=%d valid=%d nulls=%d\n",
+	         sentence_num_linkages_found(sent), num_linkages,
+	         sentence_null_count(sent));
+	std::string result = buf;
+
+	if (max_linkages < num_linkages) num_linkages = max_linkages;
+	for (int li = 0; li < num_linkages; li++)
+	{
+		Linkage linkage = linkage_create(li, sent, opts);
+
+		char *str = linkage_print_disjuncts(linkage);
+		result += str;
+		linkage_free_disjuncts(str);
+		str = linkage_print_diagram(linkage, true, 200);
+		result += str;
+		linkage_free_diagram(str);
+
+		linkage_delete(linkage);
+	}
+	sentence_delete(sent);
+
+	return result;
+}
+
+static void compare_corpus(const char *lang, const char *corpus)
+{
+	Parse_Options opts = parse_options_create();
+	parse_options_set_max_null_count(opts, 1);
+	parse_options_set_verbosity(opts, 0);
+
+	// The cache size is read when the dictionary is created.
+	parse_options_set_test(opts, "disjunct-cache:0");
+	Dictionary dict_nocache = dictionary_create_lang(lang);
+	parse_options_set_test(opts, "");
+	Dictionary dict_cache = dictionary_create_lang(lang);
+	if (!dict_nocache || !dict_cache) {
+		fprintf (stderr, "Fatal error: Unable to open the dictionary\n");
+		exit(1);
+	}
+
+	std::string path = std::string(DICTIONARY_DIR "/data/") + lang + "/" + corpus;
+	std::vector<std::string> sents = read_corpus(path.c_str());
+
+	// Go over the corpus twice, so the second time everything is cached.
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (const std::string &s : sents)
+		{
+			std::string expected = parse_result(dict_nocache, opts, s);
+			std::string actual = parse_result(dict_cache, opts, s);
+			if (actual != expected) {
+				fprintf (stderr, "Fatal error: Different result with the "
+				         "disjunct cache for \"%s\":\n%s\nInstead of:\n%s\n",
+				         s.c_str(), actual.c_str(), expected.c_str());
+				exit(3);
+			}
+		}
+	}
+	printf("%s/%s: %zu sentences parsed the same with the disjunct cache\n",
+	       lang, corpus, sents.size());
+
+	dictionary_delete(dict_cache);
+	dictionary_delete(dict_nocache);
+	parse_options_delete(opts);
+}
+
+int main(int argc, char* argv[])
+{
+	setlocale(LC_ALL, "en_US.UTF-8");
+	dictionary_set_data_dir(DICTIONARY_DIR "/data");
+
+	compare_corpus("en", "corpus-basic.batch");
+	compare_corpus("ru", "corpus-basic.batch");
+
+	return 0;
+}
@@ -0,0 +1,163 @@
+/*************************************************************************/
+/* Copyright (c) 2026 The Link Grammar project                           */
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+// Unit test of the linkage iterator (linkage_iter_create() etc.).
+// Check that it returns the same best linkage as sentence_parse(),
+// that it retries with nulls when needed, and that it doesn't change
+// the way sentence_parse() works with the same Parse_Options.
+
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "link-grammar/link-includes.h"
+
+static int parse_valid(Dictionary dict, Parse_Options opts,
+                       const char *sent_str, double *best_cost)
+{
+	Sentence sent = sentence_create(sent_str, dict);
+	if (!sent) {
+		fprintf (stderr, "Fatal error: Unable to create parser\n");
+		exit(2);
+	}
+
+	sentence_split(sent, opts);
+	int num_linkages = sentence_parse(sent, opts);
+	if (num_linkages <= 0) {
+		fprintf (stderr, "Fatal error: Unable to parse \"%s\"\n", sent_str);
+		exit(3);
+	}
+
+	int num_valid = sentence_num_valid_linkages(sent);
+	if (0 < num_valid && NULL != best_cost)
+	{
+		Linkage linkage = linkage_create(0, sent, opts);
+		*best_cost = linkage_disjunct_cost(linkage);
+		linkage_delete(linkage);
+	}
+	sentence_delete(sent);
+
+	return num_valid;
+}
+
+static size_t iterate(Dictionary dict, Parse_Options opts,
+                      const char *sent_str, size_t max_linkages,
+                      double *best_cost, int *null_count)
+{
+	Sentence sent = sentence_create(sent_str, dict);
+	if (!sent) {
+		fprintf (stderr, "Fatal error: Unable to create parser\n");
+		exit(2);
+	}
+
+	sentence_split(sent, opts);
+	Linkage_iter iter = linkage_iter_create(sent, opts);
+	if (!iter) {
+		fprintf (stderr, "Fatal error: Unable to create iterator\n");
+		exit(4);
+	}
+
+	size_t n = 0;
+	Linkage linkage;
+	while (n < max_linkages && (linkage = linkage_iter_next(iter)) != NULL)
+	{
+		if (0 == linkage_get_num_links(linkage)) {
+			fprintf (stderr, "Fatal error: Empty linkage %zu of \"%s\"\n",
+			         n, sent_str);
+			exit(4);
+		}
+		char *str = linkage_print_diagram(linkage, true, 80);
+		linkage_free_diagram(str);
+
+		if (0 == n) *best_cost = linkage_disjunct_cost(linkage);
+		n++;
+	}
+	*null_count = sentence_null_count(sent);
+
+	linkage_iter_delete(iter);
+	sentence_delete(sent);
+
+	return n;
+}
+
+int main(int argc, char* argv[])
+{
+	setlocale(LC_ALL, "en_US.UTF-8");
+	dictionary_set_data_dir(DICTIONARY_DIR "/data");
+
+	Dictionary dict = dictionary_create_lang("en");
+	if (!dict) {
+		fprintf (stderr, "Fatal error: Unable to open the dictionary\n");
+		exit(1);
+	}
+	Parse_Options opts = parse_options_create();
+
+	const char *sents[] = {
+		"Trump, Ryan and McConnell are using the budget process to pay for the GOP’s $1.5 trillion tax scam.",
+		"We ate popcorn and watched movies on TV for three days.",
+		"One of the things you do when you stop your bicycle is apply the brake.",
+	};
+	const size_t nsents = sizeof(sents) / sizeof(sents[0]);
+
+	for (size_t i = 0; i < nsents; i++)
+	{
+		double parse_cost = 0, iter_cost = 0;
+		int null_count;
+
+		if (0 == parse_valid(dict, opts, sents[i], &parse_cost)) {
+			fprintf (stderr, "Fatal error: No valid linkages for \"%s\"\n",
+			         sents[i]);
+			exit(3);
+		}
+
+		size_t n = iterate(dict, opts, sents[i], 10, &iter_cost, &null_count);
+		if (0 == n) {
+			fprintf (stderr, "Fatal error: Iterator gave no linkages for \"%s\"\n",
+			         sents[i]);
+			exit(4);
+		}
+		if (fabs(parse_cost - iter_cost) > 1e-4) {
+			fprintf (stderr, "Fatal error: Best cost %.3f != %.3f for \"%s\"\n",
+			         iter_cost, parse_cost, sents[i]);
+			exit(4);
+		}
+
+		// The iterator must not leave anything behind in opts.
+		if (0 == parse_valid(dict, opts, sents[i], NULL)) {
+			fprintf (stderr, "Fatal error: No valid linkages after iterating "
+			         "\"%s\"\n", sents[i]);
+			exit(5);
+		}
+	}
+
+	// A sentence that has no complete linkage: the iterator should parse
+	// it again with nulls, without changing the caller's min_null_count.
+	parse_options_set_max_null_count(opts, 3);
+	double cost;
+	int null_count;
+	const char *ungrammatical = "This is a the test.";
+	if (0 == iterate(dict, opts, ungrammatical, 1, &cost, &null_count) ||
+	    0 == null_count) {
+		fprintf (stderr, "Fatal error: No null-count linkage for \"%s\"\n",
+		         ungrammatical);
+		exit(6);
+	}
+	if (0 != parse_options_get_min_null_count(opts)) {
+		fprintf (stderr, "Fatal error: The iterator changed min_null_count\n");
+		exit(6);
+	}
+
+	printf("Done with linkage iteration\n");
+
+	parse_options_delete(opts);
+	dictionary_delete(dict);
+	return 0;
+}
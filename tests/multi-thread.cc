@@ -132,6 +132,136 @@ static void parse_sents(Dictionary dict, Parse_Options opts, int thread_id, int
 	}
 }
 
+// Check that sentence_batch_parse() delivers all the sentences, in order,
+// with the same number of valid linkages as sentence_parse().
+static size_t batch_next;
+static int *batch_expected;
+static size_t batch_nexpected;
+static void batch_check(Sentence, size_t index, int num_linkages,
+                        void *data)
+{
+	if (index != batch_next++)
+	{
+		fprintf(stderr, "Fatal error: Batch sentence %zu out of order\n", index);
+		exit(4);
+	}
+	if (num_linkages != batch_expected[index % batch_nexpected])
+	{
+		fprintf(stderr, "Fatal error: Batch sentence %zu: %d linkages "
+		        "(expected %d)\n", index, num_linkages,
+		        batch_expected[index % batch_nexpected]);
+		exit(4);
+	}
+	if (0 < num_linkages) (*(int *)data)++;
+}
+
+static void parse_batch(Dictionary dict, Parse_Options opts, int n_threads)
+{
+	const char *sents[] = {
+		"It was covered with bites.",
+		"I have no idea what that is.",
+		"We ate popcorn and watched movies on TV for three days.",
+		"The line extends 10 miles offshore.",
+		"One of the things you do when you stop your bicycle is apply the brake.",
+		"Sweat stood on his brow, fury was bright in his one good eye.",
+	};
+	const size_t nsents = sizeof(sents) / sizeof(sents[0]);
+	const int nrep = 20;
+	const char *batch[nsents * nrep];
+
+	for (int r = 0; r < nrep; r++)
+		for (size_t i = 0; i < nsents; i++)
+			batch[r * nsents + i] = sents[i];
+
+	int expected[nsents];
+	for (size_t i = 0; i < nsents; i++)
+	{
+		Sentence sent = sentence_create(sents[i], dict);
+		sentence_split(sent, opts);
+		expected[i] = sentence_parse(sent, opts);
+		sentence_delete(sent);
+	}
+	batch_expected = expected;
+	batch_nexpected = nsents;
+
+	int nparsed = 0;
+	batch_next = 0;
+	int rc = sentence_batch_parse(dict, opts, batch, nsents * nrep, n_threads,
+	                              batch_check, &nparsed);
+	if ((rc != (int)(nsents * nrep)) || (batch_next != nsents * nrep))
+	{
+		fprintf(stderr, "Fatal error: Batch parse returned %d\n", rc);
+		exit(4);
+	}
+	if (0 == nparsed)
+	{
+		fprintf(stderr, "Fatal error: Nothing got batch-parsed\n");
+		exit(4);
+	}
+	printf("Done with batch parsing (%d of %zu parsed)\n",
+	       nparsed, nsents * nrep);
+}
+
+// Check that the Parse_Options of sentence_batch_parse() report the
+// timeout of each sentence during its callback, and after the batch
+// whether any of them timed out, for any number of threads.
+static const char *slow_sent =
+	"Frank felt vindicated when his long time friend Bill revealed that he "
+	"was the winner of the competition, and the line extends 10 miles "
+	"offshore while sweat stood on his brow, fury was bright in his one "
+	"good eye, and one of the things you do when you stop your bicycle is "
+	"apply the brake, so we ate popcorn and watched movies on TV for three "
+	"days. the the of of a a and and";
+static const char *timeout_batch[] = {
+	"It was covered with bites.",
+	slow_sent,
+	"I have no idea what that is.",
+};
+
+static void batch_timeout_check(Sentence, size_t index, int num_linkages,
+                                void *data)
+{
+	Parse_Options opts = (Parse_Options)data;
+	bool expired = (slow_sent == timeout_batch[index]);
+
+	if (parse_options_timer_expired(opts) != expired)
+	{
+		fprintf(stderr, "Fatal error: Batch sentence %zu: timeout is %s "
+		        "reported\n", index, expired ? "not" : "wrongly");
+		exit(5);
+	}
+}
+
+static void parse_batch_timeout(Dictionary dict, int n_threads)
+{
+	Parse_Options opts = parse_options_create();
+	parse_options_set_max_null_count(opts, 10);
+	parse_options_set_max_wall_time_ms(opts, 200);
+
+	const size_t nsents = sizeof(timeout_batch) / sizeof(timeout_batch[0]);
+	sentence_batch_parse(dict, opts, timeout_batch, nsents, n_threads,
+	                     batch_timeout_check, opts);
+	if (!parse_options_timer_expired(opts))
+	{
+		fprintf(stderr, "Fatal error: Batch timeout not reported "
+		        "(%d threads)\n", n_threads);
+		exit(5);
+	}
+
+	const char *fast_batch[] = { timeout_batch[0], timeout_batch[2] };
+	sentence_batch_parse(dict, opts, fast_batch, 2, n_threads,
+	                     NULL, NULL);
+	if (parse_options_timer_expired(opts))
+	{
+		fprintf(stderr, "Fatal error: Batch timeout wrongly reported "
+		        "(%d threads)\n", n_threads);
+		exit(5);
+	}
+
+	parse_options_delete(opts);
+	printf("Done with batch timeout reporting (%d threads)\n", n_threads);
+}
+
 int main(int argc, char* argv[])
 {
 	setlocale(LC_ALL, "en_US.UTF-8");
@@ -187,6 +317,11 @@ int main(int argc, char* argv[])
 	}
 	printf("Done with multi-threaded parsing (stat: %d full parses)\n", pcnt);
 
+	parse_options_set_spell_guess(opts[0], 0);
+	parse_batch(dicte, opts[0], n_threads);
+	parse_batch_timeout(dicte, 1);
+	parse_batch_timeout(dicte, 3);
+
 
 	for (int i=0; i < n_threads; i++)
 		parse_options_delete(opts[i]);
@@ -0,0 +1,208 @@
+/*************************************************************************/
+/* Copyright (c) 2026 The Link Grammar project                           */
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+// Unit test of parsing under a time limit.
+// Check that in the anytime mode, a parse that runs out of time returns
+// degraded linkages. The sentence is chosen so that its full parse takes
+// many times longer than the time limit, while its degraded parse takes
+// only a small fraction of it.
+// Also check that a parse that would take minutes stops soon after its
+// wall-clock limit, or after sentence_cancel() from another thread.
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "link-grammar/link-includes.h"
+
+// All the links of this sentence can be short, so it can also be
+// parsed (with the extra words as null words) in the degraded mode.
+// Its full parse with nulls takes about 100 times longer than that.
+static const char *pp_chain =
+	"in the park near the river by the old mill on the hill behind the "
+	"school across the road from the church next to the station under the "
+	"bridge over the canal beside the lake at the edge of the forest past "
+	"the farm along the path towards the town ";
+
+static std::string long_sentence(void)
+{
+	std::string sent = "I saw the man with the telescope ";
+	for (int i = 0; i < 4; i++)
+		sent += pp_chain;
+	return sent + "the the of of a a and and.";
+}
+
+// Parsing this one with nulls takes minutes.
+static const char *slow_sent =
+	"Frank felt vindicated when his long time friend Bill revealed that he "
+	"was the winner of the competition, and the line extends 10 miles "
+	"offshore while sweat stood on his brow, fury was bright in his one "
+	"good eye, and one of the things you do when you stop your bicycle is "
+	"apply the brake, so we ate popcorn and watched movies on TV for three "
+	"days. the the of of a a and and";
+
+// The parses that are expected to stop early should stop well before this.
+static const int max_seconds = 30;
+
+static void check_linkages(Sentence sent, Parse_Options opts)
+{
+	int num_linkages = sentence_num_valid_linkages(sent);
+	if (3 < num_linkages) num_linkages = 3;
+
+	for (int li = 0; li < num_linkages; li++)
+	{
+		Linkage linkage = linkage_create(li, sent, opts);
+		if (!linkage || 0 == linkage_get_num_links(linkage)) {
+			fprintf (stderr, "Fatal error: Bad degraded linkage %d\n", li);
+			exit(3);
+		}
+		char *str = linkage_print_diagram(linkage, true, 80);
+		linkage_free_diagram(str);
+		linkage_delete(linkage);
+	}
+}
+
+static void test_anytime(Dictionary dict)
+{
+	Parse_Options opts = parse_options_create();
+	parse_options_set_anytime(opts, true);
+	parse_options_set_max_null_count(opts, 10);
+
+	// Half of the time limit is given to the full parse. If the degraded
+	// parse doesn't finish in the other half (a very slow or loaded
+	// machine), try again with a longer limit.
+	std::string sent_str = long_sentence();
+	bool done = false;
+	for (int msecs = 4000; !done && (msecs <= 16000); msecs *= 2)
+	{
+		parse_options_set_max_wall_time_ms(opts, msecs);
+
+		Sentence sent = sentence_create(sent_str.c_str(), dict);
+		sentence_split(sent, opts);
+		int num_linkages = sentence_parse(sent, opts);
+
+		if (!sentence_is_partial(sent))
+		{
+			printf("Anytime: Skipped (the full parse completed in %dms)\n",
+			       msecs);
+			done = true;
+		}
+		else if (0 < num_linkages)
+		{
+			check_linkages(sent, opts);
+			printf("Anytime: %d degraded linkages (%d null%s) in %dms\n",
+			       num_linkages, sentence_null_count(sent),
+			       (1 == sentence_null_count(sent)) ? "" : "s", msecs);
+			done = true;
+		}
+		sentence_delete(sent);
+	}
+	if (!done)
+		printf("Anytime: Skipped (no degraded linkages in time)\n");
+
+	parse_options_delete(opts);
+}
+
+static double elapsed_seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+static void test_wall_time(Dictionary dict)
+{
+	Parse_Options opts = parse_options_create();
+	parse_options_set_max_null_count(opts, 10);
+	parse_options_set_max_wall_time_ms(opts, 200);
+
+	Sentence sent = sentence_create(slow_sent, dict);
+	sentence_split(sent, opts);
+
+	auto start = std::chrono::steady_clock::now();
+	sentence_parse(sent, opts);
+	double secs = elapsed_seconds(start);
+
+	if (max_seconds < secs || !parse_options_timer_expired(opts)) {
+		fprintf (stderr, "Fatal error: Wall-clock limit not honored "
+		         "(%.1f seconds)\n", secs);
+		exit(4);
+	}
+	printf("Wall-clock limit: Stopped after %.3f seconds\n", secs);
+
+	sentence_delete(sent);
+	parse_options_delete(opts);
+}
+
+static void test_cancel(Dictionary dict)
+{
+	Parse_Options opts = parse_options_create();
+	parse_options_set_max_null_count(opts, 10);
+	// The cancellation should also prevent the degraded parse.
+	parse_options_set_anytime(opts, true);
+	parse_options_set_max_parse_time(opts, 10 * max_seconds);
+
+	Sentence sent = sentence_create(slow_sent, dict);
+	sentence_split(sent, opts);
+
+	int num_linkages = -1;
+	auto start = std::chrono::steady_clock::now();
+	std::thread parser([&]() { num_linkages = sentence_parse(sent, opts); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	sentence_cancel(sent);
+	parser.join();
+	double secs = elapsed_seconds(start);
+
+	if (max_seconds < secs || !parse_options_resources_exhausted(opts)) {
+		fprintf (stderr, "Fatal error: Cancellation not honored "
+		         "(%.1f seconds)\n", secs);
+		exit(5);
+	}
+	if (0 != num_linkages) {
+		fprintf (stderr, "Fatal error: Cancelled parse returned %d\n",
+		         num_linkages);
+		exit(5);
+	}
+	printf("Cancel: Stopped after %.3f seconds\n", secs);
+
+	// The cancellation is sticky.
+	start = std::chrono::steady_clock::now();
+	sentence_parse(sent, opts);
+	secs = elapsed_seconds(start);
+	if (max_seconds < secs) {
+		fprintf (stderr, "Fatal error: Cancelled sentence got parsed again\n");
+		exit(5);
+	}
+
+	sentence_delete(sent);
+	parse_options_delete(opts);
+}
+
+int main(int argc, char* argv[])
+{
+	setlocale(LC_ALL, "en_US.UTF-8");
+	dictionary_set_data_dir(DICTIONARY_DIR "/data");
+
+	Dictionary dict = dictionary_create_lang("en");
+	if (!dict) {
+		fprintf (stderr, "Fatal error: Unable to open the dictionary\n");
+		exit(1);
+	}
+
+	test_anytime(dict);
+	test_wall_time(dict);
+	test_cancel(dict);
+
+	dictionary_delete(dict);
+	return 0;
+}